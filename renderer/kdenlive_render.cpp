@@ -21,14 +21,139 @@
 #include "mlt++/Mlt.h"
 #include "renderjob.h"
 #include <QCoreApplication>
+#include <QCryptographicHash>
 #include <QDebug>
 #include <QDir>
 #include <QDomDocument>
+#include <QFile>
 #include <QFileInfo>
 #include <QString>
 #include <QStringList>
 #include <QUrl>
 #include <cstdio>
+#include <memory>
+
+// Render the chunk starting at frame to <frame>.<extension> in baseFolder
+static void renderChunk(Mlt::Profile &profile, Mlt::Producer &prod, const QDir &baseFolder, int frame, int chunkSize, const QString &extension,
+                        const QStringList &consumerParams)
+{
+    fprintf(stderr, "START:%d \n", frame);
+    QString fileName = QStringLiteral("%1.%2").arg(frame).arg(extension);
+    if (baseFolder.exists(fileName)) {
+        // Don't overwrite an existing file
+        fprintf(stderr, "DONE:%d \n", frame);
+        return;
+    }
+    QScopedPointer<Mlt::Producer> playlst(prod.cut(frame, frame + chunkSize));
+    QScopedPointer<Mlt::Consumer> cons(
+        new Mlt::Consumer(profile, QString("avformat:%1").arg(baseFolder.absoluteFilePath(fileName)).toUtf8().constData()));
+    for (const QString &param : consumerParams) {
+        if (param.contains(QLatin1Char('='))) {
+            cons->set(param.section(QLatin1Char('='), 0, 0).toUtf8().constData(), param.section(QLatin1Char('='), 1).toUtf8().constData());
+        }
+    }
+    cons->set("terminate_on_pause", 1);
+    cons->connect(*playlst);
+    playlst.reset();
+    cons->run();
+    cons->stop();
+    cons->purge();
+    fprintf(stderr, "DONE:%d \n", frame);
+}
+
+/* Long lived mode, MLT is initialized once and jobs are read from stdin, one command per line:
+   JOB<tab>playlist<tab>target folder<tab>chunk size<tab>extension<tab>consumer params (space separated)
+       Select the playlist used by the following chunks. It is only parsed again if its content changed.
+       Answers READY:1 if the previously loaded playlist was reused, READY:0 otherwise.
+   <frame>
+       Render the chunk starting at frame, with the same START: / DONE: output as the -split mode.
+       Answers FAILED:<frame> if no valid playlist is loaded.
+   The server exits when stdin is closed.
+*/
+// Read a line from stdin, blocking until it is complete. Returns false at end of input
+static bool readCommand(QByteArray &line)
+{
+    line.clear();
+    char buffer[1024];
+    while (fgets(buffer, sizeof(buffer), stdin) != nullptr) {
+        line.append(buffer);
+        if (line.endsWith('\n')) {
+            return true;
+        }
+    }
+    return !line.isEmpty();
+}
+
+static int runRenderServer()
+{
+    Mlt::Factory::init();
+    // The producer depends on the profile, so it must be deleted first
+    std::unique_ptr<Mlt::Profile> profile;
+    std::unique_ptr<Mlt::Producer> prod;
+    QByteArray sceneHash;
+    QDir baseFolder;
+    int chunkSize = 0;
+    QString extension;
+    QStringList consumerParams;
+    QByteArray command;
+    while (readCommand(command)) {
+        // Don't trim, the last field of a job may be empty
+        QString line = QString::fromUtf8(command);
+        while (line.endsWith(QLatin1Char('\n')) || line.endsWith(QLatin1Char('\r'))) {
+            line.chop(1);
+        }
+        if (line.isEmpty()) {
+            continue;
+        }
+        if (line.startsWith(QLatin1String("JOB\t"))) {
+            const QStringList fields = line.split(QLatin1Char('\t'));
+            if (fields.count() < 6) {
+                fprintf(stderr, "INVALID job: %s\n", line.toUtf8().constData());
+                continue;
+            }
+            const QString playlist = fields.at(1);
+            baseFolder = QDir(fields.at(2));
+            chunkSize = fields.at(3).toInt();
+            extension = fields.at(4);
+            consumerParams = fields.at(5).split(QLatin1Char(' '), QString::SkipEmptyParts);
+            QFile scene(playlist);
+            QByteArray hash;
+            if (scene.open(QIODevice::ReadOnly)) {
+                hash = QCryptographicHash::hash(scene.readAll(), QCryptographicHash::Md5);
+                scene.close();
+            }
+            bool reused = prod && !hash.isEmpty() && hash == sceneHash;
+            if (!reused) {
+                prod.reset();
+                profile.reset(new Mlt::Profile);
+                prod.reset(new Mlt::Producer(*profile, nullptr, playlist.toUtf8().constData()));
+                sceneHash = hash;
+                if (!prod->is_valid()) {
+                    fprintf(stderr, "INVALID playlist: %s \n", playlist.toUtf8().constData());
+                    sceneHash.clear();
+                    prod.reset();
+                }
+            }
+            fprintf(stderr, "READY:%d\n", reused ? 1 : 0);
+            continue;
+        }
+        bool ok = false;
+        int frame = line.toInt(&ok);
+        if (!ok) {
+            fprintf(stderr, "INVALID command: %s\n", line.toUtf8().constData());
+            continue;
+        }
+        if (!prod) {
+            // Let the caller know this chunk will never be rendered
+            fprintf(stderr, "FAILED:%d\n", frame);
+            continue;
+        }
+        renderChunk(*profile, *prod, baseFolder, frame, chunkSize, extension, consumerParams);
+    }
+    prod.reset();
+    profile.reset();
+    return 0;
+}
 
 int main(int argc, char **argv)
 {
@@ -36,6 +161,9 @@ int main(int argc, char **argv)
     QStringList args = app.arguments();
     QStringList preargs;
     QString locale;
+    if (args.count() == 2 && args.at(1) == QLatin1String("-server")) {
+        return runRenderServer();
+    }
     if (args.count() >= 4) {
         // Remove program name
         args.removeFirst();
@@ -77,28 +205,7 @@ int main(int argc, char **argv)
                 fprintf(stderr, "INVALID playlist: %s \n", playlist.toUtf8().constData());
             }
             for (const QString &frame : chunks) {
-                fprintf(stderr, "START:%d \n", frame.toInt());
-                QString fileName = QStringLiteral("%1.%2").arg(frame).arg(extension);
-                if (baseFolder.exists(fileName)) {
-                    // Don't overwrite an existing file
-                    fprintf(stderr, "DONE:%d \n", frame.toInt());
-                    continue;
-                }
-                QScopedPointer<Mlt::Producer> playlst(prod.cut(frame.toInt(), frame.toInt() + chunkSize));
-                QScopedPointer<Mlt::Consumer> cons(
-                    new Mlt::Consumer(profile, QString("avformat:%1").arg(baseFolder.absoluteFilePath(fileName)).toUtf8().constData()));
-                for (const QString &param : consumerParams) {
-                    if (param.contains(QLatin1Char('='))) {
-                        cons->set(param.section(QLatin1Char('='), 0, 0).toUtf8().constData(), param.section(QLatin1Char('='), 1).toUtf8().constData());
-                    }
-                }
-                cons->set("terminate_on_pause", 1);
-                cons->connect(*playlst);
-                playlst.reset();
-                cons->run();
-                cons->stop();
-                cons->purge();
-                fprintf(stderr, "DONE:%d \n", frame.toInt());
+                renderChunk(profile, prod, baseFolder, frame.toInt(), chunkSize, extension, consumerParams);
             }
             // Mlt::Factory::close();
             fprintf(stderr, "+ + + RENDERING FINSHED + + + \n");
@@ -126,6 +233,7 @@ int main(int argc, char **argv)
                 "Kdenlive video renderer for MLT.\nUsage: "
                 "kdenlive_render [-erase] [-kuiserver] [-locale:LOCALE] [in=pos] [out=pos] [render] [profile] [rendermodule] [player] [src] [dest] [[arg1] "
                 "[arg2] ...]\n"
+                "       kdenlive_render -server\n"
                 "  -erase: if that parameter is present, src file will be erased at the end\n"
                 "  -kuiserver: if that parameter is present, use KDE job tracker\n"
                 "  -locale:LOCALE : set a locale for rendering. For example, -locale:fr_FR.UTF-8 will use a french locale (comma as numeric separator)\n"
@@ -137,7 +245,8 @@ int main(int argc, char **argv)
                 "  player: path to video player to play when rendering is over, use '-' to disable playing\n"
                 "  src: source file (usually MLT XML)\n"
                 "  dest: destination file\n"
-                "  args: space separated libavformat arguments\n");
+                "  args: space separated libavformat arguments\n"
+                "  -server: keep running and read timeline preview jobs from stdin\n");
         return 1;
     }
 }
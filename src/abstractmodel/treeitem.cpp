@@ -87,8 +87,8 @@ bool TreeItem::appendChild(const std::shared_ptr<TreeItem> &child)
         ptr->notifyRowAboutToAppend(shared_from_this());
         child->updateParent(shared_from_this());
         int id = child->getId();
-        auto it = m_childItems.insert(m_childItems.end(), child);
-        m_iteratorTable[id] = it;
+        m_childRows[id] = (int)m_childItems.size();
+        m_childItems.push_back(child);
         registerSelf(child);
         ptr->notifyRowAppended(child);
         return true;
@@ -104,18 +104,17 @@ void TreeItem::moveChild(int ix, const std::shared_ptr<TreeItem> &child)
         auto parentPtr = child->m_parentItem.lock();
         if (parentPtr && parentPtr->getId() != m_id) {
             parentPtr->removeChild(child);
-        } else {
+        } else if (m_childRows.count(child->getId()) > 0) {
             // deletion of child
-            auto it = m_iteratorTable[child->getId()];
-            m_childItems.erase(it);
+            int row = m_childRows[child->getId()];
+            m_childItems.erase(m_childItems.begin() + row);
+            m_childRows.erase(child->getId());
+            updateRows(row);
         }
         ptr->notifyRowAboutToAppend(shared_from_this());
         child->updateParent(shared_from_this());
-        int id = child->getId();
-        auto pos = m_childItems.begin();
-        std::advance(pos, ix);
-        auto it = m_childItems.insert(pos, child);
-        m_iteratorTable[id] = it;
+        m_childItems.insert(m_childItems.begin() + ix, child);
+        updateRows(ix);
         ptr->notifyRowAppended(child);
         m_isInModel = true;
     } else {
@@ -128,13 +127,14 @@ void TreeItem::removeChild(const std::shared_ptr<TreeItem> &child)
 {
     if (auto ptr = m_model.lock()) {
         ptr->notifyRowAboutToDelete(shared_from_this(), child->row());
-        // get iterator corresponding to child
-        Q_ASSERT(m_iteratorTable.count(child->getId()) > 0);
-        auto it = m_iteratorTable[child->getId()];
+        // get row corresponding to child
+        Q_ASSERT(m_childRows.count(child->getId()) > 0);
+        int row = m_childRows[child->getId()];
         // deletion of child
-        m_childItems.erase(it);
-        // clean iterator table
-        m_iteratorTable.erase(child->getId());
+        m_childItems.erase(m_childItems.begin() + row);
+        // clean row table, and shift the following rows
+        m_childRows.erase(child->getId());
+        updateRows(row);
         child->m_depth = 0;
         child->m_parentItem.reset();
         child->deregisterSelf();
@@ -170,9 +170,7 @@ bool TreeItem::changeParent(std::shared_ptr<TreeItem> newParent)
 std::shared_ptr<TreeItem> TreeItem::child(int row) const
 {
     Q_ASSERT(row >= 0 && row < (int)m_childItems.size());
-    auto it = m_childItems.cbegin();
-    std::advance(it, row);
-    return (*it);
+    return m_childItems[(size_t)row];
 }
 
 int TreeItem::childCount() const
@@ -203,13 +201,18 @@ std::weak_ptr<TreeItem> TreeItem::parentItem() const
 int TreeItem::row() const
 {
     if (auto ptr = m_parentItem.lock()) {
-        // we compute the distance in the parent's children list
-        auto it = ptr->m_childItems.begin();
-        return (int)std::distance(it, (decltype(it))ptr->m_iteratorTable.at(m_id));
+        return ptr->m_childRows.at(m_id);
     }
     return -1;
 }
 
+void TreeItem::updateRows(int from)
+{
+    for (size_t i = (size_t)from; i < m_childItems.size(); ++i) {
+        m_childRows[m_childItems[i]->getId()] = (int)i;
+    }
+}
+
 int TreeItem::depth() const
 {
     return m_depth;
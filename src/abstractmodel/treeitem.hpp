@@ -27,6 +27,7 @@
 #include <QVariant>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 /* @brief This class is a generic class to represent items of a tree-like model
    It works in tandem with AbstractTreeModel or one of its derived classes.
@@ -155,9 +156,11 @@ protected:
     */
     virtual void updateParent(std::shared_ptr<TreeItem> parent);
 
-    std::list<std::shared_ptr<TreeItem>> m_childItems;
-    std::unordered_map<int, std::list<std::shared_ptr<TreeItem>>::iterator>
-        m_iteratorTable; // this logs the iterator associated which each child id. This allows easy access of a child based on its id.
+    /* @brief Refresh the row of the children, starting at the given row */
+    void updateRows(int from);
+
+    std::vector<std::shared_ptr<TreeItem>> m_childItems;
+    std::unordered_map<int, int> m_childRows; // this logs the row of each child id, so that row() doesn't have to walk the children
 
     QList<QVariant> m_itemData;
     std::weak_ptr<TreeItem> m_parentItem;
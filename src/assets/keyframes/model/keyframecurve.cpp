@@ -0,0 +1,225 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "keyframecurve.hpp"
+#include "rotoscoping/rotohelper.hpp"
+
+#include <QLineF>
+#include <QLocale>
+#include <QStringList>
+#include <algorithm>
+
+KeyframeCurve::KeyframeCurve(ValueType valueType, double fps)
+    : m_valueType(valueType)
+    , m_fps(fps)
+{
+}
+
+void KeyframeCurve::append(int frame, KeyframeType type, const QVariant &value)
+{
+    Q_ASSERT(m_frames.empty() || frame > m_frames.back());
+    m_frames.push_back(frame);
+    m_types.push_back(type);
+    m_values.push_back(value);
+    switch (m_valueType) {
+    case ValueType::Double:
+        m_doubles.push_back(value.toDouble());
+        break;
+    case ValueType::Rect:
+        m_rects.push_back(parseRect(value.toString()));
+        break;
+    case ValueType::Roto:
+        // Points are kept normalized, so that the curve doesn't depend on the frame size
+        m_points.push_back(RotoHelper::getPoints(value, QSize(1, 1)));
+        break;
+    }
+}
+
+KeyframeCurve::ValueType KeyframeCurve::valueType() const
+{
+    return m_valueType;
+}
+
+double KeyframeCurve::fps() const
+{
+    return m_fps;
+}
+
+int KeyframeCurve::count() const
+{
+    return (int)m_frames.size();
+}
+
+bool KeyframeCurve::isEmpty() const
+{
+    return m_frames.empty();
+}
+
+// static
+double KeyframeCurve::interpolate(KeyframeType type, double p0, double p1, double p2, double p3, double progress)
+{
+    switch (type) {
+    case KeyframeType::Discrete:
+        return p1;
+    case KeyframeType::Curve: {
+        // Catmull-Rom spline, same coefficients as mlt_property_interpolate
+        const double t2 = progress * progress;
+        const double a0 = -0.5 * p0 + 1.5 * p1 - 1.5 * p2 + 0.5 * p3;
+        const double a1 = p0 - 2.5 * p1 + 2 * p2 - 0.5 * p3;
+        const double a2 = -0.5 * p0 + 0.5 * p2;
+        return a0 * progress * t2 + a1 * t2 + a2 * progress + p1;
+    }
+    default:
+        return p1 + (p2 - p1) * progress;
+    }
+}
+
+// static
+mlt_rect KeyframeCurve::parseRect(const QString &value)
+{
+    mlt_rect rect{0, 0, 0, 0, 1};
+    const QStringList vals = value.split(QLatin1Char(' '), QString::SkipEmptyParts);
+    if (vals.count() >= 4) {
+        rect.x = vals.at(0).toDouble();
+        rect.y = vals.at(1).toDouble();
+        rect.w = vals.at(2).toDouble();
+        rect.h = vals.at(3).toDouble();
+        if (vals.count() > 4) {
+            rect.o = QLocale().toDouble(vals.at(4));
+        }
+    }
+    return rect;
+}
+
+// static
+QString KeyframeCurve::rectToString(const mlt_rect &rect)
+{
+    return QStringLiteral("%1 %2 %3 %4 %5").arg((int)rect.x).arg((int)rect.y).arg((int)rect.w).arg((int)rect.h).arg(QLocale().toString(rect.o));
+}
+
+int KeyframeCurve::segment(int frame) const
+{
+    auto it = std::upper_bound(m_frames.begin(), m_frames.end(), frame);
+    return int(it - m_frames.begin()) - 1;
+}
+
+double KeyframeCurve::doubleAt(int index, int frame) const
+{
+    const int last = count() - 1;
+    if (index < 0) {
+        return m_doubles.front();
+    }
+    if (index >= last || frame == m_frames[index]) {
+        return m_doubles[index];
+    }
+    const double progress = double(frame - m_frames[index]) / (m_frames[index + 1] - m_frames[index]);
+    const double p0 = m_doubles[index > 0 ? index - 1 : index];
+    const double p3 = m_doubles[index + 2 <= last ? index + 2 : index + 1];
+    return interpolate(m_types[index], p0, m_doubles[index], m_doubles[index + 1], p3, progress);
+}
+
+mlt_rect KeyframeCurve::rectAt(int index, int frame) const
+{
+    const int last = count() - 1;
+    if (index < 0) {
+        return m_rects.front();
+    }
+    if (index >= last || frame == m_frames[index]) {
+        return m_rects[index];
+    }
+    const double progress = double(frame - m_frames[index]) / (m_frames[index + 1] - m_frames[index]);
+    const mlt_rect &p0 = m_rects[index > 0 ? index - 1 : index];
+    const mlt_rect &p1 = m_rects[index];
+    const mlt_rect &p2 = m_rects[index + 1];
+    const mlt_rect &p3 = m_rects[index + 2 <= last ? index + 2 : index + 1];
+    const KeyframeType type = m_types[index];
+    mlt_rect rect;
+    rect.x = interpolate(type, p0.x, p1.x, p2.x, p3.x, progress);
+    rect.y = interpolate(type, p0.y, p1.y, p2.y, p3.y, progress);
+    rect.w = interpolate(type, p0.w, p1.w, p2.w, p3.w, progress);
+    rect.h = interpolate(type, p0.h, p1.h, p2.h, p3.h, progress);
+    rect.o = interpolate(type, p0.o, p1.o, p2.o, p3.o, progress);
+    return rect;
+}
+
+QVariant KeyframeCurve::rotoAt(int index, int frame) const
+{
+    const QList<BPoint> &p1 = m_points[index];
+    const QList<BPoint> &p2 = m_points[index + 1];
+    const qreal relPos = (frame - m_frames[index]) / (qreal)(m_frames[index + 1] - m_frames[index] + 1);
+    const int count = qMin(p1.count(), p2.count());
+    QList<QVariant> vlist;
+    vlist.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        QList<QVariant> pl;
+        for (int j = 0; j < 3; ++j) {
+            QPointF point = p1.at(i)[j];
+            if (point != p2.at(i)[j]) {
+                point = QLineF(point, p2.at(i)[j]).pointAt(relPos);
+            }
+            pl << QVariant(QList<QVariant>() << QVariant(point.x()) << QVariant(point.y()));
+        }
+        vlist << QVariant(pl);
+    }
+    return vlist;
+}
+
+QVariant KeyframeCurve::valueAt(int index, int frame) const
+{
+    if (index < 0) {
+        return m_values.front();
+    }
+    if (index >= count() - 1 || frame == m_frames[index]) {
+        return m_values[index];
+    }
+    switch (m_valueType) {
+    case ValueType::Double:
+        return QVariant(doubleAt(index, frame));
+    case ValueType::Rect:
+        return QVariant(rectToString(rectAt(index, frame)));
+    case ValueType::Roto:
+        return rotoAt(index, frame);
+    }
+    return QVariant();
+}
+
+QVariant KeyframeCurve::value(int frame) const
+{
+    if (isEmpty()) {
+        return QVariant();
+    }
+    return valueAt(segment(frame), frame);
+}
+
+double KeyframeCurve::doubleValue(int frame) const
+{
+    if (m_valueType != ValueType::Double || isEmpty()) {
+        return 0.;
+    }
+    return doubleAt(segment(frame), frame);
+}
+
+mlt_rect KeyframeCurve::rectValue(int frame) const
+{
+    if (m_valueType != ValueType::Rect || isEmpty()) {
+        return mlt_rect{0, 0, 0, 0, 1};
+    }
+    return rectAt(segment(frame), frame);
+}
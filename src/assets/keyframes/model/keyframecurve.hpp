@@ -0,0 +1,102 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef KEYFRAMECURVE_H
+#define KEYFRAMECURVE_H
+
+#include "assets/keyframes/model/keyframemodel.hpp"
+#include "assets/keyframes/model/rotoscoping/bpoint.h"
+
+#include <QList>
+#include <QVariant>
+#include <mlt++/MltProperties.h>
+#include <vector>
+
+/* @brief This class is a pre-parsed copy of the keyframes of a parameter, used to compute interpolated values.
+   Values are stored in their native form (double, rect or roto points) and interpolated with the same rules as MLT animations:
+   discrete keyframes hold their value, linear keyframes are linearly interpolated and curve keyframes use a Catmull-Rom spline
+   going through the surrounding keyframes. Before the first and after the last keyframe, the value of that keyframe is used.
+   Roto splines are interpolated linearly, as the rotoscoping filter does.
+   A curve is never modified once built, so it can be shared and evaluated from any thread.
+ */
+class KeyframeCurve
+{
+public:
+    enum class ValueType { Double, Rect, Roto };
+
+    /* @brief Builds an empty curve
+       @param valueType is the kind of values stored in the keyframes
+       @param fps is the frame rate that was used to convert the keyframe times to frames
+     */
+    KeyframeCurve(ValueType valueType, double fps);
+
+    /* @brief Adds a keyframe. Keyframes must be added in increasing frame order
+       @param value is the value as stored in the KeyframeModel: a double, a "x y w h opacity" string or a list of roto points
+     */
+    void append(int frame, KeyframeType type, const QVariant &value);
+
+    ValueType valueType() const;
+    double fps() const;
+    int count() const;
+    bool isEmpty() const;
+
+    /* @brief Returns the value at the given frame, in the format used by the KeyframeModel.
+       On a keyframe or outside of the keyframe range, the stored value is returned unchanged */
+    QVariant value(int frame) const;
+    /* @brief Returns the value of a double curve at the given frame */
+    double doubleValue(int frame) const;
+    /* @brief Returns the value of a rect curve at the given frame */
+    mlt_rect rectValue(int frame) const;
+
+    /* @brief Interpolates between p1 and p2 the way MLT does for the given keyframe type
+       @param p0 is the value of the keyframe before p1 (or p1 if there is none)
+       @param p3 is the value of the keyframe after p2 (or p2 if there is none)
+       @param progress is the position between p1 and p2, in [0, 1[
+     */
+    static double interpolate(KeyframeType type, double p0, double p1, double p2, double p3, double progress);
+
+    /* @brief Parses a rect keyframe value ("x y w h opacity", opacity is optional and defaults to 1) */
+    static mlt_rect parseRect(const QString &value);
+    /* @brief Formats a rect the way the KeyframeModel stores interpolated rects */
+    static QString rectToString(const mlt_rect &rect);
+
+protected:
+    /* @brief Returns the index of the last keyframe at or before frame, or -1 if frame is before the first keyframe */
+    int segment(int frame) const;
+    /* @brief Values of the keyframe segment starting at index, frame must be in [m_frames[index], m_frames[index + 1][ */
+    double doubleAt(int index, int frame) const;
+    mlt_rect rectAt(int index, int frame) const;
+    QVariant rotoAt(int index, int frame) const;
+    /* @brief Value of the frame in the KeyframeModel format, given the index of its segment */
+    QVariant valueAt(int index, int frame) const;
+
+    ValueType m_valueType;
+    double m_fps;
+    std::vector<int> m_frames;
+    std::vector<KeyframeType> m_types;
+    // Values as stored in the model
+    std::vector<QVariant> m_values;
+    // Parsed values, only the one matching m_valueType is filled
+    std::vector<double> m_doubles;
+    std::vector<mlt_rect> m_rects;
+    std::vector<QList<BPoint>> m_points;
+};
+
+#endif
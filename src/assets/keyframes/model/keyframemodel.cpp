@@ -22,6 +22,7 @@
 #include "keyframemodel.hpp"
 #include "core.h"
 #include "doc/docundostack.hpp"
+#include "keyframecurve.hpp"
 #include "macros.hpp"
 #include "profiles/profilemodel.hpp"
 #include "rotoscoping/bpoint.h"
@@ -419,6 +420,7 @@ Fun KeyframeModel::updateKeyframe_lambda(GenTime pos, KeyframeType type, const Q
         int row = static_cast<int>(std::distance(m_keyframeList.begin(), m_keyframeList.find(pos)));
         m_keyframeList[pos].first = type;
         m_keyframeList[pos].second = value;
+        invalidateCurve();
         if (notify) emit dataChanged(index(row), index(row), {ValueRole, NormalizedValueRole, TypeRole});
         return true;
     };
@@ -439,6 +441,7 @@ Fun KeyframeModel::addKeyframe_lambda(GenTime pos, KeyframeType type, const QVar
         if (notify) beginInsertRows(QModelIndex(), insertionRow, insertionRow);
         m_keyframeList[pos].first = type;
         m_keyframeList[pos].second = value;
+        invalidateCurve();
         if (notify) endInsertRows();
         return true;
     };
@@ -455,6 +458,7 @@ Fun KeyframeModel::deleteKeyframe_lambda(GenTime pos, bool notify)
         int row = static_cast<int>(std::distance(m_keyframeList.begin(), m_keyframeList.find(pos)));
         if (notify) beginRemoveRows(QModelIndex(), row, row);
         m_keyframeList.erase(pos);
+        invalidateCurve();
         if (notify) endRemoveRows();
         qDebug() << "after" << getAnimProperty();
         return true;
@@ -932,93 +936,34 @@ QVariant KeyframeModel::getNormalizedValue(double newVal) const
 
 QVariant KeyframeModel::getInterpolatedValue(const GenTime &pos) const
 {
-    if (m_keyframeList.count(pos) > 0) {
-        return m_keyframeList.at(pos).second;
-    }
-    if (m_keyframeList.size() == 0) {
-        return QVariant();
-    }
-    auto next = m_keyframeList.upper_bound(pos);
-    if (next == m_keyframeList.cbegin()) {
-        return (m_keyframeList.cbegin())->second.second;
-    } else if (next == m_keyframeList.cend()) {
-        auto it = m_keyframeList.cend();
-        --it;
-        return it->second.second;
-    }
-    auto prev = next;
-    --prev;
-    // We now have surrounding keyframes, we use mlt to compute the value
-    Mlt::Properties prop;
-    if (auto ptr = m_model.lock()) {
-        ptr->passProperties(prop);
+    return getCurve()->value(pos.frames(pCore->getCurrentFps()));
+}
+
+std::shared_ptr<const KeyframeCurve> KeyframeModel::getCurve() const
+{
+    const double fps = pCore->getCurrentFps();
+    QMutexLocker locker(&m_curveMutex);
+    if (m_curve && qFuzzyCompare(m_curve->fps(), fps)) {
+        return m_curve;
     }
-    QLocale locale;
-    int p = pos.frames(pCore->getCurrentFps());
-    if (m_paramType == ParamType::KeyframeParam) {
-        prop.anim_set("keyframe", prev->second.second.toDouble(), prev->first.frames(pCore->getCurrentFps()), next->first.frames(pCore->getCurrentFps()),
-                      convertToMltType(prev->second.first));
-        prop.anim_set("keyframe", next->second.second.toDouble(), next->first.frames(pCore->getCurrentFps()), next->first.frames(pCore->getCurrentFps()),
-                      convertToMltType(next->second.first));
-        return QVariant(prop.anim_get_double("keyframe", p));
-    } else if (m_paramType == ParamType::AnimatedRect) {
-        QStringList vals = prev->second.second.toString().split(QLatin1Char(' '));
-        if (vals.count() >= 4) {
-            mlt_rect rect;
-            rect.x = vals.at(0).toInt();
-            rect.y = vals.at(1).toInt();
-            rect.w = vals.at(2).toInt();
-            rect.h = vals.at(3).toInt();
-            if (vals.count() > 4) {
-                rect.o = locale.toDouble(vals.at(4));
-            } else {
-                rect.o = 1;
-            }
-            prop.anim_set("keyframe", rect, prev->first.frames(pCore->getCurrentFps()), next->first.frames(pCore->getCurrentFps()),
-                          convertToMltType(prev->second.first));
-        }
-        vals = next->second.second.toString().split(QLatin1Char(' '));
-        if (vals.count() >= 4) {
-            mlt_rect rect;
-            rect.x = vals.at(0).toInt();
-            rect.y = vals.at(1).toInt();
-            rect.w = vals.at(2).toInt();
-            rect.h = vals.at(3).toInt();
-            if (vals.count() > 4) {
-                rect.o = locale.toDouble(vals.at(4));
-            } else {
-                rect.o = 1;
-            }
-            prop.anim_set("keyframe", rect, next->first.frames(pCore->getCurrentFps()), next->first.frames(pCore->getCurrentFps()),
-                          convertToMltType(next->second.first));
-        }
-        mlt_rect rect = prop.anim_get_rect("keyframe", p);
-        const QString res = QStringLiteral("%1 %2 %3 %4 %5").arg((int)rect.x).arg((int)rect.y).arg((int)rect.w).arg((int)rect.h).arg(locale.toString(rect.o));
-        return QVariant(res);
+    KeyframeCurve::ValueType valueType = KeyframeCurve::ValueType::Double;
+    if (m_paramType == ParamType::AnimatedRect) {
+        valueType = KeyframeCurve::ValueType::Rect;
     } else if (m_paramType == ParamType::Roto_spline) {
-        // interpolate
-        QSize frame = pCore->getCurrentFrameSize();
-        QList<BPoint> p1 = RotoHelper::getPoints(prev->second.second, frame);
-        qreal relPos = (p - prev->first.frames(pCore->getCurrentFps())) / (qreal)(((next->first - prev->first).frames(pCore->getCurrentFps())) + 1);
-        QList<BPoint> p2 = RotoHelper::getPoints(next->second.second, frame);
-        int count = qMin(p1.count(), p2.count());
-        QList<QVariant> vlist;
-        for (int i = 0; i < count; ++i) {
-            BPoint bp;
-            QList<QVariant> pl;
-            for (int j = 0; j < 3; ++j) {
-                if (p1.at(i)[j] != p2.at(i)[j]) {
-                    bp[j] = QLineF(p1.at(i)[j], p2.at(i)[j]).pointAt(relPos);
-                } else {
-                    bp[j] = p1.at(i)[j];
-                }
-                pl << QVariant(QList<QVariant>() << QVariant(bp[j].x() / frame.width()) << QVariant(bp[j].y() / frame.height()));
-            }
-            vlist << QVariant(pl);
-        }
-        return vlist;
+        valueType = KeyframeCurve::ValueType::Roto;
     }
-    return QVariant();
+    auto curve = std::make_shared<KeyframeCurve>(valueType, fps);
+    for (const auto &keyframe : m_keyframeList) {
+        curve->append(keyframe.first.frames(fps), keyframe.second.first, keyframe.second.second);
+    }
+    m_curve = curve;
+    return m_curve;
+}
+
+void KeyframeModel::invalidateCurve()
+{
+    QMutexLocker locker(&m_curveMutex);
+    m_curve.reset();
 }
 
 void KeyframeModel::sendModification()
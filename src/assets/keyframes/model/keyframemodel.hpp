@@ -28,6 +28,7 @@
 #include "undohelper.hpp"
 
 #include <QAbstractListModel>
+#include <QMutex>
 #include <QReadWriteLock>
 
 #include <map>
@@ -36,6 +37,7 @@
 class AssetParameterModel;
 class DocUndoStack;
 class EffectItemModel;
+class KeyframeCurve;
 
 /* @brief This class is the model for a list of keyframes.
    A keyframe is defined by a time, a type and a value
@@ -60,6 +62,10 @@ public:
                            QObject *parent = nullptr);
 
     enum { TypeRole = Qt::UserRole + 1, PosRole, FrameRole, ValueRole, NormalizedValueRole };
+
+    /* @brief Returns a pre-parsed snapshot of the keyframes, that computes interpolated values without going through MLT.
+       It is rebuilt on the first call following a modification of the keyframes. Use it to evaluate many frames at once (drawing, export) */
+    std::shared_ptr<const KeyframeCurve> getCurve() const;
     friend class KeyframeModelList;
     friend class KeyframeWidget;
     friend class KeyframeImport;
@@ -183,6 +189,9 @@ protected:
     /* @brief Commit the modification to the model */
     void sendModification();
 
+    /* @brief Drop the cached curve, must be called after each change of m_keyframeList */
+    void invalidateCurve();
+
     /** @brief returns the keyframes as a Mlt Anim Property string.
         It is defined as pairs of frame and value, separated by ;
         Example : "0|=50; 50|=100; 100=200; 200~=60;"
@@ -207,6 +216,9 @@ private:
     mutable QReadWriteLock m_lock; // This is a lock that ensures safety in case of concurrent access
 
     std::map<GenTime, std::pair<KeyframeType, QVariant>> m_keyframeList;
+    // Cached pre-parsed keyframes, reset each time m_keyframeList changes
+    mutable QMutex m_curveMutex;
+    mutable std::shared_ptr<const KeyframeCurve> m_curve;
 
 signals:
     void modelChanged();
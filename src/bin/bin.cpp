@@ -69,6 +69,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QDrag>
 #include <QFile>
 #include <QMenu>
+#include <QScrollBar>
 #include <QSlider>
 #include <QTimeLine>
 #include <QUndoCommand>
@@ -629,6 +630,11 @@ Bin::Bin(std::shared_ptr<ProjectItemModel> model, QWidget *parent)
     m_proxyModel->setSourceModel(m_itemModel.get());
     connect(m_itemModel.get(), &QAbstractItemModel::dataChanged, m_proxyModel, &ProjectSortProxyModel::slotDataChanged);
     connect(m_proxyModel, &ProjectSortProxyModel::selectModel, this, &Bin::selectProxyModel);
+    m_visibleClipsTimer.setSingleShot(true);
+    m_visibleClipsTimer.setInterval(200);
+    connect(&m_visibleClipsTimer, &QTimer::timeout, this, &Bin::updateVisibleClips);
+    connect(m_proxyModel, &QAbstractItemModel::rowsInserted, &m_visibleClipsTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(m_proxyModel, &QAbstractItemModel::layoutChanged, &m_visibleClipsTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
     connect(m_itemModel.get(), static_cast<void (ProjectItemModel::*)(const QStringList &, const QModelIndex &)>(&ProjectItemModel::itemDropped), this,
             static_cast<void (Bin::*)(const QStringList &, const QModelIndex &)>(&Bin::slotItemDropped));
     connect(m_itemModel.get(), static_cast<void (ProjectItemModel::*)(const QList<QUrl> &, const QModelIndex &)>(&ProjectItemModel::itemDropped), this,
@@ -1260,6 +1266,7 @@ void Bin::selectProxyModel(const QModelIndex &id)
         if (currentItem) {
             // Set item as current so that it displays its content in clip monitor
             setCurrent(currentItem);
+            m_visibleClipsTimer.start();
             if (currentItem->itemType() == AbstractProjectItem::ClipItem) {
                 m_reloadAction->setEnabled(true);
                 m_locateAction->setEnabled(true);
@@ -1420,6 +1427,7 @@ void Bin::slotInitView(QAction *action)
         connect(view->header(), &QHeaderView::sectionResized, this, &Bin::slotSaveHeaders);
         connect(view->header(), &QHeaderView::sectionClicked, this, &Bin::slotSaveHeaders);
         connect(view, &MyTreeView::focusView, this, &Bin::slotGotFocus);
+        connect(view, &QTreeView::expanded, &m_visibleClipsTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
     } else if (m_listType == BinIconView) {
         auto *view = static_cast<MyListView *>(m_itemView);
         connect(view, &MyListView::focusView, this, &Bin::slotGotFocus);
@@ -1430,6 +1438,41 @@ void Bin::slotInitView(QAction *action)
     m_itemView->setAlternatingRowColors(true);
     m_itemView->setAcceptDrops(true);
     m_itemView->setFocus();
+    connect(m_itemView->verticalScrollBar(), &QScrollBar::valueChanged, &m_visibleClipsTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    m_visibleClipsTimer.start();
+}
+
+void Bin::updateVisibleClips()
+{
+    if (!m_itemView) {
+        return;
+    }
+    QSet<QString> visible;
+    const QRect viewRect = m_itemView->viewport()->rect();
+    auto *treeView = m_listType == BinTreeView ? static_cast<QTreeView *>(m_itemView) : nullptr;
+    std::function<void(const QModelIndex &)> collect = [&](const QModelIndex &parent) {
+        for (int row = 0; row < m_proxyModel->rowCount(parent); ++row) {
+            const QModelIndex ix = m_proxyModel->index(row, 0, parent);
+            if (m_itemView->visualRect(ix).intersects(viewRect)) {
+                std::shared_ptr<AbstractProjectItem> item = m_itemModel->getBinItemByIndex(m_proxyModel->mapToSource(ix));
+                if (item && item->itemType() == AbstractProjectItem::ClipItem) {
+                    visible.insert(item->clipId());
+                }
+            }
+            if (treeView && treeView->isExpanded(ix)) {
+                collect(ix);
+            }
+        }
+    };
+    collect(m_itemView->rootIndex());
+    if (m_monitor) {
+        // The clip displayed in the clip monitor is also visible
+        const QString activeId = m_monitor->activeClipId();
+        if (!activeId.isEmpty()) {
+            visible.insert(activeId);
+        }
+    }
+    pCore->jobManager()->setVisibleClips(visible);
 }
 
 void Bin::slotSetIconSize(int size)
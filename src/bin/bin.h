@@ -38,6 +38,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QPainter>
 #include <QPushButton>
 #include <QStyledItemDelegate>
+#include <QTimer>
 #include <QTreeView>
 #include <QUrl>
 #include <QWidget>
@@ -205,9 +206,6 @@ public:
 
     const QString getDocumentProperty(const QString &key);
 
-    /** @brief Ask MLT to reload this clip's producer  */
-    void reloadClip(const QString &id);
-
     /** @brief refresh monitor (if clip changed)  */
     void reloadMonitorIfActive(const QString &id);
 
@@ -314,8 +312,12 @@ private slots:
      *  this is a workaround foq Qt bug 54676
      */
     void showClearButton(bool show);
+    /** @brief Let the job manager process the clips displayed in the view first */
+    void updateVisibleClips();
 
 public slots:
+    /** @brief Ask MLT to reload this clip's producer  */
+    void reloadClip(const QString &id);
     void slotRemoveInvalidClip(const QString &id, bool replace, const QString &errorMessage);
     /** @brief Reload clip thumbnail - when frame for thumbnail changed */
     void slotRefreshClipThumbnail(const QString &id);
@@ -434,6 +436,8 @@ private:
     long m_processedAudio;
     /** @brief Indicates whether audio thumbnail creation is running. */
     QFuture<void> m_audioThumbsThread;
+    /** @brief Delays the visible clips update while scrolling. */
+    QTimer m_visibleClipsTimer;
     void showClipProperties(const std::shared_ptr<ProjectClip> &clip, bool forceRefresh = false);
     /** @brief Get the QModelIndex value for an item in the Bin. */
     QModelIndex getIndexForId(const QString &id, bool folderWanted) const;
@@ -32,6 +32,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "jobs/thumbjob.hpp"
 #include "jobs/audiothumbjob.hpp"
 #include "kdenlivesettings.h"
+#include "lib/audio/audioPeaks.h"
 #include "lib/audio/audioStreamInfo.h"
 #include "mltcontroller/clipcontroller.h"
 #include "mltcontroller/clippropertiescontroller.h"
@@ -44,6 +45,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "projectsubclip.h"
 #include "timecode.h"
 #include "timeline2/model/snapmodel.hpp"
+#include "utils/filehashcache.hpp"
 
 #include "utils/thumbnailcache.hpp"
 #include "xml/xml.hpp"
@@ -194,9 +196,10 @@ QString ProjectClip::getXmlProperty(const QDomElement &producer, const QString &
     return value;
 }
 
-void ProjectClip::updateAudioThumbnail(QList <double>audioLevels)
+void ProjectClip::updateAudioThumbnail(QList <double>audioLevels, std::shared_ptr<AudioPeaks> peaks)
 {
     audioFrameCache = audioLevels;
+    m_audioPeaks = std::move(peaks);
     m_audioThumbCreated = true;
     if (auto ptr = m_model.lock()) {
         emit std::static_pointer_cast<ProjectItemModel>(ptr)->refreshAudioThumbs(m_binId);
@@ -210,6 +213,11 @@ bool ProjectClip::audioThumbCreated() const
     return (m_audioThumbCreated);
 }
 
+std::shared_ptr<AudioPeaks> ProjectClip::audioPeaks() const
+{
+    return m_audioPeaks;
+}
+
 ClipType::ProducerType ProjectClip::clipType() const
 {
     return m_clipType;
@@ -314,6 +322,7 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool audioStreamChanged)
         ThumbnailCache::get()->invalidateThumbsForClip(clipId());
         pCore->jobManager()->discardJobs(clipId(), AbstractClipJob::THUMBJOB);
         m_thumbsProducer.reset();
+        m_thumbsGeneration++;
         pCore->jobManager()->startJob<ThumbJob>({clipId()}, loadjobId, QString(), 150, -1, true, true);
     } else {
         // If another load job is running?
@@ -325,6 +334,7 @@ void ProjectClip::reloadProducer(bool refreshOnly, bool audioStreamChanged)
         if (!xml.isNull()) {
             pCore->jobManager()->discardJobs(clipId(), AbstractClipJob::THUMBJOB);
             m_thumbsProducer.reset();
+            m_thumbsGeneration++;
             ThumbnailCache::get()->invalidateThumbsForClip(clipId());
             int loadJob = pCore->jobManager()->startJob<LoadJob>({clipId()}, loadjobId, QString(), xml);
             pCore->jobManager()->startJob<ThumbJob>({clipId()}, loadJob, QString(), 150, -1, true, true);
@@ -398,6 +408,7 @@ bool ProjectClip::setProducer(std::shared_ptr<Mlt::Producer> producer, bool repl
     QMutexLocker locker(&m_producerMutex);
     updateProducer(producer);
     m_thumbsProducer.reset();
+    m_thumbsGeneration++;
     connectEffectStack();
 
     // Update info
@@ -498,36 +509,57 @@ std::shared_ptr<Mlt::Producer> ProjectClip::thumbProducer()
         return nullptr;
     }
     QMutexLocker lock(&m_thumbMutex);
+    m_thumbsProducer = buildThumbProducer();
+    return m_thumbsProducer;
+}
+
+std::shared_ptr<Mlt::Producer> ProjectClip::createThumbProducer()
+{
+    if (clipType() == ClipType::Unknown) {
+        return nullptr;
+    }
+    QMutexLocker lock(&m_thumbMutex);
+    return buildThumbProducer();
+}
+
+int ProjectClip::thumbProducerGeneration() const
+{
+    return m_thumbsGeneration;
+}
+
+std::shared_ptr<Mlt::Producer> ProjectClip::buildThumbProducer()
+{
     std::shared_ptr<Mlt::Producer> prod = originalProducer();
     if (!prod->is_valid()) {
         return nullptr;
     }
+    std::shared_ptr<Mlt::Producer> thumbProd;
     if (KdenliveSettings::gpu_accel()) {
         // TODO: when the original producer changes, we must reload this thumb producer
-        m_thumbsProducer = softClone(ClipController::getPassPropertiesList());
+        thumbProd = softClone(ClipController::getPassPropertiesList());
         Mlt::Filter converter(*prod->profile(), "avcolor_space");
-        m_thumbsProducer->attach(converter);
+        thumbProd->attach(converter);
     } else {
         QString mltService = m_masterProducer->get("mlt_service");
         const QString mltResource = m_masterProducer->get("resource");
         if (mltService == QLatin1String("avformat")) {
             mltService = QStringLiteral("avformat-novalidate");
         }
-        m_thumbsProducer.reset(new Mlt::Producer(*pCore->thumbProfile(), mltService.toUtf8().constData(), mltResource.toUtf8().constData()));
-        if (m_thumbsProducer->is_valid()) {
+        thumbProd.reset(new Mlt::Producer(*pCore->thumbProfile(), mltService.toUtf8().constData(), mltResource.toUtf8().constData()));
+        if (thumbProd->is_valid()) {
             Mlt::Properties original(m_masterProducer->get_properties());
-            Mlt::Properties cloneProps(m_thumbsProducer->get_properties());
+            Mlt::Properties cloneProps(thumbProd->get_properties());
             cloneProps.pass_list(original, ClipController::getPassPropertiesList());
             Mlt::Filter scaler(*pCore->thumbProfile(), "swscale");
             Mlt::Filter padder(*pCore->thumbProfile(), "resize");
             Mlt::Filter converter(*pCore->thumbProfile(), "avcolor_space");
-            m_thumbsProducer->set("audio_index", -1);
-            m_thumbsProducer->attach(scaler);
-            m_thumbsProducer->attach(padder);
-            m_thumbsProducer->attach(converter);
+            thumbProd->set("audio_index", -1);
+            thumbProd->attach(scaler);
+            thumbProd->attach(padder);
+            thumbProd->attach(converter);
         }
     }
-    return m_thumbsProducer;
+    return thumbProd;
 }
 
 void ProjectClip::createDisabledMasterProducer()
@@ -882,27 +914,17 @@ const QString ProjectClip::getFileHash()
         fileData = getProducerProperty(QStringLiteral("resource")).toUtf8();
         fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
         break;
-    default:
-        QFile file(clipUrl());
-        if (file.open(QIODevice::ReadOnly)) { // write size and hash only if resource points to a file
-            /*
-             * 1 MB = 1 second per 450 files (or faster)
-             * 10 MB = 9 seconds per 450 files (or faster)
-             */
-            if (file.size() > 2000000) {
-                fileData = file.read(1000000);
-                if (file.seek(file.size() - 1000000)) {
-                    fileData.append(file.readAll());
-                }
-            } else {
-                fileData = file.readAll();
-            }
-            file.close();
-            ClipController::setProducerProperty(QStringLiteral("kdenlive:file_size"), QString::number(file.size()));
-            fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
+    default: {
+        // write size and hash only if resource points to a file
+        qint64 size = 0;
+        const QString result = FileHashCache::get()->hash(clipUrl(), &size);
+        if (!result.isEmpty()) {
+            ClipController::setProducerProperty(QStringLiteral("kdenlive:file_size"), QString::number(size));
+            fileHash = QByteArray::fromHex(result.toLatin1());
         }
         break;
     }
+    }
     if (fileHash.isEmpty()) {
         qDebug() << "// WARNING EMPTY CLIP HASH: ";
         return QString();
@@ -1167,26 +1189,19 @@ void ProjectClip::doExtractImage()
         return;
     }
     int frameWidth = 150 * prod->profile()->dar() + 0.5;
-    bool ok = false;
     auto ptr = m_model.lock();
     Q_ASSERT(ptr);
-    QDir thumbFolder = pCore->currentDoc()->getCacheDir(CacheThumbs, &ok);
     int max = prod->get_length();
     while (!m_requestedThumbs.isEmpty()) {
         m_thumbMutex.lock();
         int pos = m_requestedThumbs.takeFirst();
         m_thumbMutex.unlock();
-        if (ok && thumbFolder.exists(hash() + QLatin1Char('#') + QString::number(pos) + QStringLiteral(".png"))) {
-            emit thumbReady(pos, QImage(thumbFolder.absoluteFilePath(hash() + QLatin1Char('#') + QString::number(pos) + QStringLiteral(".png"))));
-            continue;
-        }
         if (pos >= max) {
             pos = max - 1;
         }
-        const QString path = url() + QLatin1Char('_') + QString::number(pos);
         QImage img;
-        if (ThumbnailCache::get()->hasThumbnail(clipId(), pos, true)) {
-            img = ThumbnailCache::get()->getThumbnail(clipId(), pos, true);
+        if (ThumbnailCache::get()->hasThumbnail(clipId(), pos)) {
+            img = ThumbnailCache::get()->getThumbnail(clipId(), pos);
         }
         if (!img.isNull()) {
             emit thumbReady(pos, img);
@@ -1220,6 +1235,7 @@ void ProjectClip::discardAudioThumb()
         QFile::remove(audioThumbPath);
     }
     audioFrameCache.clear();
+    m_audioPeaks.reset();
     qCDebug(KDENLIVE_LOG) << "////////////////////  DISCARD AUIIO THUMBNS";
     m_audioThumbCreated = false;
     refreshAudioInfo();
@@ -1245,8 +1261,8 @@ const QString ProjectClip::getAudioThumbPath()
     if (audioStream > 0) {
         audioPath.append(QLatin1Char('_') + QString::number(audioInfo()->audio_index()));
     }
-    int roundedFps = (int)pCore->getCurrentFps();
-    audioPath.append(QStringLiteral("_%1_audio.png").arg(roundedFps));
+    // Peaks are stored per sample, so they don't depend on the project fps
+    audioPath.append(QStringLiteral("_audio.peaks"));
     return audioPath;
 }
 
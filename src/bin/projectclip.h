@@ -31,8 +31,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QFuture>
 #include <QMutex>
 #include <QUrl>
+#include <atomic>
 #include <memory>
 
+class AudioPeaks;
 class AudioStreamInfo;
 class ClipPropertiesController;
 class MarkerListModel;
@@ -152,6 +154,10 @@ public:
 
     /** @brief Returns this clip's producer. */
     std::shared_ptr<Mlt::Producer> thumbProducer();
+    /** @brief Returns a new thumbnail producer, not shared with the other thumbnail users. */
+    std::shared_ptr<Mlt::Producer> createThumbProducer();
+    /** @brief Incremented each time the thumbnail producers become obsolete (clip reloaded). */
+    int thumbProducerGeneration() const;
 
     /** @brief Recursively disable/enable bin effects. */
     void setBinEffectsEnabled(bool enabled) override;
@@ -174,6 +180,8 @@ public:
     /** format is frame -> channel ->bytes */
     QList <double>audioFrameCache;
     bool audioThumbCreated() const;
+    /** @brief Returns the multi resolution audio peaks used to draw the timeline waveform, or nullptr if not computed yet */
+    std::shared_ptr<AudioPeaks> audioPeaks() const;
 
     void setWaitingStatus(const QString &id);
     /** @brief Returns true if the clip matched a condition, for example vcodec=mpeg1video. */
@@ -244,7 +252,7 @@ protected:
 public slots:
     /* @brief Store the audio thumbnails once computed. Note that the parameter is a value and not a reference, fill free to use it as a sink (use std::move to
      * avoid copy). */
-    void updateAudioThumbnail(QList <double>audioLevels);
+    void updateAudioThumbnail(QList <double>audioLevels, std::shared_ptr<AudioPeaks> peaks = nullptr);
     /** @brief Extract image thumbnails for timeline. */
     void slotExtractImage(const QList<int> &frames);
     /** @brief Delete the proxy file */
@@ -256,12 +264,16 @@ private:
     /** @brief Store clip url temporarily while the clip controller has not been created. */
     QString m_temporaryUrl;
     std::shared_ptr<Mlt::Producer> m_thumbsProducer;
+    std::shared_ptr<AudioPeaks> m_audioPeaks;
     QMutex m_producerMutex;
     QMutex m_thumbMutex;
     QFuture<void> m_thumbThread;
     QList<int> m_requestedThumbs;
+    std::atomic<int> m_thumbsGeneration{0};
     const QString geometryWithOffset(const QString &data, int offset);
     void doExtractImage();
+    // Build a thumbnail producer. Must be called with m_thumbMutex held
+    std::shared_ptr<Mlt::Producer> buildThumbProducer();
 
     // This is a helper function that creates the disabled producer. This is a clone of the original one, with audio and video disabled
     void createDisabledMasterProducer();
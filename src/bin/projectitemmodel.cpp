@@ -332,29 +332,31 @@ std::shared_ptr<ProjectClip> ProjectItemModel::getClipByBinID(const QString &bin
     if (binId.contains(QLatin1Char('_'))) {
         return getClipByBinID(binId.section(QLatin1Char('_'), 0, 0));
     }
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::ClipItem && c->clipId() == binId) {
-            return std::static_pointer_cast<ProjectClip>(c);
-        }
+    auto c = getItemByBinId(binId);
+    if (c && c->itemType() == AbstractProjectItem::ClipItem) {
+        return std::static_pointer_cast<ProjectClip>(c);
     }
     return nullptr;
 }
 
 const QList<double> ProjectItemModel::getAudioLevelsByBinID(const QString &binId)
 {
-    if (binId.contains(QLatin1Char('_'))) {
-        return getAudioLevelsByBinID(binId.section(QLatin1Char('_'), 0, 0));
-    }
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::ClipItem && c->clipId() == binId) {
-            return std::static_pointer_cast<ProjectClip>(c)->audioFrameCache;
-        }
+    std::shared_ptr<ProjectClip> clip = getClipByBinID(binId);
+    if (clip) {
+        return clip->audioFrameCache;
     }
     return QList<double>();
 }
 
+std::shared_ptr<AudioPeaks> ProjectItemModel::getAudioPeaksByBinID(const QString &binId)
+{
+    std::shared_ptr<ProjectClip> clip = getClipByBinID(binId);
+    if (clip) {
+        return clip->audioPeaks();
+    }
+    return nullptr;
+}
+
 bool ProjectItemModel::hasClip(const QString &binId)
 {
     return getClipByBinID(binId) != nullptr;
@@ -362,35 +364,39 @@ bool ProjectItemModel::hasClip(const QString &binId)
 
 std::shared_ptr<ProjectFolder> ProjectItemModel::getFolderByBinId(const QString &binId)
 {
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::FolderItem && c->clipId() == binId) {
-            return std::static_pointer_cast<ProjectFolder>(c);
-        }
+    auto c = getItemByBinId(binId);
+    if (c && c->itemType() == AbstractProjectItem::FolderItem) {
+        return std::static_pointer_cast<ProjectFolder>(c);
     }
     return nullptr;
 }
 
 const QString ProjectItemModel::getFolderIdByName(const QString &folderName)
 {
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::FolderItem && c->name() == folderName) {
-            return c->clipId();
-        }
+    QReadLocker locker(&m_indexLock);
+    auto it = m_folderIndex.find(folderName);
+    if (it == m_folderIndex.end() || it->second.empty()) {
+        return QString();
     }
-    return QString();
+    return *it->second.begin();
 }
 
 std::shared_ptr<AbstractProjectItem> ProjectItemModel::getItemByBinId(const QString &binId)
 {
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->clipId() == binId) {
-            return c;
+    int itemId;
+    {
+        QReadLocker locker(&m_indexLock);
+        auto it = m_binIdIndex.find(binId);
+        if (it == m_binIdIndex.end()) {
+            return nullptr;
         }
+        itemId = it->second;
     }
-    return nullptr;
+    auto it = m_allItems.find(itemId);
+    if (it == m_allItems.end()) {
+        return nullptr;
+    }
+    return std::static_pointer_cast<AbstractProjectItem>(it->second.lock());
 }
 
 void ProjectItemModel::setBinEffectsEnabled(bool enabled)
@@ -501,6 +507,7 @@ void ProjectItemModel::registerItem(const std::shared_ptr<TreeItem> &item)
     auto clip = std::static_pointer_cast<AbstractProjectItem>(item);
     m_binPlaylist->manageBinItemInsertion(clip);
     AbstractTreeModel::registerItem(item);
+    indexItem(clip);
     if (clip->itemType() == AbstractProjectItem::ClipItem) {
         auto clipItem = std::static_pointer_cast<ProjectClip>(clip);
         updateWatcher(clipItem);
@@ -511,6 +518,7 @@ void ProjectItemModel::deregisterItem(int id, TreeItem *item)
     auto clip = static_cast<AbstractProjectItem *>(item);
     m_binPlaylist->manageBinItemDeletion(clip);
     // TODO : here, we should suspend jobs belonging to the item we delete. They can be restarted if the item is reinserted by undo
+    unindexItem(clip);
     AbstractTreeModel::deregisterItem(id, item);
     if (clip->itemType() == AbstractProjectItem::ClipItem) {
         auto clipItem = static_cast<ProjectClip *>(clip);
@@ -518,6 +526,130 @@ void ProjectItemModel::deregisterItem(int id, TreeItem *item)
     }
 }
 
+void ProjectItemModel::indexItem(const std::shared_ptr<AbstractProjectItem> &item)
+{
+    QWriteLocker locker(&m_indexLock);
+    m_binIdIndex[item->clipId()] = item->getId();
+    if (item->itemType() == AbstractProjectItem::FolderItem) {
+        m_folderIndex[item->name()].insert(item->clipId());
+    }
+}
+
+void ProjectItemModel::unindexItem(AbstractProjectItem *item)
+{
+    QWriteLocker locker(&m_indexLock);
+    const QString &binId = item->clipId();
+    auto it = m_binIdIndex.find(binId);
+    if (it != m_binIdIndex.end() && it->second == item->getId()) {
+        m_binIdIndex.erase(it);
+    }
+    if (item->itemType() == AbstractProjectItem::FolderItem) {
+        auto folder = m_folderIndex.find(item->name());
+        if (folder != m_folderIndex.end()) {
+            folder->second.erase(binId);
+            if (folder->second.empty()) {
+                m_folderIndex.erase(folder);
+            }
+        }
+    } else if (item->itemType() == AbstractProjectItem::ClipItem) {
+        auto url = m_clipUrls.find(binId);
+        if (url != m_clipUrls.end()) {
+            auto clips = m_urlIndex.find(url->second);
+            if (clips != m_urlIndex.end()) {
+                clips->second.erase(binId);
+                if (clips->second.empty()) {
+                    m_urlIndex.erase(clips);
+                }
+            }
+            m_clipUrls.erase(url);
+        }
+    }
+}
+
+QString ProjectItemModel::urlKey(const QFileInfo &url)
+{
+    // Mimic QFileInfo's comparison: use the canonical path when the file exists
+    QString key = url.canonicalFilePath();
+    if (key.isEmpty()) {
+        key = url.absoluteFilePath();
+    }
+    return key;
+}
+
+void ProjectItemModel::indexClipUrl(const QString &binId, const QString &url)
+{
+    QString key = url.isEmpty() ? QString() : urlKey(QFileInfo(url));
+    QWriteLocker locker(&m_indexLock);
+    auto current = m_clipUrls.find(binId);
+    if (current != m_clipUrls.end()) {
+        if (current->second == key) {
+            return;
+        }
+        auto clips = m_urlIndex.find(current->second);
+        if (clips != m_urlIndex.end()) {
+            clips->second.erase(binId);
+            if (clips->second.empty()) {
+                m_urlIndex.erase(clips);
+            }
+        }
+        m_clipUrls.erase(current);
+    }
+    if (!key.isEmpty()) {
+        m_clipUrls[binId] = key;
+        m_urlIndex[key].insert(binId);
+    }
+}
+
+void ProjectItemModel::indexFolderName(const QString &binId, const QString &oldName, const QString &newName)
+{
+    QWriteLocker locker(&m_indexLock);
+    auto folder = m_folderIndex.find(oldName);
+    if (folder != m_folderIndex.end()) {
+        folder->second.erase(binId);
+        if (folder->second.empty()) {
+            m_folderIndex.erase(folder);
+        }
+    }
+    m_folderIndex[newName].insert(binId);
+}
+
+bool ProjectItemModel::checkIndexConsistency() const
+{
+    QReadLocker locker(&m_indexLock);
+    size_t folders = 0;
+    for (const auto &item : m_allItems) {
+        auto c = std::static_pointer_cast<AbstractProjectItem>(item.second.lock());
+        auto it = m_binIdIndex.find(c->clipId());
+        if (it == m_binIdIndex.end() || it->second != c->getId()) {
+            qDebug() << "ERROR: bin id" << c->clipId() << "is not correctly indexed";
+            return false;
+        }
+        if (c->itemType() == AbstractProjectItem::FolderItem) {
+            auto folder = m_folderIndex.find(c->name());
+            if (folder == m_folderIndex.end() || folder->second.count(c->clipId()) == 0) {
+                qDebug() << "ERROR: folder" << c->name() << "is not correctly indexed";
+                return false;
+            }
+            ++folders;
+        } else if (c->itemType() == AbstractProjectItem::ClipItem) {
+            auto url = m_clipUrls.find(c->clipId());
+            if (url != m_clipUrls.end() && m_urlIndex.at(url->second).count(c->clipId()) == 0) {
+                qDebug() << "ERROR: url of clip" << c->clipId() << "is not correctly indexed";
+                return false;
+            }
+        }
+    }
+    size_t indexedFolders = 0;
+    for (const auto &folder : m_folderIndex) {
+        indexedFolders += folder.second.size();
+    }
+    size_t indexedUrls = 0;
+    for (const auto &url : m_urlIndex) {
+        indexedUrls += url.second.size();
+    }
+    return m_binIdIndex.size() == m_allItems.size() && indexedFolders == folders && indexedUrls == m_clipUrls.size();
+}
+
 int ProjectItemModel::getFreeFolderId()
 {
     while (!isIdFree(QString::number(++m_nextId))) {
@@ -673,7 +805,9 @@ Fun ProjectItemModel::requestRenameFolder_lambda(const std::shared_ptr<AbstractP
         if (!currentFolder) {
             return false;
         }
+        QString oldName = currentFolder->name();
         currentFolder->setName(newName);
+        indexFolderName(currentFolder->clipId(), oldName, newName);
         m_binPlaylist->manageBinFolderRename(currentFolder);
         auto index = getIndexFromItem(currentFolder);
         emit dataChanged(index, index, {AbstractProjectItem::DataName});
@@ -747,12 +881,12 @@ std::vector<QString> ProjectItemModel::getAllClipIds() const
 QStringList ProjectItemModel::getClipByUrl(const QFileInfo &url) const
 {
     QStringList result;
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->itemType() == AbstractProjectItem::ClipItem) {
-            if (QFileInfo(std::static_pointer_cast<ProjectClip>(c)->clipUrl()) == url) {
-                result << c->clipId();
-            }
+    QString key = urlKey(url);
+    QReadLocker locker(&m_indexLock);
+    auto it = m_urlIndex.find(key);
+    if (it != m_urlIndex.end()) {
+        for (const QString &binId : it->second) {
+            result << binId;
         }
     }
     return result;
@@ -825,13 +959,8 @@ bool ProjectItemModel::loadFolders(Mlt::Properties &folders)
 
 bool ProjectItemModel::isIdFree(const QString &id) const
 {
-    for (const auto &clip : m_allItems) {
-        auto c = std::static_pointer_cast<AbstractProjectItem>(clip.second.lock());
-        if (c->clipId() == id) {
-            return false;
-        }
-    }
-    return true;
+    QReadLocker locker(&m_indexLock);
+    return m_binIdIndex.count(id) == 0;
 }
 
 void ProjectItemModel::loadBinPlaylist(Mlt::Tractor *documentTractor, Mlt::Tractor *modelTractor, std::unordered_map<QString, QString> &binIdCorresp)
@@ -949,6 +1078,7 @@ void ProjectItemModel::setClipInvalid(const QString &binId)
 
 void ProjectItemModel::updateWatcher(const std::shared_ptr<ProjectClip> &clipItem)
 {
+    indexClipUrl(clipItem->clipId(), clipItem->clipUrl());
     if (clipItem->clipType() == ClipType::AV || clipItem->clipType() == ClipType::Audio || clipItem->clipType() == ClipType::Image ||
         clipItem->clipType() == ClipType::Video || clipItem->clipType() == ClipType::Playlist || clipItem->clipType() == ClipType::TextTemplate) {
         m_fileWatcher->removeFile(clipItem->clipId());
@@ -32,8 +32,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <QIcon>
 #include <QReadWriteLock>
 #include <QSize>
+#include <unordered_map>
+#include <unordered_set>
 
 class AbstractProjectItem;
+class AudioPeaks;
 class BinPlaylist;
 class FileWatcher;
 class MarkerListModel;
@@ -68,6 +71,8 @@ public:
     std::shared_ptr<ProjectClip> getClipByBinID(const QString &binId);
     /** @brief Returns audio levels for a clip from its id */
     const QList <double>getAudioLevelsByBinID(const QString &binId);
+    /** @brief Returns the audio peaks of a clip from its id, used to draw the timeline waveform */
+    std::shared_ptr<AudioPeaks> getAudioPeaksByBinID(const QString &binId);
 
     /** @brief Returns a list of clips using the given url */
     QStringList getClipByUrl(const QFileInfo &url) const;
@@ -207,6 +212,9 @@ public:
     /** @brief Number of clips in the bin playlist */
     int clipsCount() const;
 
+    /** @brief Check that the lookup indexes are consistent with the registered items (used for testing) */
+    bool checkIndexConsistency() const;
+
 protected:
     /* @brief Register the existence of a new element
      */
@@ -223,6 +231,14 @@ protected:
     /* @brief Function to be called when the url of a clip changes */
     void updateWatcher(const std::shared_ptr<ProjectClip> &item);
 
+    /* @brief Helpers maintaining the lookup indexes (bin id, url, folder name) on insertion/deletion/change of an item */
+    void indexItem(const std::shared_ptr<AbstractProjectItem> &item);
+    void unindexItem(AbstractProjectItem *item);
+    void indexClipUrl(const QString &binId, const QString &url);
+    void indexFolderName(const QString &binId, const QString &oldName, const QString &newName);
+    /* @brief Returns the key used to index a clip url */
+    static QString urlKey(const QFileInfo &url);
+
 public slots:
     /** @brief An item in the list was modified, notify */
     void onItemUpdated(const std::shared_ptr<AbstractProjectItem> &item, int role);
@@ -242,6 +258,14 @@ private:
 
     std::unique_ptr<FileWatcher> m_fileWatcher;
 
+    /* Secondary indexes kept in sync with m_allItems so that lookups do not need to scan the whole bin.
+       They are protected by m_indexLock since they are queried from job and thumbnail threads */
+    mutable QReadWriteLock m_indexLock;
+    std::unordered_map<QString, int> m_binIdIndex;                            // bin id -> tree item id
+    std::unordered_map<QString, QString> m_clipUrls;                          // clip bin id -> indexed url key
+    std::unordered_map<QString, std::unordered_set<QString>> m_urlIndex;      // url key -> clip bin ids
+    std::unordered_map<QString, std::unordered_set<QString>> m_folderIndex;   // folder name -> folder bin ids
+
     int m_nextId;
     QIcon m_blankThumb;
     PlaylistState::ClipState m_dragType;
@@ -28,6 +28,7 @@ the Free Software Foundation, either version 3 of the License, or
 #include "timeline2/model/timelineitemmodel.hpp"
 #include "timeline2/view/timelinecontroller.h"
 #include "timeline2/view/timelinewidget.h"
+#include "utils/mediaprobecache.hpp"
 
 #include <mlt++/MltRepository.h>
 
@@ -680,6 +681,8 @@ void Core::triggerAction(const QString &name)
 
 void Core::clean()
 {
+    // Background validations use the bin
+    MediaProbeCache::get()->cancelValidation();
     m_self.reset();
 }
 
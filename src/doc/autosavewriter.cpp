@@ -0,0 +1,73 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "autosavewriter.h"
+
+#include <QFile>
+#include <QtConcurrent>
+
+AutoSaveWriter::AutoSaveWriter(QObject *parent)
+    : QObject(parent)
+{
+    // A single thread keeps the writes in order
+    m_writer.setMaxThreadCount(1);
+}
+
+AutoSaveWriter::~AutoSaveWriter()
+{
+    waitForDone();
+}
+
+void AutoSaveWriter::write(const QString &autoSaveFile, const QString &scene, const QMap<QString, QString> &replacements)
+{
+    if (autoSaveFile.isEmpty()) {
+        return;
+    }
+    QtConcurrent::run(&m_writer, [this, autoSaveFile, scene, replacements]() {
+        QString content = scene;
+        QMapIterator<QString, QString> i(replacements);
+        while (i.hasNext()) {
+            i.next();
+            content.replace(i.key(), i.value());
+        }
+        QFile file(autoSaveFile);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(content.toUtf8()) < 0) {
+            emit writeFailed(autoSaveFile);
+        }
+    });
+}
+
+void AutoSaveWriter::clear(const QString &autoSaveFile)
+{
+    if (autoSaveFile.isEmpty()) {
+        return;
+    }
+    QtConcurrent::run(&m_writer, [autoSaveFile]() {
+        QFile file(autoSaveFile);
+        if (file.exists()) {
+            file.resize(0);
+        }
+    });
+}
+
+void AutoSaveWriter::waitForDone()
+{
+    m_writer.waitForDone();
+}
@@ -0,0 +1,59 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef AUTOSAVEWRITER_H
+#define AUTOSAVEWRITER_H
+
+#include <QMap>
+#include <QObject>
+#include <QThreadPool>
+
+/** @class AutoSaveWriter
+    @brief Writes the autosave file of a document in the background.
+
+    The scene is serialized by the caller, applying the replacements to it and writing the file are done in order,
+    on a worker thread, so that large projects don't block the interface while they are autosaved.
+ */
+class AutoSaveWriter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit AutoSaveWriter(QObject *parent = nullptr);
+    /** @brief Waits for the pending writes */
+    ~AutoSaveWriter() override;
+
+    /** @brief Replace the content of the autosave file with the scene
+        @param replacements are applied to the scene before it is written */
+    void write(const QString &autoSaveFile, const QString &scene, const QMap<QString, QString> &replacements);
+    /** @brief Empty the autosave file, for example after the document was saved */
+    void clear(const QString &autoSaveFile);
+    /** @brief Block until all writes are done */
+    void waitForDone();
+
+signals:
+    /** @brief Emitted (from the worker thread) when a file could not be written */
+    void writeFailed(const QString &file);
+
+private:
+    QThreadPool m_writer;
+};
+
+#endif
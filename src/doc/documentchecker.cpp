@@ -22,6 +22,7 @@
 #include "effects/effectsrepository.hpp"
 #include "kdenlivesettings.h"
 #include "kthumb.h"
+#include "mediarelinker.h"
 #include "titler/titlewidget.h"
 
 #include <KMessageBox>
@@ -30,12 +31,14 @@
 #include <klocalizedstring.h>
 
 #include "kdenlive_debug.h"
-#include <QCryptographicHash>
+#include <QEventLoop>
 #include <QFile>
 #include <QFileDialog>
 #include <QFontDatabase>
+#include <QFutureWatcher>
 #include <QStandardPaths>
 #include <QTreeWidgetItem>
+#include <QtConcurrent>
 #include <utility>
 const int hashRole = Qt::UserRole;
 const int sizeRole = Qt::UserRole + 1;
@@ -658,41 +661,90 @@ void DocumentChecker::slotSearchClips()
     if (newpath.isEmpty()) {
         return;
     }
-    int ix = 0;
     bool fixed = false;
     m_ui.recursiveSearch->setChecked(true);
-    // TODO: make non modal
-    QTreeWidgetItem *child = m_ui.treeWidget->topLevelItem(ix);
+    m_ui.recursiveSearch->setEnabled(false);
+    m_ui.buttonBox->setEnabled(false);
     QDir searchDir(newpath);
-    while (child != nullptr) {
+
+    // Collect the clips that can be found by size and hash, they are all resolved at once
+    QList<QTreeWidgetItem *> items;
+    QList<MediaRelinker::Clip> clips;
+    auto addClip = [&items, &clips](QTreeWidgetItem *item) {
+        MediaRelinker::Clip clip;
+        bool ok;
+        clip.size = item->data(0, sizeRole).toString().toLongLong(&ok);
+        if (!ok) {
+            clip.size = -1;
+        }
+        clip.hash = item->data(0, hashRole).toString();
+        items << item;
+        clips << clip;
+    };
+    for (int ix = 0; ix < m_ui.treeWidget->topLevelItemCount(); ++ix) {
+        QTreeWidgetItem *child = m_ui.treeWidget->topLevelItem(ix);
         if (child->data(0, statusRole).toInt() == SOURCEMISSING) {
             for (int j = 0; j < child->childCount(); ++j) {
-                QTreeWidgetItem *subchild = child->child(j);
-                QString clipPath =
-                    searchFileRecursively(searchDir, subchild->data(0, sizeRole).toString(), subchild->data(0, hashRole).toString(), subchild->text(1));
-                if (!clipPath.isEmpty()) {
-                    fixed = true;
-                    subchild->setText(1, clipPath);
-                    subchild->setIcon(0, QIcon::fromTheme(QStringLiteral("dialog-ok")));
-                    subchild->setData(0, statusRole, CLIPOK);
-                }
-            }
-        } else if (child->data(0, statusRole).toInt() == CLIPMISSING) {
-            bool perfectMatch = true;
-            ClipType::ProducerType type = (ClipType::ProducerType)child->data(0, clipTypeRole).toInt();
-            QString clipPath;
-            if (type != ClipType::SlideShow) {
-                // Slideshows cannot be found with hash / size
-                clipPath = searchFileRecursively(searchDir, child->data(0, sizeRole).toString(), child->data(0, hashRole).toString(), child->text(1));
+                addClip(child->child(j));
             }
-            if (clipPath.isEmpty()) {
-                clipPath = searchPathRecursively(searchDir, QUrl::fromLocalFile(child->text(1)).fileName(), type);
+        } else if (child->data(0, statusRole).toInt() == CLIPMISSING && (ClipType::ProducerType)child->data(0, clipTypeRole).toInt() != ClipType::SlideShow) {
+            // Slideshows cannot be found with hash / size
+            addClip(child);
+        }
+    }
+
+    // Walk the search folder once, in the background
+    const QString previousInfo = m_ui.infoLabel->text();
+    MediaRelinker relinker(newpath);
+    QStringList found;
+    KMessageWidget *info = m_ui.infoLabel;
+    QEventLoop loop;
+    QFutureWatcher<void> watcher;
+    connect(&watcher, &QFutureWatcher<void>::finished, &loop, &QEventLoop::quit);
+    watcher.setFuture(QtConcurrent::run([&relinker, &found, &clips, info]() {
+        relinker.crawl([info](int folders, int files) {
+            QMetaObject::invokeMethod(info, "setText", Qt::QueuedConnection,
+                                      Q_ARG(QString, i18n("Searching clips: %1 folders, %2 files scanned", folders, files)));
+        });
+        QMetaObject::invokeMethod(info, "setText", Qt::QueuedConnection, Q_ARG(QString, i18n("Comparing %1 files", relinker.fileCount())));
+        found = relinker.resolve(clips);
+    }));
+    loop.exec();
+    m_ui.infoLabel->setText(previousInfo);
+
+    for (int i = 0; i < items.count(); ++i) {
+        QTreeWidgetItem *item = items.at(i);
+        QString clipPath = found.at(i);
+        bool perfectMatch = true;
+        if (clipPath.isEmpty()) {
+            if (item->data(0, statusRole).toInt() == SOURCEMISSING) {
+                // Only look for the exact source of a proxy. Without size and hash, the name is all we can check
+                if (clips.at(i).size >= 0 || !clips.at(i).hash.isEmpty()) {
+                    continue;
+                }
+            } else {
+                // A clip found by its name only may not be the right one
                 perfectMatch = false;
             }
+            clipPath = relinker.findByName(QUrl::fromLocalFile(item->text(1)).fileName());
+        }
+        if (!clipPath.isEmpty()) {
+            fixed = true;
+            item->setText(1, clipPath);
+            item->setIcon(0, perfectMatch ? QIcon::fromTheme(QStringLiteral("dialog-ok")) : QIcon::fromTheme(QStringLiteral("dialog-warning")));
+            item->setData(0, statusRole, CLIPOK);
+        }
+    }
+
+    for (int ix = 0; ix < m_ui.treeWidget->topLevelItemCount(); ++ix) {
+        QTreeWidgetItem *child = m_ui.treeWidget->topLevelItem(ix);
+        if (child->data(0, statusRole).toInt() == CLIPMISSING && (ClipType::ProducerType)child->data(0, clipTypeRole).toInt() == ClipType::SlideShow) {
+            // Slideshows are found by their name pattern
+            QString clipPath = searchPathRecursively(searchDir, QUrl::fromLocalFile(child->text(1)).fileName(), ClipType::SlideShow);
             if (!clipPath.isEmpty()) {
                 fixed = true;
                 child->setText(1, clipPath);
-                child->setIcon(0, perfectMatch ? QIcon::fromTheme(QStringLiteral("dialog-ok")) : QIcon::fromTheme(QStringLiteral("dialog-warning")));
+                child->setIcon(0, QIcon::fromTheme(QStringLiteral("dialog-warning")));
                 child->setData(0, statusRole, CLIPOK);
             }
         } else if (child->data(0, statusRole).toInt() == LUMAMISSING) {
@@ -706,7 +758,7 @@ void DocumentChecker::slotSearchClips()
         } else if (child->data(0, typeRole).toInt() == TITLE_IMAGE_ELEMENT && child->data(0, statusRole).toInt() == CLIPPLACEHOLDER) {
             // Search missing title images
             QString missingFileName = QUrl::fromLocalFile(child->text(1)).fileName();
-            QString newPath = searchPathRecursively(searchDir, missingFileName);
+            QString newPath = relinker.findByName(missingFileName);
             if (!newPath.isEmpty()) {
                 // File found
                 fixed = true;
@@ -715,11 +767,10 @@ void DocumentChecker::slotSearchClips()
                 child->setData(0, statusRole, CLIPOK);
             }
         }
-        ix++;
-        child = m_ui.treeWidget->topLevelItem(ix);
     }
     m_ui.recursiveSearch->setChecked(false);
     m_ui.recursiveSearch->setEnabled(true);
+    m_ui.buttonBox->setEnabled(true);
     if (fixed) {
         // original doc was modified
         m_doc.documentElement().setAttribute(QStringLiteral("modified"), 1);
@@ -794,50 +845,6 @@ QString DocumentChecker::searchPathRecursively(const QDir &dir, const QString &f
     return foundFileName;
 }
 
-QString DocumentChecker::searchFileRecursively(const QDir &dir, const QString &matchSize, const QString &matchHash, const QString &fileName) const
-{
-    if (matchSize.isEmpty() && matchHash.isEmpty()) {
-        return searchPathRecursively(dir, QUrl::fromLocalFile(fileName).fileName());
-    }
-    QString foundFileName;
-    QByteArray fileData;
-    QByteArray fileHash;
-    QStringList filesAndDirs = dir.entryList(QDir::Files | QDir::Readable);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
-        QFile file(dir.absoluteFilePath(filesAndDirs.at(i)));
-        if (QString::number(file.size()) == matchSize) {
-            if (file.open(QIODevice::ReadOnly)) {
-                /*
-                 * 1 MB = 1 second per 450 files (or faster)
-                 * 10 MB = 9 seconds per 450 files (or faster)
-                 */
-                if (file.size() > 1000000 * 2) {
-                    fileData = file.read(1000000);
-                    if (file.seek(file.size() - 1000000)) {
-                        fileData.append(file.readAll());
-                    }
-                } else {
-                    fileData = file.readAll();
-                }
-                file.close();
-                fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
-                if (QString::fromLatin1(fileHash.toHex()) == matchHash) {
-                    return file.fileName();
-                }
-            }
-        }
-        ////qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << file.size() << fileHash.toHex();
-    }
-    filesAndDirs = dir.entryList(QDir::Dirs | QDir::Readable | QDir::Executable | QDir::NoDotAndDotDot);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
-        foundFileName = searchFileRecursively(dir.absoluteFilePath(filesAndDirs.at(i)), matchSize, matchHash, fileName);
-        if (!foundFileName.isEmpty()) {
-            break;
-        }
-    }
-    return foundFileName;
-}
-
 void DocumentChecker::slotEditItem(QTreeWidgetItem *item, int)
 {
     int t = item->data(0, typeRole).toInt();
@@ -20,8 +20,12 @@
  ***************************************************************************/
 
 #include "docundostack.hpp"
+#include "kdenlive_debug.h"
+#include "undohelper.hpp"
+#include <QSignalBlocker>
 #include <QUndoCommand>
 #include <QUndoGroup>
+#include <vector>
 
 DocUndoStack::DocUndoStack(QUndoGroup *parent)
     : QUndoStack(parent)
@@ -34,5 +38,103 @@ void DocUndoStack::push(QUndoCommand *cmd)
     if (index() < count()) {
         emit invalidate();
     }
+    if (m_operationLimit > 0) {
+        // Trim before pushing, so that the signals emitted by the push describe the final state of the stack
+        trimToLimit(commandOperations(cmd));
+    }
     QUndoStack::push(cmd);
 }
+
+void DocUndoStack::setOperationLimit(size_t operations)
+{
+    m_operationLimit = operations;
+}
+
+// static
+size_t DocUndoStack::commandOperations(const QUndoCommand *cmd)
+{
+    if (const auto *command = dynamic_cast<const FunctionalUndoCommand *>(cmd)) {
+        return command->operationCount();
+    }
+    // Legacy commands perform a single operation, plus the ones of their children
+    size_t operations = 1;
+    for (int i = 0; i < cmd->childCount(); ++i) {
+        operations += commandOperations(cmd->child(i));
+    }
+    return operations;
+}
+
+size_t DocUndoStack::operationCount() const
+{
+    size_t operations = 0;
+    for (int i = 0; i < count(); ++i) {
+        operations += commandOperations(command(i));
+    }
+    return operations;
+}
+
+void DocUndoStack::trimToLimit(size_t reserved)
+{
+    // The commands after the current index are discarded by the next push
+    const int last = index();
+    if (last < 2) {
+        return;
+    }
+    // Find the oldest command that we can keep
+    std::vector<size_t> operations((size_t)last);
+    size_t total = reserved;
+    for (int i = 0; i < last; ++i) {
+        operations[(size_t)i] = commandOperations(command(i));
+        total += operations[(size_t)i];
+    }
+    if (total <= m_operationLimit) {
+        return;
+    }
+    int first = 0;
+    while (first < last - 1 && total > m_operationLimit) {
+        total -= operations[(size_t)first];
+        first++;
+    }
+    // QUndoStack cannot drop its oldest commands, so we rebuild it with copies of the ones we keep. Only functional commands can be copied
+    for (int i = last - 1; i >= first; --i) {
+        if (dynamic_cast<const FunctionalUndoCommand *>(command(i)) == nullptr || command(i)->childCount() > 0) {
+            first = i + 1;
+            break;
+        }
+    }
+    if (first == 0 || first >= last) {
+        return;
+    }
+    std::vector<QUndoCommand *> kept;
+    for (int i = first; i < last; ++i) {
+        kept.push_back(static_cast<const FunctionalUndoCommand *>(command(i))->clone());
+    }
+    qCDebug(KDENLIVE_LOG) << "// Undo stack exceeds its operation limit, discarding" << first << "commands";
+    const int clean = cleanIndex();
+    {
+        // The intermediate states are not reported, the push following the trim emits the signals of the final state
+        QSignalBlocker blocker(this);
+        clear();
+        if (clean < first || clean > last) {
+            // The saved state cannot be reached anymore
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+            resetClean();
+#else
+            // QUndoStack forgets the clean state when the command leading to it is dropped by the next push
+            QUndoStack::push(new QUndoCommand());
+            setClean();
+            undo();
+#endif
+        }
+        for (int i = first; i < last; ++i) {
+            if (i == clean) {
+                setClean();
+            }
+            // The copies were never undone, so pushing them doesn't execute anything
+            QUndoStack::push(kept[(size_t)(i - first)]);
+        }
+        if (clean == last) {
+            setClean();
+        }
+    }
+}
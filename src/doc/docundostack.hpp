@@ -32,6 +32,18 @@ class DocUndoStack : public QUndoStack
 public:
     explicit DocUndoStack(QUndoGroup *parent = Q_NULLPTR);
     void push(QUndoCommand *cmd);
+    /** @brief Set the maximum number of undo/redo operations that the commands of the stack should hold. The oldest commands are discarded when a push
+        exceeds it. 0 means no limit */
+    void setOperationLimit(size_t operations);
+    /** @brief Returns the number of undo/redo operations held by the commands of the stack */
+    size_t operationCount() const;
+    /** @brief Returns the number of undo/redo operations held by a command */
+    static size_t commandOperations(const QUndoCommand *cmd);
+
+private:
+    size_t m_operationLimit{0};
+    /** @brief Discard the oldest commands until the stack, and a command of @param reserved operations pushed at the current index, fit in the limit */
+    void trimToLimit(size_t reserved);
 signals:
     void invalidate();
 };
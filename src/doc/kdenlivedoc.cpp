@@ -18,6 +18,7 @@
  ***************************************************************************/
 
 #include "kdenlivedoc.h"
+#include "autosavewriter.h"
 #include "bin/bin.h"
 #include "bin/bincommands.h"
 #include "bin/binplaylist.hpp"
@@ -38,8 +39,10 @@
 #include "profiles/profilemodel.hpp"
 #include "profiles/profilerepository.hpp"
 #include "project/projectcommands.h"
+#include "scenelistwriter.h"
 #include "titler/titlewidget.h"
 #include "transitions/transitionsrepository.hpp"
+#include "utils/filehashcache.hpp"
 
 #include <config-kdenlive.h>
 
@@ -52,13 +55,13 @@
 #include <klocalizedstring.h>
 
 #include "kdenlive_debug.h"
-#include <QCryptographicHash>
 #include <QDomImplementation>
 #include <QFile>
 #include <QFileDialog>
 #include <QTimer>
 #include <QUndoGroup>
 #include <QUndoStack>
+#include <QtConcurrent>
 
 #include <KJobWidgets/KJobWidgets>
 #include <QStandardPaths>
@@ -77,6 +80,7 @@ KdenliveDoc::KdenliveDoc(const QUrl &url, QString projectFolder, QUndoGroup *und
     , m_autosave(nullptr)
     , m_url(url)
     , m_commandStack(std::make_shared<DocUndoStack>(undoGroup))
+    , m_autoSaveWriter(new AutoSaveWriter(this))
     , m_modified(false)
     , m_documentOpenStatus(CleanProject)
     , m_projectFolder(std::move(projectFolder))
@@ -86,7 +90,10 @@ KdenliveDoc::KdenliveDoc(const QUrl &url, QString projectFolder, QUndoGroup *und
     connect(this, SIGNAL(updateCompositionMode(int)), parent, SLOT(slotUpdateCompositeAction(int)));
     bool success = false;
     connect(m_commandStack.get(), &QUndoStack::indexChanged, this, &KdenliveDoc::slotModified);
-    connect(m_commandStack.get(), &DocUndoStack::invalidate, this, &KdenliveDoc::checkPreviewStack);
+    connect(this, &KdenliveDoc::sceneListWritten, this, &KdenliveDoc::slotSceneListWritten, Qt::QueuedConnection);
+    connect(m_autoSaveWriter, &AutoSaveWriter::writeFailed, this,
+            [](const QString &file) { pCore->displayMessage(i18n("Cannot create autosave file %1", file), ErrorMessage); });
+    m_commandStack->setOperationLimit((size_t)KdenliveSettings::undooperations());
     // connect(m_commandStack, SIGNAL(cleanChanged(bool)), this, SLOT(setModified(bool)));
 
     // init default document properties
@@ -294,6 +301,9 @@ KdenliveDoc::~KdenliveDoc()
     // Clean up guide model
     m_guideModel.reset();
     // qCDebug(KDENLIVE_LOG) << "// DEL CLP MAN done";
+    // Let the pending writes finish before removing the files
+    m_saveFuture.waitForFinished();
+    m_autoSaveWriter->waitForDone();
     if (m_autosave) {
         if (!m_autosave->fileName().isEmpty()) {
             m_autosave->remove();
@@ -427,7 +437,7 @@ bool KdenliveDoc::autoGenerateImageProxy(int width) const
            width > m_documentProperties.value(QStringLiteral("proxyimageminsize")).toInt();
 }
 
-void KdenliveDoc::slotAutoSave(const QString &scene)
+void KdenliveDoc::slotAutoSave(const QString &scene, const QMap<QString, QString> &replacements)
 {
     if (m_autosave != nullptr) {
         if (!m_autosave->isOpen() && !m_autosave->open(QIODevice::ReadWrite)) {
@@ -441,11 +451,14 @@ void KdenliveDoc::slotAutoSave(const QString &scene)
             KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1, scene list is corrupted.", m_autosave->fileName()));
             return;
         }
-        m_autosave->resize(0);
-        if (m_autosave->write(scene.toUtf8()) < 0) {
-            pCore->displayMessage(i18n("Cannot create autosave file %1", m_autosave->fileName()), ErrorMessage);
-        };
-        m_autosave->flush();
+        m_autoSaveWriter->write(m_autosave->fileName(), scene, replacements);
+    }
+}
+
+void KdenliveDoc::clearAutoSave()
+{
+    if (m_autosave != nullptr) {
+        m_autoSaveWriter->clear(m_autosave->fileName());
     }
 }
 
@@ -550,14 +563,15 @@ QDomDocument KdenliveDoc::xmlSceneList(const QString &scene)
     return sceneList;
 }
 
-bool KdenliveDoc::saveSceneList(const QString &path, const QString &scene)
+bool KdenliveDoc::saveSceneList(const QString &path, const QString &scene, const QMap<QString, QString> &replacements)
 {
-    QDomDocument sceneList = xmlSceneList(scene);
-    if (sceneList.isNull()) {
+    if (!scene.contains(QLatin1String("<mlt"))) {
         // Make sure we don't save if scenelist is corrupted
         KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1, scene list is corrupted.", path));
         return false;
     }
+    // Only one save at a time, the previous one must be written before we backup it
+    waitForSave();
 
     // Backup current version
     backupLastSavedVersion(path);
@@ -591,29 +605,54 @@ bool KdenliveDoc::saveSceneList(const QString &path, const QString &scene)
                      backupFile));
         }
     }
-    QFile file(path);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        qCWarning(KDENLIVE_LOG) << "//////  ERROR writing to file: " << path;
-        KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1", path));
-        return false;
+    m_savePath = path;
+    m_savePending = true;
+    m_saveFailed = false;
+    m_saveFuture = QtConcurrent::run([this, scene, path, replacements]() {
+        QString error;
+        SceneListWriter::write(scene, path, replacements, [this](int progress) { emit saveProgress(progress); }, &error);
+        emit sceneListWritten();
+        return error;
+    });
+    return true;
+}
+
+bool KdenliveDoc::waitForSave()
+{
+    if (m_savePending) {
+        m_saveFuture.waitForFinished();
+        slotSceneListWritten();
     }
+    return !m_saveFailed;
+}
 
-    file.write(sceneList.toString().toUtf8());
-    if (file.error() != QFile::NoError) {
-        KMessageBox::error(QApplication::activeWindow(), i18n("Cannot write to file %1", path));
-        file.close();
-        return false;
+void KdenliveDoc::slotSceneListWritten()
+{
+    if (!m_savePending) {
+        // Already processed by waitForSave()
+        return;
+    }
+    m_savePending = false;
+    const QString error = m_saveFuture.result();
+    m_saveFailed = !error.isEmpty();
+    if (m_saveFailed) {
+        qCWarning(KDENLIVE_LOG) << "//////  ERROR writing to file: " << m_savePath;
+        KMessageBox::error(QApplication::activeWindow(), error);
+        setModified(true);
+        return;
+    }
+    if (m_savePath == m_url.toLocalFile()) {
+        // The project file is now more recent than the crash recovery data
+        clearAutoSave();
     }
-    file.close();
     cleanupBackupFiles();
-    QFileInfo info(file);
-    QString fileName = QUrl::fromLocalFile(path).fileName().section(QLatin1Char('.'), 0, -2);
+    QFileInfo info(m_savePath);
+    QString fileName = QUrl::fromLocalFile(m_savePath).fileName().section(QLatin1Char('.'), 0, -2);
     fileName.append(QLatin1Char('-') + m_documentProperties.value(QStringLiteral("documentid")));
     fileName.append(info.lastModified().toString(QStringLiteral("-yyyy-MM-dd-hh-mm")));
     fileName.append(QStringLiteral(".kdenlive.png"));
     QDir backupFolder(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + QStringLiteral("/.backup"));
     emit saveTimelinePreview(backupFolder.absoluteFilePath(fileName));
-    return true;
 }
 
 QString KdenliveDoc::projectTempFolder() const
@@ -783,34 +822,21 @@ const QString KdenliveDoc::description() const
 QString KdenliveDoc::searchFileRecursively(const QDir &dir, const QString &matchSize, const QString &matchHash) const
 {
     QString foundFileName;
-    QByteArray fileData;
-    QByteArray fileHash;
     QStringList filesAndDirs = dir.entryList(QDir::Files | QDir::Readable);
-    for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
-        QFile file(dir.absoluteFilePath(filesAndDirs.at(i)));
-        if (file.open(QIODevice::ReadOnly)) {
-            if (QString::number(file.size()) == matchSize) {
-                /*
-                 * 1 MB = 1 second per 450 files (or faster)
-                 * 10 MB = 9 seconds per 450 files (or faster)
-                 */
-                if (file.size() > 1000000 * 2) {
-                    fileData = file.read(1000000);
-                    if (file.seek(file.size() - 1000000)) {
-                        fileData.append(file.readAll());
-                    }
-                } else {
-                    fileData = file.readAll();
-                }
-                file.close();
-                fileHash = QCryptographicHash::hash(fileData, QCryptographicHash::Md5);
-                if (QString::fromLatin1(fileHash.toHex()) == matchHash) {
-                    return file.fileName();
-                }
-                qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << "size match but not hash";
-            }
+    // Only files of the same size can match, hash them in parallel
+    QStringList candidates;
+    for (const QString &name : filesAndDirs) {
+        QFileInfo info(dir.absoluteFilePath(name));
+        if (QString::number(info.size()) == matchSize) {
+            candidates << info.absoluteFilePath();
+        }
+    }
+    const QMap<QString, QString> hashes = FileHashCache::get()->hashFiles(candidates);
+    for (const QString &candidate : candidates) {
+        if (hashes.value(candidate) == matchHash) {
+            return candidate;
         }
-        ////qCDebug(KDENLIVE_LOG) << filesAndDirs.at(i) << file.size() << fileHash.toHex();
+        qCDebug(KDENLIVE_LOG) << candidate << "size match but not hash";
     }
     filesAndDirs = dir.entryList(QDir::Dirs | QDir::Readable | QDir::Executable | QDir::NoDotAndDotDot);
     for (int i = 0; i < filesAndDirs.size() && foundFileName.isEmpty(); ++i) {
@@ -1594,12 +1620,6 @@ void KdenliveDoc::initProxySettings()
     m_proxyExtension = params.section(QLatin1Char(';'), 1);
 }
 
-void KdenliveDoc::checkPreviewStack()
-{
-    // A command was pushed in the middle of the stack, remove all cached data from last undos
-    emit removeInvalidUndo(m_commandStack->count());
-}
-
 void KdenliveDoc::saveMltPlaylist(const QString &fileName)
 {
     Q_UNUSED(fileName)
@@ -26,6 +26,7 @@
 #define KDENLIVEDOC_H
 
 #include <QDir>
+#include <QFuture>
 #include <QList>
 #include <QMap>
 #include <QTimer>
@@ -38,6 +39,7 @@
 #include "gentime.h"
 #include "timecode.h"
 
+class AutoSaveWriter;
 class MainWindow;
 class TrackInfo;
 class ProjectClip;
@@ -71,6 +73,8 @@ public:
     int height() const;
     QUrl url() const;
     KAutoSaveFile *m_autosave;
+    /** @brief Empty the autosave file, once the document was saved */
+    void clearAutoSave();
     Timecode timecode() const;
     QDomDocument toXml();
     std::shared_ptr<DocUndoStack> commandStack();
@@ -96,8 +100,14 @@ public:
     double dar() const;
     /** @brief Returns the project file xml. */
     QDomDocument xmlSceneList(const QString &scene);
-    /** @brief Saves the project file xml to a file. */
-    bool saveSceneList(const QString &path, const QString &scene);
+    /** @brief Saves the project file xml to a file.
+     * @description The file is written in the background, saveProgress is emitted while it is written
+     * @param replacements are applied to the scene while it is written
+     * @return false if the save could not be started */
+    bool saveSceneList(const QString &path, const QString &scene, const QMap<QString, QString> &replacements = QMap<QString, QString>());
+    /** @brief Block until the file being saved is written
+     * @return false if the last save failed */
+    bool waitForSave();
     /** @brief Saves only the MLT xml to a file for preview rendering. */
     void saveMltPlaylist(const QString &fileName);
     void cacheImage(const QString &fileId, const QImage &img) const;
@@ -167,6 +177,12 @@ private:
     QString m_documentRoot;
     Timecode m_timecode;
     std::shared_ptr<DocUndoStack> m_commandStack;
+    AutoSaveWriter *m_autoSaveWriter;
+    /** @brief Project file being written, and the error message of the write */
+    QFuture<QString> m_saveFuture;
+    QString m_savePath;
+    bool m_savePending{false};
+    bool m_saveFailed{false};
     QString m_searchFolder;
 
     /** @brief Tells whether the current document has been changed after being saved. */
@@ -217,17 +233,18 @@ public slots:
     void slotProxyCurrentItem(bool doProxy, QList<std::shared_ptr<ProjectClip>> clipList = QList<std::shared_ptr<ProjectClip>>(), bool force = false,
                               QUndoCommand *masterCommand = nullptr);
     /** @brief Saves the current project at the autosave location.
-     * @description The autosave files are in ~/.kde/data/stalefiles/kdenlive/ */
-    void slotAutoSave(const QString &scene);
+     * @description The autosave files are in ~/.kde/data/stalefiles/kdenlive/. The file is written in the background
+     * @param replacements are applied to the scene before it is written */
+    void slotAutoSave(const QString &scene, const QMap<QString, QString> &replacements = QMap<QString, QString>());
     /** @brief Groups were changed, save to MLT. */
     void groupsChanged(const QString &groups);
 
 private slots:
     void slotModified();
+    /** @brief The project file was written (or could not be) */
+    void slotSceneListWritten();
     void switchProfile(std::unique_ptr<ProfileParam> &profile, const QString &id, const QDomElement &xml);
     void slotSwitchProfile(const QString &profile_path);
-    /** @brief Check if we did a new action invalidating more recent undo items. */
-    void checkPreviewStack();
     /** @brief Guides were changed, save to MLT. */
     void guidesChanged();
 
@@ -241,14 +258,16 @@ signals:
     void selectLastAddedClip(const QString &);
     /** @brief When creating a backup file, also save a thumbnail of current timeline */
     void saveTimelinePreview(const QString &path);
+    /** @brief Percentage of the project file written, emitted from the saving thread */
+    void saveProgress(int progress);
+    /** @brief Emitted from the saving thread once the project file is written */
+    void sceneListWritten();
     /** @brief Trigger the autosave timer start */
     void startAutoSave();
     /** @brief Current doc created effects, reload list */
     void reloadEffects(const QStringList &paths);
     /** @brief Fps was changed, update timeline (changed = 1 means no change) */
     void updateFps(double changed);
-    /** @brief If a command is pushed when we are in the middle of undo stack, invalidate further undo history */
-    void removeInvalidUndo(int ix);
     /** @brief Update compositing info */
     void updateCompositionMode(int);
 };
@@ -0,0 +1,129 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "mediarelinker.h"
+#include "utils/filehashcache.hpp"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSet>
+#include <QtConcurrent>
+
+MediaRelinker::MediaRelinker(const QString &root)
+    : m_root(root)
+{
+}
+
+// static
+MediaRelinker::Folder MediaRelinker::listFolder(const QString &path)
+{
+    Folder folder;
+    QDir dir(path);
+    const QFileInfoList files = dir.entryInfoList(QDir::Files | QDir::Readable, QDir::Name);
+    for (const QFileInfo &info : files) {
+        folder.files << qMakePair(info.absoluteFilePath(), info.size());
+    }
+    const QFileInfoList folders = dir.entryInfoList(QDir::Dirs | QDir::Readable | QDir::Executable | QDir::NoDotAndDotDot, QDir::Name);
+    for (const QFileInfo &info : folders) {
+        folder.folders << info.absoluteFilePath();
+    }
+    return folder;
+}
+
+void MediaRelinker::crawl(const std::function<void(int folders, int files)> &progress)
+{
+    m_folderCount = 0;
+    m_fileCount = 0;
+    m_bySize.clear();
+    m_byName.clear();
+    // Symbolic links may point to a parent folder
+    QSet<QString> visited;
+    QStringList level;
+    level << QDir(m_root).absolutePath();
+    visited << QFileInfo(m_root).canonicalFilePath();
+    // Breadth first: the folders of a level are listed in parallel, and files closer to the root come first
+    while (!level.isEmpty()) {
+        const QList<Folder> folders = QtConcurrent::blockingMapped<QList<Folder>>(level, &MediaRelinker::listFolder);
+        QStringList next;
+        for (const Folder &folder : folders) {
+            for (const auto &file : folder.files) {
+                m_bySize[file.second] << file.first;
+                m_byName[QFileInfo(file.first).fileName().toLower()] << file.first;
+            }
+            m_fileCount += folder.files.count();
+            for (const QString &path : folder.folders) {
+                const QString canonical = QFileInfo(path).canonicalFilePath();
+                if (!visited.contains(canonical)) {
+                    visited << canonical;
+                    next << path;
+                }
+            }
+        }
+        m_folderCount += level.count();
+        if (progress) {
+            progress(m_folderCount, m_fileCount);
+        }
+        level = next;
+    }
+}
+
+QStringList MediaRelinker::resolve(const QList<Clip> &clips) const
+{
+    // Only the files having the size of a missing clip need to be hashed
+    QStringList candidates;
+    QSet<qint64> sizes;
+    for (const Clip &clip : clips) {
+        if (clip.size >= 0 && !clip.hash.isEmpty() && !sizes.contains(clip.size)) {
+            sizes << clip.size;
+            candidates << m_bySize.value(clip.size);
+        }
+    }
+    const QMap<QString, QString> hashes = FileHashCache::get()->hashFiles(candidates);
+    QStringList result;
+    for (const Clip &clip : clips) {
+        QString found;
+        if (clip.size >= 0 && !clip.hash.isEmpty()) {
+            for (const QString &path : m_bySize.value(clip.size)) {
+                if (hashes.value(path) == clip.hash) {
+                    found = path;
+                    break;
+                }
+            }
+        }
+        result << found;
+    }
+    return result;
+}
+
+QString MediaRelinker::findByName(const QString &fileName) const
+{
+    const QStringList paths = m_byName.value(fileName.toLower());
+    return paths.isEmpty() ? QString() : paths.first();
+}
+
+int MediaRelinker::folderCount() const
+{
+    return m_folderCount;
+}
+
+int MediaRelinker::fileCount() const
+{
+    return m_fileCount;
+}
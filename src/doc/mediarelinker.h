@@ -0,0 +1,84 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef MEDIARELINKER_H
+#define MEDIARELINKER_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+/** @class MediaRelinker
+    @brief Finds the new location of missing clips in a folder tree.
+
+    The tree is walked once, folder levels being listed in parallel, and its files are indexed by size and by name.
+    All the missing clips are then resolved together: only the files having the size of a missing clip are hashed,
+    and each file is hashed at most once (see FileHashCache).
+    When several files match, the one closest to the search root is used.
+ */
+class MediaRelinker
+{
+public:
+    /** @brief What is known about a missing clip */
+    struct Clip
+    {
+        /** Size of the file, or -1 if unknown */
+        qint64 size{-1};
+        /** Hash of the file, see ProjectClip::getFileHash() */
+        QString hash;
+    };
+
+    explicit MediaRelinker(const QString &root);
+
+    /** @brief Walk the folder tree and index its files. May be called from any thread
+        @param progress is called from the calling thread with the number of folders and files indexed so far */
+    void crawl(const std::function<void(int folders, int files)> &progress = nullptr);
+
+    /** @brief Find the files matching the size and hash of clips
+        @return the path found for each clip, in the same order. Empty if there is no match */
+    QStringList resolve(const QList<Clip> &clips) const;
+
+    /** @brief Find a file by name, ignoring case. Returns an empty string if there is none */
+    QString findByName(const QString &fileName) const;
+
+    int folderCount() const;
+    int fileCount() const;
+
+private:
+    /** @brief Files and sub folders of a folder */
+    struct Folder
+    {
+        QList<QPair<QString, qint64>> files;
+        QStringList folders;
+    };
+    static Folder listFolder(const QString &path);
+
+    QString m_root;
+    int m_folderCount{0};
+    int m_fileCount{0};
+    // Paths of the indexed files, shallowest first
+    QHash<qint64, QStringList> m_bySize;
+    // Keyed by lower case file name
+    QHash<QString, QStringList> m_byName;
+};
+
+#endif
@@ -0,0 +1,153 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "scenelistwriter.h"
+
+#include "klocalizedstring.h"
+#include <QSaveFile>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+
+// static
+QString SceneListWriter::replace(const QString &text, const QMap<QString, QString> &replacements, bool isText)
+{
+    QString result = text;
+    QMapIterator<QString, QString> i(replacements);
+    while (i.hasNext()) {
+        i.next();
+        if (i.key().startsWith(QLatin1Char('>'))) {
+            // Matches the beginning of an element's text
+            const QString prefix = i.key().mid(1);
+            if (isText && result.startsWith(prefix)) {
+                result.replace(0, prefix.size(), i.value().mid(1));
+            }
+        } else {
+            result.replace(i.key(), i.value());
+        }
+    }
+    return result;
+}
+
+// static
+bool SceneListWriter::write(const QString &scene, const QString &path, const QMap<QString, QString> &replacements, const std::function<void(int)> &progress,
+                            QString *error)
+{
+    auto fail = [error](const QString &message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        return fail(i18n("Cannot write to file %1", path));
+    }
+    QXmlStreamReader reader(scene);
+    reader.setNamespaceProcessing(false);
+    QXmlStreamWriter writer(&file);
+    writer.setAutoFormatting(true);
+    writer.setAutoFormattingIndent(1);
+
+    // The project needs an mlt root element with content
+    int depth = 0;
+    bool hasContent = false;
+    bool validRoot = true;
+    // Depth of the first tractor of the root, while we are inside it
+    int tractorDepth = -1;
+    bool seenTractor = false;
+    bool volumeReset = false;
+    const qint64 total = qMax(1, scene.size());
+    int lastProgress = -1;
+
+    while (!reader.atEnd() && validRoot) {
+        switch (reader.readNext()) {
+        case QXmlStreamReader::StartElement: {
+            const QString name = reader.qualifiedName().toString();
+            if (depth == 0) {
+                validRoot = name == QLatin1String("mlt");
+            } else {
+                hasContent = true;
+            }
+            if (depth == 1 && !seenTractor && name == QLatin1String("tractor")) {
+                seenTractor = true;
+                tractorDepth = depth;
+            }
+            writer.writeStartElement(name);
+            for (const QXmlStreamAttribute &attribute : reader.attributes()) {
+                writer.writeAttribute(attribute.qualifiedName().toString(), replace(attribute.value().toString(), replacements, false));
+            }
+            depth++;
+            if (tractorDepth >= 0 && !volumeReset && name == QLatin1String("property") &&
+                reader.attributes().value(QLatin1String("name")) == QLatin1String("meta.volume")) {
+                // Set playlist audio volume to 100%
+                volumeReset = true;
+                reader.readElementText(QXmlStreamReader::IncludeChildElements);
+                writer.writeCharacters(QStringLiteral("1"));
+                writer.writeEndElement();
+                depth--;
+            }
+            break;
+        }
+        case QXmlStreamReader::EndElement:
+            depth--;
+            if (depth == tractorDepth) {
+                tractorDepth = -1;
+            }
+            writer.writeEndElement();
+            break;
+        case QXmlStreamReader::Characters:
+            if (reader.isWhitespace()) {
+                // Indentation is done by the writer
+                break;
+            }
+            if (depth == 1) {
+                hasContent = true;
+            }
+            if (reader.isCDATA()) {
+                writer.writeCDATA(replace(reader.text().toString(), replacements, true));
+            } else {
+                writer.writeCharacters(replace(reader.text().toString(), replacements, true));
+            }
+            break;
+        default:
+            writer.writeCurrentToken(reader);
+            break;
+        }
+        if (progress) {
+            const int percent = int(100 * reader.characterOffset() / total);
+            if (percent != lastProgress) {
+                lastProgress = percent;
+                progress(qMin(percent, 100));
+            }
+        }
+    }
+    if (progress && lastProgress < 100) {
+        progress(100);
+    }
+    if (reader.hasError() || !validRoot || !hasContent) {
+        // Keep the previous version of the file
+        file.cancelWriting();
+        return fail(i18n("Cannot write to file %1, scene list is corrupted.", path));
+    }
+    if (writer.hasError() || !file.commit()) {
+        return fail(i18n("Cannot write to file %1", path));
+    }
+    return true;
+}
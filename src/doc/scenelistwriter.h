@@ -0,0 +1,50 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef SCENELISTWRITER_H
+#define SCENELISTWRITER_H
+
+#include <QMap>
+#include <QString>
+#include <functional>
+
+/** @class SceneListWriter
+    @brief Writes the project file from the MLT scene list, without building a DOM.
+
+    The scene is parsed and written back token by token, directly to the file. Memory use does not
+    depend on the size of the project, so large projects can be saved on a worker thread.
+    The file is only replaced once it was completely written.
+ */
+class SceneListWriter
+{
+public:
+    /** @brief Write the project file
+        @param replacements are applied to the text and attribute values. A key starting with '>' only matches the start of a text
+        @param progress is called with the percentage of the scene written, from the calling thread
+        @param error receives the reason of a failure
+        @return true if the file was written */
+    static bool write(const QString &scene, const QString &path, const QMap<QString, QString> &replacements, const std::function<void(int)> &progress,
+                      QString *error = nullptr);
+
+private:
+    static QString replace(const QString &text, const QMap<QString, QString> &replacements, bool isText);
+};
+
+#endif
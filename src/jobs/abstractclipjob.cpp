@@ -27,6 +27,7 @@ AbstractClipJob::AbstractClipJob(JOBTYPE type, QString id, QObject *parent)
     , m_clipId(std::move(id))
     , m_jobType(type)
 {
+    connect(this, &AbstractClipJob::jobCanceled, this, [this]() { m_isCanceled = true; }, Qt::DirectConnection);
 }
 
 AbstractClipJob::~AbstractClipJob() = default;
@@ -56,3 +57,32 @@ AbstractClipJob::JOBTYPE AbstractClipJob::jobType() const
 {
     return m_jobType;
 }
+
+AbstractClipJob::JOBPRIORITY AbstractClipJob::priority() const
+{
+    switch (m_jobType) {
+    case THUMBJOB:
+        // The user is usually looking at the bin waiting for these
+        return INTERACTIVEPRIORITY;
+    case LOADJOB:
+        return LOADPRIORITY;
+    case AUDIOTHUMBJOB:
+        return AUDIOTHUMBPRIORITY;
+    default:
+        return BACKGROUNDPRIORITY;
+    }
+}
+
+AbstractClipJob::JOBRESOURCE AbstractClipJob::resource() const
+{
+    switch (m_jobType) {
+    case THUMBJOB:
+    case AUDIOTHUMBJOB:
+        return CPURESOURCE;
+    case LOADJOB:
+        return IORESOURCE;
+    default:
+        // Proxies, transcoding and filter jobs run an external process or a full render
+        return PROCESSRESOURCE;
+    }
+}
@@ -26,6 +26,7 @@
 
 #include "definitions.h"
 #include "undohelper.hpp"
+#include <atomic>
 #include <memory>
 
 /**
@@ -53,6 +54,10 @@ public:
         AUDIOTHUMBJOB = 9,
         SPEEDJOB = 10
     };
+    /** @brief Scheduling classes, jobs of a lower class are started first */
+    enum JOBPRIORITY { INTERACTIVEPRIORITY = 0, LOADPRIORITY = 1, AUDIOTHUMBPRIORITY = 2, BACKGROUNDPRIORITY = 3 };
+    /** @brief The resource a job mostly waits on, each one has its own concurrency limit */
+    enum JOBRESOURCE { CPURESOURCE = 0, IORESOURCE = 1, PROCESSRESOURCE = 2 };
     AbstractClipJob(JOBTYPE type, QString id, QObject *parent = nullptr);
     ~AbstractClipJob() override;
 
@@ -82,6 +87,12 @@ public:
     /* @brief return the type of this job */
     JOBTYPE jobType() const;
 
+    /* @brief return the scheduling class of this job. The default depends on the job type */
+    virtual JOBPRIORITY priority() const;
+
+    /* @brief return the resource class of this job. The default depends on the job type */
+    virtual JOBRESOURCE resource() const;
+
 protected:
     QString m_clipId;
     QString m_errorMessage;
@@ -90,6 +101,8 @@ protected:
     JOBTYPE m_jobType;
 
     bool m_resultConsumed{false};
+    // Set when the job is canceled, long computations should check it regularly
+    std::atomic<bool> m_isCanceled{false};
 
 signals:
     // send an int between 0 and 100 to reflect computation progress
@@ -27,19 +27,19 @@
 #include "doc/kthumb.h"
 #include "kdenlivesettings.h"
 #include "klocalizedstring.h"
+#include "lib/audio/audioPeaks.h"
 #include "lib/audio/audioStreamInfo.h"
 #include "macros.hpp"
 #include "utils/thumbnailcache.hpp"
 #include <QDir>
 #include <QFile>
+#include <QProcess>
 #include <QScopedPointer>
-#include <QTemporaryFile>
 #include <memory>
 #include <mlt++/MltProducer.h>
 
 AudioThumbJob::AudioThumbJob(const QString &binId)
     : AbstractClipJob(AUDIOTHUMBJOB, binId)
-    , m_ffmpegProcess(nullptr)
 {
 }
 
@@ -67,40 +67,43 @@ bool AudioThumbJob::computeWithMlt()
     audioProducer->set("video_index", "-1");
     Mlt::Filter chans(*m_prod->profile(), "audiochannels");
     Mlt::Filter converter(*m_prod->profile(), "audioconvert");
-    Mlt::Filter levels(*m_prod->profile(), "audiolevel");
     audioProducer->attach(chans);
     audioProducer->attach(converter);
-    audioProducer->attach(levels);
 
     int last_val = 0;
     double framesPerSecond = audioProducer->get_fps();
     mlt_audio_format audioFormat = mlt_audio_s16;
-    QStringList keys;
-    keys.reserve(m_channels);
-    for (int i = 0; i < m_channels; i++) {
-        keys << "meta.media.audio_level." + QString::number(i);
-    }
+    AudioPeaks::Builder builder(m_channels, m_frequency);
+    std::vector<qint16> silence;
 
     for (int z = 0; z < m_lengthInFrames; ++z) {
+        if (m_isCanceled) {
+            return false;
+        }
         int val = (int)(100.0 * z / m_lengthInFrames);
         if (last_val != val) {
             emit jobProgress(val);
             last_val = val;
         }
+        int samples = mlt_sample_calculator(float(framesPerSecond), m_frequency, z);
         QScopedPointer<Mlt::Frame> mltFrame(audioProducer->get_frame());
+        const qint16 *data = nullptr;
         if ((mltFrame != nullptr) && mltFrame->is_valid() && (mltFrame->get_int("test_audio") == 0)) {
-            int samples = mlt_sample_calculator(float(framesPerSecond), m_frequency, z);
-            mltFrame->get_audio(audioFormat, m_frequency, m_channels, samples);
-            for (int channel = 0; channel < m_channels; ++channel) {
-                double level = 256 * qMin(mltFrame->get_double(keys.at(channel).toUtf8().constData()) * 0.9, 1.0);
-                m_audioLevels << level;
-            }
-        } else if (!m_audioLevels.isEmpty()) {
-            for (int channel = 0; channel < m_channels; channel++) {
-                m_audioLevels << m_audioLevels.last();
-            }
+            data = static_cast<const qint16 *>(mltFrame->get_audio(audioFormat, m_frequency, m_channels, samples));
+        }
+        if (data == nullptr) {
+            // Keep the peaks aligned with the frames
+            silence.resize(size_t(samples * m_channels), 0);
+            data = silence.data();
         }
+        builder.addSamples(data, samples);
     }
+    m_peaks = builder.finish(m_cachePath);
+    if (!m_peaks) {
+        m_errorMessage.append(i18n("Audio thumbs: cannot compute audio levels for %1", m_prod->get("resource")));
+        return false;
+    }
+    m_audioLevels = m_peaks->frameLevels(framesPerSecond);
     m_done = true;
     return true;
 }
@@ -109,127 +112,102 @@ bool AudioThumbJob::computeWithFFMPEG()
 {
     m_audioLevels.clear();
     QStringList args;
-
-    std::vector<std::unique_ptr<QTemporaryFile>> channelFiles;
-    for (int i = 0; i < m_channels; i++) {
-        std::unique_ptr<QTemporaryFile> channelTmpfile(new QTemporaryFile());
-        if (!channelTmpfile->open()) {
-            m_errorMessage.append(i18n("Audio thumbs: cannot create temporary file, check disk space and permissions\n"));
-            return false;
-        }
-        channelTmpfile->close();
-        channelFiles.emplace_back(std::move(channelTmpfile));
-    }
+    // Decode to interleaved 16 bit samples on stdout, so that we can reduce them to peaks while reading
+    args << QStringLiteral("-nostdin") << QStringLiteral("-v") << QStringLiteral("error");
     args << QStringLiteral("-i") << QUrl::fromLocalFile(m_prod->get("resource")).toLocalFile();
-    // Output progress info
-    args << QStringLiteral("-progress");
-#ifdef Q_OS_WIN
-    args << QStringLiteral("-");
-#else
-    args << QStringLiteral("/dev/stdout");
-#endif
-    bool isFFmpeg = KdenliveSettings::ffmpegpath().contains(QLatin1String("ffmpeg"));
-    args << QStringLiteral("-filter_complex:a");
-    if (m_channels == 1) {
-        //TODO: this does not correcty generate the correct stream data
-        args << QStringLiteral("aformat=channel_layouts=mono,%1=100").arg(isFFmpeg ? "aresample=async" : "sample_rates");
-        args << QStringLiteral("-map") << QStringLiteral("0:a%1").arg(m_audioStream > 0 ? ":" + QString::number(m_audioStream) : QString())
-             << QStringLiteral("-c:a") << QStringLiteral("pcm_s16le") << QStringLiteral("-y") << QStringLiteral("-f") << QStringLiteral("data")
-             << channelFiles[0]->fileName();
-    } else {
-        QString aformat = QStringLiteral("[0:a%1]%2=100,channelsplit=channel_layout=%3")
-                              .arg(m_audioStream > 0 ? ":" + QString::number(m_audioStream) : QString())
-                              .arg(isFFmpeg ? "aresample=async" : "aformat=sample_rates=")
-                              .arg(m_channels > 2 ? "5.1" : "stereo");
-        for (int i = 0; i < m_channels; ++i) {
-            aformat.append(QStringLiteral("[0:%1]").arg(i));
-        }
-        args << aformat;
-        for (int i = 0; i < m_channels; i++) {
-            // Channel 1
-            args << QStringLiteral("-map") << QStringLiteral("[0:%1]").arg(i) << QStringLiteral("-c:a") << QStringLiteral("pcm_s16le") << QStringLiteral("-y")
-                 << QStringLiteral("-f") << QStringLiteral("data") << channelFiles[size_t(i)]->fileName();
-        }
+    args << QStringLiteral("-vn") << QStringLiteral("-map") << QStringLiteral("0:a:%1").arg(qMax(0, m_audioStream));
+    args << QStringLiteral("-ac") << QString::number(m_channels) << QStringLiteral("-ar") << QString::number(m_frequency);
+    args << QStringLiteral("-c:a") << QStringLiteral("pcm_s16le") << QStringLiteral("-f") << QStringLiteral("s16le") << QStringLiteral("pipe:1");
+
+    QProcess ffmpeg;
+    ffmpeg.start(KdenliveSettings::ffmpegpath(), args);
+    if (!ffmpeg.waitForStarted()) {
+        qWarning() << "Failed to start FFmpeg for audio thumbs";
+        return false;
     }
-    m_ffmpegProcess = new QProcess;
-    m_ffmpegProcess->start(KdenliveSettings::ffmpegpath(), args);
-    connect(m_ffmpegProcess, &QProcess::readyReadStandardOutput, this, &AudioThumbJob::updateFfmpegProgress);
-    m_ffmpegProcess->waitForFinished(-1);
-    if (m_ffmpegProcess->exitStatus() != QProcess::CrashExit) {
-        int dataSize = 0;
-        std::vector<const qint16 *> rawChannels;
-        std::vector<QByteArray> sourceChannels;
-        for (auto &channelFile : channelFiles) {
-            channelFile->open();
-            sourceChannels.emplace_back(channelFile->readAll());
-            QByteArray &res = sourceChannels.back();
-            channelFile->close();
-            if (dataSize == 0) {
-                dataSize = res.size();
-            }
-            if (res.isEmpty() || res.size() != dataSize) {
-                // Something went wrong, abort
-                m_errorMessage.append(i18n("Audio thumbs: error reading audio thumbnail created with FFmpeg\n"));
-                return false;
-            }
-            rawChannels.emplace_back((const qint16 *)res.constData());
-        }
-        int progress = 0;
-        std::vector<long> channelsData;
-        double offset = (double)dataSize / (2.0 * m_lengthInFrames);
-        int intraOffset = 1;
-        if (offset > 1000) {
-            intraOffset = offset / 60;
-        } else if (offset > 250) {
-            intraOffset = offset / 10;
+    AudioPeaks::Builder builder(m_channels, m_frequency);
+    // Read the samples in fixed size chunks so that memory does not depend on the clip duration
+    const int frameBytes = 2 * m_channels;
+    const int chunkFrames = 1 << 15;
+    std::vector<qint16> buffer(size_t(chunkFrames * m_channels));
+    auto *data = reinterpret_cast<char *>(buffer.data());
+    const qint64 chunkBytes = (qint64)chunkFrames * frameBytes;
+    qint64 filled = 0;
+    const double expectedSamples = qMax(1., m_lengthInFrames / m_prod->get_fps() * m_frequency);
+    int progress = 0;
+    QByteArray errors;
+    auto processChunk = [&]() {
+        builder.addSamples(buffer.data(), int(filled / frameBytes));
+        filled = 0;
+        int p = qMin(99, int(100 * builder.sampleCount() / expectedSamples));
+        if (p != progress) {
+            emit jobProgress(p);
+            progress = p;
         }
-        double factor = 800.0 / 32768;
-        for (int i = 0; i < m_lengthInFrames; i++) {
-            channelsData.resize((size_t)rawChannels.size());
-            std::fill(channelsData.begin(), channelsData.end(), 0);
-            int pos = (int)(i * offset);
-            int steps = 0;
-            for (int j = 0; j < (int)offset && (pos + j < dataSize); j += intraOffset) {
-                steps++;
-                for (size_t k = 0; k < rawChannels.size(); k++) {
-                    channelsData[k] += abs(rawChannels[k][pos + j]);
-                }
-            }
-            for (long &k : channelsData) {
-                if (steps != 0) {
-                    k /= steps;
-                }
-                m_audioLevels << (int)((double)k * factor);
-            }
-            int p = 80 + (i * 20 / m_lengthInFrames);
-            if (p != progress) {
-                emit jobProgress(p);
-                progress = p;
+    };
+    auto consume = [&](const char *block, qint64 size) {
+        while (size > 0) {
+            const qint64 copied = qMin(size, chunkBytes - filled);
+            memcpy(data + filled, block, (size_t)copied);
+            filled += copied;
+            block += copied;
+            size -= copied;
+            if (filled == chunkBytes) {
+                processChunk();
             }
         }
-        m_done = true;
-        return true;
+    };
+    if (!readProcessOutput(ffmpeg, consume, [this]() { return m_isCanceled.load(); }, errors)) {
+        return false;
     }
-    QString err = m_ffmpegProcess->readAllStandardError();
-    delete m_ffmpegProcess;
-    // m_errorMessage += err;
-    // m_errorMessage.append(i18n("Failed to create FFmpeg audio thumbnails, we now try to use MLT"));
-    qWarning() << "Failed to create FFmpeg audio thumbs:\n" << err << "\n---------------------";
-    return false;
+    // Drop an incomplete sample frame at the end, if any
+    filled -= filled % frameBytes;
+    processChunk();
+    errors.append(ffmpeg.readAllStandardError());
+    if (ffmpeg.exitStatus() == QProcess::CrashExit || ffmpeg.exitCode() != 0 || builder.sampleCount() == 0) {
+        m_logDetails += QString::fromUtf8(errors);
+        qWarning() << "Failed to create FFmpeg audio thumbs:\n" << errors << "\n---------------------";
+        return false;
+    }
+    m_peaks = builder.finish(m_cachePath);
+    if (!m_peaks) {
+        m_errorMessage.append(i18n("Audio thumbs: error reading audio thumbnail created with FFmpeg\n"));
+        return false;
+    }
+    m_audioLevels = m_peaks->frameLevels(m_prod->get_fps());
+    m_done = true;
+    return true;
 }
 
-void AudioThumbJob::updateFfmpegProgress()
+// static
+bool AudioThumbJob::readProcessOutput(QProcess &process, const std::function<void(const char *, qint64)> &consume, const std::function<bool()> &canceled,
+                                      QByteArray &errors)
 {
-    QString result = m_ffmpegProcess->readAllStandardOutput();
-    const QStringList lines = result.split(QLatin1Char('\n'));
-    for (const QString &data : lines) {
-        if (data.startsWith(QStringLiteral("out_time_ms"))) {
-            double ms = data.section(QLatin1Char('='), 1).toDouble();
-            emit jobProgress((int)(ms / m_binClip->duration().ms() / 10));
-        } else {
-            m_logDetails += data + QStringLiteral("\n");
+    // Wake up regularly to check for cancelation, a stuck process would otherwise block the job forever
+    const int pollInterval = 500;
+    QByteArray buffer(1 << 16, Qt::Uninitialized);
+    while (true) {
+        if (canceled()) {
+            process.kill();
+            process.waitForFinished();
+            return false;
+        }
+        qint64 read = process.read(buffer.data(), buffer.size());
+        if (read > 0) {
+            consume(buffer.constData(), read);
+            continue;
+        }
+        errors.append(process.readAllStandardError());
+        if (read < 0) {
+            break;
+        }
+        if (!process.waitForReadyRead(pollInterval) && process.bytesAvailable() == 0 && process.state() == QProcess::NotRunning) {
+            // the process exited and all the data was consumed
+            break;
         }
     }
+    process.waitForFinished(pollInterval);
+    return true;
 }
 
 bool AudioThumbJob::startJob()
@@ -263,17 +241,9 @@ bool AudioThumbJob::startJob()
     m_cachePath = m_binClip->getAudioThumbPath();
 
     // checking for cached thumbs
-    QImage image(m_cachePath);
-    if (!image.isNull()) {
-        // convert cached image
-        int n = image.width() * image.height();
-        for (int i = 0; i < n; i++) {
-            QRgb p = image.pixel(i / m_channels, i % m_channels);
-            m_audioLevels << qRed(p);
-            m_audioLevels << qGreen(p);
-            m_audioLevels << qBlue(p);
-            m_audioLevels << qAlpha(p);
-        }
+    m_peaks = AudioPeaks::load(m_cachePath);
+    if (m_peaks && m_peaks->channels() == m_channels) {
+        m_audioLevels = m_peaks->frameLevels(m_prod->get_fps());
     }
     if (!m_audioLevels.isEmpty()) {
         m_done = true;
@@ -281,30 +251,11 @@ bool AudioThumbJob::startJob()
         return true;
     }
     bool ok = m_binClip->clipType() == ClipType::Playlist ? false : computeWithFFMPEG();
-    ok = ok ? ok : computeWithMlt();
+    ok = ok || (!m_isCanceled && computeWithMlt());
     Q_ASSERT(ok == m_done);
 
     if (ok && m_done && !m_audioLevels.isEmpty()) {
-        // Put into an image for caching.
-        int count = m_audioLevels.size();
-        image = QImage((int)lrint((count + 3) / 4.0 / m_channels), m_channels, QImage::Format_ARGB32);
-        int n = image.width() * image.height();
-        for (int i = 0; i < n; i++) {
-            QRgb p;
-            if ((4 * i + 3) < count) {
-                p = qRgba(m_audioLevels.at(4 * i), m_audioLevels.at(4 * i + 1), m_audioLevels.at(4 * i + 2),
-                          m_audioLevels.at(4 * i + 3));
-            } else {
-                int last = m_audioLevels.last();
-                int r = (4 * i + 0) < count ? m_audioLevels.at(4 * i + 0) : last;
-                int g = (4 * i + 1) < count ? m_audioLevels.at(4 * i + 1) : last;
-                int b = (4 * i + 2) < count ? m_audioLevels.at(4 * i + 2) : last;
-                int a = last;
-                p = qRgba(r, g, b, a);
-            }
-            image.setPixel(i / m_channels, i % m_channels, p);
-        }
-        image.save(m_cachePath);
+        // peaks were saved to the cache by the builder
         m_successful = true;
         return true;
     }
@@ -325,14 +276,15 @@ bool AudioThumbJob::commitResult(Fun &undo, Fun &redo)
         return false;
     }
     QList <double>old = m_binClip->audioFrameCache;
+    std::shared_ptr<AudioPeaks> oldPeaks = m_binClip->audioPeaks();
 
-    // note that the image is moved into lambda, it won't be available from this class anymore
-    auto operation = [clip = m_binClip, audio = std::move(m_audioLevels)]() {
-        clip->updateAudioThumbnail(audio);
+    // note that the levels are moved into lambda, they won't be available from this class anymore
+    auto operation = [clip = m_binClip, audio = std::move(m_audioLevels), peaks = std::move(m_peaks)]() {
+        clip->updateAudioThumbnail(audio, peaks);
         return true;
     };
-    auto reverse = [clip = m_binClip, audio = std::move(old)]() {
-        clip->updateAudioThumbnail(audio);
+    auto reverse = [clip = m_binClip, audio = std::move(old), peaks = std::move(oldPeaks)]() {
+        clip->updateAudioThumbnail(audio, peaks);
         return true;
     };
     bool ok = operation();
@@ -23,12 +23,16 @@
 
 #include "abstractclipjob.h"
 
+#include <QByteArray>
+#include <functional>
 #include <memory>
 
 /* @brief This class represents the job that corresponds to computing the audio thumb of a clip (waveform)
  */
 
+class AudioPeaks;
 class ProjectClip;
+class QProcess;
 namespace Mlt {
 class Producer;
 }
@@ -53,12 +57,16 @@ public:
     bool commitResult(Fun &undo, Fun &redo) override;
 
 protected:
+    /** @brief Stream the decoded samples from an ffmpeg process and reduce them to peaks chunk by chunk */
     bool computeWithFFMPEG();
     // MLT audio thumbs: slower but safer
     bool computeWithMlt();
-
-    // process the stdout/stderr from ffmpeg
-    void updateFfmpegProgress();
+    /** @brief Read the output of a running process until it exits, or until canceled returns true
+        @param consume is called with each block of data read
+        @param errors receives the error output of the process
+        @return false if the process was killed because of a cancelation */
+    static bool readProcessOutput(QProcess &process, const std::function<void(const char *, qint64)> &consume, const std::function<bool()> &canceled,
+                                  QByteArray &errors);
 
 private:
     std::shared_ptr<ProjectClip> m_binClip;
@@ -69,5 +77,5 @@ private:
     bool m_done{false}, m_successful{false};
     int m_channels, m_frequency, m_lengthInFrames, m_audioStream;
     QList <double>m_audioLevels;
-    QProcess *m_ffmpegProcess;
+    std::shared_ptr<AudioPeaks> m_peaks;
 };
@@ -101,10 +101,7 @@ void JobManager::discardJobs(const QString &binId, AbstractClipJob::JOBTYPE type
     }
     for (int jobId : m_jobsByClip.at(binId)) {
         if (type == AbstractClipJob::NOJOBTYPE || m_jobs.at(jobId)->m_type == type) {
-            for (const std::shared_ptr<AbstractClipJob> &job : m_jobs.at(jobId)->m_job) {
-                job->jobCanceled();
-            }
-            m_jobs.at(jobId)->m_future.cancel();
+            cancelJob(m_jobs.at(jobId));
         }
     }
 }
@@ -187,10 +184,7 @@ void JobManager::slotDiscardClipJobs(const QString &binId)
     if (m_jobsByClip.count(binId) > 0) {
         for (int jobId : m_jobsByClip.at(binId)) {
             Q_ASSERT(m_jobs.count(jobId) > 0);
-            for (const std::shared_ptr<AbstractClipJob> &job : m_jobs.at(jobId)->m_job) {
-                job->jobCanceled();
-            }
-            m_jobs[jobId]->m_future.cancel();
+            cancelJob(m_jobs.at(jobId));
         }
     }
 }
@@ -200,10 +194,7 @@ void JobManager::slotCancelPendingJobs()
     QWriteLocker locker(&m_lock);
     for (const auto &j : m_jobs) {
         if (!j.second->m_future.isStarted()) {
-            for (const std::shared_ptr<AbstractClipJob> &job : j.second->m_job) {
-                job->jobCanceled();
-            }
-            j.second->m_future.cancel();
+            cancelJob(j.second);
         }
     }
 }
@@ -212,36 +203,58 @@ void JobManager::slotCancelJobs()
 {
     QWriteLocker locker(&m_lock);
     for (const auto &j : m_jobs) {
-        for (const std::shared_ptr<AbstractClipJob> &job : j.second->m_job) {
-            job->jobCanceled();
+        cancelJob(j.second);
+    }
+}
+
+void JobManager::cancelJob(const std::shared_ptr<Job_t> &job)
+{
+    for (const std::shared_ptr<AbstractClipJob> &clipJob : job->m_job) {
+        clipJob->jobCanceled();
+    }
+    job->m_future.cancel();
+    // The pending tasks will only report their completion
+    m_scheduler.drop(job->m_id);
+}
+
+void JobManager::setVisibleClips(const QSet<QString> &binIds)
+{
+    m_scheduler.setBoostedClips(binIds);
+}
+
+void JobManager::registerJob(const std::shared_ptr<Job_t> &job, int parentId)
+{
+    connect(&job->m_future, &QFutureWatcher<bool>::started, this, &JobManager::updateJobCount);
+    connect(&job->m_future, &QFutureWatcher<bool>::finished, [this, id = job->m_id]() { slotManageFinishedJob(id); });
+    connect(&job->m_future, &QFutureWatcher<bool>::canceled, [this, id = job->m_id]() { slotManageCanceledJob(id); });
+    job->m_future.setFuture(job->m_interface.future());
+    bool waitForParent = false;
+    {
+        QWriteLocker locker(&m_lock);
+        int insertionRow = static_cast<int>(m_jobs.size());
+        beginInsertRows(QModelIndex(), insertionRow, insertionRow);
+        Q_ASSERT(m_jobs.count(job->m_id) == 0);
+        m_jobs[job->m_id] = job;
+        endInsertRows();
+        if (parentId != -1 && m_jobs.count(parentId) > 0 && !m_jobs.at(parentId)->m_completed) {
+            // The job will be started by releaseChildren when the parent completes
+            m_jobsByParents[parentId].push_back(job->m_id);
+            waitForParent = true;
         }
-        j.second->m_future.cancel();
+    }
+    if (!waitForParent) {
+        createJob(job);
     }
 }
 
 void JobManager::createJob(const std::shared_ptr<Job_t> &job)
 {
-    /*
-    // This thread wait mechanism was broken and caused a race condition locking the application
-    // so I switched to a simpler model
-    bool ok = false;
-    // wait for parents to finish
-    while (!ok) {
-        ok = true;
-        for (int p : parents) {
-            if (!m_jobs[p]->m_completionMutex.tryLock()) {
-                ok = false;
-                qDebug()<<"********\nWAITING FOR JOB COMPLETION MUTEX!!: "<<job->m_id<<" : "<<m_jobs[p]->m_id<<"="<<m_jobs[p]->m_type;
-                break;
-            } else {
-                qDebug()<<">>>>>>>>>>\nJOB COMPLETION MUTEX DONE: "<<job->m_id;
-                m_jobs[p]->m_completionMutex.unlock();
-            }
-        }
-        if (!ok) {
-            QThread::msleep(10);
-        }
-    }*/
+    if (job->m_interface.isCanceled() || job->m_job.empty()) {
+        // Canceled while waiting for its parent, or nothing to do
+        job->m_interface.reportStarted();
+        job->m_interface.reportFinished();
+        return;
+    }
     // connect progress signals
     QReadLocker locker(&m_lock);
     for (const auto &it : job->m_indices) {
@@ -252,21 +265,48 @@ void JobManager::createJob(const std::shared_ptr<Job_t> &job)
             pCore->projectItemModel()->onItemUpdated(binId, AbstractProjectItem::JobProgress);
         });
     }
-    connect(&job->m_future, &QFutureWatcher<bool>::started, this, &JobManager::updateJobCount);
-    connect(&job->m_future, &QFutureWatcher<bool>::finished, [this, id = job->m_id]() { slotManageFinishedJob(id); });
-    connect(&job->m_future, &QFutureWatcher<bool>::canceled, [this, id = job->m_id]() { slotManageCanceledJob(id); });
-    job->m_actualFuture = QtConcurrent::mapped(job->m_job, AbstractClipJob::execute);
-    job->m_future.setFuture(job->m_actualFuture);
+    locker.unlock();
+    job->m_remaining = int(job->m_job.size());
+    for (size_t i = 0; i < job->m_job.size(); ++i) {
+        const std::shared_ptr<AbstractClipJob> &clipJob = job->m_job[i];
+        m_scheduler.schedule(job->m_id, clipJob->clipId(), clipJob->priority(), clipJob->resource(), [job, i](bool run) {
+            bool result = false;
+            if (run && !job->m_interface.isCanceled()) {
+                job->m_interface.reportStarted();
+                result = AbstractClipJob::execute(job->m_job[i]);
+            }
+            job->m_interface.reportResult(result, int(i));
+            if (--job->m_remaining == 0) {
+                // Triggers slotManageFinishedJob through the watcher
+                job->m_interface.reportFinished();
+            }
+        });
+    }
+}
 
-    // In the unlikely event that the job finished before the signal connection was made, we check manually for finish and cancel
-    /*if (job->m_future.isFinished()) {
-        //emit job->m_future.finished();
-        slotManageFinishedJob(job->m_id);
+void JobManager::releaseChildren(int id, bool run)
+{
+    std::vector<std::shared_ptr<Job_t>> children;
+    {
+        QWriteLocker locker(&m_lock);
+        m_jobs.at(id)->m_completed = true;
+        if (m_jobsByParents.count(id) > 0) {
+            for (int cid : m_jobsByParents.at(id)) {
+                children.push_back(m_jobs.at(cid));
+            }
+            m_jobsByParents.erase(id);
+        }
+    }
+    for (const auto &child : children) {
+        if (run) {
+            createJob(child);
+        } else {
+            // The parent failed, its children cannot run. Their own children are released by the canceled signal
+            cancelJob(child);
+            child->m_interface.reportStarted();
+            child->m_interface.reportFinished();
+        }
     }
-    if (job->m_future.isCanceled()) {
-        //emit job->m_future.canceled();
-        slotManageCanceledJob(job->m_id);
-    }*/
 }
 
 void JobManager::slotManageCanceledJob(int id)
@@ -275,12 +315,12 @@ void JobManager::slotManageCanceledJob(int id)
     Q_ASSERT(m_jobs.count(id) > 0);
     if (m_jobs[id]->m_processed) return;
     m_jobs[id]->m_processed = true;
-    m_jobs[id]->m_completionMutex.unlock();
     // send notification to refresh view
     for (const auto &it : m_jobs[id]->m_indices) {
         pCore->projectItemModel()->onItemUpdated(it.first, AbstractProjectItem::JobStatus);
     }
-    // TODO: delete child jobs
+    locker.unlock();
+    releaseChildren(id, false);
     updateJobCount();
 }
 void JobManager::slotManageFinishedJob(int id)
@@ -302,9 +342,8 @@ void JobManager::slotManageFinishedJob(int id)
     Fun redo = []() { return true; };
     if (!ok) {
         qDebug() << " * * * ** * * *\nWARNING + + +\nJOB NOT CORRECT FINISH: " << id << "\n------------------------";
-        // TODO: delete child jobs
-        m_jobs[id]->m_completionMutex.unlock();
         locker.unlock();
+        releaseChildren(id, false);
         if (m_jobs.at(id)->m_type == AbstractClipJob::LOADJOB) {
             // loading failed, remove clip
             for (const auto &it : m_jobs[id]->m_indices) {
@@ -359,17 +398,10 @@ void JobManager::slotManageFinishedJob(int id)
             }
         }
     }
-    m_jobs[id]->m_completionMutex.unlock();
     if (ok && !m_jobs[id]->m_undoString.isEmpty()) {
         pCore->pushUndo(undo, redo, m_jobs[id]->m_undoString);
     }
-    if (m_jobsByParents.count(id) > 0) {
-        std::vector<int> children = m_jobsByParents[id];
-        for (int cid : children) {
-            QtConcurrent::run(this, &JobManager::createJob, m_jobs[cid]);
-        }
-        m_jobsByParents.erase(id);
-    }
+    releaseChildren(id, ok);
     updateJobCount();
 }
 
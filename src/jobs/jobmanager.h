@@ -25,11 +25,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "abstractclipjob.h"
 #include "definitions.h"
+#include "jobscheduler.hpp"
 
 #include <QAbstractListModel>
+#include <QFutureInterface>
 #include <QFutureWatcher>
 #include <QObject>
 #include <QReadWriteLock>
+#include <atomic>
 #include <map>
 #include <memory>
 #include <unordered_map>
@@ -51,13 +54,14 @@ struct Job_t
     std::vector<int> m_progress;                         // progress of the job, for each clip
     std::unordered_map<QString, size_t> m_indices;       // keys are binIds, value are ids in the vectors m_job and m_progress;
     QFutureWatcher<bool> m_future;                       // future of the job
-    QFuture<bool> m_actualFuture;
-    QMutex m_completionMutex; // mutex that is locked during execution of the process
+    QFutureInterface<bool> m_interface;                  // the results of the scheduled tasks are reported here
+    std::atomic<int> m_remaining{0};                     // number of tasks not completed yet
     AbstractClipJob::JOBTYPE m_type;
     QString m_undoString;
     int m_id;
     bool m_processed = false; // flag that we set to true when we are done with this job
     bool m_failed = false;    // flag that we set to true when a problem occurred
+    bool m_completed = false; // set with the write lock held once children can no longer be attached to this job
 };
 
 class AudioThumbJob;
@@ -132,14 +136,24 @@ public:
     /** @brief return the message of a given job on a given clip (message, detailed log)*/
     QPair<QString, QString> getJobMessageForClip(int jobId, const QString &binId) const;
 
+    /** @brief Give precedence to the jobs of the given clips, for example the ones visible in the bin.
+     *  @param binIds the clips to boost, replacing the previously boosted ones
+     */
+    void setVisibleClips(const QSet<QString> &binIds);
+
     // Mandatory overloads
     QVariant data(const QModelIndex &index, int role) const override;
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
 
 protected:
-    // Helper function to launch a given job.
-    // This has to be launched asynchrnously since it blocks until all parents are finished
+    // Insert a newly built job, it is started immediately or when its parent completes
+    void registerJob(const std::shared_ptr<Job_t> &job, int parentId);
+    // Helper function to send the tasks of a job to the scheduler
     void createJob(const std::shared_ptr<Job_t> &job);
+    // Mark a job completed, then start its children, or cancel them if run is false
+    void releaseChildren(int id, bool run);
+    // Cancel a job and drop its pending tasks
+    void cancelJob(const std::shared_ptr<Job_t> &job);
 
     void updateJobCount();
 
@@ -163,7 +177,10 @@ private:
     std::map<int, std::shared_ptr<Job_t>> m_jobs;
     /** @brief List of all the jobs by clip. */
     std::unordered_map<QString, std::vector<int>> m_jobsByClip;
+    /** @brief Jobs waiting for another one to complete, by parent id. */
     std::unordered_map<int, std::vector<int>> m_jobsByParents;
+    /** @brief Runs the tasks of the jobs, with priority and resource classes. */
+    JobScheduler m_scheduler;
 
 signals:
     void jobCount(int);
@@ -30,7 +30,6 @@ int JobManager::startJob(const std::vector<QString> &binIds, int parentId, QStri
     // QWriteLocker locker(&m_lock);
     int jobId = m_currentId++;
     std::shared_ptr<Job_t> job(new Job_t());
-    job->m_completionMutex.lock();
     job->m_undoString = std::move(undoString);
     job->m_id = jobId;
     for (const auto &id : binIds) {
@@ -40,21 +39,7 @@ int JobManager::startJob(const std::vector<QString> &binIds, int parentId, QStri
         job->m_type = job->m_job.back()->jobType();
         m_jobsByClip[id].push_back(jobId);
     }
-    m_lock.lockForWrite();
-    int insertionRow = static_cast<int>(m_jobs.size());
-    beginInsertRows(QModelIndex(), insertionRow, insertionRow);
-    Q_ASSERT(m_jobs.count(jobId) == 0);
-    m_jobs[jobId] = job;
-    endInsertRows();
-    m_lock.unlock();
-    if (parentId == -1 || m_jobs[parentId]->m_completionMutex.tryLock()) {
-        if (parentId != -1) {
-            m_jobs[parentId]->m_completionMutex.unlock();
-        }
-        QtConcurrent::run(this, &JobManager::createJob, job);
-    } else {
-        m_jobsByParents[parentId].push_back(jobId);
-    }
+    registerJob(job, parentId);
     return jobId;
 }
 
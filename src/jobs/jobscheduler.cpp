@@ -0,0 +1,176 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "jobscheduler.hpp"
+
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <vector>
+
+class JobSchedulerRunnable : public QRunnable
+{
+public:
+    JobSchedulerRunnable(JobScheduler *scheduler, int resource, JobScheduler::Task task)
+        : m_scheduler(scheduler)
+        , m_resource(resource)
+        , m_task(std::move(task))
+    {
+    }
+    void run() override
+    {
+        m_task(true);
+        // Release the captured job data before the next task starts
+        m_task = nullptr;
+        m_scheduler->taskDone(m_resource);
+    }
+
+private:
+    JobScheduler *m_scheduler;
+    int m_resource;
+    JobScheduler::Task m_task;
+};
+
+JobScheduler::JobScheduler()
+{
+    const int cores = qMax(1, QThread::idealThreadCount());
+    m_running.fill(0);
+    // Thumbnails and audio levels are decoded in process
+    m_limits[AbstractClipJob::CPURESOURCE] = cores;
+    // Loading mostly waits for the disk
+    m_limits[AbstractClipJob::IORESOURCE] = qBound(2, cores / 2, 4);
+    // Transcoders are multithreaded themselves
+    m_limits[AbstractClipJob::PROCESSRESOURCE] = qBound(1, cores / 4, 2);
+    m_pool.setMaxThreadCount(m_limits[0] + m_limits[1] + m_limits[2]);
+}
+
+JobScheduler::~JobScheduler()
+{
+    std::vector<Task> dropped;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_closing = true;
+        for (auto &queue : m_queues) {
+            for (auto &pending : queue) {
+                dropped.push_back(std::move(pending.second.task));
+            }
+            queue.clear();
+        }
+    }
+    for (const Task &task : dropped) {
+        task(false);
+    }
+    m_pool.waitForDone();
+}
+
+void JobScheduler::setLimit(AbstractClipJob::JOBRESOURCE resource, int limit)
+{
+    QMutexLocker locker(&m_mutex);
+    m_limits[resource] = qMax(1, limit);
+    m_pool.setMaxThreadCount(m_limits[0] + m_limits[1] + m_limits[2]);
+    dispatch();
+}
+
+int JobScheduler::limit(AbstractClipJob::JOBRESOURCE resource) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_limits[resource];
+}
+
+void JobScheduler::schedule(int jobId, const QString &binId, AbstractClipJob::JOBPRIORITY priority, AbstractClipJob::JOBRESOURCE resource, Task task)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_closing) {
+        locker.unlock();
+        task(false);
+        return;
+    }
+    Key key(int(priority), m_boosted.contains(binId) ? 0 : 1, m_sequence++);
+    m_queues[resource].emplace(key, Pending{jobId, binId, std::move(task)});
+    dispatch();
+}
+
+void JobScheduler::drop(int jobId)
+{
+    std::vector<Task> dropped;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (auto &queue : m_queues) {
+            for (auto it = queue.begin(); it != queue.end();) {
+                if (it->second.jobId == jobId) {
+                    dropped.push_back(std::move(it->second.task));
+                    it = queue.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+    // Tasks may call back into the job manager, don't hold our lock
+    for (const Task &task : dropped) {
+        task(false);
+    }
+}
+
+void JobScheduler::setBoostedClips(const QSet<QString> &binIds)
+{
+    QMutexLocker locker(&m_mutex);
+    m_boosted = binIds;
+    for (auto &queue : m_queues) {
+        std::map<Key, Pending> sorted;
+        for (auto &pending : queue) {
+            Key key = pending.first;
+            std::get<1>(key) = m_boosted.contains(pending.second.binId) ? 0 : 1;
+            sorted.emplace(key, std::move(pending.second));
+        }
+        queue.swap(sorted);
+    }
+}
+
+int JobScheduler::pendingCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    int count = 0;
+    for (const auto &queue : m_queues) {
+        count += int(queue.size());
+    }
+    return count;
+}
+
+void JobScheduler::dispatch()
+{
+    for (int resource = 0; resource < ResourceCount; ++resource) {
+        auto &queue = m_queues[resource];
+        while (!queue.empty() && m_running[resource] < m_limits[resource]) {
+            auto first = queue.begin();
+            Task task = std::move(first->second.task);
+            queue.erase(first);
+            m_running[resource]++;
+            m_pool.start(new JobSchedulerRunnable(this, resource, std::move(task)));
+        }
+    }
+}
+
+void JobScheduler::taskDone(int resource)
+{
+    QMutexLocker locker(&m_mutex);
+    m_running[resource]--;
+    dispatch();
+}
@@ -0,0 +1,96 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#pragma once
+
+#include "abstractclipjob.h"
+
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <array>
+#include <functional>
+#include <map>
+#include <tuple>
+
+/** @brief This class runs the clip jobs tasks on its own thread pool.
+    Each resource class (see AbstractClipJob::JOBRESOURCE) has its own queue and its own concurrency limit, so that a few proxy jobs waiting for an
+    external process cannot starve thumbnail creation. Inside a queue, tasks are sorted by priority class, then tasks working on a boosted clip (for
+    example visible in the bin) come first, then tasks are run in submission order.
+    All methods are thread safe.
+ */
+class JobScheduler
+{
+
+public:
+    /* @brief A task receives false if it was dropped before running, in which case it must only report its completion */
+    using Task = std::function<void(bool)>;
+
+    JobScheduler();
+    /* @brief Drops the pending tasks and waits for the running ones */
+    ~JobScheduler();
+
+    /* @brief Set the maximum number of tasks running at the same time for a resource class */
+    void setLimit(AbstractClipJob::JOBRESOURCE resource, int limit);
+    int limit(AbstractClipJob::JOBRESOURCE resource) const;
+
+    /* @brief Queue a task
+       @param jobId is the JobManager id of the job this task belongs to
+       @param binId is the clip this task works on, used for boosting
+    */
+    void schedule(int jobId, const QString &binId, AbstractClipJob::JOBPRIORITY priority, AbstractClipJob::JOBRESOURCE resource, Task task);
+
+    /* @brief Remove the pending tasks of a job, they are called with false */
+    void drop(int jobId);
+
+    /* @brief Set the clips whose tasks should run first in their priority class. This replaces the previous set */
+    void setBoostedClips(const QSet<QString> &binIds);
+
+    /* @brief Returns the number of pending (not yet running) tasks */
+    int pendingCount() const;
+
+protected:
+    // priority, 0 if boosted (1 otherwise), submission order
+    using Key = std::tuple<int, int, quint64>;
+    struct Pending
+    {
+        int jobId;
+        QString binId;
+        Task task;
+    };
+    static const int ResourceCount = 3;
+
+    // Start as many tasks as the limits allow. Must be called with m_mutex held
+    void dispatch();
+    // Called by the pool threads when a task is done
+    void taskDone(int resource);
+
+    mutable QMutex m_mutex;
+    QThreadPool m_pool;
+    std::array<std::map<Key, Pending>, ResourceCount> m_queues;
+    std::array<int, ResourceCount> m_running;
+    std::array<int, ResourceCount> m_limits;
+    QSet<QString> m_boosted;
+    quint64 m_sequence{0};
+    bool m_closing{false};
+
+    friend class JobSchedulerRunnable;
+};
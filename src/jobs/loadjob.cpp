@@ -31,6 +31,8 @@
 #include "macros.hpp"
 #include "profiles/profilemodel.hpp"
 #include "project/dialogs/slideshowclip.h"
+#include "utils/filehashcache.hpp"
+#include "utils/mediaprobecache.hpp"
 #include "xml/xml.hpp"
 #include <KMessageWidget>
 #include <QMimeDatabase>
@@ -254,6 +256,10 @@ bool LoadJob::startJob()
     if (type == ClipType::Unknown) {
         type = getTypeForService(service, m_resource);
     }
+    // Path of the media file, before a service prefix is added to the resource
+    const QString mediaPath = m_resource;
+    QMap<QString, QString> cachedProbe;
+    bool fromCache = false;
     switch (type) {
     case ClipType::Color:
         m_producer = loadResource(m_resource, QStringLiteral("color:"));
@@ -270,6 +276,21 @@ bool LoadJob::startJob()
         break;
     case ClipType::SlideShow:
     default:
+        if (type != ClipType::SlideShow && (service.isEmpty() || service.startsWith(QLatin1String("avformat"))) &&
+            MediaProbeCache::get()->lookup(mediaPath, pCore->getCurrentProfile()->fps(), cachedProbe)) {
+            // The file did not change since it was last probed, don't open it now
+            m_producer = std::make_shared<Mlt::Producer>(pCore->getCurrentProfile()->profile(), "avformat-novalidate", mediaPath.toUtf8().constData());
+            if (m_producer->is_valid()) {
+                QMapIterator<QString, QString> i(cachedProbe);
+                while (i.hasNext()) {
+                    i.next();
+                    m_producer->set(i.key().toUtf8().constData(), i.value().toUtf8().constData());
+                }
+                m_producer->set("mlt_service", "avformat");
+                fromCache = true;
+                break;
+            }
+        }
         if (!service.isEmpty()) {
             service.append(QChar(':'));
             m_producer = loadResource(m_resource, service);
@@ -290,6 +311,18 @@ bool LoadJob::startJob()
         m_errorMessage.append(i18n("ERROR: Could not load clip %1: producer is invalid", m_resource));
         return false;
     }
+    if (fromCache) {
+        MediaProbeCache::get()->validate(m_clipId, mediaPath);
+    } else if (type != ClipType::SlideShow && QString(m_producer->get("mlt_service")).startsWith(QLatin1String("avformat"))) {
+        MediaProbeCache::get()->store(mediaPath, pCore->getCurrentProfile()->fps(), MediaProbeCache::probedProperties(*m_producer));
+    }
+    if (type != ClipType::Color && type != ClipType::Text && type != ClipType::TextTemplate && type != ClipType::QText && type != ClipType::SlideShow &&
+        Xml::getXmlProperty(m_xml, QStringLiteral("kdenlive:file_hash")).isEmpty()) {
+        // Compute the file hash now, so that load jobs hash their clips in parallel and the bin finds it in the cache.
+        // Clips of a saved project already know their hash
+        QString originalUrl = Xml::getXmlProperty(m_xml, QStringLiteral("kdenlive:originalurl"));
+        FileHashCache::get()->hash(originalUrl.isEmpty() ? mediaPath : originalUrl);
+    }
     processProducerProperties(m_producer, m_xml);
     QString clipName = Xml::getXmlProperty(m_xml, QStringLiteral("kdenlive:clipname"));
     if (clipName.isEmpty()) {
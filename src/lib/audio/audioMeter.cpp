@@ -0,0 +1,273 @@
+/***************************************************************************
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "audioMeter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIOMETER_SSE2
+#include <emmintrin.h>
+#endif
+
+const float AudioMeter::MinLevel = -100;
+
+namespace {
+// Loudness blocks of 100 ms, the momentary window is 4 blocks and the short-term one 30
+const int momentaryBlocks = 4;
+const int shortTermBlocks = 30;
+// Length of the true peak interpolation filter, at the oversampled rate
+const int interpolatorTaps = 49;
+
+float toDb(double level)
+{
+    if (level <= 0) {
+        return AudioMeter::MinLevel;
+    }
+    return std::max(AudioMeter::MinLevel, float(20 * std::log10(level)));
+}
+} // namespace
+
+AudioMeter::Levels::Levels()
+    : momentary(MinLevel)
+    , shortTerm(MinLevel)
+{
+    std::fill(peak, peak + MaxChannels, MinLevel);
+    std::fill(rms, rms + MaxChannels, MinLevel);
+    std::fill(truePeak, truePeak + MaxChannels, MinLevel);
+}
+
+bool AudioMeter::Ring::push(const AudioMeter::Levels &levels)
+{
+    const int write = m_write.load(std::memory_order_relaxed);
+    const int next = (write + 1) % Size;
+    if (next == m_read.load(std::memory_order_acquire)) {
+        // Full
+        return false;
+    }
+    m_levels[write] = levels;
+    m_write.store(next, std::memory_order_release);
+    return true;
+}
+
+bool AudioMeter::Ring::pop(AudioMeter::Levels &levels)
+{
+    const int read = m_read.load(std::memory_order_relaxed);
+    if (read == m_write.load(std::memory_order_acquire)) {
+        // Empty
+        return false;
+    }
+    levels = m_levels[read];
+    m_read.store((read + 1) % Size, std::memory_order_release);
+    return true;
+}
+
+AudioMeter::AudioMeter() = default;
+
+void AudioMeter::configure(int channels, int frequency)
+{
+    m_channels = channels;
+    m_frequency = frequency;
+
+    // K-weighting, a high shelf followed by a high pass filter, adapted to the sample rate
+    double f0 = 1681.974450955533;
+    double q = 0.7071752369554196;
+    double k = std::tan(M_PI * f0 / frequency);
+    const double vh = std::pow(10.0, 3.999843853973347 / 20.0);
+    const double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    m_shelf = {(vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = std::tan(M_PI * f0 / frequency);
+    a0 = 1.0 + k / q + k * k;
+    m_highPass = {1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+
+    // BS.1770 channel weights: the LFE is ignored and surround channels count more
+    m_channelWeights.assign((size_t)channels, 1.0);
+    if (channels >= 6) {
+        m_channelWeights[3] = 0;
+        for (int i = 4; i < channels; ++i) {
+            m_channelWeights[(size_t)i] = 1.41;
+        }
+    }
+
+    // True peak: 4x oversampling is enough up to 96kHz, higher rates need less
+    m_oversampling = frequency < 96000 ? 4 : (frequency < 192000 ? 2 : 1);
+    m_phaseTaps = (interpolatorTaps + m_oversampling - 1) / m_oversampling;
+    m_interpolator.assign((size_t)(m_oversampling * m_phaseTaps), 0.f);
+    if (m_oversampling > 1) {
+        // Hann windowed sinc, stored by phase
+        for (int j = 0; j < interpolatorTaps; ++j) {
+            const double m = j - (interpolatorTaps - 1) / 2.0;
+            double c = 1.0;
+            if (std::fabs(m) > 1e-6) {
+                c = std::sin(m * M_PI / m_oversampling) / (m * M_PI / m_oversampling);
+            }
+            c *= 0.5 * (1.0 - std::cos(2.0 * M_PI * j / (interpolatorTaps - 1)));
+            m_interpolator[(size_t)((j % m_oversampling) * m_phaseTaps + j / m_oversampling)] = (float)c;
+        }
+    }
+
+    m_blockSize = std::max(1, frequency / 10);
+    reset();
+}
+
+void AudioMeter::reset()
+{
+    m_filterState.assign((size_t)m_channels * 4, 0.);
+    m_history.assign((size_t)(m_channels * std::max(0, m_phaseTaps - 1)), 0.f);
+    m_blockSamples = 0;
+    m_blockSum = 0;
+    m_blocks.clear();
+}
+
+// static
+void AudioMeter::peaksAndSquares(const qint16 *samples, int channels, int count, int *peaks, double *squares, bool allowSimd)
+{
+    const int total = count * channels;
+    int i = 0;
+#ifdef AUDIOMETER_SSE2
+    if (allowSimd && 8 % channels == 0) {
+        // Each lane always holds the same channel
+        __m128i maxValues = _mm_set1_epi16(-32768);
+        __m128i minValues = _mm_set1_epi16(32767);
+        __m128d sums[4] = {_mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd()};
+        for (; i + 8 <= total; i += 8) {
+            const __m128i values = _mm_loadu_si128((const __m128i *)(samples + i));
+            maxValues = _mm_max_epi16(maxValues, values);
+            minValues = _mm_min_epi16(minValues, values);
+            // 32 bit squares, from the low and high halves of the 16 bit products
+            const __m128i low = _mm_mullo_epi16(values, values);
+            const __m128i high = _mm_mulhi_epi16(values, values);
+            const __m128i squares0 = _mm_unpacklo_epi16(low, high);
+            const __m128i squares1 = _mm_unpackhi_epi16(low, high);
+            sums[0] = _mm_add_pd(sums[0], _mm_cvtepi32_pd(squares0));
+            sums[1] = _mm_add_pd(sums[1], _mm_cvtepi32_pd(_mm_srli_si128(squares0, 8)));
+            sums[2] = _mm_add_pd(sums[2], _mm_cvtepi32_pd(squares1));
+            sums[3] = _mm_add_pd(sums[3], _mm_cvtepi32_pd(_mm_srli_si128(squares1, 8)));
+        }
+        qint16 laneMax[8];
+        qint16 laneMin[8];
+        double laneSums[8];
+        _mm_storeu_si128((__m128i *)laneMax, maxValues);
+        _mm_storeu_si128((__m128i *)laneMin, minValues);
+        for (int lane = 0; lane < 4; ++lane) {
+            _mm_storeu_pd(laneSums + 2 * lane, sums[lane]);
+        }
+        if (i > 0) {
+            for (int lane = 0; lane < 8; ++lane) {
+                const int channel = lane % channels;
+                peaks[channel] = std::max(peaks[channel], std::max((int)laneMax[lane], -(int)laneMin[lane]));
+                squares[channel] += laneSums[lane];
+            }
+        }
+    }
+#else
+    Q_UNUSED(allowSimd)
+#endif
+    for (; i < total; ++i) {
+        const int channel = i % channels;
+        const int value = samples[i];
+        peaks[channel] = std::max(peaks[channel], std::abs(value));
+        squares[channel] += double(value * value);
+    }
+}
+
+float AudioMeter::loudness(int blocks) const
+{
+    const int n = std::min(blocks, (int)m_blocks.size());
+    if (n == 0) {
+        return MinLevel;
+    }
+    double sum = 0;
+    for (auto it = m_blocks.end() - n; it != m_blocks.end(); ++it) {
+        sum += *it;
+    }
+    if (sum <= 0) {
+        return MinLevel;
+    }
+    return std::max(MinLevel, float(-0.691 + 10 * std::log10(sum / n)));
+}
+
+AudioMeter::Levels AudioMeter::process(const qint16 *samples, int channels, int frequency, int count)
+{
+    Levels levels;
+    if (samples == nullptr || channels <= 0 || channels > MaxChannels || frequency <= 0 || count <= 0) {
+        return levels;
+    }
+    if (channels != m_channels || frequency != m_frequency) {
+        configure(channels, frequency);
+    }
+    levels.channels = channels;
+
+    int peaks[MaxChannels] = {0};
+    double squares[MaxChannels] = {0};
+    peaksAndSquares(samples, channels, count, peaks, squares);
+
+    const int history = m_phaseTaps - 1;
+    std::vector<float> input((size_t)(history + count));
+    for (int c = 0; c < channels; ++c) {
+        levels.peak[c] = toDb(peaks[c] / 32768.);
+        levels.rms[c] = toDb(std::sqrt(squares[c] / count) / 32768.);
+
+        // True peak, on the oversampled signal
+        float truePeak = peaks[c] / 32768.f;
+        if (m_oversampling > 1) {
+            float *channelHistory = m_history.data() + c * history;
+            std::copy(channelHistory, channelHistory + history, input.begin());
+            for (int i = 0; i < count; ++i) {
+                input[(size_t)(history + i)] = samples[i * channels + c] / 32768.f;
+            }
+            for (int i = 0; i < count; ++i) {
+                // The newest sample is input[history + i]
+                const float *last = input.data() + history + i;
+                for (int phase = 0; phase < m_oversampling; ++phase) {
+                    const float *coefficients = m_interpolator.data() + phase * m_phaseTaps;
+                    float value = 0;
+                    for (int k = 0; k < m_phaseTaps; ++k) {
+                        value += coefficients[k] * last[-k];
+                    }
+                    truePeak = std::max(truePeak, std::fabs(value));
+                }
+            }
+            std::copy(input.end() - history, input.end(), channelHistory);
+        }
+        levels.truePeak[c] = toDb(truePeak);
+    }
+
+    // Loudness, on the K-weighted signal
+    for (int i = 0; i < count; ++i) {
+        const qint16 *frame = samples + i * channels;
+        for (int c = 0; c < channels; ++c) {
+            double *state = m_filterState.data() + 4 * c;
+            const double x = frame[c] / 32768.;
+            // Transposed direct form II
+            const double shelf = m_shelf.b0 * x + state[0];
+            state[0] = m_shelf.b1 * x - m_shelf.a1 * shelf + state[1];
+            state[1] = m_shelf.b2 * x - m_shelf.a2 * shelf;
+            const double y = m_highPass.b0 * shelf + state[2];
+            state[2] = m_highPass.b1 * shelf - m_highPass.a1 * y + state[3];
+            state[3] = m_highPass.b2 * shelf - m_highPass.a2 * y;
+            m_blockSum += m_channelWeights[(size_t)c] * y * y;
+        }
+        if (++m_blockSamples == m_blockSize) {
+            if ((int)m_blocks.size() == shortTermBlocks) {
+                m_blocks.erase(m_blocks.begin());
+            }
+            m_blocks.push_back(m_blockSum / m_blockSize);
+            m_blockSum = 0;
+            m_blockSamples = 0;
+        }
+    }
+    levels.momentary = loudness(momentaryBlocks);
+    levels.shortTerm = loudness(shortTermBlocks);
+    return levels;
+}
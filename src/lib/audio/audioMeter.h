@@ -0,0 +1,106 @@
+/***************************************************************************
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef AUDIOMETER_H
+#define AUDIOMETER_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <vector>
+
+/**
+  Measures the levels of a stream of interleaved 16 bit samples, frame after frame.
+
+  For each frame, we compute per channel:
+    - the sample peak and RMS level (dBFS),
+    - the true peak (dBTP), estimated on a 4x oversampled signal as described in ITU-R BS.1770,
+  and the EBU R128 momentary (400 ms) and short-term (3 s) loudness (LUFS) of all channels.
+
+  Loudness is measured on the K-weighted signal in blocks of 100 ms, the windows are made of the
+  last blocks. Channels are weighted as in BS.1770, assuming the usual L R C LFE Ls Rs layout.
+  Frames are expected to follow each other, reset() must be called after a seek.
+  */
+class AudioMeter
+{
+public:
+    static const int MaxChannels = 16;
+    /** Value used for silence */
+    static const float MinLevel;
+
+    struct Levels
+    {
+        Levels();
+        int channels{0};
+        float peak[MaxChannels];
+        float rms[MaxChannels];
+        float truePeak[MaxChannels];
+        float momentary;
+        float shortTerm;
+    };
+
+    /** @brief Single producer, single consumer queue of levels, that never blocks or allocates.
+        The meter thread pushes the levels of each frame, the GUI thread pops them when it refreshes */
+    class Ring
+    {
+    public:
+        static const int Size = 32;
+        /** @brief Add levels, dropped if the consumer is too late. Only call from the producer thread */
+        bool push(const Levels &levels);
+        /** @brief Take the oldest levels. Only call from the consumer thread */
+        bool pop(Levels &levels);
+
+    private:
+        Levels m_levels[Size];
+        std::atomic<int> m_read{0};
+        std::atomic<int> m_write{0};
+    };
+
+    AudioMeter();
+
+    /** @brief Forget the previous samples, the next frame starts a new measure */
+    void reset();
+    /** @brief Measure the levels of a frame
+        @param samples are interleaved, samples * channels values
+        @param channels must be at most MaxChannels */
+    Levels process(const qint16 *samples, int channels, int frequency, int count);
+
+    /** @brief Computes the largest absolute value and the sum of squares of each channel of interleaved samples,
+        using SSE2 when available and allowed. Peaks and squares are added to the given arrays */
+    static void peaksAndSquares(const qint16 *samples, int channels, int count, int *peaks, double *squares, bool allowSimd = true);
+
+private:
+    struct Biquad
+    {
+        double b0, b1, b2, a1, a2;
+    };
+    void configure(int channels, int frequency);
+    /** @brief Loudness of the last blocks, in LUFS */
+    float loudness(int blocks) const;
+
+    int m_channels{0};
+    int m_frequency{0};
+    // K-weighting filters and their state (2 values per filter and channel)
+    Biquad m_shelf;
+    Biquad m_highPass;
+    std::vector<double> m_filterState;
+    std::vector<double> m_channelWeights;
+    // Oversampling filter, m_oversampling phases of m_phaseTaps coefficients
+    int m_oversampling{1};
+    int m_phaseTaps{0};
+    std::vector<float> m_interpolator;
+    // Last input samples of each channel, needed by the oversampling filter
+    std::vector<float> m_history;
+    // Weighted mean square of the loudness blocks, most recent last
+    int m_blockSize{0};
+    int m_blockSamples{0};
+    double m_blockSum{0};
+    std::vector<double> m_blocks;
+};
+
+#endif
@@ -0,0 +1,313 @@
+/***************************************************************************
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "audioPeaks.h"
+
+#include <QDebug>
+#include <QSaveFile>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+const quint32 AudioPeaks::Version = 1;
+const quint32 AudioPeaks::BaseSamplesPerPeak = 128;
+const quint32 AudioPeaks::LevelFactor = 4;
+
+namespace {
+const char peaksMagic[4] = {'K', 'D', 'A', 'P'};
+const int headerSize = 32;
+const int levelEntrySize = 24;
+const int maxLevels = 8;
+} // namespace
+
+AudioPeaks::AudioPeaks()
+    : m_map(nullptr)
+    , m_channels(0)
+    , m_sampleRate(0)
+    , m_sampleCount(0)
+{
+}
+
+AudioPeaks::~AudioPeaks()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+    }
+}
+
+std::shared_ptr<AudioPeaks> AudioPeaks::load(const QString &path)
+{
+    std::shared_ptr<AudioPeaks> peaks(new AudioPeaks());
+    peaks->m_file.setFileName(path);
+    if (!peaks->m_file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+    qint64 size = peaks->m_file.size();
+    peaks->m_map = peaks->m_file.map(0, size);
+    const uchar *data = peaks->m_map;
+    if (data == nullptr) {
+        // Mapping is not available, read the file in memory
+        if (size > std::numeric_limits<int>::max()) {
+            qDebug() << "// Audio peak file too large to be read in memory" << path;
+            return nullptr;
+        }
+        peaks->m_buffer = peaks->m_file.readAll();
+        data = reinterpret_cast<const uchar *>(peaks->m_buffer.constData());
+        size = peaks->m_buffer.size();
+    }
+    if (!peaks->parse(data, size)) {
+        qDebug() << "// Invalid audio peak file" << path;
+        return nullptr;
+    }
+    return peaks;
+}
+
+bool AudioPeaks::parse(const uchar *data, qint64 size)
+{
+    if (size < headerSize || memcmp(data, peaksMagic, 4) != 0 || qFromLittleEndian<quint32>(data + 4) != Version) {
+        return false;
+    }
+    m_channels = (int)qFromLittleEndian<quint32>(data + 8);
+    m_sampleRate = (int)qFromLittleEndian<quint32>(data + 12);
+    m_sampleCount = qFromLittleEndian<qint64>(data + 16);
+    int count = (int)qFromLittleEndian<quint32>(data + 24);
+    if (m_channels <= 0 || m_sampleRate <= 0 || count <= 0 || count > maxLevels || size < headerSize + count * levelEntrySize) {
+        return false;
+    }
+    m_levels.clear();
+    for (int i = 0; i < count; ++i) {
+        const uchar *entry = data + headerSize + i * levelEntrySize;
+        Level level;
+        level.samplesPerPeak = qFromLittleEndian<quint32>(entry);
+        level.count = qFromLittleEndian<qint64>(entry + 8);
+        qint64 offset = qFromLittleEndian<qint64>(entry + 16);
+        if (level.samplesPerPeak == 0 || level.count < 0 || offset < 0 || offset % 2 != 0 || offset + level.count * m_channels * 4 > size) {
+            return false;
+        }
+        level.data = reinterpret_cast<const qint16 *>(data + offset);
+        m_levels.push_back(level);
+    }
+    return true;
+}
+
+int AudioPeaks::channels() const
+{
+    return m_channels;
+}
+
+int AudioPeaks::sampleRate() const
+{
+    return m_sampleRate;
+}
+
+qint64 AudioPeaks::sampleCount() const
+{
+    return m_sampleCount;
+}
+
+int AudioPeaks::levelCount() const
+{
+    return (int)m_levels.size();
+}
+
+const AudioPeaks::Level &AudioPeaks::level(int index) const
+{
+    return m_levels[(size_t)index];
+}
+
+int AudioPeaks::levelForResolution(double samplesPerPixel) const
+{
+    int result = 0;
+    for (int i = 1; i < levelCount(); ++i) {
+        if (m_levels[(size_t)i].samplesPerPeak > samplesPerPixel) {
+            break;
+        }
+        result = i;
+    }
+    return result;
+}
+
+bool AudioPeaks::peak(int levelIndex, int channel, qint64 firstSample, qint64 lastSample, qint16 &min, qint16 &max) const
+{
+    const Level &l = m_levels[(size_t)levelIndex];
+    firstSample = qMax(firstSample, (qint64)0);
+    lastSample = qMin(lastSample, m_sampleCount);
+    if (firstSample >= lastSample || channel < 0 || channel >= m_channels) {
+        return false;
+    }
+    qint64 first = firstSample / l.samplesPerPeak;
+    qint64 last = qMin((lastSample - 1) / l.samplesPerPeak, l.count - 1);
+    min = std::numeric_limits<qint16>::max();
+    max = std::numeric_limits<qint16>::min();
+    for (qint64 i = first; i <= last; ++i) {
+        const qint16 *p = l.data + (i * m_channels + channel) * 2;
+        min = qMin(min, qFromLittleEndian<qint16>(p));
+        max = qMax(max, qFromLittleEndian<qint16>(p + 1));
+    }
+    return first <= last;
+}
+
+QList<double> AudioPeaks::frameLevels(double fps) const
+{
+    QList<double> levels;
+    if (fps <= 0 || m_levels.empty()) {
+        return levels;
+    }
+    double samplesPerFrame = m_sampleRate / fps;
+    auto frames = (qint64)std::ceil(m_sampleCount / samplesPerFrame);
+    int levelIndex = levelForResolution(samplesPerFrame);
+    levels.reserve((int)(frames * m_channels));
+    for (qint64 f = 0; f < frames; ++f) {
+        auto first = (qint64)llround(f * samplesPerFrame);
+        auto last = (qint64)llround((f + 1) * samplesPerFrame);
+        for (int channel = 0; channel < m_channels; ++channel) {
+            qint16 min = 0, max = 0;
+            if (!peak(levelIndex, channel, first, last, min, max)) {
+                min = max = 0;
+            }
+            levels << 256. * qMax(std::abs((int)min), std::abs((int)max)) / 32768.;
+        }
+    }
+    return levels;
+}
+
+AudioPeaks::Builder::Builder(int channels, int sampleRate)
+    : m_channels(channels)
+    , m_sampleRate(sampleRate)
+    , m_channelSamples((size_t)channels, 0)
+{
+}
+
+qint64 AudioPeaks::Builder::sampleCount() const
+{
+    return m_channelSamples.empty() ? 0 : *std::min_element(m_channelSamples.begin(), m_channelSamples.end());
+}
+
+void AudioPeaks::Builder::addSamples(const qint16 *samples, int frames)
+{
+    for (int channel = 0; channel < m_channels; ++channel) {
+        addStridedSamples(channel, samples + channel, frames, m_channels);
+    }
+}
+
+void AudioPeaks::Builder::addChannelSamples(int channel, const qint16 *samples, int count)
+{
+    addStridedSamples(channel, samples, count, 1);
+}
+
+void AudioPeaks::Builder::addStridedSamples(int channel, const qint16 *samples, int count, int stride)
+{
+    qint64 position = m_channelSamples[(size_t)channel];
+    int i = 0;
+    while (i < count) {
+        qint64 peakIndex = position / BaseSamplesPerPeak;
+        size_t required = (size_t)(peakIndex + 1) * (size_t)m_channels * 2;
+        while (m_base.size() < required) {
+            // new peaks start empty
+            m_base.push_back(std::numeric_limits<qint16>::max());
+            m_base.push_back(std::numeric_limits<qint16>::min());
+        }
+        int inBlock = qMin(count - i, int(BaseSamplesPerPeak - position % BaseSamplesPerPeak));
+        qint16 &min = m_base[(size_t)(peakIndex * m_channels + channel) * 2];
+        qint16 &max = m_base[(size_t)(peakIndex * m_channels + channel) * 2 + 1];
+        const qint16 *src = samples + (qint64)i * stride;
+        for (int k = 0; k < inBlock; ++k, src += stride) {
+            min = qMin(min, *src);
+            max = qMax(max, *src);
+        }
+        i += inBlock;
+        position += inBlock;
+    }
+    m_channelSamples[(size_t)channel] = position;
+}
+
+std::shared_ptr<AudioPeaks> AudioPeaks::Builder::finish(const QString &path)
+{
+    const qint64 samples = sampleCount();
+    if (m_channels <= 0 || m_sampleRate <= 0 || samples == 0) {
+        return nullptr;
+    }
+    // Drop the peaks that are not covered by all channels
+    qint64 baseCount = (samples + BaseSamplesPerPeak - 1) / BaseSamplesPerPeak;
+    m_base.resize((size_t)(baseCount * m_channels * 2));
+
+    // Compute the coarser levels from the previous one
+    std::vector<std::vector<qint16>> levels;
+    std::vector<quint32> samplesPerPeak{BaseSamplesPerPeak};
+    levels.push_back(std::move(m_base));
+    m_base.clear();
+    while ((int)levels.size() < maxLevels && levels.back().size() / 2 / (size_t)m_channels > 64) {
+        const std::vector<qint16> &previous = levels.back();
+        size_t previousCount = previous.size() / 2 / (size_t)m_channels;
+        size_t count = (previousCount + LevelFactor - 1) / LevelFactor;
+        std::vector<qint16> current(count * (size_t)m_channels * 2);
+        for (size_t i = 0; i < count; ++i) {
+            for (int channel = 0; channel < m_channels; ++channel) {
+                qint16 min = std::numeric_limits<qint16>::max();
+                qint16 max = std::numeric_limits<qint16>::min();
+                for (size_t j = i * LevelFactor; j < qMin(previousCount, (i + 1) * LevelFactor); ++j) {
+                    min = qMin(min, previous[(j * (size_t)m_channels + (size_t)channel) * 2]);
+                    max = qMax(max, previous[(j * (size_t)m_channels + (size_t)channel) * 2 + 1]);
+                }
+                current[(i * (size_t)m_channels + (size_t)channel) * 2] = min;
+                current[(i * (size_t)m_channels + (size_t)channel) * 2 + 1] = max;
+            }
+        }
+        levels.push_back(std::move(current));
+        samplesPerPeak.push_back(samplesPerPeak.back() * LevelFactor);
+    }
+
+    // Serialize
+    qint64 dataSize = headerSize + (qint64)levels.size() * levelEntrySize;
+    for (const auto &l : levels) {
+        dataSize += (qint64)l.size() * 2;
+    }
+    if (dataSize > std::numeric_limits<int>::max()) {
+        // The peaks are built in a QByteArray
+        qDebug() << "// Audio peaks too large:" << dataSize << "bytes";
+        return nullptr;
+    }
+    std::shared_ptr<AudioPeaks> peaks(new AudioPeaks());
+    peaks->m_buffer.resize((int)dataSize);
+    auto *data = reinterpret_cast<uchar *>(peaks->m_buffer.data());
+    memcpy(data, peaksMagic, 4);
+    qToLittleEndian<quint32>(Version, data + 4);
+    qToLittleEndian<quint32>((quint32)m_channels, data + 8);
+    qToLittleEndian<quint32>((quint32)m_sampleRate, data + 12);
+    qToLittleEndian<qint64>(samples, data + 16);
+    qToLittleEndian<quint32>((quint32)levels.size(), data + 24);
+    qToLittleEndian<quint32>(0, data + 28);
+    qint64 offset = headerSize + (qint64)levels.size() * levelEntrySize;
+    for (size_t i = 0; i < levels.size(); ++i) {
+        uchar *entry = data + headerSize + i * levelEntrySize;
+        qToLittleEndian<quint32>(samplesPerPeak[i], entry);
+        qToLittleEndian<quint32>(0, entry + 4);
+        qToLittleEndian<qint64>((qint64)(levels[i].size() / 2 / (size_t)m_channels), entry + 8);
+        qToLittleEndian<qint64>(offset, entry + 16);
+        uchar *dest = data + offset;
+        for (qint16 value : levels[i]) {
+            qToLittleEndian<qint16>(value, dest);
+            dest += 2;
+        }
+        offset += (qint64)levels[i].size() * 2;
+    }
+    if (!peaks->parse(data, dataSize)) {
+        return nullptr;
+    }
+    if (!path.isEmpty()) {
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly) || file.write(peaks->m_buffer) != dataSize || !file.commit()) {
+            qDebug() << "// Cannot write audio peak file" << path;
+        }
+    }
+    return peaks;
+}
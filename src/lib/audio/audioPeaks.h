@@ -0,0 +1,109 @@
+/***************************************************************************
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef AUDIOPEAKS_H
+#define AUDIOPEAKS_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <memory>
+#include <vector>
+
+/**
+  Multi resolution peak data of an audio stream, used to draw waveforms.
+
+  For each decimation level, the stream is cut in blocks of samplesPerPeak
+  samples and we store the minimum and maximum sample value of each block
+  and channel as 16 bit integers. The finest level has BaseSamplesPerPeak
+  samples per peak, each following level groups LevelFactor peaks of the
+  previous one.
+
+  The file layout (all values little endian) is:
+    - header: magic "KDAP", version, channels, sample rate, sample count, level count
+    - level table: for each level, samples per peak, peak count and data offset
+    - peak data: for each level, peaks of all channels interleaved as (min, max) pairs
+  so that the file can be memory mapped and used directly.
+  */
+class AudioPeaks
+{
+public:
+    static const quint32 Version;
+    static const quint32 BaseSamplesPerPeak;
+    static const quint32 LevelFactor;
+
+    struct Level
+    {
+        quint32 samplesPerPeak;
+        qint64 count;
+        const qint16 *data; // count * channels * (min, max)
+    };
+
+    /** @brief Open a peak file. The file is memory mapped. Returns nullptr if the file is missing, invalid or of another version */
+    static std::shared_ptr<AudioPeaks> load(const QString &path);
+    ~AudioPeaks();
+
+    int channels() const;
+    int sampleRate() const;
+    qint64 sampleCount() const;
+    int levelCount() const;
+    const Level &level(int index) const;
+
+    /** @brief Returns the index of the coarsest level that still has at most samplesPerPixel samples per peak */
+    int levelForResolution(double samplesPerPixel) const;
+
+    /** @brief Compute the minimum and maximum values of a channel in the sample range [firstSample, lastSample[ using the given level
+        @return false if the range is empty */
+    bool peak(int levelIndex, int channel, qint64 firstSample, qint64 lastSample, qint16 &min, qint16 &max) const;
+
+    /** @brief Returns one level (0-256) per frame and channel, interleaved. This is the format expected by the monitor audio thumbnail */
+    QList<double> frameLevels(double fps) const;
+
+    /** @brief Incrementally computes the peaks of an audio stream */
+    class Builder
+    {
+    public:
+        Builder(int channels, int sampleRate);
+        /** @brief Add interleaved samples
+            @param frames is the number of samples per channel */
+        void addSamples(const qint16 *samples, int frames);
+        /** @brief Add the samples of a single channel. All channels must be fed with the same number of samples before calling finish */
+        void addChannelSamples(int channel, const qint16 *samples, int count);
+        /** @brief Number of samples (per channel) processed so far */
+        qint64 sampleCount() const;
+        /** @brief Build the decimation levels and save them
+            @param path is the file where the peaks are stored, leave empty to keep them in memory only */
+        std::shared_ptr<AudioPeaks> finish(const QString &path);
+
+    private:
+        void addStridedSamples(int channel, const qint16 *samples, int count, int stride);
+
+        int m_channels;
+        int m_sampleRate;
+        // Base level being built, (min, max) pairs interleaved by channel
+        std::vector<qint16> m_base;
+        // Per channel progress, needed for planar input
+        std::vector<qint64> m_channelSamples;
+    };
+
+private:
+    AudioPeaks();
+    bool parse(const uchar *data, qint64 size);
+
+    QFile m_file;
+    uchar *m_map;
+    QByteArray m_buffer;
+    int m_channels;
+    int m_sampleRate;
+    qint64 m_sampleCount;
+    std::vector<Level> m_levels;
+};
+
+#endif
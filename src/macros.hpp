@@ -37,13 +37,7 @@
    Note that it is automatically called when you push the lambda so you shouldn't have
    to call it directly yourself
 */
-#define LOCK_IN_LAMBDA(lambda)                                                                                                                                 \
-    lambda = [this, lambda]() {                                                                                                                                \
-        m_lock.lockForWrite();                                                                                                                                 \
-        bool res_lambda = lambda();                                                                                                                            \
-        m_lock.unlock();                                                                                                                                       \
-        return res_lambda;                                                                                                                                     \
-    };
+#define LOCK_IN_LAMBDA(lambda) lambda = LockedFun{&m_lock, lambda};
 
 /*This convenience macro locks the mutex for reading.
 Note that it might happen that a thread is executing a write operation that requires
@@ -77,14 +71,8 @@ reading a Read-protected property. In that case, we try to write lock it first (
    This should be used in the rare case where we don't need a lock mutex. In general, prefer the other version
 */
 #define UPDATE_UNDO_REDO_NOLOCK(operation, reverse, undo, redo)                                                                                                \
-    undo = [reverse, undo]() {                                                                                                                                 \
-        bool v = reverse();                                                                                                                                    \
-        return undo() && v;                                                                                                                                    \
-    };                                                                                                                                                         \
-    redo = [operation, redo]() {                                                                                                                               \
-        bool v = redo();                                                                                                                                       \
-        return operation() && v;                                                                                                                               \
-    };
+    UndoHelper::pushFront(undo, reverse, FunList::Mode::Always);                                                                                               \
+    UndoHelper::pushBack(redo, operation, FunList::Mode::Always);
 /* @brief This macro takes as parameter one atomic operation and its reverse, and update
    the undo and redo functional stacks/queue accordingly
    It will also ensure that operation and reverse are dealing with mutexes
@@ -63,6 +63,7 @@
 #include "transitions/transitionsrepository.hpp"
 #include "utils/resourcewidget.h"
 #include "utils/thememanager.h"
+#include "utils/thumbnailcache.hpp"
 
 #include "profiles/profilerepository.hpp"
 #include "widgets/progressbutton.h"
@@ -1992,6 +1993,9 @@ void MainWindow::connectDocument()
     connect(m_projectMonitor, SIGNAL(zoneUpdated(QPoint)), project, SLOT(setModified()));
     connect(m_clipMonitor, SIGNAL(zoneUpdated(QPoint)), project, SLOT(setModified()));
     connect(project, &KdenliveDoc::docModified, this, &MainWindow::slotUpdateDocumentState);
+    connect(project, &KdenliveDoc::saveProgress, this, [this](int progress) {
+        slotGotProgressInfo(progress < 100 ? i18n("Saving project") : QString(), progress, ProcessingJobMessage);
+    });
     connect(pCore->bin(), SIGNAL(displayMessage(QString, int, MessageType)), m_messageLabel, SLOT(setProgressMessage(QString, int, MessageType)));
 
     if (m_renderWidget) {
@@ -2149,6 +2153,7 @@ void MainWindow::updateConfiguration()
     m_buttonVideoThumbs->setChecked(KdenliveSettings::videothumbnails());
     m_buttonShowMarkers->setChecked(KdenliveSettings::showmarkers());
     slotSwitchAutomaticTransition();
+    ThumbnailCache::get()->setMaxCost(qMax(1, KdenliveSettings::thumbnailcachesize()) * 1048576LL);
 
     // Update list of transcoding profiles
     buildDynamicActions();
@@ -21,6 +21,7 @@
 #define ABSTRACTMONITOR_H
 
 #include "definitions.h"
+#include "scopes/sharedframe.h"
 
 #include <cstdint>
 
@@ -97,8 +98,12 @@ protected:
     MonitorManager *m_monitorManager;
 
 signals:
-    /** @brief Send a frame for analysis or title background display. */
+    /** @brief Send a frame image for analysis, used when the native frame is not available. */
     void frameUpdated(const QImage &);
+    /** @brief Send the native (yuv420p) frame for analysis. */
+    void sharedFrameUpdated(const SharedFrame &);
+    /** @brief Send a frame image for title background display. */
+    void backgroundFrameUpdated(const QImage &);
     /** @brief This signal contains the audio of the current frame. */
     void audioSamplesSignal(const audioShortVector &, int, int, int);
     /** @brief Scopes are ready to receive a new frame. */
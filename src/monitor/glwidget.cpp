@@ -70,6 +70,7 @@ using namespace Mlt;
 GLWidget::GLWidget(int id, QObject *parent)
     : QQuickView((QWindow *)parent)
     , sendFrameForAnalysis(false)
+    , sendImageForBackground(false)
     , m_glslManager(nullptr)
     , m_consumer(nullptr)
     , m_producer(nullptr)
@@ -92,6 +93,7 @@ GLWidget::GLWidget(int id, QObject *parent)
     , m_colorspaceLocation(0)
     , m_zoom(1.0f)
     , m_sendFrame(false)
+    , m_sendImage(false)
     , m_isZoneMode(false)
     , m_isLoopMode(false)
     , m_offset(QPoint(0, 0))
@@ -589,8 +591,26 @@ void GLWidget::paintGL()
     glDrawArrays(GL_TRIANGLE_STRIP, 0, vertices.size());
     check_error(f);
 
+    // The scopes analyse the yuv frame directly when it is available, the rendered image is only needed
+    // for the title background and when the frame only exists as a GPU texture
+    bool renderImage = m_sendImage;
+    bool analyseImage = false;
     if (m_sendFrame && m_analyseSem.tryAcquire(1)) {
-        // Render RGB frame for analysis
+        SharedFrame frame;
+        if (m_glslManager == nullptr) {
+            QMutexLocker locker(&m_contextSharedAccess);
+            frame = m_sharedFrame;
+        }
+        if (frame.is_valid() && frame.get_image_format() == mlt_image_yuv420p) {
+            emit analyseSharedFrame(frame);
+        } else {
+            analyseImage = true;
+            renderImage = true;
+        }
+        m_sendFrame = false;
+    }
+    if (renderImage) {
+        // Render RGB frame
         int fullWidth = pCore->getCurrentProfile()->width();
         int fullHeight = pCore->getCurrentProfile()->height();
         if ((m_fbo == nullptr) || m_fbo->size() != QSize(fullWidth, fullHeight)) {
@@ -610,8 +630,14 @@ void GLWidget::paintGL()
         glDrawArrays(GL_TRIANGLE_STRIP, 0, vertices.size());
         check_error(f);
         m_fbo->release();
-        emit analyseFrame(m_fbo->toImage());
-        m_sendFrame = false;
+        const QImage image = m_fbo->toImage();
+        if (m_sendImage) {
+            emit backgroundFrame(image);
+            m_sendImage = false;
+        }
+        if (analyseImage) {
+            emit analyseFrame(image);
+        }
     }
     // Cleanup
     m_shader->disableAttributeArray(m_vertexLocation);
@@ -1399,6 +1425,7 @@ void GLWidget::onFrameDisplayed(const SharedFrame &frame)
     m_contextSharedAccess.lock();
     m_sharedFrame = frame;
     m_sendFrame = sendFrameForAnalysis;
+    m_sendImage = sendImageForBackground;
     m_contextSharedAccess.unlock();
     update();
 }
@@ -1513,6 +1540,7 @@ void GLWidget::updateTexture(GLuint yName, GLuint uName, GLuint vName)
     m_texture[1] = uName;
     m_texture[2] = vName;
     m_sendFrame = sendFrameForAnalysis;
+    m_sendImage = sendImageForBackground;
     // update();
 }
 
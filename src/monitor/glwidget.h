@@ -107,8 +107,10 @@ public:
     Mlt::Producer *producer();
     QSize profileSize() const;
     QRect displayRect() const;
-    /** @brief set to true if we want to emit a QImage of the frame for analysis */
+    /** @brief set to true if we want to emit the frame for analysis */
     bool sendFrameForAnalysis;
+    /** @brief set to true if we want to emit a QImage of the frame for the title background */
+    bool sendImageForBackground;
     void updateGamma();
     /** @brief delete and rebuild consumer, for example when external display is switched */
     void resetConsumer(bool fullReset);
@@ -179,7 +181,10 @@ signals:
     void switchFullScreen(bool minimizeOnly = false);
     void mouseSeek(int eventDelta, uint modifiers);
     void startDrag();
+    /** @brief The frame only exists as a GPU texture, send a rendered image for analysis */
     void analyseFrame(const QImage &);
+    void analyseSharedFrame(const SharedFrame &);
+    void backgroundFrame(const QImage &);
     void audioSamplesSignal(const audioShortVector &, int, int, int);
     void showContextMenu(const QPoint &);
     void lockMonitor(bool);
@@ -224,6 +229,7 @@ private:
     QTimer m_refreshTimer;
     float m_zoom;
     bool m_sendFrame;
+    bool m_sendImage;
     bool m_isZoneMode;
     bool m_isLoopMode;
     QPoint m_offset;
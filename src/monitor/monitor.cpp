@@ -301,6 +301,8 @@ Monitor::Monitor(Kdenlive::MonitorId id, MonitorManager *manager, QWidget *paren
 
     connect(this, &Monitor::scopesClear, m_glMonitor, &GLWidget::releaseAnalyse, Qt::DirectConnection);
     connect(m_glMonitor, &GLWidget::analyseFrame, this, &Monitor::frameUpdated);
+    connect(m_glMonitor, &GLWidget::analyseSharedFrame, this, &Monitor::sharedFrameUpdated);
+    connect(m_glMonitor, &GLWidget::backgroundFrame, this, &Monitor::backgroundFrameUpdated);
     connect(m_glMonitor, &GLWidget::audioSamplesSignal, this, &Monitor::audioSamplesSignal);
 
     if (id != Kdenlive::ClipMonitor) {
@@ -385,15 +387,9 @@ void Monitor::setOffsetY(int y)
 
 void Monitor::slotGetCurrentImage(bool request)
 {
-    m_glMonitor->sendFrameForAnalysis = request;
+    m_glMonitor->sendImageForBackground = request;
     m_monitorManager->activateMonitor(m_id);
     refreshMonitorIfActive();
-    if (request) {
-        // Update analysis state
-        QTimer::singleShot(500, m_monitorManager, &MonitorManager::checkScopes);
-    } else {
-        m_glMonitor->releaseAnalyse();
-    }
 }
 
 void Monitor::slotAddEffect(const QStringList &effect)
@@ -20,74 +20,72 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "monitoraudiolevel.h"
-#include "core.h"
-#include "profiles/profilemodel.hpp"
+#include "klocalizedstring.h"
 
 #include "mlt++/Mlt.h"
 
 #include <cmath>
+#include <memory>
 
 #include <QFont>
 #include <QPaintEvent>
 #include <QPainter>
 
-const double log_factor = 1.0 / log10(1.0 / 127);
-
-static inline double levelToDB(double level)
+// Position of a level on the meter, the dB scale is drawn with the same function
+static inline int dbToPixel(double db, int width)
 {
-    if (level <= 0) {
-        return -100;
-    }
-    return 100 * (1.0 - log10(level) * log_factor);
+    return (int)(pow(10.0, db / 50.0) * width * 40.0 / 42);
 }
 
 MonitorAudioLevel::MonitorAudioLevel(int height, QWidget *parent)
     : ScopeWidget(parent)
     , audioChannels(2)
+    , isValid(true)
     , m_height(height)
     , m_channelHeight(height / 2)
     , m_channelDistance(2)
     , m_channelFillHeight(m_channelHeight)
 {
     setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::Preferred);
-    m_filter = new Mlt::Filter(pCore->getCurrentProfile()->profile(), "audiolevel");
-    if (!m_filter->is_valid()) {
-        isValid = false;
-        return;
-    }
-    m_filter->set("iec_scale", 0);
-    isValid = true;
+    // The GUI refreshes at its own pace, whatever the frame rate is
+    m_pollTimer.setInterval(40);
+    connect(&m_pollTimer, &QTimer::timeout, this, &MonitorAudioLevel::pollLevels);
 }
 
-MonitorAudioLevel::~MonitorAudioLevel()
-{
-    delete m_filter;
-}
+MonitorAudioLevel::~MonitorAudioLevel() = default;
 
 void MonitorAudioLevel::refreshScope(const QSize & /*size*/, bool /*full*/)
 {
     SharedFrame sFrame;
     while (m_queue.count() > 0) {
         sFrame = m_queue.pop();
-        if (sFrame.is_valid() && sFrame.get_audio_samples() > 0) {
+        if (!sFrame.is_valid() || sFrame.get_audio_samples() <= 0) {
+            continue;
+        }
+        int channels = sFrame.get_audio_channels();
+        int frequency = sFrame.get_audio_frequency();
+        int samples = sFrame.get_audio_samples();
+        const int16_t *audio = nullptr;
+        std::unique_ptr<Mlt::Frame> mFrame;
+        if (sFrame.get_audio_format() == mlt_audio_s16) {
+            // Read the displayed samples directly
+            audio = sFrame.get_audio();
+        } else {
             mlt_audio_format format = mlt_audio_s16;
-            int channels = sFrame.get_audio_channels();
-            int frequency = sFrame.get_audio_frequency();
-            int samples = sFrame.get_audio_samples();
-            Mlt::Frame mFrame = sFrame.clone(true, false, false);
-            m_filter->process(mFrame);
-            mFrame.get_audio(format, frequency, channels, samples);
-            if (samples == 0) {
-                // There was an error processing audio from frame
-                continue;
-            }
-            QVector<int> levels;
-            for (int i = 0; i < audioChannels; i++) {
-                QString s = QStringLiteral("meta.media.audio_level.%1").arg(i);
-                levels << (int)levelToDB(mFrame.get_double(s.toLatin1().constData()));
-            }
-            QMetaObject::invokeMethod(this, "setAudioValues", Qt::QueuedConnection, Q_ARG(const QVector<int> &, levels));
+            mFrame.reset(new Mlt::Frame(sFrame.clone(true, false, false)));
+            audio = (const int16_t *)mFrame->get_audio(format, frequency, channels, samples);
         }
+        if (audio == nullptr || samples == 0) {
+            // There was an error processing audio from frame
+            continue;
+        }
+        const int position = sFrame.get_position();
+        if (position != m_lastPosition + 1) {
+            // Seek, loudness is measured on continuous audio
+            m_meter.reset();
+        }
+        m_lastPosition = position;
+        m_levels.push(m_meter.process(audio, channels, frequency, samples));
     }
 }
 
@@ -154,7 +152,7 @@ void MonitorAudioLevel::drawBackground(int channels)
         int value = dbscale.at(i);
         QString label = QString().sprintf("%d", value);
         int labelWidth = fontMetrics().width(label);
-        double xf = pow(10.0, (double)dbscale.at(i) / 50.0) * m_pixmap.width() * 40.0 / 42;
+        double xf = dbToPixel(dbscale.at(i), m_pixmap.width());
         if (xf + labelWidth / 2 > m_pixmap.width()) {
             xf = width() - labelWidth / 2;
         }
@@ -191,21 +189,42 @@ void MonitorAudioLevel::drawBackground(int channels)
     p.end();
 }
 
-// cppcheck-suppress unusedFunction
-void MonitorAudioLevel::setAudioValues(const QVector<int> &values)
+void MonitorAudioLevel::pollLevels()
 {
-    m_values = values;
-    if (m_peaks.size() != m_values.size()) {
-        m_peaks = values;
-        drawBackground(values.size());
+    AudioMeter::Levels levels;
+    bool received = false;
+    QVector<int> peaks;
+    QVector<int> truePeaks;
+    // Several frames may have been played since the last refresh, show the loudest of them
+    while (m_levels.pop(levels)) {
+        const int channels = qMin(levels.channels, audioChannels);
+        if (!received || truePeaks.size() != channels) {
+            peaks.fill(AudioMeter::MinLevel, channels);
+            truePeaks.fill(AudioMeter::MinLevel, channels);
+        }
+        for (int i = 0; i < channels; i++) {
+            peaks[i] = qMax(peaks.at(i), (int)levels.peak[i]);
+            truePeaks[i] = qMax(truePeaks.at(i), (int)std::ceil(levels.truePeak[i]));
+        }
+        received = true;
+    }
+    if (!received) {
+        return;
+    }
+    m_values = peaks;
+    if (m_peaks.size() != truePeaks.size()) {
+        m_peaks = truePeaks;
+        drawBackground(truePeaks.size());
     } else {
-        for (int i = 0; i < m_values.size(); i++) {
+        for (int i = 0; i < truePeaks.size(); i++) {
             m_peaks[i]--;
-            if (m_values.at(i) > m_peaks.at(i)) {
-                m_peaks[i] = m_values.at(i);
+            if (truePeaks.at(i) > m_peaks.at(i)) {
+                m_peaks[i] = truePeaks.at(i);
             }
         }
     }
+    setToolTip(i18n("Momentary loudness: %1 LUFS\nShort-term loudness: %2 LUFS", QString::number(levels.momentary, 'f', 1),
+                    QString::number(levels.shortTerm, 'f', 1)));
     update();
 }
 
@@ -214,7 +233,9 @@ void MonitorAudioLevel::setVisibility(bool enable)
     if (enable) {
         setVisible(true);
         setFixedHeight(m_height);
+        m_pollTimer.start();
     } else {
+        m_pollTimer.stop();
         // set height to 0 so the toolbar layout is not affected
         setFixedHeight(0);
         setVisible(false);
@@ -239,11 +260,9 @@ void MonitorAudioLevel::paintEvent(QPaintEvent *pe)
     p.setOpacity(0.9);
     int width = m_channelDistance == 1 ? rect.width() : rect.width() - 1;
     for (int i = 0; i < m_values.count(); i++) {
-        if (m_values.at(i) >= 100) {
-            continue;
-        }
-        int val = (50 + m_values.at(i)) / 150.0 * rect.width();
+        int val = qMin(dbToPixel(m_values.at(i), rect.width()), width);
         p.fillRect(val, i * (m_channelHeight + m_channelDistance) + 1, width - val, m_channelFillHeight, palette().dark());
-        p.fillRect((50 + m_peaks.at(i)) / 150.0 * rect.width(), i * (m_channelHeight + m_channelDistance) + 1, 1, m_channelFillHeight, palette().text());
+        p.fillRect(qMin(dbToPixel(m_peaks.at(i), rect.width()), width - 1), i * (m_channelHeight + m_channelDistance) + 1, 1, m_channelFillHeight,
+                   palette().text());
     }
 }
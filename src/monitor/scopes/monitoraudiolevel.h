@@ -22,13 +22,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef MONITORAUDIOLEVEL_H
 #define MONITORAUDIOLEVEL_H
 
+#include "lib/audio/audioMeter.h"
 #include "scopewidget.h"
+#include <QTimer>
 #include <QWidget>
 
-namespace Mlt {
-class Filter;
-} // namespace Mlt
-
 class MonitorAudioLevel : public ScopeWidget
 {
     Q_OBJECT
@@ -45,9 +43,15 @@ protected:
     void resizeEvent(QResizeEvent *event) override;
 
 private:
-    Mlt::Filter *m_filter;
+    // Only used by the refresh thread
+    AudioMeter m_meter;
+    int m_lastPosition{-1};
+    // Levels measured by the refresh thread, polled by the GUI thread
+    AudioMeter::Ring m_levels;
+    QTimer m_pollTimer;
     int m_height;
     QPixmap m_pixmap;
+    /** Held true peak and sample peak of each channel, in dBFS */
     QVector<int> m_peaks;
     QVector<int> m_values;
     int m_channelHeight;
@@ -57,7 +61,8 @@ private:
     void refreshScope(const QSize &size, bool full) override;
 
 private slots:
-    void setAudioValues(const QVector<int> &values);
+    /** @brief Display the last levels measured */
+    void pollLevels();
 };
 
 #endif
@@ -217,11 +217,18 @@ void TemporaryData::updateDataInfo()
         m_currentPage->setEnabled(false);
         return;
     }
+    // Rendered chunks are stored by content in a folder shared by the projects, the project folder only holds the chunks being rendered
+    m_currentSizes[0] = 0;
     preview = m_doc->getCacheDir(CachePreview, &ok);
     if (ok) {
         KIO::DirectorySizeJob *job = KIO::directorySize(QUrl::fromLocalFile(preview.absolutePath()));
         connect(job, &KIO::DirectorySizeJob::result, this, &TemporaryData::gotPreviewSize);
     }
+    preview = m_doc->getCacheDir(CacheRoot, &ok);
+    if (ok && preview.cd(QStringLiteral("previewchunks"))) {
+        KIO::DirectorySizeJob *job = KIO::directorySize(QUrl::fromLocalFile(preview.absolutePath()));
+        connect(job, &KIO::DirectorySizeJob::result, this, &TemporaryData::gotPreviewSize);
+    }
 
     preview = m_doc->getCacheDir(CacheProxy, &ok);
     if (ok) {
@@ -256,13 +263,13 @@ void TemporaryData::gotPreviewSize(KJob *job)
     if (sourceJob->totalFiles() == 0) {
         total = 0;
     }
+    m_totalCurrent += total;
+    m_currentSizes[0] += total;
     QLayoutItem *button = m_grid->itemAtPosition(0, 4);
     if ((button != nullptr) && (button->widget() != nullptr)) {
-        button->widget()->setEnabled(total > 0);
+        button->widget()->setEnabled(m_currentSizes[0] > 0);
     }
-    m_totalCurrent += total;
-    m_currentSizes[0] = total;
-    m_previewSize->setText(KIO::convertSize(total));
+    m_previewSize->setText(KIO::convertSize(m_currentSizes[0]));
     updateTotal();
 }
 
@@ -337,13 +344,24 @@ void TemporaryData::deletePreview()
     if (!ok) {
         return;
     }
-    if (KMessageBox::warningContinueCancel(this, i18n("Delete all data in the cache folder:\n%1", dir.absolutePath())) != KMessageBox::Continue) {
+    QDir chunks = m_doc->getCacheDir(CacheRoot, &ok);
+    bool hasChunks = ok && chunks.cd(QStringLiteral("previewchunks"));
+    QStringList folders{dir.absolutePath()};
+    if (hasChunks) {
+        folders << chunks.absolutePath();
+    }
+    if (KMessageBox::warningContinueCancelList(this, i18n("Delete all timeline preview data, the rendered chunks are shared by all projects:"), folders) !=
+        KMessageBox::Continue) {
         return;
     }
     if (dir.dirName() == QLatin1String("preview")) {
+        emit disablePreview();
         dir.removeRecursively();
         dir.mkpath(QStringLiteral("."));
-        emit disablePreview();
+        if (hasChunks && chunks.dirName() == QLatin1String("previewchunks")) {
+            chunks.removeRecursively();
+            chunks.mkpath(QStringLiteral("."));
+        }
         updateDataInfo();
     }
 }
@@ -537,6 +555,9 @@ void TemporaryData::gotFolderSize(KJob *job)
         item->setText(0, m_processingDirectory);
         if (m_processingDirectory == QLatin1String("proxy")) {
             item->setIcon(0, QIcon::fromTheme(QStringLiteral("kdenlive-show-video")));
+        } else if (m_processingDirectory == QLatin1String("previewchunks")) {
+            item->setText(0, i18n("Timeline preview chunks (all projects)"));
+            item->setIcon(0, QIcon::fromTheme(QStringLiteral("kdenlive-show-video")));
         }
     }
     item->setData(0, Qt::UserRole, m_processingDirectory);
@@ -597,8 +618,8 @@ void TemporaryData::deleteSelected()
         }
         QDir toRemove(m_globalDir.absoluteFilePath(folder));
         toRemove.removeRecursively();
-        if (folder == QLatin1String("proxy")) {
-            // We deleted proxy folder, recreate it
+        if (folder == QLatin1String("proxy") || folder == QLatin1String("previewchunks")) {
+            // We deleted a shared folder, recreate it
             toRemove.mkpath(QStringLiteral("."));
         }
     }
@@ -22,6 +22,7 @@ the Free Software Foundation, either version 3 of the License, or
 #include "project/dialogs/backupwidget.h"
 #include "project/dialogs/noteswidget.h"
 #include "project/dialogs/projectsettings.h"
+#include "utils/mediaprobecache.hpp"
 #include "utils/thumbnailcache.hpp"
 #include "xml/xml.hpp"
 
@@ -227,7 +228,7 @@ bool ProjectManager::closeCurrentDocument(bool saveChanges, bool quit)
         switch (KMessageBox::warningYesNoCancel(pCore->window(), message)) {
         case KMessageBox::Yes:
             // save document here. If saving fails, return false;
-            if (!saveFile()) {
+            if (!saveFile() || !m_project->waitForSave()) {
                 return false;
             }
             break;
@@ -243,6 +244,7 @@ bool ProjectManager::closeCurrentDocument(bool saveChanges, bool quit)
         m_autoSaveTimer.stop();
         if (m_project) {
             pCore->jobManager()->slotCancelJobs();
+            MediaProbeCache::get()->cancelValidation();
             pCore->bin()->abortOperations();
             pCore->monitorManager()->clipMonitor()->slotOpenClip(nullptr);
             pCore->window()->clearAssetPanel();
@@ -282,14 +284,8 @@ bool ProjectManager::saveFileAs(const QString &outputFileName)
     prepareSave();
     QString saveFolder = QFileInfo(outputFileName).absolutePath();
     QString scene = projectSceneList(saveFolder);
-    if (!m_replacementPattern.isEmpty()) {
-        QMapIterator<QString, QString> i(m_replacementPattern);
-        while (i.hasNext()) {
-            i.next();
-            scene.replace(i.key(), i.value());
-        }
-    }
-    if (!m_project->saveSceneList(outputFileName, scene)) {
+    // The file is written in the background, the document is marked as saved right away
+    if (!m_project->saveSceneList(outputFileName, scene, m_replacementPattern)) {
         return false;
     }
     QUrl url = QUrl::fromLocalFile(outputFileName);
@@ -374,9 +370,7 @@ bool ProjectManager::saveFile()
     if (m_project->url().isEmpty()) {
         return saveFileAs();
     }
-    bool result = saveFileAs(m_project->url().toLocalFile());
-    m_project->m_autosave->resize(0);
-    return result;
+    return saveFileAs(m_project->url().toLocalFile());
 }
 
 void ProjectManager::openFile()
@@ -550,9 +544,8 @@ void ProjectManager::doOpenFile(const QUrl &url, KAutoSaveFile *stale)
 
     updateTimeline(m_project->getDocumentProperty(QStringLiteral("position")).toInt());
     pCore->window()->connectDocument();
-    QDateTime documentDate = QFileInfo(m_project->url().toLocalFile()).lastModified();
     pCore->window()->getMainTimeline()->controller()->loadPreview(m_project->getDocumentProperty(QStringLiteral("previewchunks")),
-                                                                  m_project->getDocumentProperty(QStringLiteral("dirtypreviewchunks")), documentDate,
+                                                                  m_project->getDocumentProperty(QStringLiteral("dirtypreviewchunks")),
                                                                   m_project->getDocumentProperty(QStringLiteral("disablepreview")).toInt());
 
     emit docOpened(m_project);
@@ -643,15 +636,8 @@ void ProjectManager::slotAutoSave()
 {
     prepareSave();
     QString saveFolder = m_project->url().adjusted(QUrl::RemoveFilename | QUrl::StripTrailingSlash).toLocalFile();
-    QString scene = projectSceneList(saveFolder);
-    if (!m_replacementPattern.isEmpty()) {
-        QMapIterator<QString, QString> i(m_replacementPattern);
-        while (i.hasNext()) {
-            i.next();
-            scene.replace(i.key(), i.value());
-        }
-    }
-    m_project->slotAutoSave(scene);
+    // Replacements and writing are done in the background
+    m_project->slotAutoSave(projectSceneList(saveFolder), m_replacementPattern);
     m_lastSave.start();
 }
 
@@ -819,7 +805,11 @@ void ProjectManager::slotMoveFinished(KJob *job)
             m_replacementPattern.insert(m_project->projectTempFolder() + QStringLiteral("/proxy/"), newFolder + QStringLiteral("/proxy/"));
         }
         m_project->setProjectFolder(QUrl::fromLocalFile(newFolder));
-        saveFile();
+        // The project is reopened from the saved file
+        if (!saveFile() || !m_project->waitForSave()) {
+            // Keep the replacements, the next save must still use the new folder
+            return;
+        }
         m_replacementPattern.clear();
         slotRevert();
     } else {
@@ -899,7 +889,7 @@ void ProjectManager::saveWithUpdatedProfile(const QString &updatedProfile)
                                                                   m_project->url().fileName().isEmpty() ? i18n("Untitled") : m_project->url().fileName()))) {
         case KMessageBox::Yes:
             // save document here. If saving fails, return false;
-            if (!saveFile()) {
+            if (!saveFile() || !m_project->waitForSave()) {
                 pCore->displayBinMessage(i18n("Project profile change aborted"), KMessageWidget::Information);
                 return;
             }
@@ -28,8 +28,16 @@ AbstractGfxScopeWidget::~AbstractGfxScopeWidget() = default;
 
 QImage AbstractGfxScopeWidget::renderScope(uint accelerationFactor)
 {
-    QMutexLocker lock(&m_mutex);
-    return renderGfxScope(accelerationFactor, m_scopeImage);
+    std::shared_ptr<const FrameStatistics> stats;
+    {
+        QMutexLocker lock(&m_mutex);
+        stats = m_statistics;
+    }
+    if (!stats) {
+        emit signalScopeRenderingFinished(0, accelerationFactor);
+        return QImage();
+    }
+    return renderGfxScope(accelerationFactor, *stats);
 }
 
 void AbstractGfxScopeWidget::mouseReleaseEvent(QMouseEvent *event)
@@ -40,10 +48,12 @@ void AbstractGfxScopeWidget::mouseReleaseEvent(QMouseEvent *event)
 
 ///// Slots /////
 
-void AbstractGfxScopeWidget::slotRenderZoneUpdated(const QImage &frame)
+void AbstractGfxScopeWidget::slotRenderZoneUpdated(const std::shared_ptr<const FrameStatistics> &stats)
 {
-    QMutexLocker lock(&m_mutex);
-    m_scopeImage = frame;
+    {
+        QMutexLocker lock(&m_mutex);
+        m_statistics = stats;
+    }
     AbstractScopeWidget::slotRenderZoneUpdated();
 }
 
@@ -54,6 +64,11 @@ void AbstractGfxScopeWidget::slotAutoRefreshToggled(bool autoRefresh)
     }
 }
 
+void AbstractGfxScopeWidget::slotStatisticsRequestChanged()
+{
+    emit signalFrameRequest(widgetName());
+}
+
 #ifdef DEBUG_AGSW
 #undef DEBUG_AGSW
 #endif
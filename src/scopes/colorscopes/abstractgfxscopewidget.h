@@ -16,9 +16,15 @@
 #include <QtCore>
 
 #include "../abstractscopewidget.h"
+#include "framestatistics.h"
+
+#include <memory>
 
 /**
 \brief Abstract class for scopes analyzing image frames.
+
+Frames are not analysed by the scopes themselves: the ScopeManager collects the statistics
+requested by all active scopes in a single pass, and the scopes paint them.
 */
 class AbstractGfxScopeWidget : public AbstractScopeWidget
 {
@@ -28,30 +34,36 @@ public:
     explicit AbstractGfxScopeWidget(bool trackMouse = false, QWidget *parent = nullptr);
     ~AbstractGfxScopeWidget() override; // Must be virtual because of inheritance, to avoid memory leaks
 
+    /** @brief Returns what the scope needs to be collected from the frames. */
+    virtual FrameStatistics::Request statisticsRequest() const = 0;
+
 protected:
     ///// Variables /////
 
     /** @brief Scope renderer. Must emit signalScopeRenderingFinished()
         when calculation has finished, to allow multi-threading.
-        accelerationFactor hints how much faster than usual the calculation should be accomplished, if possible. */
-    virtual QImage renderGfxScope(uint accelerationFactor, const QImage &) = 0;
+        accelerationFactor hints how much faster than usual the calculation should be accomplished, if possible.
+        The statistics are never null. */
+    virtual QImage renderGfxScope(uint accelerationFactor, const FrameStatistics &stats) = 0;
 
     QImage renderScope(uint accelerationFactor) override;
 
     void mouseReleaseEvent(QMouseEvent *) override;
 
 private:
-    QImage m_scopeImage;
+    std::shared_ptr<const FrameStatistics> m_statistics;
     QMutex m_mutex;
 
 public slots:
     /** @brief Must be called when the active monitor has shown a new frame.
       This slot must be connected in the implementing class, it is *not*
       done in this abstract class. */
-    void slotRenderZoneUpdated(const QImage &);
+    void slotRenderZoneUpdated(const std::shared_ptr<const FrameStatistics> &stats);
 
 protected slots:
     virtual void slotAutoRefreshToggled(bool autoRefresh);
+    /** @brief Must be called when an option changing statisticsRequest() was modified, to get a new frame analysis. */
+    void slotStatisticsRequestChanged();
 
 signals:
     void signalFrameRequest(const QString &widgetName);
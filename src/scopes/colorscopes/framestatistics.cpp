@@ -0,0 +1,477 @@
+/***************************************************************************
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#include "framestatistics.h"
+
+#include <QImage>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FRAMESTATISTICS_SSE2
+#include <emmintrin.h>
+#endif
+
+const int FrameStatistics::MaxColumns = 768;
+const int FrameStatistics::MaxThreads = 4;
+
+namespace {
+// Bands smaller than this are not worth a thread
+const int MinBandHeight = 64;
+
+/** Frames are analysed from tasks of the global thread pool (see ScopeManager), which may have no thread left for
+    the bands: they run in their own pool. The first band is analysed by the calling thread. */
+class BandPool : public QThreadPool
+{
+public:
+    BandPool() { setMaxThreadCount(FrameStatistics::MaxThreads - 1); }
+};
+
+QThreadPool *bandPool()
+{
+    static BandPool pool;
+    return &pool;
+}
+
+/** 16 bit fixed point YUV to RGB coefficients of the monitor shader, applied to limited range values
+    (16 for black, 128 for neutral chroma). The luma coefficient has 14 fractional bits and the chroma
+    ones 13 so that everything fits in 16 bit lanes; the results have 4 fractional bits.
+    The scalar and SSE2 code do exactly the same integer operations and give the same results. */
+struct YuvCoefficients
+{
+    YuvCoefficients(double rv_, double gu_, double gv_, double bu_)
+        : y((int16_t)std::lround(1.1643 * 16384))
+        , rv((int16_t)std::lround(rv_ * 8192))
+        , gu((int16_t)std::lround(gu_ * 8192))
+        , gv((int16_t)std::lround(gv_ * 8192))
+        , bu((int16_t)std::lround(bu_ * 8192))
+    {
+    }
+    int16_t y, rv, gu, gv, bu;
+};
+
+const YuvCoefficients &yuvCoefficients(FrameStatistics::Rec matrix)
+{
+    static const YuvCoefficients rec601(1.5958, -0.39173, -0.8129, 2.017);
+    static const YuvCoefficients rec709(1.793, -0.213, -0.533, 2.112);
+    return matrix == FrameStatistics::Rec_601 ? rec601 : rec709;
+}
+
+/** Luma weights with 8 fractional bits, summing to 256 so that white stays at 255 */
+struct LumaWeights
+{
+    int16_t r, g, b;
+};
+
+const LumaWeights &lumaWeights(FrameStatistics::Rec rec)
+{
+    static const LumaWeights rec601{77, 150, 29};
+    static const LumaWeights rec709{54, 183, 19};
+    return rec == FrameStatistics::Rec_601 ? rec601 : rec709;
+}
+
+inline int clampByte(int value)
+{
+    return value < 0 ? 0 : (value > 255 ? 255 : value);
+}
+
+// Same as _mm_mulhi_epi16
+inline int mulhi(int a, int b)
+{
+    return (a * b) >> 16;
+}
+
+#ifdef FRAMESTATISTICS_SSE2
+// Converts 8 pixels, y/u/v are 16 bit values
+inline void yuvToRgb8(const YuvCoefficients &c, __m128i y, __m128i u, __m128i v, __m128i &r, __m128i &g, __m128i &b)
+{
+    const __m128i round = _mm_set1_epi16(8);
+    const __m128i yy = _mm_mulhi_epi16(_mm_slli_epi16(_mm_sub_epi16(y, _mm_set1_epi16(16)), 6), _mm_set1_epi16(c.y));
+    const __m128i uu = _mm_slli_epi16(_mm_sub_epi16(u, _mm_set1_epi16(128)), 6);
+    const __m128i vv = _mm_slli_epi16(_mm_sub_epi16(v, _mm_set1_epi16(128)), 6);
+    r = _mm_add_epi16(yy, _mm_slli_epi16(_mm_mulhi_epi16(vv, _mm_set1_epi16(c.rv)), 1));
+    g = _mm_add_epi16(yy, _mm_slli_epi16(_mm_mulhi_epi16(uu, _mm_set1_epi16(c.gu)), 1));
+    g = _mm_add_epi16(g, _mm_slli_epi16(_mm_mulhi_epi16(vv, _mm_set1_epi16(c.gv)), 1));
+    b = _mm_add_epi16(yy, _mm_slli_epi16(_mm_mulhi_epi16(uu, _mm_set1_epi16(c.bu)), 1));
+    r = _mm_srai_epi16(_mm_add_epi16(r, round), 4);
+    g = _mm_srai_epi16(_mm_add_epi16(g, round), 4);
+    b = _mm_srai_epi16(_mm_add_epi16(b, round), 4);
+}
+
+// Computes the luma of 8 pixels, r/g/b are 16 bit values on [0,255]
+inline __m128i luma8(const LumaWeights &w, __m128i r, __m128i g, __m128i b)
+{
+    // The sum is at most 255 * 256 and fits in unsigned 16 bit values
+    __m128i sum = _mm_mullo_epi16(r, _mm_set1_epi16(w.r));
+    sum = _mm_add_epi16(sum, _mm_mullo_epi16(g, _mm_set1_epi16(w.g)));
+    sum = _mm_add_epi16(sum, _mm_mullo_epi16(b, _mm_set1_epi16(w.b)));
+    return _mm_srli_epi16(sum, 8);
+}
+#endif
+} // namespace
+
+void FrameStatistics::Request::merge(const FrameStatistics::Request &other)
+{
+    if ((other.scopes & Histogram) != 0) {
+        histogramRec = other.histogramRec;
+    }
+    if ((other.scopes & Waveform) != 0) {
+        waveformRec = other.waveformRec;
+    }
+    scopes |= other.scopes;
+}
+
+FrameStatistics::FrameStatistics(int width, int height, const FrameStatistics::Request &request)
+    : m_request(request)
+    , m_width(std::max(0, width))
+    , m_height(std::max(0, height))
+    , m_columns(std::min(m_width, MaxColumns))
+    , m_histograms(4 * 256, 0)
+{
+    if ((request.scopes & (Waveform | Parade)) != 0) {
+        m_columnOffsets.resize((size_t)m_width);
+        for (int x = 0; x < m_width; ++x) {
+            m_columnOffsets[(size_t)x] = int((qint64)x * m_columns / m_width) * 256;
+        }
+    }
+    if ((request.scopes & Waveform) != 0) {
+        m_waveform.resize((size_t)m_columns * 256, 0);
+    }
+    if ((request.scopes & Parade) != 0) {
+        m_parade.resize((size_t)m_columns * 3 * 256, 0);
+    }
+    if ((request.scopes & Vectorscope) != 0) {
+        m_chroma.resize(256 * 256, 0);
+        m_chromaColors.resize(256 * 256, 0);
+    }
+}
+
+// static
+void FrameStatistics::yuvToRgbRow(const uint8_t *y, const uint8_t *u, const uint8_t *v, int width, int chromaWidth, FrameStatistics::Rec matrix, uint8_t *r,
+                                  uint8_t *g, uint8_t *b, bool allowSimd)
+{
+    const YuvCoefficients &c = yuvCoefficients(matrix);
+    int x = 0;
+#ifdef FRAMESTATISTICS_SSE2
+    if (allowSimd) {
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 16 <= width && (x + 16) / 2 <= chromaWidth; x += 16) {
+            const __m128i y16 = _mm_loadu_si128((const __m128i *)(y + x));
+            // Each chroma sample is used by 2 pixels
+            __m128i u16 = _mm_loadl_epi64((const __m128i *)(u + x / 2));
+            __m128i v16 = _mm_loadl_epi64((const __m128i *)(v + x / 2));
+            u16 = _mm_unpacklo_epi8(u16, u16);
+            v16 = _mm_unpacklo_epi8(v16, v16);
+            __m128i rLo, gLo, bLo, rHi, gHi, bHi;
+            yuvToRgb8(c, _mm_unpacklo_epi8(y16, zero), _mm_unpacklo_epi8(u16, zero), _mm_unpacklo_epi8(v16, zero), rLo, gLo, bLo);
+            yuvToRgb8(c, _mm_unpackhi_epi8(y16, zero), _mm_unpackhi_epi8(u16, zero), _mm_unpackhi_epi8(v16, zero), rHi, gHi, bHi);
+            // Saturating packs clamp to [0,255]
+            _mm_storeu_si128((__m128i *)(r + x), _mm_packus_epi16(rLo, rHi));
+            _mm_storeu_si128((__m128i *)(g + x), _mm_packus_epi16(gLo, gHi));
+            _mm_storeu_si128((__m128i *)(b + x), _mm_packus_epi16(bLo, bHi));
+        }
+    }
+#else
+    Q_UNUSED(allowSimd)
+#endif
+    for (; x < width; ++x) {
+        const int cx = std::min(x / 2, chromaWidth - 1);
+        const int yy = mulhi((y[x] - 16) * 64, c.y);
+        const int uu = (u[cx] - 128) * 64;
+        const int vv = (v[cx] - 128) * 64;
+        r[x] = (uint8_t)clampByte((yy + 2 * mulhi(vv, c.rv) + 8) >> 4);
+        g[x] = (uint8_t)clampByte((yy + 2 * mulhi(uu, c.gu) + 2 * mulhi(vv, c.gv) + 8) >> 4);
+        b[x] = (uint8_t)clampByte((yy + 2 * mulhi(uu, c.bu) + 8) >> 4);
+    }
+}
+
+// static
+void FrameStatistics::rgbToLumaRow(const uint8_t *r, const uint8_t *g, const uint8_t *b, int width, FrameStatistics::Rec rec, uint8_t *luma, bool allowSimd)
+{
+    const LumaWeights &w = lumaWeights(rec);
+    int x = 0;
+#ifdef FRAMESTATISTICS_SSE2
+    if (allowSimd) {
+        const __m128i zero = _mm_setzero_si128();
+        for (; x + 16 <= width; x += 16) {
+            const __m128i r16 = _mm_loadu_si128((const __m128i *)(r + x));
+            const __m128i g16 = _mm_loadu_si128((const __m128i *)(g + x));
+            const __m128i b16 = _mm_loadu_si128((const __m128i *)(b + x));
+            const __m128i lo = luma8(w, _mm_unpacklo_epi8(r16, zero), _mm_unpacklo_epi8(g16, zero), _mm_unpacklo_epi8(b16, zero));
+            const __m128i hi = luma8(w, _mm_unpackhi_epi8(r16, zero), _mm_unpackhi_epi8(g16, zero), _mm_unpackhi_epi8(b16, zero));
+            _mm_storeu_si128((__m128i *)(luma + x), _mm_packus_epi16(lo, hi));
+        }
+    }
+#else
+    Q_UNUSED(allowSimd)
+#endif
+    for (; x < width; ++x) {
+        luma[x] = (uint8_t)((w.r * r[x] + w.g * g[x] + w.b * b[x]) >> 8);
+    }
+}
+
+void FrameStatistics::accumulateRow(const uint8_t *r, const uint8_t *g, const uint8_t *b, const uint8_t *cb, const uint8_t *cr, uint8_t *luma)
+{
+    const int width = m_width;
+    uint32_t *red = m_histograms.data();
+    uint32_t *green = red + 256;
+    uint32_t *blue = red + 512;
+    for (int x = 0; x < width; ++x) {
+        red[r[x]]++;
+        green[g[x]]++;
+        blue[b[x]]++;
+    }
+    if ((m_request.scopes & Histogram) != 0) {
+        rgbToLumaRow(r, g, b, width, m_request.histogramRec, luma);
+        uint32_t *histogram = red + 768;
+        for (int x = 0; x < width; ++x) {
+            histogram[luma[x]]++;
+        }
+    }
+    if ((m_request.scopes & Waveform) != 0) {
+        if ((m_request.scopes & Histogram) == 0 || m_request.histogramRec != m_request.waveformRec) {
+            rgbToLumaRow(r, g, b, width, m_request.waveformRec, luma);
+        }
+        uint32_t *waveform = m_waveform.data();
+        const int *offsets = m_columnOffsets.data();
+        for (int x = 0; x < width; ++x) {
+            waveform[offsets[x] + luma[x]]++;
+        }
+    }
+    if ((m_request.scopes & Parade) != 0) {
+        uint32_t *parade = m_parade.data();
+        const int *offsets = m_columnOffsets.data();
+        for (int x = 0; x < width; ++x) {
+            uint32_t *column = parade + 3 * offsets[x];
+            column[r[x]]++;
+            column[256 + g[x]]++;
+            column[512 + b[x]]++;
+        }
+    }
+    if ((m_request.scopes & Vectorscope) != 0) {
+        uint32_t *chroma = m_chroma.data();
+        QRgb *colors = m_chromaColors.data();
+        for (int x = 0; x < width; ++x) {
+            const int index = cr[x] * 256 + cb[x];
+            chroma[index]++;
+            colors[index] = qRgb(r[x], g[x], b[x]);
+        }
+    }
+}
+
+void FrameStatistics::merge(const FrameStatistics &other)
+{
+    std::transform(m_histograms.begin(), m_histograms.end(), other.m_histograms.begin(), m_histograms.begin(), std::plus<uint32_t>());
+    std::transform(m_waveform.begin(), m_waveform.end(), other.m_waveform.begin(), m_waveform.begin(), std::plus<uint32_t>());
+    std::transform(m_parade.begin(), m_parade.end(), other.m_parade.begin(), m_parade.begin(), std::plus<uint32_t>());
+    for (size_t i = 0; i < m_chroma.size(); ++i) {
+        if (other.m_chroma[i] > 0) {
+            // The other part comes later in the frame
+            m_chroma[i] += other.m_chroma[i];
+            m_chromaColors[i] = other.m_chromaColors[i];
+        }
+    }
+}
+
+// static
+std::shared_ptr<FrameStatistics> FrameStatistics::analyseBands(int width, int height, const FrameStatistics::Request &request, int threads,
+                                                               const std::function<void(FrameStatistics &, int, int)> &analyseRows)
+{
+    int bands = qBound(1, threads > 0 ? threads : QThread::idealThreadCount(), MaxThreads);
+    bands = qBound(1, height / MinBandHeight, bands);
+    // Bands start on even rows, so that they don't share chroma rows
+    const int bandHeight = ((height + bands - 1) / bands + 1) & ~1;
+
+    std::vector<std::shared_ptr<FrameStatistics>> partials;
+    QList<QFuture<void>> futures;
+    partials.emplace_back(new FrameStatistics(width, height, request));
+    for (int first = bandHeight; first < height; first += bandHeight) {
+        std::shared_ptr<FrameStatistics> partial(new FrameStatistics(width, height, request));
+        partials.push_back(partial);
+        const int last = std::min(height, first + bandHeight);
+        futures << QtConcurrent::run(bandPool(), [&analyseRows, partial, first, last]() { analyseRows(*partial, first, last); });
+    }
+    // The first band is analysed by the calling thread
+    analyseRows(*partials.front(), 0, std::min(height, bandHeight));
+    for (QFuture<void> &future : futures) {
+        future.waitForFinished();
+    }
+    for (size_t i = 1; i < partials.size(); ++i) {
+        partials.front()->merge(*partials[i]);
+    }
+    return partials.front();
+}
+
+// static
+std::shared_ptr<FrameStatistics> FrameStatistics::fromYuv420p(const uint8_t *image, int width, int height, FrameStatistics::Rec matrix,
+                                                              const FrameStatistics::Request &request, int threads)
+{
+    const int cw = width / 2;
+    const int ch = height / 2;
+    if (image == nullptr || cw <= 0 || ch <= 0) {
+        // Not a valid yuv420p frame
+        return std::shared_ptr<FrameStatistics>(new FrameStatistics(0, 0, request));
+    }
+    const uint8_t *uPlane = image + width * height;
+    const uint8_t *vPlane = uPlane + cw * ch;
+    const bool needChroma = (request.scopes & Vectorscope) != 0;
+
+    return analyseBands(width, height, request, threads, [=](FrameStatistics &stats, int first, int last) {
+        std::vector<uint8_t> buffer((size_t)width * 6);
+        uint8_t *r = buffer.data();
+        uint8_t *g = r + width;
+        uint8_t *b = g + width;
+        uint8_t *cb = b + width;
+        uint8_t *cr = cb + width;
+        uint8_t *luma = cr + width;
+        for (int y = first; y < last; ++y) {
+            const int cy = std::min(y / 2, ch - 1);
+            const uint8_t *uLine = uPlane + cy * cw;
+            const uint8_t *vLine = vPlane + cy * cw;
+            yuvToRgbRow(image + y * width, uLine, vLine, width, cw, matrix, r, g, b);
+            if (needChroma) {
+                for (int x = 0; x < width; ++x) {
+                    const int cx = std::min(x / 2, cw - 1);
+                    cb[x] = uLine[cx];
+                    cr[x] = vLine[cx];
+                }
+            }
+            stats.accumulateRow(r, g, b, cb, cr, luma);
+        }
+    });
+}
+
+// static
+std::shared_ptr<FrameStatistics> FrameStatistics::fromImage(const QImage &image, const FrameStatistics::Request &request, int threads)
+{
+    if (image.isNull()) {
+        return std::shared_ptr<FrameStatistics>(new FrameStatistics(0, 0, request));
+    }
+    const QImage rgb = image.format() == QImage::Format_RGB32 || image.format() == QImage::Format_ARGB32 ? image : image.convertToFormat(QImage::Format_RGB32);
+    const int width = rgb.width();
+    const bool needChroma = (request.scopes & Vectorscope) != 0;
+
+    return analyseBands(width, rgb.height(), request, threads, [&rgb, width, needChroma](FrameStatistics &stats, int first, int last) {
+        std::vector<uint8_t> buffer((size_t)width * 6);
+        uint8_t *r = buffer.data();
+        uint8_t *g = r + width;
+        uint8_t *b = g + width;
+        uint8_t *cb = b + width;
+        uint8_t *cr = cb + width;
+        uint8_t *luma = cr + width;
+        for (int y = first; y < last; ++y) {
+            auto *line = (const QRgb *)rgb.constScanLine(y);
+            for (int x = 0; x < width; ++x) {
+                r[x] = (uint8_t)qRed(line[x]);
+                g[x] = (uint8_t)qGreen(line[x]);
+                b[x] = (uint8_t)qBlue(line[x]);
+            }
+            if (needChroma) {
+                for (int x = 0; x < width; ++x) {
+                    // Rec. 601 RGB to limited range YCbCr
+                    cb[x] = (uint8_t)clampByte(((-38 * r[x] - 74 * g[x] + 112 * b[x] + 128) >> 8) + 128);
+                    cr[x] = (uint8_t)clampByte(((112 * r[x] - 94 * g[x] - 18 * b[x] + 128) >> 8) + 128);
+                }
+            }
+            stats.accumulateRow(r, g, b, cb, cr, luma);
+        }
+    });
+}
+
+const FrameStatistics::Request &FrameStatistics::request() const
+{
+    return m_request;
+}
+
+int FrameStatistics::width() const
+{
+    return m_width;
+}
+
+int FrameStatistics::height() const
+{
+    return m_height;
+}
+
+int FrameStatistics::pixelCount() const
+{
+    return m_width * m_height;
+}
+
+bool FrameStatistics::isEmpty() const
+{
+    return m_width <= 0 || m_height <= 0;
+}
+
+const uint32_t *FrameStatistics::redHistogram() const
+{
+    return m_histograms.data();
+}
+
+const uint32_t *FrameStatistics::greenHistogram() const
+{
+    return m_histograms.data() + 256;
+}
+
+const uint32_t *FrameStatistics::blueHistogram() const
+{
+    return m_histograms.data() + 512;
+}
+
+const uint32_t *FrameStatistics::lumaHistogram() const
+{
+    return m_histograms.data() + 768;
+}
+
+int FrameStatistics::columns() const
+{
+    return m_columns;
+}
+
+const uint32_t *FrameStatistics::waveformColumn(int column) const
+{
+    Q_ASSERT(!m_waveform.empty() && column >= 0 && column < m_columns);
+    return m_waveform.data() + (size_t)column * 256;
+}
+
+const uint32_t *FrameStatistics::redColumn(int column) const
+{
+    Q_ASSERT(!m_parade.empty() && column >= 0 && column < m_columns);
+    return m_parade.data() + (size_t)column * 768;
+}
+
+const uint32_t *FrameStatistics::greenColumn(int column) const
+{
+    return redColumn(column) + 256;
+}
+
+const uint32_t *FrameStatistics::blueColumn(int column) const
+{
+    return redColumn(column) + 512;
+}
+
+uint32_t FrameStatistics::chromaCount(int cb, int cr) const
+{
+    if (m_chroma.empty()) {
+        return 0;
+    }
+    return m_chroma[(size_t)cr * 256 + cb];
+}
+
+QRgb FrameStatistics::chromaColor(int cb, int cr) const
+{
+    if (m_chromaColors.empty()) {
+        return 0;
+    }
+    return m_chromaColors[(size_t)cr * 256 + cb];
+}
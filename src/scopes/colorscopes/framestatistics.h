@@ -0,0 +1,138 @@
+/***************************************************************************
+ *   This file is part of kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ ***************************************************************************/
+
+#ifndef FRAMESTATISTICS_H
+#define FRAMESTATISTICS_H
+
+#include <QRgb>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class QImage;
+
+/**
+  \brief Statistics of a frame, shared by all the color scopes.
+
+  The frame is read once and everything the enabled scopes need is accumulated
+  in the same pass. The scopes then only have to paint the statistics, whatever
+  the frame size is.
+
+  Frames are usually analysed in their native yuv420p format, converted to RGB with
+  the same coefficients as the monitor shader. Images (captured frames, or frames
+  rendered by Movit) can be analysed too, and give the same statistics.
+
+  Collected data:
+  - RGB histograms, always
+  - Luma histogram (Histogram)
+  - Luma per column (Waveform)
+  - R, G and B per column (Parade)
+  - Cb/Cr distribution and the color of the last pixel of each Cb/Cr pair (Vectorscope)
+
+  Columns are the frame columns, grouped when the frame is wider than MaxColumns.
+
+  Rows are converted with SSE2 when available, and bands of rows are analysed in parallel
+  with their own counters, merged at the end.
+  */
+class FrameStatistics
+{
+public:
+    enum Scope { Histogram = 1 << 0, Waveform = 1 << 1, Parade = 1 << 2, Vectorscope = 1 << 3 };
+    /** Recommendation used to calculate the luma or to convert YUV to RGB.
+        See http://www.poynton.com/ColorFAQ.html for details. */
+    enum Rec { Rec_601, Rec_709 };
+
+    /** @brief What the scopes need from a frame. */
+    struct Request
+    {
+        /** OR-ed FrameStatistics::Scope flags */
+        int scopes{0};
+        Rec histogramRec{Rec_601};
+        Rec waveformRec{Rec_601};
+
+        /** @brief Add the needs of another scope. The luma recommendations of a request are only used if it asks for the matching scope */
+        void merge(const Request &other);
+    };
+
+    static const int MaxColumns;
+
+    /** @brief Analyse a yuv420p frame (Y plane followed by the U and V planes, each of half width and height)
+        @param matrix is the color matrix of the frame, as used by the monitor
+        @param threads is the number of threads to use, at most MaxThreads. 0 uses one per core */
+    static std::shared_ptr<FrameStatistics> fromYuv420p(const uint8_t *image, int width, int height, Rec matrix, const Request &request, int threads = 0);
+    /** @brief Analyse an RGB image */
+    static std::shared_ptr<FrameStatistics> fromImage(const QImage &image, const Request &request, int threads = 0);
+
+    const Request &request() const;
+    int width() const;
+    int height() const;
+    int pixelCount() const;
+    bool isEmpty() const;
+
+    /** @brief Histograms of the R, G, B and luma values, 256 entries each. Luma is only filled for the Histogram scope */
+    const uint32_t *redHistogram() const;
+    const uint32_t *greenHistogram() const;
+    const uint32_t *blueHistogram() const;
+    const uint32_t *lumaHistogram() const;
+
+    /** @brief Number of columns of the waveform and parade data */
+    int columns() const;
+    /** @brief Luma distribution of a column, 256 entries */
+    const uint32_t *waveformColumn(int column) const;
+    /** @brief R, G and B distributions of a column, 256 entries each */
+    const uint32_t *redColumn(int column) const;
+    const uint32_t *greenColumn(int column) const;
+    const uint32_t *blueColumn(int column) const;
+
+    /** @brief Number of pixels with the given chroma, Cb and Cr are on [0,255] with 128 as neutral */
+    uint32_t chromaCount(int cb, int cr) const;
+    /** @brief Color of the last pixel counted for the given chroma */
+    QRgb chromaColor(int cb, int cr) const;
+
+    /** @brief Converts a row of a yuv420p frame to RGB, using SSE2 when available and allowed.
+        Both code paths give the same result.
+        @param u, v are the chroma rows, each sample is used by 2 pixels
+        @param chromaWidth is the number of samples in the chroma rows; the last one is reused if the row is longer */
+    static void yuvToRgbRow(const uint8_t *y, const uint8_t *u, const uint8_t *v, int width, int chromaWidth, Rec matrix, uint8_t *r, uint8_t *g, uint8_t *b,
+                            bool allowSimd = true);
+    /** @brief Computes the luma of a row of RGB pixels, using SSE2 when available and allowed */
+    static void rgbToLumaRow(const uint8_t *r, const uint8_t *g, const uint8_t *b, int width, Rec rec, uint8_t *luma, bool allowSimd = true);
+
+    /** Maximum number of threads used to analyse a frame */
+    static const int MaxThreads;
+
+protected:
+    FrameStatistics(int width, int height, const Request &request);
+    /** @brief Count a row of pixels
+        @param cb, cr are the chroma values of each pixel, only read for the Vectorscope
+        @param luma is a buffer of width values used to compute the luma */
+    void accumulateRow(const uint8_t *r, const uint8_t *g, const uint8_t *b, const uint8_t *cb, const uint8_t *cr, uint8_t *luma);
+    /** @brief Add the counts of a following part of the same frame */
+    void merge(const FrameStatistics &other);
+    /** @brief Splits the frame in bands of rows analysed in parallel, each in its own statistics, and merges them.
+        @param threads is the maximum number of bands, 0 uses one per core
+        @param analyseRows must accumulate the rows [first, last[ in the given statistics */
+    static std::shared_ptr<FrameStatistics> analyseBands(int width, int height, const Request &request, int threads,
+                                                         const std::function<void(FrameStatistics &stats, int first, int last)> &analyseRows);
+
+    Request m_request;
+    int m_width;
+    int m_height;
+    int m_columns;
+    // Offset of the waveform data of each pixel column (grouped column * 256)
+    std::vector<int> m_columnOffsets;
+    std::vector<uint32_t> m_histograms;
+    std::vector<uint32_t> m_waveform;
+    std::vector<uint32_t> m_parade;
+    std::vector<uint32_t> m_chroma;
+    std::vector<QRgb> m_chromaColors;
+};
+
+#endif // FRAMESTATISTICS_H
@@ -45,8 +45,8 @@ Histogram::Histogram(QWidget *parent)
     connect(m_ui->cbG, &QAbstractButton::toggled, this, &AbstractScopeWidget::forceUpdateScope);
     connect(m_ui->cbB, &QAbstractButton::toggled, this, &AbstractScopeWidget::forceUpdateScope);
     connect(m_aUnscaled, &QAction::toggled, this, &Histogram::forceUpdateScope);
-    connect(m_aRec601, &QAction::toggled, this, &Histogram::forceUpdateScope);
-    connect(m_aRec709, &QAction::toggled, this, &Histogram::forceUpdateScope);
+    // The luma is computed when the frame is analysed
+    connect(m_aRec601, &QAction::toggled, this, &Histogram::slotStatisticsRequestChanged);
 
     init();
     m_histogramGenerator = new HistogramGenerator();
@@ -122,7 +122,15 @@ QImage Histogram::renderHUD(uint)
     emit signalHUDRenderingFinished(0, 1);
     return QImage();
 }
-QImage Histogram::renderGfxScope(uint accelFactor, const QImage &qimage)
+FrameStatistics::Request Histogram::statisticsRequest() const
+{
+    FrameStatistics::Request request;
+    request.scopes = FrameStatistics::Histogram;
+    request.histogramRec = m_aRec601->isChecked() ? FrameStatistics::Rec_601 : FrameStatistics::Rec_709;
+    return request;
+}
+
+QImage Histogram::renderGfxScope(uint accelFactor, const FrameStatistics &stats)
 {
     QTime start = QTime::currentTime();
     start.start();
@@ -131,9 +139,7 @@ QImage Histogram::renderGfxScope(uint accelFactor, const QImage &qimage)
         (m_ui->cbR->isChecked() ? 1 : 0) * HistogramGenerator::ComponentR | (m_ui->cbG->isChecked() ? 1 : 0) * HistogramGenerator::ComponentG |
         (m_ui->cbB->isChecked() ? 1 : 0) * HistogramGenerator::ComponentB;
 
-    HistogramGenerator::Rec rec = m_aRec601->isChecked() ? HistogramGenerator::Rec_601 : HistogramGenerator::Rec_709;
-
-    QImage histogram = m_histogramGenerator->calculateHistogram(m_scopeRect.size(), qimage, componentFlags, rec, m_aUnscaled->isChecked(), accelFactor);
+    QImage histogram = m_histogramGenerator->calculateHistogram(m_scopeRect.size(), stats, componentFlags, m_aUnscaled->isChecked());
 
     emit signalScopeRenderingFinished(uint(start.elapsed()), accelFactor);
     return histogram;
@@ -27,6 +27,7 @@ public:
     explicit Histogram(QWidget *parent = nullptr);
     ~Histogram() override;
     QString widgetName() const override;
+    FrameStatistics::Request statisticsRequest() const override;
 
 protected:
     void readConfig() override;
@@ -44,7 +45,7 @@ private:
     bool isScopeDependingOnInput() const override;
     bool isBackgroundDependingOnInput() const override;
     QImage renderHUD(uint accelerationFactor) override;
-    QImage renderGfxScope(uint accelerationFactor, const QImage &) override;
+    QImage renderGfxScope(uint accelerationFactor, const FrameStatistics &stats) override;
     QImage renderBackground(uint accelerationFactor) override;
     Ui::Histogram_UI *m_ui;
 };
@@ -9,19 +9,20 @@
  ***************************************************************************/
 
 #include "histogramgenerator.h"
+#include "framestatistics.h"
 
 #include "klocalizedstring.h"
 #include <QImage>
 #include <QPainter>
 #include <algorithm>
 #include <cmath>
+#include <vector>
 
 HistogramGenerator::HistogramGenerator() = default;
 
-QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QImage &image, const int &components, HistogramGenerator::Rec rec, bool unscaled,
-                                              uint accelFactor) const
+QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const FrameStatistics &stats, const int &components, bool unscaled) const
 {
-    if (paradeSize.height() <= 0 || paradeSize.width() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (paradeSize.height() <= 0 || paradeSize.width() <= 0 || stats.isEmpty()) {
         return QImage();
     }
 
@@ -31,43 +32,21 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QIm
     bool drawB = (components & HistogramGenerator::ComponentB) != 0;
     bool drawSum = (components & HistogramGenerator::ComponentSum) != 0;
 
-    int r[256], g[256], b[256], y[256], s[766];
-    // Initialize the values to zero
-    std::fill(r, r + 256, 0);
-    std::fill(g, g + 256, 0);
-    std::fill(b, b + 256, 0);
-    std::fill(y, y + 256, 0);
-    std::fill(s, s + 766, 0);
+    int r[256], g[256], b[256], y[256], s[256];
+    const uint32_t *statsR = stats.redHistogram();
+    const uint32_t *statsG = stats.greenHistogram();
+    const uint32_t *statsB = stats.blueHistogram();
+    const uint32_t *statsY = stats.lumaHistogram();
+    for (int i = 0; i < 256; ++i) {
+        r[i] = (int)statsR[i];
+        g[i] = (int)statsG[i];
+        b[i] = (int)statsB[i];
+        y[i] = (int)statsY[i];
+        s[i] = r[i] + g[i] + b[i];
+    }
 
-    const uint iw = (uint)image.bytesPerLine();
-    const uint ih = (uint)image.height();
     const uint ww = (uint)paradeSize.width();
     const uint wh = (uint)paradeSize.height();
-    const uint byteCount = iw * ih;
-
-    // Read the stats from the input image
-    for (int Y = 0; Y < image.height(); ++Y) {
-        for (int X = 0; X < image.width(); X += (int)accelFactor) {
-            QRgb col = image.pixel(X, Y);
-            r[qRed(col)]++;
-            g[qGreen(col)]++;
-            b[qBlue(col)]++;
-            if (drawY) {
-                // Use if branch to avoid expensive multiplication if Y disabled
-                if (rec == HistogramGenerator::Rec_601) {
-                    y[(int)floor(.299 * qRed(col) + .587 * qGreen(col) + .114 * qBlue(col))]++;
-                } else {
-                    y[(int)floor(.2125 * qRed(col) + .7154 * qGreen(col) + .0721 * qBlue(col))]++;
-                }
-            }
-            if (drawSum) {
-                // Use an if branch here because the sum takes more operations than rgb
-                s[qRed(col)]++;
-                s[qGreen(col)]++;
-                s[qBlue(col)]++;
-            }
-        }
-    }
 
     const int nParts = (drawY ? 1 : 0) + (drawR ? 1 : 0) + (drawG ? 1 : 0) + (drawB ? 1 : 0) + (drawSum ? 1 : 0);
     if (nParts == 0) {
@@ -78,9 +57,10 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QIm
     const int d = 20; // Distance for text
     const int partH = int((int)wh - nParts * d) / nParts;
     float scaling = 0;
-    int div = (int)byteCount >> 7;
+    // Same scale as for a 4 bytes per pixel image of the frame size
+    int div = stats.pixelCount() >> 5;
     if (div > 0) {
-        scaling = (float)partH / float((int)byteCount >> 7);
+        scaling = (float)partH / float(div);
     }
     const int dist = 40;
 
@@ -124,11 +104,12 @@ QImage HistogramGenerator::calculateHistogram(const QSize &paradeSize, const QIm
 QImage HistogramGenerator::drawComponent(const int *y, const QSize &size, const float &scaling, const QColor &color, bool unscaled, uint max) const
 {
     QImage component((int)max, size.height(), QImage::Format_ARGB32);
-    component.fill(qRgba(0, 0, 0, 255));
     Q_ASSERT(scaling != INFINITY);
 
     const int partH = size.height();
 
+    // First row of the bar at each position x
+    std::vector<int> top(max);
     for (uint x = 0; x < max; ++x) {
         // Calculate the height of the curve at position x
         int partY = int(scaling * (float)y[x]);
@@ -137,10 +118,15 @@ QImage HistogramGenerator::drawComponent(const int *y, const QSize &size, const
         if (partY > partH - 1) {
             partY = partH - 1;
         }
-        partY = partH - 1 - partY;
+        top[x] = partH - 1 - partY;
+    }
 
-        for (int k = partH - 1; k >= partY; --k) {
-            component.setPixel((int)x, k, color.rgba());
+    const QRgb background = qRgba(0, 0, 0, 255);
+    const QRgb foreground = color.rgba();
+    for (int k = 0; k < partH; ++k) {
+        auto *line = (QRgb *)component.scanLine(k);
+        for (uint x = 0; x < max; ++x) {
+            line[x] = k >= top[x] ? foreground : background;
         }
     }
     if (unscaled && size.width() >= component.width()) {
@@ -13,6 +13,7 @@
 
 #include <QObject>
 
+class FrameStatistics;
 class QColor;
 class QImage;
 class QPainter;
@@ -25,16 +26,12 @@ class HistogramGenerator : public QObject
 public:
     explicit HistogramGenerator();
 
-    /** Recommendation to use.
-        See http://www.poynton.com/ColorFAQ.html for details. */
-    enum Rec { Rec_601, Rec_709 };
-
     /**
-        Calculates a histogram display from the input image.
+        Calculates a histogram display from the frame statistics.
         components are OR-ed HistogramGenerator::Components flags and decide with components (Y, R, G, B) to paint.
+        The luma recommendation is the one requested when the statistics were collected.
         unscaled = true leaves the width at 256 if the widget is wider (to avoid scaling). */
-    QImage calculateHistogram(const QSize &paradeSize, const QImage &image, const int &components, const HistogramGenerator::Rec rec, bool unscaled,
-                              uint accelFactor = 1) const;
+    QImage calculateHistogram(const QSize &paradeSize, const FrameStatistics &stats, const int &components, bool unscaled) const;
 
     QImage drawComponent(const int *y, const QSize &size, const float &scaling, const QColor &color, bool unscaled, uint max) const;
 
@@ -125,14 +125,21 @@ QImage RGBParade::renderHUD(uint)
     return hud;
 }
 
-QImage RGBParade::renderGfxScope(uint accelerationFactor, const QImage &qimage)
+FrameStatistics::Request RGBParade::statisticsRequest() const
+{
+    FrameStatistics::Request request;
+    request.scopes = FrameStatistics::Parade;
+    return request;
+}
+
+QImage RGBParade::renderGfxScope(uint accelerationFactor, const FrameStatistics &stats)
 {
     QTime start = QTime::currentTime();
     start.start();
 
     int paintmode = m_ui->paintMode->itemData(m_ui->paintMode->currentIndex()).toInt();
-    QImage parade = m_rgbParadeGenerator->calculateRGBParade(m_scopeRect.size(), qimage, (RGBParadeGenerator::PaintMode)paintmode, m_aAxis->isChecked(),
-                                                             m_aGradRef->isChecked(), accelerationFactor);
+    QImage parade = m_rgbParadeGenerator->calculateRGBParade(m_scopeRect.size(), stats, (RGBParadeGenerator::PaintMode)paintmode, m_aAxis->isChecked(),
+                                                             m_aGradRef->isChecked());
     emit signalScopeRenderingFinished((uint)start.elapsed(), accelerationFactor);
     return parade;
 }
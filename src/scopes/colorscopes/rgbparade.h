@@ -28,6 +28,7 @@ public:
     explicit RGBParade(QWidget *parent = nullptr);
     ~RGBParade() override;
     QString widgetName() const override;
+    FrameStatistics::Request statisticsRequest() const override;
 
 protected:
     void readConfig() override;
@@ -46,7 +47,7 @@ private:
     bool isBackgroundDependingOnInput() const override;
 
     QImage renderHUD(uint accelerationFactor) override;
-    QImage renderGfxScope(uint accelerationFactor, const QImage &) override;
+    QImage renderGfxScope(uint accelerationFactor, const FrameStatistics &stats) override;
     QImage renderBackground(uint accelerationFactor) override;
 };
 
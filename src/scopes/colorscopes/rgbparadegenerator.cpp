@@ -9,9 +9,12 @@
  ***************************************************************************/
 
 #include "rgbparadegenerator.h"
+#include "framestatistics.h"
 #include "klocalizedstring.h"
 #include <QColor>
 #include <QPainter>
+#include <cmath>
+#include <vector>
 
 #define CHOP255(a) ((255) < (a) ? (255) : int(a))
 #define CHOP1255(a) ((a) < (1) ? (1) : ((a) > (255) ? (255) : (a)))
@@ -23,21 +26,12 @@ const QColor RGBParadeGenerator::colSoft(150, 150, 150, 255);
 const uchar RGBParadeGenerator::distRight(40);
 const uchar RGBParadeGenerator::distBottom(40);
 
-struct StructRGB
-{
-    uint r;
-    uint g;
-    uint b;
-};
-
 RGBParadeGenerator::RGBParadeGenerator() = default;
 
-QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QImage &image, const RGBParadeGenerator::PaintMode paintMode, bool drawAxis,
-                                              bool drawGradientRef, uint accelFactor)
+QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const FrameStatistics &stats, const RGBParadeGenerator::PaintMode paintMode, bool drawAxis,
+                                              bool drawGradientRef)
 {
-    Q_ASSERT(accelFactor >= 1);
-
-    if (paradeSize.width() <= 0 || paradeSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (paradeSize.width() <= 0 || paradeSize.height() <= 0 || stats.isEmpty() || (stats.request().scopes & FrameStatistics::Parade) == 0) {
         return QImage();
     }
     QImage parade(paradeSize, QImage::Format_ARGB32);
@@ -47,104 +41,103 @@ QImage RGBParadeGenerator::calculateRGBParade(const QSize &paradeSize, const QIm
 
     const uint ww = (uint)paradeSize.width();
     const uint wh = (uint)paradeSize.height();
-    const uint iw = (uint)image.bytesPerLine();
-    const uint ih = (uint)image.height();
-    const uint byteCount = iw * ih; // Note that 1 px = 4 B
+    const int columns = stats.columns();
 
     const uchar offset = 10;
     const uint partW = (ww - 2 * offset - distRight) / 3;
     const uint partH = wh - distBottom;
 
     // Statistics
-    uchar minR = 255, minG = 255, minB = 255, maxR = 0, maxG = 0, maxB = 0, r, g, b;
+    int minR = 255, minG = 255, minB = 255, maxR = 0, maxG = 0, maxB = 0;
+    const uint32_t *histR = stats.redHistogram();
+    const uint32_t *histG = stats.greenHistogram();
+    const uint32_t *histB = stats.blueHistogram();
+    for (int i = 0; i < 256; ++i) {
+        if (histR[i] > 0) {
+            minR = qMin(minR, i);
+            maxR = i;
+        }
+        if (histG[i] > 0) {
+            minG = qMin(minG, i);
+            maxG = i;
+        }
+        if (histB[i] > 0) {
+            minB = qMin(minB, i);
+            maxB = i;
+        }
+    }
 
     // Number of input pixels that will fall on one scope pixel.
-    // Must be a float because the acceleration factor can be high, leading to <1 expected px per px.
-    const float pixelDepth = (float)((byteCount >> 2) / accelFactor) / float(partW * 255);
+    const float pixelDepth = (float)stats.pixelCount() / float(partW * 255);
     const float gain = 255 / (8 * pixelDepth);
-    //        qCDebug(KDENLIVE_LOG) << "Pixel depth: expected " << pixelDepth << "; Gain: using " << gain << " (acceleration: " << accelFactor << "x)";
+    //        qCDebug(KDENLIVE_LOG) << "Pixel depth: expected " << pixelDepth << "; Gain: using " << gain;
 
     QImage unscaled((int)ww - distRight, 256, QImage::Format_ARGB32);
     unscaled.fill(qRgba(0, 0, 0, 0));
 
-    const float wPrediv = (float)(partW - 1) / float((int)iw - 1);
-
-    std::vector<std::vector<StructRGB>> paradeVals(partW, std::vector<StructRGB>(256, {0, 0, 0}));
-
-    const uchar *bits = image.bits();
-    const uint stepsize = uint(uint(image.depth() / 8) * accelFactor);
-
-    for (uint i = 0, x = 0; i < byteCount; i += stepsize) {
-        auto *col = (const QRgb *)(bits);
-        r = (uchar)qRed(*col);
-        g = (uchar)qGreen(*col);
-        b = (uchar)qBlue(*col);
-
-        double dx = x * (double)wPrediv;
-
-        paradeVals[(size_t)dx][r].r++;
-        paradeVals[(size_t)dx][g].g++;
-        paradeVals[(size_t)dx][b].b++;
-
-        if (r < minR) {
-            minR = r;
+    const float wPrediv = columns > 1 ? (float)(partW - 1) / float(columns - 1) : 0;
+
+    // Counts of the R, G and B parts, row by row (one row per value)
+    std::vector<uint> paradeVals((size_t)3 * 256 * partW, 0);
+    uint *paradeR = paradeVals.data();
+    uint *paradeG = paradeR + 256 * partW;
+    uint *paradeB = paradeG + 256 * partW;
+
+    for (int x = 0; x < columns; ++x) {
+        const size_t i = (size_t)(x * wPrediv);
+        const uint32_t *r = stats.redColumn(x);
+        const uint32_t *g = stats.greenColumn(x);
+        const uint32_t *b = stats.blueColumn(x);
+        for (int j = 0; j < 256; ++j) {
+            paradeR[(size_t)j * partW + i] += r[j];
+            paradeG[(size_t)j * partW + i] += g[j];
+            paradeB[(size_t)j * partW + i] += b[j];
         }
-        if (g < minG) {
-            minG = g;
-        }
-        if (b < minB) {
-            minB = b;
-        }
-        if (r > maxR) {
-            maxR = r;
-        }
-        if (g > maxG) {
-            maxG = g;
-        }
-        if (b > maxB) {
-            maxB = b;
-        }
-
-        bits += stepsize;
-        x += stepsize;
-        x %= iw; // Modulo image width, to represent the current x position in the image
     }
 
+    // Alpha of the counts, up to the count where it saturates
+    std::vector<uchar> alphas;
+    const size_t saturation = qMin((size_t)std::ceil(255 / gain) + 1, (size_t)65536);
+    alphas.reserve(saturation);
+    for (size_t count = 0; count < saturation; ++count) {
+        alphas.push_back((uchar)CHOP255(gain * (float)count));
+    }
+    const auto alpha = [&alphas, gain](uint count) { return count < alphas.size() ? (int)alphas[count] : CHOP255(gain * (float)count); };
+
+    QRgb colR = qRgb(255, 255, 255);
+    QRgb colG = qRgb(255, 255, 255);
+    QRgb colB = qRgb(255, 255, 255);
+    if (paintMode == PaintMode_RGB) {
+        colR = qRgb(255, 10, 10);
+        colG = qRgb(10, 255, 10);
+        colB = qRgb(10, 10, 255);
+    }
     const int offset1 = (int)partW + (int)offset;
     const int offset2 = 2 * (int)partW + 2 * (int)offset;
-    switch (paintMode) {
-    case PaintMode_RGB:
-        for (int i = 0; i < (int)partW; ++i) {
-            for (int j = 0; j < 256; ++j) {
-                unscaled.setPixel(i, j, qRgba(255, 10, 10, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].r)));
-                unscaled.setPixel(i + offset1, j, qRgba(10, 255, 10, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].g)));
-                unscaled.setPixel(i + offset2, j, qRgba(10, 10, 255, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].b)));
-            }
-        }
-        break;
-    default:
+    for (int j = 0; j < 256; ++j) {
+        // Values grow upwards
+        auto *line = (QRgb *)unscaled.scanLine(255 - j);
+        const uint *r = paradeR + (size_t)j * partW;
+        const uint *g = paradeG + (size_t)j * partW;
+        const uint *b = paradeB + (size_t)j * partW;
         for (int i = 0; i < (int)partW; ++i) {
-            for (int j = 0; j < 256; ++j) {
-                unscaled.setPixel(i, j, qRgba(255, 255, 255, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].r)));
-                unscaled.setPixel(i + offset1, j, qRgba(255, 255, 255, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].g)));
-                unscaled.setPixel(i + offset2, j, qRgba(255, 255, 255, CHOP255(gain * (float)paradeVals[(size_t)i][(size_t)j].b)));
-            }
+            line[i] = (colR & RGB_MASK) | ((QRgb)alpha(r[i]) << 24);
+            line[i + offset1] = (colG & RGB_MASK) | ((QRgb)alpha(g[i]) << 24);
+            line[i + offset2] = (colB & RGB_MASK) | ((QRgb)alpha(b[i]) << 24);
         }
-        break;
     }
 
     // Scale the image to the target height. Scaling is not accomplished before because
     // there are only 255 different values which would lead to gaps if the height is not exactly 255.
     // Don't use bilinear transformation because the fast transformation meets the goal better.
-    davinci.drawImage(0, 0, unscaled.mirrored(false, true).scaled(unscaled.width(), (int)partH, Qt::IgnoreAspectRatio, Qt::FastTransformation));
+    davinci.drawImage(0, 0, unscaled.scaled(unscaled.width(), (int)partH, Qt::IgnoreAspectRatio, Qt::FastTransformation));
 
     if (drawAxis) {
-        QRgb opx;
         for (int i = 0; i <= 10; ++i) {
-            double dy = (float)i / 10. * float((int)partH - 1);
+            auto *line = (QRgb *)parade.scanLine((int)((float)i / 10. * float((int)partH - 1)));
             for (int x = 0; x < (int)ww - (int)distRight; ++x) {
-                opx = parade.pixel(x, dy);
-                parade.setPixel(x, dy, qRgba(CHOP255(150 + qRed(opx)), 255, CHOP255(200 + qBlue(opx)), CHOP255(32 + qAlpha(opx))));
+                const QRgb opx = line[x];
+                line[x] = qRgba(CHOP255(150 + qRed(opx)), 255, CHOP255(200 + qBlue(opx)), CHOP255(32 + qAlpha(opx)));
             }
         }
     }
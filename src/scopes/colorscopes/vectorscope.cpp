@@ -261,7 +261,14 @@ QImage Vectorscope::renderHUD(uint)
     return hud;
 }
 
-QImage Vectorscope::renderGfxScope(uint accelerationFactor, const QImage &qimage)
+FrameStatistics::Request Vectorscope::statisticsRequest() const
+{
+    FrameStatistics::Request request;
+    request.scopes = FrameStatistics::Vectorscope;
+    return request;
+}
+
+QImage Vectorscope::renderGfxScope(uint accelerationFactor, const FrameStatistics &stats)
 {
     QTime start = QTime::currentTime();
     QImage scope;
@@ -273,8 +280,7 @@ QImage Vectorscope::renderGfxScope(uint accelerationFactor, const QImage &qimage
         VectorscopeGenerator::ColorSpace colorSpace =
             m_aColorSpace_YPbPr->isChecked() ? VectorscopeGenerator::ColorSpace_YPbPr : VectorscopeGenerator::ColorSpace_YUV;
         VectorscopeGenerator::PaintMode paintMode = (VectorscopeGenerator::PaintMode)m_ui->paintMode->itemData(m_ui->paintMode->currentIndex()).toInt();
-        scope = m_vectorscopeGenerator->calculateVectorscope(m_scopeRect.size(), qimage, m_gain, paintMode, colorSpace, m_aAxisEnabled->isChecked(),
-                                                             accelerationFactor);
+        scope = m_vectorscopeGenerator->calculateVectorscope(m_scopeRect.size(), stats, m_gain, paintMode, colorSpace, m_aAxisEnabled->isChecked());
     }
 
     unsigned int mseconds = (uint)start.msecsTo(QTime::currentTime());
@@ -35,12 +35,13 @@ public:
     ~Vectorscope() override;
 
     QString widgetName() const override;
+    FrameStatistics::Request statisticsRequest() const override;
 
 protected:
     ///// Implemented methods /////
     QRect scopeRect() override;
     QImage renderHUD(uint accelerationFactor) override;
-    QImage renderGfxScope(uint accelerationFactor, const QImage &) override;
+    QImage renderGfxScope(uint accelerationFactor, const FrameStatistics &stats) override;
     QImage renderBackground(uint accelerationFactor) override;
     bool isHUDDependingOnInput() const override;
     bool isScopeDependingOnInput() const override;
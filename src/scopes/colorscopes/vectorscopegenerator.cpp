@@ -64,6 +64,7 @@ mRgb2YPbPr =                        r =
  */
 
 #include "vectorscopegenerator.h"
+#include "framestatistics.h"
 #include <QImage>
 #include <cmath>
 
@@ -108,11 +109,10 @@ QPoint VectorscopeGenerator::mapToCircle(const QSize &targetSize, const QPointF
     return {int((targetSize.width() - 1) * (point.x() + 1) / 2), int((targetSize.height() - 1) * (1 - (point.y() + 1) / 2))};
 }
 
-QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize, const QImage &image, const float &gain,
-                                                  const VectorscopeGenerator::PaintMode &paintMode, const VectorscopeGenerator::ColorSpace &colorSpace, bool,
-                                                  uint accelFactor) const
+QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize, const FrameStatistics &stats, const float &gain,
+                                                  const VectorscopeGenerator::PaintMode &paintMode, const VectorscopeGenerator::ColorSpace &colorSpace, bool) const
 {
-    if (vectorscopeSize.width() <= 0 || vectorscopeSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (vectorscopeSize.width() <= 0 || vectorscopeSize.height() <= 0 || stats.isEmpty() || (stats.request().scopes & FrameStatistics::Vectorscope) == 0) {
         // Invalid size
         return QImage();
     }
@@ -122,47 +122,44 @@ QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize,
     QImage scope = QImage(cw, cw, QImage::Format_ARGB32);
     scope.fill(qRgba(0, 0, 0, 0));
 
-    const uchar *bits = image.bits();
-
     double dy, dr, dg, db, dmax;
     double /*y,*/ u, v;
     QPoint pt;
-    QRgb px;
-
-    const int stepsize = int(uint(image.depth() / 8) * accelFactor);
-
-    // Just an average for the number of image pixels per scope pixel.
-    // NOTE: byteCount() has to be replaced by (img.bytesPerLine()*img.height()) for Qt 4.5 to compile, see:
-    // http://doc.trolltech.org/4.6/qimage.html#bytesPerLine
-    double avgPxPerPx = (double)image.depth() / 8 * (image.bytesPerLine() * image.height()) / scope.size().width() / scope.size().height() / accelFactor;
 
-    for (int i = 0; i < (image.bytesPerLine() * image.height()); i += stepsize) {
-        auto *col = (const QRgb *)(bits);
-
-        int r = qRed(*col);
-        int g = qGreen(*col);
-        int b = qBlue(*col);
-
-        switch (colorSpace) {
-        case VectorscopeGenerator::ColorSpace_YUV:
-            //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
-            u = (double)-0.0005781 * r - 0.001135 * g + 0.001713 * b;
-            v = (double)0.002411 * r - 0.002019 * g - 0.0003921 * b;
-            break;
-        case VectorscopeGenerator::ColorSpace_YPbPr:
-        default:
-            //             y = (double)  0.001173 * r +0.002302 * g +0.0004471* b;
-            u = (double)-0.0006671 * r - 0.001299 * g + 0.0019608 * b;
-            v = (double)0.001961 * r - 0.001642 * g - 0.0003189 * b;
-            break;
-        }
-
-        pt = mapToCircle(vectorscopeSize, QPointF(SCALING * gain * u, SCALING * gain * v));
+    // Just an average for the number of image pixels per scope pixel,
+    // scaled like it used to be for 4 bytes per pixel images.
+    double avgPxPerPx = 16. * stats.pixelCount() / scope.size().width() / scope.size().height();
+
+    // Pixels with the same chroma are drawn at the same place, so the vectorscope
+    // only needs the chroma distribution of the frame.
+    for (int cr = 0; cr < 256; ++cr) {
+        for (int cb = 0; cb < 256; ++cb) {
+            const uint32_t count = stats.chromaCount(cb, cr);
+            if (count == 0) {
+                continue;
+            }
+            // Cb/Cr are digital YPbPr values
+            const double pb = (cb - 128) / 224.;
+            const double pr = (cr - 128) / 224.;
+
+            switch (colorSpace) {
+            case VectorscopeGenerator::ColorSpace_YUV:
+                u = 0.8736 * pb;
+                v = 1.2295 * pr;
+                break;
+            case VectorscopeGenerator::ColorSpace_YPbPr:
+            default:
+                u = pb;
+                v = pr;
+                break;
+            }
 
-        if (pt.x() >= scope.width() || pt.x() < 0 || pt.y() >= scope.height() || pt.y() < 0) {
-            // Point lies outside (because of scaling), don't plot it
+            pt = mapToCircle(vectorscopeSize, QPointF(SCALING * gain * u, SCALING * gain * v));
 
-        } else {
+            if (pt.x() >= scope.width() || pt.x() < 0 || pt.y() >= scope.height() || pt.y() < 0) {
+                // Point lies outside (because of scaling), don't plot it
+                continue;
+            }
 
             // Draw the pixel using the chosen draw mode.
             switch (paintMode) {
@@ -242,27 +239,40 @@ QImage VectorscopeGenerator::calculateVectorscope(const QSize &vectorscopeSize,
                 scope.setPixel(pt, qRgba(dr, dg, db, 255));
                 break;
             case PaintMode_Original:
-                scope.setPixel(pt, *col);
+                scope.setPixel(pt, stats.chromaColor(cb, cr));
                 break;
             case PaintMode_Green:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(qRed(px) + (255 - qRed(px)) / (3 * avgPxPerPx), qGreen(px) + 20 * (255 - qGreen(px)) / (avgPxPerPx),
-                                         qBlue(px) + (255 - qBlue(px)) / (avgPxPerPx), qAlpha(px) + (255 - qAlpha(px)) / (avgPxPerPx)));
+                scope.setPixel(pt, accumulate(scope.pixel(pt), count, [avgPxPerPx](QRgb px) {
+                                   return qRgba(qRed(px) + (255 - qRed(px)) / (3 * avgPxPerPx), qGreen(px) + 20 * (255 - qGreen(px)) / (avgPxPerPx),
+                                                qBlue(px) + (255 - qBlue(px)) / (avgPxPerPx), qAlpha(px) + (255 - qAlpha(px)) / (avgPxPerPx));
+                               }));
                 break;
             case PaintMode_Green2:
-                px = scope.pixel(pt);
-                scope.setPixel(pt,
-                               qRgba(qRed(px) + ceil((255 - (float)qRed(px)) / (4 * avgPxPerPx)), 255,
-                                     qBlue(px) + ceil((255 - (float)qBlue(px)) / (avgPxPerPx)), qAlpha(px) + ceil((255 - (float)qAlpha(px)) / (avgPxPerPx))));
+                scope.setPixel(pt, accumulate(scope.pixel(pt), count, [avgPxPerPx](QRgb px) {
+                                   return qRgba(qRed(px) + ceil((255 - (float)qRed(px)) / (4 * avgPxPerPx)), 255,
+                                                qBlue(px) + ceil((255 - (float)qBlue(px)) / (avgPxPerPx)),
+                                                qAlpha(px) + ceil((255 - (float)qAlpha(px)) / (avgPxPerPx)));
+                               }));
                 break;
             case PaintMode_Black:
-                px = scope.pixel(pt);
-                scope.setPixel(pt, qRgba(0, 0, 0, qAlpha(px) + (255 - qAlpha(px)) / 20));
+                scope.setPixel(pt, accumulate(scope.pixel(pt), count, [](QRgb px) { return qRgba(0, 0, 0, qAlpha(px) + (255 - qAlpha(px)) / 20); }));
                 break;
             }
         }
-
-        bits += stepsize;
     }
     return scope;
 }
+
+// static
+QRgb VectorscopeGenerator::accumulate(QRgb px, uint32_t count, const std::function<QRgb(QRgb)> &step)
+{
+    // Equivalent to drawing count pixels one after the other, but stops when the color does not change anymore
+    for (uint32_t i = 0; i < count; ++i) {
+        const QRgb next = step(px);
+        if (next == px) {
+            break;
+        }
+        px = next;
+    }
+    return px;
+}
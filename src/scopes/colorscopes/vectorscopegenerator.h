@@ -13,7 +13,10 @@
 
 #include <QImage>
 #include <QObject>
+#include <cstdint>
+#include <functional>
 
+class FrameStatistics;
 class QImage;
 class QPoint;
 class QPointF;
@@ -27,12 +30,18 @@ public:
     enum ColorSpace { ColorSpace_YUV, ColorSpace_YPbPr };
     enum PaintMode { PaintMode_Green, PaintMode_Green2, PaintMode_Original, PaintMode_Chroma, PaintMode_YUV, PaintMode_Black };
 
-    QImage calculateVectorscope(const QSize &vectorscopeSize, const QImage &image, const float &gain, const VectorscopeGenerator::PaintMode &paintMode,
-                                const VectorscopeGenerator::ColorSpace &colorSpace, bool, uint accelFactor = 1) const;
+    /** Draws the chroma distribution of the frame. Chroma is read from the statistics in Cb/Cr form,
+        and converted to the selected color space. */
+    QImage calculateVectorscope(const QSize &vectorscopeSize, const FrameStatistics &stats, const float &gain, const VectorscopeGenerator::PaintMode &paintMode,
+                                const VectorscopeGenerator::ColorSpace &colorSpace, bool) const;
 
     QPoint mapToCircle(const QSize &targetSize, const QPointF &point) const;
     static const float scaling;
 
+private:
+    /** Applies step count times to the color of a scope pixel */
+    static QRgb accumulate(QRgb px, uint32_t count, const std::function<QRgb(QRgb)> &step);
+
 signals:
     void signalCalculationFinished(const QImage &image, uint ms);
 };
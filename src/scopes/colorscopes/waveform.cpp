@@ -47,8 +47,8 @@ Waveform::Waveform(QWidget *parent)
 
     connect(m_ui->paintMode, SIGNAL(currentIndexChanged(int)), this, SLOT(forceUpdateScope()));
     connect(this, &Waveform::signalMousePositionChanged, this, &Waveform::forceUpdateHUD);
-    connect(m_aRec601, &QAction::toggled, this, &Waveform::forceUpdateScope);
-    connect(m_aRec709, &QAction::toggled, this, &Waveform::forceUpdateScope);
+    // The luma is computed when the frame is analysed
+    connect(m_aRec601, &QAction::toggled, this, &Waveform::slotStatisticsRequestChanged);
 
     init();
     m_waveformGenerator = new WaveformGenerator();
@@ -174,15 +174,22 @@ QImage Waveform::renderHUD(uint)
     return hud;
 }
 
-QImage Waveform::renderGfxScope(uint accelFactor, const QImage &qimage)
+FrameStatistics::Request Waveform::statisticsRequest() const
+{
+    FrameStatistics::Request request;
+    request.scopes = FrameStatistics::Waveform;
+    request.waveformRec = m_aRec601->isChecked() ? FrameStatistics::Rec_601 : FrameStatistics::Rec_709;
+    return request;
+}
+
+QImage Waveform::renderGfxScope(uint, const FrameStatistics &stats)
 {
     QTime start = QTime::currentTime();
     start.start();
 
     const int paintmode = m_ui->paintMode->itemData(m_ui->paintMode->currentIndex()).toInt();
-    WaveformGenerator::Rec rec = m_aRec601->isChecked() ? WaveformGenerator::Rec_601 : WaveformGenerator::Rec_709;
-    QImage wave = m_waveformGenerator->calculateWaveform(scopeRect().size() - m_textWidth - QSize(0, m_paddingBottom), qimage,
-                                                         (WaveformGenerator::PaintMode)paintmode, true, rec, accelFactor);
+    QImage wave = m_waveformGenerator->calculateWaveform(scopeRect().size() - m_textWidth - QSize(0, m_paddingBottom), stats,
+                                                         (WaveformGenerator::PaintMode)paintmode, true);
 
     emit signalScopeRenderingFinished((uint)start.elapsed(), 1);
     return wave;
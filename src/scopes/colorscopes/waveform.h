@@ -32,6 +32,7 @@ public:
     ~Waveform() override;
 
     QString widgetName() const override;
+    FrameStatistics::Request statisticsRequest() const override;
 
 protected:
     void readConfig() override;
@@ -53,7 +54,7 @@ private:
     /// Implemented methods ///
     QRect scopeRect() override;
     QImage renderHUD(uint) override;
-    QImage renderGfxScope(uint, const QImage &) override;
+    QImage renderGfxScope(uint, const FrameStatistics &stats) override;
     QImage renderBackground(uint) override;
     bool isHUDDependingOnInput() const override;
     bool isScopeDependingOnInput() const override;
@@ -9,130 +9,111 @@
  ***************************************************************************/
 
 #include "waveformgenerator.h"
+#include "framestatistics.h"
 
 #include <cmath>
+#include <functional>
+#include <limits>
 
 #include <QImage>
-#include <QPainter>
 #include <QSize>
 #include <QTime>
 #include <vector>
 
-#define CHOP255(a) ((255) < (a) ? (255) : (a))
+// Clamps to [0,255], the log scale is negative for small counts
+#define CHOP(a) ((a) < 0 ? 0 : ((255) < (a) ? (255) : (int)(a)))
+
+namespace {
+// The color table covers at most this number of counts, larger counts are computed
+const size_t MaxColorTableSize = 65536;
+} // namespace
 
 WaveformGenerator::WaveformGenerator() = default;
 
 WaveformGenerator::~WaveformGenerator() = default;
 
-QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const QImage &image, WaveformGenerator::PaintMode paintMode, bool drawAxis,
-                                            WaveformGenerator::Rec rec, uint accelFactor)
+QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const FrameStatistics &stats, WaveformGenerator::PaintMode paintMode, bool drawAxis)
 {
-    Q_ASSERT(accelFactor >= 1);
-
     // QTime time;
     // time.start();
 
     QImage wave(waveformSize, QImage::Format_ARGB32);
 
-    if (waveformSize.width() <= 0 || waveformSize.height() <= 0 || image.width() <= 0 || image.height() <= 0) {
+    if (waveformSize.width() <= 0 || waveformSize.height() <= 0 || stats.isEmpty() || (stats.request().scopes & FrameStatistics::Waveform) == 0) {
         return QImage();
     }
 
-    // Fill with transparent color
-    wave.fill(qRgba(0, 0, 0, 0));
-
     const uint ww = (uint)waveformSize.width();
     const uint wh = (uint)waveformSize.height();
-    const uint iw = (uint)image.bytesPerLine();
-    const uint ih = (uint)image.height();
-    const uint byteCount = iw * ih;
+    const int columns = stats.columns();
 
-    std::vector<std::vector<uint>> waveValues((size_t)waveformSize.width(), std::vector<uint>((size_t)waveformSize.height(), 0));
+    // Counts of the scope pixels, row by row from the top of the scope
+    std::vector<uint> waveValues((size_t)ww * wh, 0);
 
     // Number of input pixels that will fall on one scope pixel.
-    // Must be a float because the acceleration factor can be high, leading to <1 expected px per px.
-    const float pixelDepth = (float)((byteCount >> 2) / accelFactor) / float(ww * wh);
+    const float pixelDepth = (float)stats.pixelCount() / float(ww * wh);
     const float gain = 255. / (8. * pixelDepth);
-    // qCDebug(KDENLIVE_LOG) << "Pixel depth: expected " << pixelDepth << "; Gain: using " << gain << " (acceleration: " << accelFactor << "x)";
+    // qCDebug(KDENLIVE_LOG) << "Pixel depth: expected " << pixelDepth << "; Gain: using " << gain;
 
     // Subtract 1 from sizes because we start counting from 0.
     // Not doing it would result in attempts to paint outside of the image.
     const float hPrediv = (float)(wh - 1) / 255.;
-    const float wPrediv = (float)(ww - 1) / float(iw - 1);
-
-    const uchar *bits = image.bits();
-    const int bpp = image.depth() / 8;
-
-    for (uint i = 0, x = 0; i < byteCount; i += (uint)bpp) {
-
-        Q_ASSERT(bits < image.bits() + byteCount);
-
-        double dY, dx, dy;
-        auto *col = (const QRgb *)bits;
-
-        if (rec == WaveformGenerator::Rec_601) {
-            // CIE 601 Luminance
-            dY = .299 * qRed(*col) + .587 * qGreen(*col) + .114 * qBlue(*col);
-        } else {
-            // CIE 709 Luminance
-            dY = .2125 * qRed(*col) + .7154 * qGreen(*col) + .0721 * qBlue(*col);
-        }
-        // dY is on [0,255] now.
-
-        dy = dY * hPrediv;
-        dx = (float)x * wPrediv;
-        waveValues[(size_t)dx][(size_t)dy]++;
-
-        bits += bpp;
-        x += (uint)bpp;
-        if (x > iw) {
-            x -= iw;
-            if (accelFactor > 1) {
-                bits += bpp * (int)iw * ((int)accelFactor - 1);
-                i += (uint)bpp * iw * (accelFactor - 1);
+    const float wPrediv = columns > 1 ? (float)(ww - 1) / float(columns - 1) : 0;
+
+    for (int x = 0; x < columns; ++x) {
+        uint *column = waveValues.data() + (size_t)(x * wPrediv);
+        const uint32_t *lumaValues = stats.waveformColumn(x);
+        for (int dY = 0; dY < 256; ++dY) {
+            if (lumaValues[dY] > 0) {
+                column[(size_t)(wh - 1 - (uint)(dY * hPrediv)) * ww] += lumaValues[dY];
             }
         }
     }
 
+    std::function<QRgb(uint)> toneMap;
     switch (paintMode) {
     case PaintMode_Green:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                // Logarithmic scale. Needs fine tuning by hand, but looks great.
-                wave.setPixel(i, waveformSize.height() - j - 1,
-                              qRgba(CHOP255(52 * log(0.1 * gain * (float)waveValues[(size_t)i][(size_t)j])),
-                                    CHOP255(52 * std::log(gain * (float)waveValues[(size_t)i][(size_t)j])),
-                                    CHOP255(52 * log(.25 * gain * (float)waveValues[(size_t)i][(size_t)j])),
-                                    CHOP255(64 * std::log(gain * (float)waveValues[(size_t)i][(size_t)j]))));
-            }
-        }
+        toneMap = [gain](uint count) {
+            // Logarithmic scale. Needs fine tuning by hand, but looks great.
+            const float value = gain * (float)count;
+            return qRgba(CHOP(52 * std::log(0.1 * value)), CHOP(52 * std::log(value)), CHOP(52 * std::log(.25 * value)), CHOP(64 * std::log(value)));
+        };
         break;
     case PaintMode_Yellow:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                wave.setPixel(i, waveformSize.height() - j - 1, qRgba(255, 242, 0, CHOP255(gain * (float)waveValues[(size_t)i][(size_t)j])));
-            }
-        }
+        toneMap = [gain](uint count) { return qRgba(255, 242, 0, CHOP(gain * (float)count)); };
         break;
     default:
-        for (int i = 0; i < waveformSize.width(); ++i) {
-            for (int j = 0; j < waveformSize.height(); ++j) {
-                wave.setPixel(i, waveformSize.height() - j - 1, qRgba(255, 255, 255, CHOP255(2. * gain * (float)waveValues[(size_t)i][(size_t)j])));
-            }
-        }
+        toneMap = [gain](uint count) { return qRgba(255, 255, 255, CHOP(2. * gain * (float)count)); };
         break;
     }
 
+    // Colors of the counts, up to the count where the color saturates
+    const QRgb saturated = toneMap(std::numeric_limits<uint>::max());
+    std::vector<QRgb> colors;
+    while (colors.size() < MaxColorTableSize) {
+        colors.push_back(toneMap((uint)colors.size()));
+        if (colors.back() == saturated) {
+            break;
+        }
+    }
+    const uint tableSize = (uint)colors.size();
+    const bool tableSaturates = colors.back() == saturated;
+
+    for (uint y = 0; y < wh; ++y) {
+        auto *line = (QRgb *)wave.scanLine((int)y);
+        const uint *values = waveValues.data() + (size_t)y * ww;
+        for (uint x = 0; x < ww; ++x) {
+            const uint count = values[x];
+            line[x] = count < tableSize ? colors[count] : (tableSaturates ? saturated : toneMap(count));
+        }
+    }
+
     if (drawAxis) {
-        QPainter davinci(&wave);
-        QRgb opx;
-        davinci.setPen(qRgba(150, 255, 200, 32));
-        davinci.setCompositionMode(QPainter::CompositionMode_Overlay);
         for (int i = 0; i <= 10; ++i) {
-            float dy = (float)i / 10. * ((int)wh - 1);
-            for (int x = 0; x < (int)ww; ++x) {
-                opx = wave.pixel(x, dy);
-                wave.setPixel(x, dy, qRgba(CHOP255(150 + qRed(opx)), 255, CHOP255(200 + qBlue(opx)), CHOP255(32 + qAlpha(opx))));
+            auto *line = (QRgb *)wave.scanLine((int)((float)i / 10. * ((int)wh - 1)));
+            for (uint x = 0; x < ww; ++x) {
+                const QRgb opx = line[x];
+                line[x] = qRgba(CHOP(150 + qRed(opx)), 255, CHOP(200 + qBlue(opx)), CHOP(32 + qAlpha(opx)));
             }
         }
     }
@@ -142,4 +123,4 @@ QImage WaveformGenerator::calculateWaveform(const QSize &waveformSize, const QIm
 
     return wave;
 }
-#undef CHOP255
+#undef CHOP
@@ -12,6 +12,7 @@
 #define WAVEFORMGENERATOR_H
 
 #include <QObject>
+class FrameStatistics;
 class QImage;
 class QSize;
 
@@ -21,13 +22,13 @@ class WaveformGenerator : public QObject
 
 public:
     enum PaintMode { PaintMode_Green, PaintMode_Yellow, PaintMode_White };
-    enum Rec { Rec_601, Rec_709 };
 
     WaveformGenerator();
     ~WaveformGenerator() override;
 
-    QImage calculateWaveform(const QSize &waveformSize, const QImage &image, WaveformGenerator::PaintMode paintMode, bool drawAxis,
-                             const WaveformGenerator::Rec rec, uint accelFactor = 1);
+    /** Paints the luma distribution of each column of the frame.
+        The luma recommendation is the one requested when the statistics were collected. */
+    QImage calculateWaveform(const QSize &waveformSize, const FrameStatistics &stats, WaveformGenerator::PaintMode paintMode, bool drawAxis);
 };
 
 #endif // WAVEFORMGENERATOR_H
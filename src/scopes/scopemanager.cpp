@@ -21,9 +21,12 @@
 #include "kdenlivesettings.h"
 #include "mainwindow.h"
 #include "monitor/monitormanager.h"
+#include "monitor/scopes/sharedframe.h"
+#include "profiles/profilemodel.hpp"
 
 #include "klocalizedstring.h"
 #include <QDockWidget>
+#include <QtConcurrent>
 
 //#define DEBUG_SM
 #ifdef DEBUG_SM
@@ -40,6 +43,7 @@ ScopeManager::ScopeManager(QObject *parent)
     connect(pCore->monitorManager(), &MonitorManager::clearScopes, this, &ScopeManager::slotClearColorScopes);
     connect(pCore->monitorManager(), &MonitorManager::checkScopes, this, &ScopeManager::slotCheckActiveScopes);
     connect(m_signalMapper, SIGNAL(mapped(QString)), SLOT(slotRequestFrame(QString)));
+    connect(&m_analysisWatcher, &QFutureWatcherBase::finished, this, &ScopeManager::slotDistributeStatistics);
 
     slotUpdateActiveRenderer();
 
@@ -130,15 +134,62 @@ void ScopeManager::slotDistributeAudio(const audioShortVector &sampleData, int f
         }
     }
 }
+bool ScopeManager::acceptsFrame(const GfxScopeData &colorScope) const
+{
+    return !colorScope.scope->visibleRegion().isEmpty() && (colorScope.scope->autoRefreshEnabled() || colorScope.singleFrameRequested);
+}
+
+FrameStatistics::Request ScopeManager::statisticsRequest() const
+{
+    FrameStatistics::Request request;
+    for (const auto &m_colorScope : m_colorScopes) {
+        if (acceptsFrame(m_colorScope)) {
+            request.merge(m_colorScope.scope->statisticsRequest());
+        }
+    }
+    return request;
+}
+
+void ScopeManager::analyseFrame(const std::function<std::shared_ptr<const FrameStatistics>(const FrameStatistics::Request &)> &analyse)
+{
+    const FrameStatistics::Request request = statisticsRequest();
+    if (request.scopes == 0 || m_analysisWatcher.isRunning()) {
+        // Nobody needs this frame, or we are still busy with the previous one
+        slotScopeReady();
+        return;
+    }
+#ifdef DEBUG_SM
+    qCDebug(KDENLIVE_LOG) << "ScopeManager: Starting frame analysis.";
+#endif
+    m_analysisWatcher.setFuture(QtConcurrent::run([analyse, request]() { return analyse(request); }));
+}
+
 void ScopeManager::slotDistributeFrame(const QImage &image)
+{
+    analyseFrame([image](const FrameStatistics::Request &request) { return FrameStatistics::fromImage(image, request); });
+}
+
+void ScopeManager::slotDistributeSharedFrame(const SharedFrame &frame)
+{
+    // Use the same conversion as the monitor
+    const FrameStatistics::Rec matrix = pCore->getCurrentProfile()->colorspace() == 601 ? FrameStatistics::Rec_601 : FrameStatistics::Rec_709;
+    analyseFrame([frame, matrix](const FrameStatistics::Request &request) {
+        return FrameStatistics::fromYuv420p(frame.get_image(), frame.get_image_width(), frame.get_image_height(), matrix, request);
+    });
+}
+
+void ScopeManager::slotDistributeStatistics()
 {
 #ifdef DEBUG_SM
     qCDebug(KDENLIVE_LOG) << "ScopeManager: Starting to distribute frame.";
 #endif
+    std::shared_ptr<const FrameStatistics> stats = m_analysisWatcher.result();
+    bool distributed = false;
     for (auto &m_colorScope : m_colorScopes) {
         if (!m_colorScope.scope->visibleRegion().isEmpty()) {
             if (m_colorScope.scope->autoRefreshEnabled()) {
-                m_colorScope.scope->slotRenderZoneUpdated(image);
+                m_colorScope.scope->slotRenderZoneUpdated(stats);
+                distributed = true;
 #ifdef DEBUG_SM
                 qCDebug(KDENLIVE_LOG) << "ScopeManager: Distributed frame to " << m_colorScopes[i].scope->widgetName();
 #endif
@@ -146,14 +197,19 @@ void ScopeManager::slotDistributeFrame(const QImage &image)
                 // Special case: Auto refresh is disabled, but user requested an update (e.g. by clicking).
                 // Force the scope to update.
                 m_colorScope.singleFrameRequested = false;
-                m_colorScope.scope->slotRenderZoneUpdated(image);
+                m_colorScope.scope->slotRenderZoneUpdated(stats);
                 m_colorScope.scope->forceUpdateScope();
+                distributed = true;
 #ifdef DEBUG_SM
                 qCDebug(KDENLIVE_LOG) << "ScopeManager: Distributed forced frame to " << m_colorScopes[i].scope->widgetName();
 #endif
             }
         }
     }
+    if (!distributed) {
+        // No scope will tell us it is ready
+        slotScopeReady();
+    }
     // checkActiveColourScopes();
 }
 
@@ -215,6 +271,7 @@ void ScopeManager::slotUpdateActiveRenderer()
     // Connect new renderer
     if (m_lastConnectedRenderer != nullptr) {
         connect(m_lastConnectedRenderer, &Monitor::frameUpdated, this, &ScopeManager::slotDistributeFrame, Qt::UniqueConnection);
+        connect(m_lastConnectedRenderer, &Monitor::sharedFrameUpdated, this, &ScopeManager::slotDistributeSharedFrame, Qt::UniqueConnection);
         connect(m_lastConnectedRenderer, &Monitor::audioSamplesSignal, this, &ScopeManager::slotDistributeAudio, Qt::UniqueConnection);
 
 #ifdef DEBUG_SM
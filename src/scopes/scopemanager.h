@@ -13,11 +13,16 @@
 
 #include "audioscopes/abstractaudioscopewidget.h"
 #include "colorscopes/abstractgfxscopewidget.h"
+#include "colorscopes/framestatistics.h"
 
+#include <QFutureWatcher>
 #include <QList>
+#include <functional>
+#include <memory>
 
 class QDockWidget;
 class AbstractMonitor;
+class SharedFrame;
 
 /**
   \brief Manages communication between Scopes and Renderer
@@ -26,6 +31,9 @@ class AbstractMonitor;
   all scopes that have been registered via ScopeManager::addScope(AbstractAudioScopeWidget, QDockWidget)
   or ScopeManager::addScope(AbstractGfxScopeWidget, QDockWidget). It checks whether the renderer really
   needs to send data (it does not, for example, if no scopes are visible).
+
+  Frames are analysed once for all the color scopes, in a worker thread: the statistics
+  requested by the active scopes are collected in a single pass, then sent to the scopes.
   */
 class ScopeManager : public QObject
 {
@@ -75,6 +83,9 @@ private:
 
     QSignalMapper *m_signalMapper;
 
+    /** Analysis of the last frame, running in a worker thread */
+    QFutureWatcher<std::shared_ptr<const FrameStatistics>> m_analysisWatcher;
+
     /**
       Checks whether there is any scope accepting audio data, or if all of them are hidden
       or if auto refresh is disabled.
@@ -86,6 +97,18 @@ private:
       */
     bool imagesAcceptedByScopes() const;
 
+    /** @brief Returns true if the color scope will be sent the next frame */
+    bool acceptsFrame(const GfxScopeData &colorScope) const;
+    /**
+      Merges the statistics requests of all scopes that will receive the next frame.
+      */
+    FrameStatistics::Request statisticsRequest() const;
+    /**
+      Starts the analysis of a frame in a worker thread. The frame is dropped if the previous one is still being analysed.
+      @param analyse computes the statistics of the frame for the given request
+      */
+    void analyseFrame(const std::function<std::shared_ptr<const FrameStatistics>(const FrameStatistics::Request &)> &analyse);
+
     /**
       Creates all the scopes in audioscopes/ and colorscopes/.
       New scopes are not detected automatically but have to be added.
@@ -127,7 +150,12 @@ private slots:
       */
     void checkActiveColourScopes();
 
+    /** @brief Analyses an RGB image of the frame, used when the native frame is not available (GPU rendering) */
     void slotDistributeFrame(const QImage &image);
+    /** @brief Analyses a yuv420p frame */
+    void slotDistributeSharedFrame(const SharedFrame &frame);
+    /** @brief Sends the statistics of the last analysed frame to the scopes */
+    void slotDistributeStatistics();
     void slotDistributeAudio(const audioShortVector &sampleData, int freq, int num_channels, int num_samples);
     /**
       Allows a scope to explicitly request a new frame, even if the scope's autoRefresh is disabled.
@@ -28,6 +28,7 @@
 #include "timelinemodel.hpp"
 #include "trackmodel.hpp"
 #include <QDebug>
+#include <QFileInfo>
 #include <effects/effectsrepository.hpp>
 #include <mlt++/MltProducer.h>
 #include <utility>
@@ -56,6 +57,9 @@ ClipModel::ClipModel(const std::shared_ptr<TimelineModel> &parent, std::shared_p
     }
     QObject::connect(m_effectStack.get(), &EffectStackModel::dataChanged, [&](const QModelIndex &, const QModelIndex &, QVector<int> roles) {
         qDebug() << "// GOT CLIP STACK DATA CHANGE: " << roles;
+        if (affectsViewState(roles)) {
+            invalidateViewState();
+        }
         if (m_currentTrackId != -1) {
             if (auto ptr = m_parent.lock()) {
                 QModelIndex ix = ptr->makeClipIndexFromID(m_id);
@@ -387,6 +391,7 @@ void ClipModel::refreshProducerFromBin(PlaylistState::ClipState state, double sp
     m_producer->set("kdenlive:id", binClip->clipId().toUtf8().constData());
     m_producer->set("_kdenlive_cid", m_id);
     m_endlessResize = !binClip->hasLimitedDuration();
+    invalidateViewState();
 }
 
 void ClipModel::refreshProducerFromBin()
@@ -609,6 +614,73 @@ const QString ClipModel::effectNames() const
     return m_effectStack->effectNames();
 }
 
+ClipModel::ViewState ClipModel::viewState() const
+{
+    int revision;
+    {
+        QMutexLocker locker(&m_viewStateMutex);
+        if (m_viewStateValid) {
+            return m_viewState;
+        }
+        revision = m_viewStateRevision;
+    }
+    // The values are computed without holding the cache mutex, since this requires the clip lock
+    ViewState state;
+    state.service = getProperty(QStringLiteral("mlt_service"));
+    state.resource = getProperty(QStringLiteral("resource"));
+    state.name = getProperty(QStringLiteral("kdenlive:clipname"));
+    if (state.name.isEmpty()) {
+        state.name = getProperty(QStringLiteral("kdenlive:originalurl"));
+        if (state.name.isEmpty()) {
+            state.name = state.resource;
+        }
+        if (!state.name.isEmpty()) {
+            state.name = QFileInfo(state.name).fileName();
+        } else {
+            state.name = state.service;
+        }
+    }
+    if (state.resource == QLatin1String("<producer>")) {
+        state.resource = state.service;
+    }
+    state.effectNames = effectNames();
+    QMutexLocker locker(&m_viewStateMutex);
+    if (revision == m_viewStateRevision) {
+        // Only store the values if the cache was not invalidated in the meantime
+        m_viewState = state;
+        m_viewStateValid = true;
+    }
+    return state;
+}
+
+void ClipModel::invalidateViewState()
+{
+    QMutexLocker locker(&m_viewStateMutex);
+    m_viewStateValid = false;
+    m_viewStateRevision++;
+}
+
+// static
+bool ClipModel::affectsViewState(const QVector<int> &roles)
+{
+    if (roles.isEmpty()) {
+        return true;
+    }
+    for (int role : roles) {
+        switch (role) {
+        case Qt::DisplayRole:
+        case TimelineModel::NameRole:
+        case TimelineModel::ResourceRole:
+        case TimelineModel::ServiceRole:
+        case TimelineModel::EffectNamesRole:
+            return true;
+        default:
+            break;
+        }
+    }
+    return false;
+}
+
 int ClipModel::getFakeTrackId() const
 {
     return m_fakeTrack;
@@ -24,7 +24,9 @@
 
 #include "moveableItem.hpp"
 #include "undohelper.hpp"
+#include <QMutex>
 #include <QObject>
+#include <QVector>
 #include <memory>
 
 namespace Mlt {
@@ -137,6 +139,21 @@ public:
     int fadeIn() const;
     int fadeOut() const;
 
+    /** @brief Display values of the clip shown by the timeline view */
+    struct ViewState
+    {
+        QString name;
+        QString resource;
+        QString service;
+        QString effectNames;
+    };
+    /** @brief Returns the display values of the clip. They are computed on first access and cached until invalidateViewState() is called */
+    ViewState viewState() const;
+    /** @brief Drops the cached display values. Must be called when the name, resource, service or effects of the clip change */
+    void invalidateViewState();
+    /** @brief Returns true if a change of the given timeline roles requires to invalidate the view state (an empty list means all roles) */
+    static bool affectsViewState(const QVector<int> &roles);
+
     /**@brief Tracks have two sub playlists to enable same track transitions. This returns the index of the sub-playlist containing this clip */
     int getSubPlaylistIndex() const;
     void setSubPlaylistIndex(int index);
@@ -218,6 +235,12 @@ protected:
     int m_fakePosition;
 
     int m_subPlaylistIndex; // Tracks have two sub playlists to enable same track transitions, we store in which one this clip is.
+
+    // Cached display values, see viewState()
+    mutable QMutex m_viewStateMutex;
+    mutable ViewState m_viewState;
+    mutable bool m_viewStateValid{false};
+    int m_viewStateRevision{0};
 };
 
 #endif
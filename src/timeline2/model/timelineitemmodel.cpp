@@ -33,7 +33,6 @@
 #include "trackmodel.hpp"
 #include "transitions/transitionsrepository.hpp"
 #include <QDebug>
-#include <QFileInfo>
 #include <mlt++/MltField.h>
 #include <mlt++/MltProfile.h>
 #include <mlt++/MltTractor.h>
@@ -256,28 +255,10 @@ QVariant TimelineItemModel::data(const QModelIndex &index, int role) const
         switch (role) {
         // TODO
         case NameRole:
-        case Qt::DisplayRole: {
-            QString result = clip->getProperty("kdenlive:clipname");
-            if (result.isEmpty()) {
-                result = clip->getProperty("kdenlive:originalurl");
-                if (result.isEmpty()) {
-                    result = clip->getProperty("resource");
-                }
-                if (!result.isEmpty()) {
-                    result = QFileInfo(result).fileName();
-                } else {
-                    result = clip->getProperty("mlt_service");
-                }
-            }
-            return result;
-        }
-        case ResourceRole: {
-            QString result = clip->getProperty("resource");
-            if (result == QLatin1String("<producer>")) {
-                result = clip->getProperty("mlt_service");
-            }
-            return result;
-        }
+        case Qt::DisplayRole:
+            return clip->viewState().name;
+        case ResourceRole:
+            return clip->viewState().resource;
         case FakeTrackIdRole:
             return clip->getFakeTrackId();
         case FakePositionRole:
@@ -287,8 +268,7 @@ QVariant TimelineItemModel::data(const QModelIndex &index, int role) const
         case TrackIdRole:
             return clip->getCurrentTrackId();
         case ServiceRole:
-            return clip->getProperty("mlt_service");
-            break;
+            return clip->viewState().service;
         case AudioLevelsRole:
             // Dumb property to trigger audio thumbs reload
             return true;
@@ -319,7 +299,7 @@ QVariant TimelineItemModel::data(const QModelIndex &index, int role) const
         case GroupedRole:
             return m_groups->isInGroup(id);
         case EffectNamesRole:
-            return clip->effectNames();
+            return clip->viewState().effectNames;
         case InPointRole:
             return clip->getIn();
         case OutPointRole:
@@ -533,9 +513,23 @@ void TimelineItemModel::notifyChange(const QModelIndex &topleft, const QModelInd
 
 void TimelineItemModel::notifyChange(const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles)
 {
+    invalidateViewState(topleft, bottomright, roles);
     emit dataChanged(topleft, bottomright, roles);
 }
 
+void TimelineItemModel::invalidateViewState(const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles)
+{
+    if (!topleft.isValid() || !ClipModel::affectsViewState(roles)) {
+        return;
+    }
+    for (int row = topleft.row(); row <= bottomright.row(); ++row) {
+        const int id = (int)topleft.sibling(row, 0).internalId();
+        if (isClip(id)) {
+            m_allClips.at(id)->invalidateViewState();
+        }
+    }
+}
+
 void TimelineItemModel::buildTrackCompositing(bool rebuild)
 {
     auto it = m_allTracks.cbegin();
@@ -585,6 +579,7 @@ void TimelineItemModel::buildTrackCompositing(bool rebuild)
 
 void TimelineItemModel::notifyChange(const QModelIndex &topleft, const QModelIndex &bottomright, int role)
 {
+    invalidateViewState(topleft, bottomright, {role});
     emit dataChanged(topleft, bottomright, {role});
 }
 
@@ -107,6 +107,8 @@ public:
     void _resetView() override;
 
 protected:
+    /** @brief Drops the cached display values of the clips in the given range if the changed roles affect them */
+    void invalidateViewState(const QModelIndex &topleft, const QModelIndex &bottomright, const QVector<int> &roles);
     // This is an helper function that finishes a construction of a freshly created TimelineItemModel
     static void finishConstruct(const std::shared_ptr<TimelineItemModel> &ptr, const std::shared_ptr<MarkerListModel> &guideModel);
 };
@@ -299,9 +299,16 @@ int TimelineModel::getTrackPosition(int trackId) const
 {
     READ_LOCK();
     Q_ASSERT(isTrack(trackId));
-    auto it = m_allTracks.begin();
-    int pos = (int)std::distance(it, (decltype(it))m_iteratorTable.at(trackId));
-    return pos;
+    return m_trackPositions.at(trackId);
+}
+
+void TimelineModel::updateTrackPositions(int from)
+{
+    auto it = m_allTracks.cbegin();
+    std::advance(it, from);
+    for (int pos = from; it != m_allTracks.cend(); ++it, ++pos) {
+        m_trackPositions[(*it)->getId()] = pos;
+    }
 }
 
 int TimelineModel::getTrackMltIndex(int trackId) const
@@ -1365,6 +1372,50 @@ bool TimelineModel::requestGroupMove(int itemId, int groupId, int delta_track, i
         };
     }
 
+    if (delta_track == 0) {
+        // Horizontal move: compute the final layout of each affected track and rewrite its playlist once, instead of removing and reinserting each clip
+        std::unordered_map<int, std::unordered_map<int, int>> track_moves;
+        bool batched = true;
+        for (int item : sorted_clips) {
+            if (isClip(item)) {
+                int tid = getClipTrackId(item);
+                batched = batched && tid != -1;
+                track_moves[tid][item] = m_allClips[item]->getPosition() + delta_pos;
+            }
+        }
+        for (const auto &moves : track_moves) {
+            batched = batched && getTrackById(moves.first)->requestClipsMove(moves.second, finalMove, local_undo, local_redo);
+        }
+        if (batched) {
+            // Compositions are moved from left to right
+            for (auto it = sorted_clips.rbegin(); it != sorted_clips.rend(); ++it) {
+                int item = *it;
+                if (isComposition(item)) {
+                    auto compo = m_allCompositions[item];
+                    ok = ok && requestCompositionMove(item, compo->getCurrentTrackId(), compo->getForcedTrack(), compo->getPosition() + delta_pos,
+                                                      allowViewRefresh, finalMove, local_undo, local_redo);
+                }
+                if (!ok) {
+                    bool undone = local_undo();
+                    Q_ASSERT(undone);
+                    return false;
+                }
+            }
+            if (updatePositionOnly) {
+                update_model();
+                PUSH_LAMBDA(update_model, local_redo);
+                PUSH_LAMBDA(update_model, local_undo);
+            }
+            UPDATE_UNDO_REDO(local_redo, local_undo, undo, redo);
+            return true;
+        }
+        // Some clips cannot be moved in a batch (for example clips in a same track transition), fallback to the clip by clip method
+        bool undone = local_undo();
+        Q_ASSERT(undone);
+        local_undo = []() { return true; };
+        local_redo = []() { return true; };
+    }
+
     // First, remove clips
     std::unordered_map<int, int> old_track_ids, old_position, old_forced_track;
     for (int item : sorted_clips) {
@@ -1881,6 +1932,7 @@ void TimelineModel::registerTrack(std::shared_ptr<TrackModel> track, int pos, bo
     // it now contains the iterator to the inserted element, we store it
     Q_ASSERT(m_iteratorTable.count(id) == 0); // check that id is not used (shouldn't happen)
     m_iteratorTable[id] = it;
+    updateTrackPositions(pos);
     if (reloadView) {
         // don't reload view on each track load on project opening
         _resetView();
@@ -1914,6 +1966,8 @@ Fun TimelineModel::deregisterTrack_lambda(int id, bool updateView)
         // send update to the model
         m_allTracks.erase(it);     // actual deletion of object
         m_iteratorTable.erase(id); // clean table
+        m_trackPositions.erase(id);
+        updateTrackPositions(index);
         if (updateView) {
             _resetView();
         }
@@ -2424,6 +2478,58 @@ bool TimelineModel::requestCompositionMove(int compoId, int trackId, int composi
 }
 
 bool TimelineModel::replantCompositions(int currentCompo, bool updateView)
+{
+    // The field must contain the compositions in a decreasing order of b_track, starting from the multitrack, with the internal track compositing above
+    // them. Instead of replanting everything, we insert the composition right above the first composition that has a higher b_track.
+    Mlt::Transition &transition = *m_allCompositions[currentCompo].get();
+    int aTrack = m_allCompositions[currentCompo]->getATrack();
+    int bTrack = getTrackMltIndex(getCompositionTrackId(currentCompo));
+    Q_ASSERT(aTrack != -1 && aTrack < m_tractor->count());
+    QScopedPointer<Mlt::Field> field(m_tractor->field());
+    field->lock();
+    // Walk down from the top of the field, the consumer stays null while we are at the top
+    mlt_service consumer = nullptr;
+    mlt_service current = field->get_service();
+    while (current != nullptr && mlt_service_identify(current) == transition_type) {
+        auto tr = (mlt_transition)current;
+        mlt_properties properties = MLT_TRANSITION_PROPERTIES(tr);
+        if (mlt_properties_get_int(properties, "internal_added") <= 0 && mlt_transition_get_b_track(tr) > bTrack) {
+            break;
+        }
+        consumer = current;
+        current = mlt_service_producer(current);
+    }
+    int ret = 0;
+    if (consumer == nullptr || current == nullptr) {
+        // Nothing above us, or we reached the end of the chain
+        ret = field->plant_transition(transition, aTrack, bTrack);
+    } else {
+        // Insert between consumer and current, the same way mlt_field_disconnect_service relinks the chain
+        ret = mlt_transition_connect(transition.get_transition(), current, aTrack, bTrack);
+        if (ret == 0) {
+            auto consumerTransition = (mlt_transition)consumer;
+            mlt_service_connect_producer(consumer, transition.get_service(), mlt_transition_get_a_track(consumerTransition));
+            consumerTransition->producer = transition.get_service();
+            field->fire_event("service-changed");
+        }
+    }
+    qDebug() << "Planting composition " << currentCompo << "in " << aTrack << "/" << bTrack << "IN = " << m_allCompositions[currentCompo]->getIn()
+             << "OUT = " << m_allCompositions[currentCompo]->getOut() << "ret=" << ret;
+    if (ret != 0) {
+        field->unlock();
+        return false;
+    }
+    transition.set_tracks(aTrack, bTrack);
+    Q_ASSERT(mlt_service_consumer(transition.get_service()) != nullptr);
+    field->unlock();
+    if (updateView) {
+        QModelIndex modelIndex = makeCompositionIndexFromID(currentCompo);
+        notifyChange(modelIndex, modelIndex, ItemATrack);
+    }
+    return true;
+}
+
+bool TimelineModel::replantAllCompositions(int currentCompo, bool updateView)
 {
     // We ensure that the compositions are planted in a decreasing order of b_track.
     // For that, there is no better option than to disconnect every composition and then reinsert everything in the correct order.
@@ -2541,6 +2647,19 @@ bool TimelineModel::checkConsistency()
             return false;
         }
     }
+    // Check the cached track positions
+    int trackPos = 0;
+    for (const auto &track : m_allTracks) {
+        if (m_trackPositions.count(track->getId()) == 0 || m_trackPositions.at(track->getId()) != trackPos) {
+            qDebug() << "Wrong cached position for track" << track->getId();
+            return false;
+        }
+        trackPos++;
+    }
+    if (m_trackPositions.size() != m_allTracks.size()) {
+        qDebug() << "Cached track positions don't match the tracks";
+        return false;
+    }
 
     // We store all in/outs of clips to check snap points
     std::map<int, int> snaps;
@@ -2681,6 +2800,10 @@ bool TimelineModel::checkConsistency()
     }
     field->unlock();
 
+    if (!checkCompositionOrder()) {
+        return false;
+    }
+
     if (!remaining_compo.empty()) {
         qDebug() << "Error: We found less compositions than expected. Compositions that have not been found:";
         for (int compoId : remaining_compo) {
@@ -2703,6 +2826,39 @@ bool TimelineModel::checkConsistency()
     return true;
 }
 
+bool TimelineModel::checkCompositionOrder()
+{
+    // From the top of the field: internal track compositing, then the compositions by increasing b_track
+    QScopedPointer<Mlt::Field> field(m_tractor->field());
+    field->lock();
+    bool foundComposition = false;
+    int lastTrack = -1;
+    bool ok = true;
+    mlt_service current = field->get_service();
+    while (ok && current != nullptr && mlt_service_identify(current) == transition_type) {
+        auto tr = (mlt_transition)current;
+        mlt_properties properties = MLT_TRANSITION_PROPERTIES(tr);
+        if (mlt_properties_get_int(properties, "internal_added") > 0) {
+            QString service(mlt_properties_get(properties, "mlt_service"));
+            if (foundComposition && service != QLatin1String("mix")) {
+                qDebug() << "Track compositing found below a composition on track" << mlt_transition_get_b_track(tr);
+                ok = false;
+            }
+        } else {
+            int bTrack = mlt_transition_get_b_track(tr);
+            if (bTrack < lastTrack) {
+                qDebug() << "Composition on track" << bTrack << "is planted below a composition on track" << lastTrack;
+                ok = false;
+            }
+            foundComposition = true;
+            lastTrack = bTrack;
+        }
+        current = mlt_service_producer(current);
+    }
+    field->unlock();
+    return ok;
+}
+
 void TimelineModel::setTimelineEffectsEnabled(bool enabled)
 {
     m_timelineEffectsEnabled = enabled;
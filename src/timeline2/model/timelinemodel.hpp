@@ -652,6 +652,9 @@ protected:
      */
     Fun deregisterTrack_lambda(int id, bool updateView = false);
 
+    /* @brief Recompute the cached position of the tracks, starting at the given position */
+    void updateTrackPositions(int from = 0);
+
     /* @brief Return a lambda that deregisters and destructs the clip with given id.
        Note that the clip must already be deleted from its track and groups.
      */
@@ -680,10 +683,16 @@ protected:
      */
     static int getNextId();
 
+    /* @brief plant a composition at its place in the field, keeping the compositions sorted by b_track. Only the new composition is connected, the
+       others are left untouched
+       @param currentCompo is the id of a compo that have not yet been planted
+     */
+    bool replantCompositions(int currentCompo, bool updateView);
+
     /* @brief unplant and the replant all the compositions in the correct order
        @param currentCompo is the id of a compo that have not yet been planted, if any. Otherwise send -1
      */
-    bool replantCompositions(int currentCompo, bool updateView);
+    bool replantAllCompositions(int currentCompo, bool updateView);
 
     /* @brief Unplant the composition with given Id */
     bool unplantComposition(int compoId);
@@ -703,6 +712,8 @@ protected:
 public:
     /* @brief Debugging function that checks consistency with Mlt objects */
     bool checkConsistency();
+    /* @brief Check that the field contains the compositions sorted by b_track, below the track compositing */
+    bool checkCompositionOrder();
 
 protected:
     /* @brief Refresh project monitor if cursor was inside range */
@@ -733,6 +744,8 @@ protected:
     std::unordered_map<int, std::list<std::shared_ptr<TrackModel>>::iterator>
         m_iteratorTable; // this logs the iterator associated which each track id. This allows easy access of a track based on its id.
 
+    std::unordered_map<int, int> m_trackPositions; // position of each track in m_allTracks, refreshed when a track is added or removed
+
     std::unordered_map<int, std::shared_ptr<ClipModel>> m_allClips; // the keys are the clip id, and the values are the corresponding pointers
 
     std::unordered_map<int, std::shared_ptr<CompositionModel>>
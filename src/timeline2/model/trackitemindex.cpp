@@ -0,0 +1,102 @@
+/***************************************************************************
+ *   Copyright (C) 2017 by Nicolas Carion                                  *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "trackitemindex.hpp"
+#include <climits>
+
+void TrackItemIndex::insert(int itemId, int start, int end)
+{
+    m_items[start] = {end, itemId};
+}
+
+void TrackItemIndex::remove(int itemId, int start)
+{
+    auto it = m_items.find(start);
+    if (it != m_items.end() && it->second.second == itemId) {
+        m_items.erase(it);
+    }
+}
+
+void TrackItemIndex::clear()
+{
+    m_items.clear();
+}
+
+bool TrackItemIndex::empty() const
+{
+    return m_items.empty();
+}
+
+size_t TrackItemIndex::size() const
+{
+    return m_items.size();
+}
+
+int TrackItemIndex::itemAt(int position) const
+{
+    auto it = m_items.upper_bound(position);
+    if (it == m_items.begin()) {
+        return -1;
+    }
+    --it;
+    return position < it->second.first ? it->second.second : -1;
+}
+
+std::vector<int> TrackItemIndex::itemsInRange(int start, int end) const
+{
+    std::vector<int> ids;
+    auto it = m_items.upper_bound(start);
+    if (it != m_items.begin()) {
+        // the previous item may extend into the range
+        --it;
+        if (it->second.first <= start) {
+            ++it;
+        }
+    }
+    for (; it != m_items.end() && (end < 0 || it->first < end); ++it) {
+        ids.push_back(it->second.second);
+    }
+    return ids;
+}
+
+int TrackItemIndex::previousEnd(int position) const
+{
+    auto it = m_items.upper_bound(position);
+    while (it != m_items.begin()) {
+        --it;
+        if (it->second.first <= position) {
+            return it->second.first;
+        }
+    }
+    return 0;
+}
+
+int TrackItemIndex::nextStart(int position) const
+{
+    auto it = m_items.lower_bound(position);
+    return it == m_items.end() ? INT_MAX : it->first;
+}
+
+int TrackItemIndex::endOf(int start) const
+{
+    auto it = m_items.find(start);
+    return it == m_items.end() ? -1 : it->second.first;
+}
@@ -0,0 +1,62 @@
+/***************************************************************************
+ *   Copyright (C) 2017 by Nicolas Carion                                  *
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef TRACKITEMINDEX_H
+#define TRACKITEMINDEX_H
+
+#include <map>
+#include <vector>
+
+/* @brief This class indexes the position of items (clips or compositions) that cannot overlap each other, like the clips of one playlist of a track.
+   Since the items are disjoint, sorting them by start position is enough to answer point, range and neighbourhood queries in logarithmic time, without
+   walking the Mlt playlists.
+   Intervals are half open: an item inserted with (start, end) covers the frames start to end - 1.
+*/
+class TrackItemIndex
+{
+public:
+    TrackItemIndex() = default;
+
+    /* @brief Add an item to the index */
+    void insert(int itemId, int start, int end);
+    /* @brief Remove the item starting at the given position, if it has the given id */
+    void remove(int itemId, int start);
+    void clear();
+    bool empty() const;
+    size_t size() const;
+
+    /* @brief Returns the id of the item covering the given position, or -1 */
+    int itemAt(int position) const;
+    /* @brief Returns the ids of the items intersecting [start, end[. If end is -1, the range extends to the end of the track */
+    std::vector<int> itemsInRange(int start, int end) const;
+    /* @brief Returns the end of the last item ending before or at position, or 0 if there is none */
+    int previousEnd(int position) const;
+    /* @brief Returns the start of the first item starting after or at position, or INT_MAX if there is none */
+    int nextStart(int position) const;
+    /* @brief Returns the end of the item starting at the given position, or -1 if there is none */
+    int endOf(int start) const;
+
+private:
+    // start -> (end, id)
+    std::map<int, std::pair<int, int>> m_items;
+};
+
+#endif
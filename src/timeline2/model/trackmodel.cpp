@@ -29,7 +29,9 @@
 #include "timelinemodel.hpp"
 #include <QDebug>
 #include <QModelIndex>
+#include <algorithm>
 #include <mlt++/MltTransition.h>
+#include <tuple>
 
 TrackModel::TrackModel(const std::weak_ptr<TimelineModel> &parent, int id, const QString &trackName, bool audioTrack)
     : m_parent(parent)
@@ -141,6 +143,7 @@ Fun TrackModel::requestClipInsertion_lambda(int clipId, int position, bool updat
             // update clip position and track
             clip->setPosition(position);
             clip->setSubPlaylistIndex(subPlaylist);
+            m_clipIndex[subPlaylist].insert(clipId, position, position + clip->getPlaytime());
             int new_in = clip->getPosition();
             int new_out = new_in + clip->getPlaytime();
             ptr->m_snaps->addPoint(new_in);
@@ -302,6 +305,7 @@ Fun TrackModel::requestClipDeletion_lambda(int clipId, bool updateView, bool fin
         auto prod = m_playlists[target_track].replace_with_blank(target_clip);
         if (prod != nullptr) {
             m_playlists[target_track].consolidate_blanks();
+            m_clipIndex[target_track].remove(clipId, clip_position);
             m_allClips[clipId]->setCurrentTrackId(-1);
             m_allClips[clipId]->setSubPlaylistIndex(-1);
             m_allClips.erase(clipId);
@@ -350,14 +354,162 @@ bool TrackModel::requestClipDeletion(int clipId, bool updateView, bool finalMove
     return false;
 }
 
+bool TrackModel::requestClipsMove(const std::unordered_map<int, int> &moves, bool finalMove, Fun &undo, Fun &redo)
+{
+    QWriteLocker locker(&m_lock);
+    if (isLocked() || moves.empty()) {
+        return false;
+    }
+    std::unordered_map<int, int> old_positions;
+    std::unordered_set<int> old_starts;
+    std::vector<std::pair<int, int>> new_zones;
+    for (const auto &move : moves) {
+        auto it = m_allClips.find(move.first);
+        if (it == m_allClips.end() || move.second < 0 || it->second->getSubPlaylistIndex() != 0) {
+            // Clips living in the second playlist must be moved one by one
+            return false;
+        }
+        old_positions[move.first] = it->second->getPosition();
+        old_starts.insert(it->second->getPosition());
+        new_zones.emplace_back(move.second, move.second + it->second->getPlaytime());
+    }
+    // Check the final layout before touching anything: moved clips must not overlap each other...
+    std::sort(new_zones.begin(), new_zones.end());
+    for (size_t i = 1; i < new_zones.size(); ++i) {
+        if (new_zones[i - 1].second > new_zones[i].first) {
+            return false;
+        }
+    }
+    // ... and their target zones may only contain blanks or clips that are moved away
+    for (const auto &zone : new_zones) {
+        for (int pl = 0; pl < 2; ++pl) {
+            int count = m_playlists[pl].count();
+            int index = m_playlists[pl].get_clip_index_at(zone.first);
+            while (index < count && m_playlists[pl].clip_start(index) < zone.second) {
+                if (!m_playlists[pl].is_blank(index) && (pl == 1 || old_starts.count(m_playlists[pl].clip_start(index)) == 0)) {
+                    return false;
+                }
+                ++index;
+            }
+        }
+    }
+    auto operation = requestClipsMove_lambda(moves, finalMove);
+    if (operation()) {
+        auto reverse = requestClipsMove_lambda(old_positions, finalMove);
+        UPDATE_UNDO_REDO(operation, reverse, undo, redo);
+        return true;
+    }
+    return false;
+}
+
+Fun TrackModel::requestClipsMove_lambda(const std::unordered_map<int, int> &moves, bool finalMove)
+{
+    return [moves, finalMove, this]() {
+        auto ptr = m_parent.lock();
+        if (!ptr) {
+            qDebug() << "Error : Clips move failed because timeline is not available anymore";
+            return false;
+        }
+        // Find the zone covered by the old and new positions of the moved clips
+        int start = -1;
+        int end = 0;
+        std::unordered_set<int> old_starts;
+        // new position, old position, clip
+        std::vector<std::tuple<int, int, std::shared_ptr<ClipModel>>> moved;
+        for (const auto &move : moves) {
+            const auto &clip = m_allClips.at(move.first);
+            int position = clip->getPosition();
+            int playtime = clip->getPlaytime();
+            old_starts.insert(position);
+            start = start < 0 ? std::min(position, move.second) : std::min(start, std::min(position, move.second));
+            end = std::max(end, std::max(position, move.second) + playtime);
+            moved.emplace_back(move.second, position, clip);
+        }
+        // lock MLT playlist so that we don't end up with invalid frames in monitor
+        Mlt::Playlist &playlist = m_playlists[0];
+        playlist.lock();
+        int count = playlist.count();
+        int first = playlist.get_clip_index_at(start);
+        int last = std::min(playlist.get_clip_index_at(end - 1), count - 1);
+        int zone_start = first < count ? playlist.clip_start(first) : playlist.get_playtime();
+        int zone_end = first <= last ? playlist.clip_start(last) + playlist.clip_length(last) : zone_start;
+        bool lastInPlaylist = last == count - 1;
+
+        // Build the final content of the zone: clips that don't move are reinserted as is
+        // position, length, producer
+        std::vector<std::tuple<int, int, Mlt::Producer *>> layout;
+        std::vector<std::unique_ptr<Mlt::Producer>> kept;
+        for (int i = first; i <= last; ++i) {
+            if (!playlist.is_blank(i) && old_starts.count(playlist.clip_start(i)) == 0) {
+                kept.emplace_back(playlist.get_clip(i));
+                layout.emplace_back(playlist.clip_start(i), playlist.clip_length(i), kept.back().get());
+            }
+        }
+        for (const auto &m : moved) {
+            Mlt::Producer &prod = *std::get<2>(m);
+            layout.emplace_back(std::get<0>(m), std::get<2>(m)->getPlaytime(), &prod);
+        }
+        std::sort(layout.begin(), layout.end(), [](const std::tuple<int, int, Mlt::Producer *> &a, const std::tuple<int, int, Mlt::Producer *> &b) {
+            return std::get<0>(a) < std::get<0>(b);
+        });
+
+        // Rewrite the zone in a single pass. If clips follow the zone, its length must not change
+        for (int i = last; i >= first; --i) {
+            playlist.remove(i);
+        }
+        int index = first;
+        int cursor = zone_start;
+        for (const auto &item : layout) {
+            if (std::get<0>(item) > cursor) {
+                playlist.insert_blank(index++, std::get<0>(item) - cursor - 1);
+            }
+            playlist.insert(*std::get<2>(item), index++);
+            cursor = std::get<0>(item) + std::get<1>(item);
+        }
+        if (!lastInPlaylist && cursor < zone_end) {
+            playlist.insert_blank(index, zone_end - cursor - 1);
+        }
+        playlist.consolidate_blanks();
+        playlist.unlock();
+
+        for (const auto &m : moved) {
+            int playtime = std::get<2>(m)->getPlaytime();
+            m_clipIndex[0].remove(std::get<2>(m)->getId(), std::get<1>(m));
+            ptr->m_snaps->removePoint(std::get<1>(m));
+            ptr->m_snaps->removePoint(std::get<1>(m) + playtime);
+        }
+        for (const auto &m : moved) {
+            int playtime = std::get<2>(m)->getPlaytime();
+            std::get<2>(m)->setPosition(std::get<0>(m));
+            m_clipIndex[0].insert(std::get<2>(m)->getId(), std::get<0>(m), std::get<0>(m) + playtime);
+            ptr->m_snaps->addPoint(std::get<0>(m));
+            ptr->m_snaps->addPoint(std::get<0>(m) + playtime);
+        }
+        if (!isHidden() && !isAudioTrack()) {
+            // only refresh monitor if not an audio track and not hidden
+            ptr->checkRefresh(start, end);
+        }
+        if (finalMove) {
+            if (!isAudioTrack()) {
+                ptr->invalidateZone(start, end);
+            }
+            if (lastInPlaylist) {
+                ptr->updateDuration();
+            }
+        }
+        return true;
+    };
+}
+
 int TrackModel::getBlankSizeAtPos(int frame)
 {
     READ_LOCK();
     int min_length = 0;
-    for (auto &m_playlist : m_playlists) {
-        int ix = m_playlist.get_clip_index_at(frame);
-        if (m_playlist.is_blank(ix)) {
-            int blank_length = m_playlist.clip_length(ix);
+    for (const auto &index : m_clipIndex) {
+        if (index.itemAt(frame) == -1) {
+            int next = index.nextStart(frame);
+            // the blank after the last clip has no length
+            int blank_length = next == INT_MAX ? 0 : next - index.previousEnd(frame);
             if (min_length == 0 || (blank_length > 0 && blank_length < min_length)) {
                 min_length = blank_length;
             }
@@ -369,18 +521,19 @@ int TrackModel::getBlankSizeAtPos(int frame)
 int TrackModel::suggestCompositionLength(int position)
 {
     READ_LOCK();
-    if (m_playlists[0].is_blank_at(position) && m_playlists[1].is_blank_at(position)) {
+    if (isBlankAt(position)) {
         return -1;
     }
-    auto clip_loc = getClipIndexAt(position);
-    int track = clip_loc.first;
-    int index = clip_loc.second;
-    int other_index; // index in the other track
+    int track = m_clipIndex[0].itemAt(position) != -1 ? 0 : 1;
     int other_track = (track + 1) % 2;
-    int end_pos = m_playlists[track].clip_start(index) + m_playlists[track].clip_length(index);
-    other_index = m_playlists[other_track].get_clip_index_at(end_pos);
-    if (other_index < m_playlists[other_track].count()) {
-        end_pos = std::min(end_pos, m_playlists[other_track].clip_start(other_index) + m_playlists[other_track].clip_length(other_index));
+    int clipId = m_clipIndex[track].itemAt(position);
+    int end_pos = m_allClips[clipId]->getPosition() + m_allClips[clipId]->getPlaytime();
+    // the item of the other playlist (clip or blank) at end_pos might limit the length
+    int other_clip = m_clipIndex[other_track].itemAt(end_pos);
+    if (other_clip != -1) {
+        end_pos = std::min(end_pos, m_allClips[other_clip]->getPosition() + m_allClips[other_clip]->getPlaytime());
+    } else if (m_clipIndex[other_track].nextStart(end_pos) != INT_MAX) {
+        end_pos = std::min(end_pos, m_clipIndex[other_track].nextStart(end_pos));
     }
     int min = -1;
     std::unordered_set<int> existing = getCompositionsInRange(position, end_pos);
@@ -477,7 +630,9 @@ Fun TrackModel::requestClipResize_lambda(int clipId, int in, int out, bool right
         checkRefresh = true;
     }
 
-    auto update_snaps = [old_in, old_out, checkRefresh, this](int new_in, int new_out) {
+    auto update_snaps = [clipId, target_track, old_in, old_out, checkRefresh, this](int new_in, int new_out) {
+        m_clipIndex[target_track].remove(clipId, old_in);
+        m_clipIndex[target_track].insert(clipId, new_in, new_out);
         if (auto ptr = m_parent.lock()) {
             ptr->m_snaps->removePoint(old_in);
             ptr->m_snaps->removePoint(old_out);
@@ -608,17 +763,11 @@ int TrackModel::getId() const
 int TrackModel::getClipByPosition(int position)
 {
     READ_LOCK();
-    QSharedPointer<Mlt::Producer> prod(nullptr);
-    if (m_playlists[0].count() > 0) {
-        prod = QSharedPointer<Mlt::Producer>(m_playlists[0].get_clip_at(position));
-    }
-    if ((!prod || prod->is_blank()) && m_playlists[1].count() > 0) {
-        prod = QSharedPointer<Mlt::Producer>(m_playlists[1].get_clip_at(position));
-    }
-    if (!prod || prod->is_blank()) {
-        return -1;
+    int clipId = m_clipIndex[0].itemAt(position);
+    if (clipId == -1) {
+        clipId = m_clipIndex[1].itemAt(position);
     }
-    return prod->get_int("_kdenlive_cid");
+    return clipId;
 }
 
 QSharedPointer<Mlt::Producer> TrackModel::getClipProducer(int clipId)
@@ -637,14 +786,14 @@ QSharedPointer<Mlt::Producer> TrackModel::getClipProducer(int clipId)
 int TrackModel::getCompositionByPosition(int position)
 {
     READ_LOCK();
-    for (const auto &comp : m_compoPos) {
-        if (comp.first == position) {
-            return comp.second;
-        } else if (comp.first < position) {
-            if (comp.first + m_allCompositions[comp.second]->getPlaytime() >= position) {
-                return comp.second;
-            }
-        }
+    // compositions cannot overlap, so only the last one starting before position can contain it
+    auto it = m_compoPos.upper_bound(position);
+    if (it == m_compoPos.begin()) {
+        return -1;
+    }
+    --it;
+    if (it->first == position || it->first + m_allCompositions[it->second]->getPlaytime() >= position) {
+        return it->second;
     }
     return -1;
 }
@@ -664,14 +813,9 @@ std::unordered_set<int> TrackModel::getClipsInRange(int position, int end)
 {
     READ_LOCK();
     std::unordered_set<int> ids;
-    for (const auto &clp : m_allClips) {
-        int pos = clp.second->getPosition();
-        int length = clp.second->getPlaytime();
-        if (end > -1 && pos >= end) {
-            continue;
-        }
-        if (pos >= position || pos + length - 1 >= position) {
-            ids.insert(clp.first);
+    for (const auto &index : m_clipIndex) {
+        for (int id : index.itemsInRange(position, end)) {
+            ids.insert(id);
         }
     }
     return ids;
@@ -689,16 +833,17 @@ std::unordered_set<int> TrackModel::getCompositionsInRange(int position, int end
     READ_LOCK();
     // TODO: this function doesn't take into accounts the fact that there are two tracks
     std::unordered_set<int> ids;
-    for (const auto &compo : m_allCompositions) {
-        int pos = compo.second->getPosition();
-        int length = compo.second->getPlaytime();
-        if (end > -1 && pos >= end) {
-            continue;
-        }
-        if (pos >= position || pos + length - 1 >= position) {
-            ids.insert(compo.first);
+    auto it = m_compoPos.upper_bound(position);
+    if (it != m_compoPos.begin()) {
+        // the previous composition may extend into the range
+        --it;
+        if (it->first + m_allCompositions[it->second]->getPlaytime() <= position) {
+            ++it;
         }
     }
+    for (; it != m_compoPos.end() && (end < 0 || it->first < end); ++it) {
+        ids.insert(it->second);
+    }
     return ids;
 }
 
@@ -852,6 +997,20 @@ bool TrackModel::checkConsistency()
         return false;
     }
 
+    // The position index must match the clips
+    if (m_clipIndex[0].size() + m_clipIndex[1].size() != m_allClips.size()) {
+        qDebug() << "Error: the number of indexed clips doesn't match number of clips";
+        return false;
+    }
+    for (const auto &clip : m_allClips) {
+        int pos = clip.second->getPosition();
+        int sub = clip.second->getSubPlaylistIndex();
+        if (sub < 0 || sub > 1 || m_clipIndex[sub].itemAt(pos) != clip.first || m_clipIndex[sub].endOf(pos) != pos + clip.second->getPlaytime()) {
+            qDebug() << "Error: the position of clip " << clip.first << " is not properly indexed";
+            return false;
+        }
+    }
+
     // We now check compositions positions
     if (m_allCompositions.size() != m_compoPos.size()) {
         qDebug() << "Error: the number of compositions position doesn't match number of compositions";
@@ -904,26 +1063,18 @@ std::pair<int, int> TrackModel::getClipIndexAt(int position)
 bool TrackModel::isBlankAt(int position)
 {
     READ_LOCK();
-    return m_playlists[0].is_blank_at(position) && m_playlists[1].is_blank_at(position);
+    return m_clipIndex[0].itemAt(position) == -1 && m_clipIndex[1].itemAt(position) == -1;
 }
 
 int TrackModel::getBlankStart(int position)
 {
     READ_LOCK();
     int result = 0;
-    for (auto &m_playlist : m_playlists) {
-        if (m_playlist.count() == 0) {
-            break;
-        }
-        if (!m_playlist.is_blank_at(position)) {
-            result = position;
-            break;
-        }
-        int clip_index = m_playlist.get_clip_index_at(position);
-        int start = m_playlist.clip_start(clip_index);
-        if (start > result) {
-            result = start;
+    for (const auto &index : m_clipIndex) {
+        if (index.itemAt(position) != -1) {
+            return position;
         }
+        result = std::max(result, index.previousEnd(position));
     }
     return result;
 }
@@ -931,18 +1082,10 @@ int TrackModel::getBlankStart(int position)
 int TrackModel::getBlankEnd(int position, int track)
 {
     READ_LOCK();
-    // Q_ASSERT(m_playlists[track].is_blank_at(position));
-    if (!m_playlists[track].is_blank_at(position)) {
+    if (m_clipIndex[track].itemAt(position) != -1) {
         return position;
     }
-    int clip_index = m_playlists[track].get_clip_index_at(position);
-    int count = m_playlists[track].count();
-    if (clip_index < count) {
-        int blank_start = m_playlists[track].clip_start(clip_index);
-        int blank_length = m_playlists[track].clip_length(clip_index);
-        return blank_start + blank_length;
-    }
-    return INT_MAX;
+    return m_clipIndex[track].nextStart(position);
 }
 
 int TrackModel::getBlankEnd(int position)
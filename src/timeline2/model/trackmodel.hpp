@@ -23,6 +23,7 @@
 #define TRACKMODEL_H
 
 #include "definitions.h"
+#include "trackitemindex.hpp"
 #include "undohelper.hpp"
 #include <QReadWriteLock>
 #include <QSharedPointer>
@@ -147,6 +148,20 @@ protected:
     /* @brief This function returns a lambda that performs the requested operation */
     Fun requestClipDeletion_lambda(int clipId, bool updateView, bool finalMove);
 
+    /* @brief Moves several clips of the track at once, without changing their track.
+       The final layout is checked first, then the part of the playlist covered by the old and new positions of the clips is rewritten in a
+       single pass, and one undo/redo pair is recorded for the whole batch.
+       Returns true if the operation succeeded, and otherwise, the track is not modified.
+       This method is protected because it shouldn't be called directly. Call the function in the timeline instead.
+       @param moves maps the id of each moved clip to its new position
+       @param finalMove if the move is finished (not while dragging), so we invalidate timeline preview / check project duration
+       @param undo Lambda function containing the current undo stack. Will be updated with current operation
+       @param redo Lambda function containing the current redo queue. Will be updated with current operation
+    */
+    bool requestClipsMove(const std::unordered_map<int, int> &moves, bool finalMove, Fun &undo, Fun &redo);
+    /* @brief This function returns a lambda that performs the requested operation */
+    Fun requestClipsMove_lambda(const std::unordered_map<int, int> &moves, bool finalMove);
+
     /* @brief Performs an insertion of the given composition.
        Returns true if the operation succeeded, and otherwise, the track is not modified.
        This method is protected because it shouldn't be called directly. Call the function in the timeline instead.
@@ -271,6 +286,7 @@ private:
 
     std::map<int, int> m_compoPos; // We store the positions of the compositions. In Melt, the compositions are not inserted at the track level, but we keep
                                    // those positions here to check for moves and resize
+    TrackItemIndex m_clipIndex[2]; // Positions of the clips of each playlist, so that position queries don't have to walk the Mlt playlists
 
     mutable QReadWriteLock m_lock; // This is a lock that ensures safety in case of concurrent access
 
@@ -27,10 +27,182 @@
 #include "timeline2/view/timelinecontroller.h"
 
 #include <KLocalizedString>
+#include <QCryptographicHash>
 #include <QProcess>
 #include <QScopedPointer>
 #include <QStandardPaths>
+#include <QThread>
 #include <QtConcurrent>
+#include <cstring>
+
+namespace {
+// Properties that have no influence on the rendered frames
+bool isIgnoredProperty(const char *name)
+{
+    if (name == nullptr || name[0] == '_' || strncmp(name, "meta.", 5) == 0) {
+        return true;
+    }
+    if (strncmp(name, "kdenlive:", 9) == 0) {
+        // Keep the file hash so that a modified source file is detected
+        return strcmp(name, "kdenlive:file_hash") != 0;
+    }
+    static const char *ignored[] = {"id", "in", "out", "length", "global_feed", "eof"};
+    for (const char *ignoredName : ignored) {
+        if (strcmp(name, ignoredName) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void hashInt(QCryptographicHash &hash, int value)
+{
+    hash.addData(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+void hashProperties(QCryptographicHash &hash, Mlt::Properties &properties)
+{
+    // Sort the properties so that the insertion order does not matter
+    QVector<QPair<QByteArray, QByteArray>> values;
+    for (int i = 0; i < properties.count(); ++i) {
+        const char *name = properties.get_name(i);
+        const char *value = properties.get(i);
+        if (value != nullptr && !isIgnoredProperty(name)) {
+            values.append({QByteArray(name), QByteArray(value)});
+        }
+    }
+    std::sort(values.begin(), values.end());
+    for (const auto &value : values) {
+        hash.addData(value.first);
+        hash.addData("=", 1);
+        hash.addData(value.second);
+        hash.addData("\n", 1);
+    }
+}
+
+// Filters attached to a service, in and out are the range of the service that is rendered
+void hashFilters(QCryptographicHash &hash, Mlt::Service &service, int in, int out)
+{
+    for (int i = 0; i < service.filter_count(); ++i) {
+        QScopedPointer<Mlt::Filter> filter(service.filter(i));
+        if (!filter || !filter->is_valid() || filter->get_int("disable") == 1) {
+            continue;
+        }
+        hash.addData("filter", 6);
+        hashInt(hash, filter->get_in() - in);
+        hashInt(hash, filter->get_out() - in);
+        hashInt(hash, out - in);
+        hashProperties(hash, *filter.data());
+    }
+}
+
+void hashProducer(QCryptographicHash &hash, Mlt::Producer &producer, int in, int out);
+
+void hashPlaylist(QCryptographicHash &hash, Mlt::Playlist &playlist, int in, int out)
+{
+    hashProperties(hash, playlist);
+    const int count = playlist.count();
+    for (int i = qMax(0, playlist.get_clip_index_at(in)); i < count; ++i) {
+        QScopedPointer<Mlt::ClipInfo> info(playlist.clip_info(i));
+        if (!info || info->start > out) {
+            break;
+        }
+        const int start = qMax(in, info->start);
+        const int end = qMin(out, info->start + info->frame_count - 1);
+        if (end < start) {
+            continue;
+        }
+        // Positions are relative to the chunk, so that identical content at another position gives the same hash
+        hashInt(hash, start - in);
+        hashInt(hash, end - in);
+        if (playlist.is_blank(i) || info->cut == nullptr) {
+            hash.addData("blank", 5);
+            continue;
+        }
+        hashProducer(hash, *info->cut, start - info->start, end - info->start);
+    }
+    hashFilters(hash, playlist, in, out);
+}
+
+void hashTractor(QCryptographicHash &hash, Mlt::Tractor &tractor, int in, int out)
+{
+    hashProperties(hash, tractor);
+    for (int i = 0; i < tractor.count(); ++i) {
+        QScopedPointer<Mlt::Producer> track(tractor.track(i));
+        if (!track || !track->is_valid()) {
+            continue;
+        }
+        const char *trackId = track->get("id");
+        if (trackId != nullptr && (strcmp(trackId, "timeline_preview") == 0 || strcmp(trackId, "timeline_overlay") == 0)) {
+            // Our own tracks are not rendered
+            continue;
+        }
+        hash.addData("track", 5);
+        hashProducer(hash, *track.data(), in, out);
+    }
+    QScopedPointer<Mlt::Service> service(tractor.producer());
+    while (service && service->is_valid()) {
+        if (service->type() == transition_type) {
+            Mlt::Transition transition((mlt_transition)service->get_service());
+            const int transitionIn = transition.get_in();
+            const int transitionOut = transition.get_out();
+            if (transition.get_int("always_active") == 1 || (transitionOut >= in && transitionIn <= out)) {
+                hash.addData("transition", 10);
+                hashInt(hash, transitionIn - in);
+                hashInt(hash, transitionOut - in);
+                hashInt(hash, transition.get_a_track());
+                hashInt(hash, transition.get_b_track());
+                hashProperties(hash, transition);
+            }
+        }
+        service.reset(service->producer());
+    }
+    hashFilters(hash, tractor, in, out);
+}
+
+void hashProducer(QCryptographicHash &hash, Mlt::Producer &producer, int in, int out)
+{
+    if (producer.is_cut()) {
+        QScopedPointer<Mlt::Producer> parent(producer.parent());
+        const int offset = producer.get_in();
+        hashProducer(hash, *parent.data(), in + offset, out + offset);
+        hashFilters(hash, producer, in, out);
+        return;
+    }
+    switch (producer.type()) {
+    case playlist_type: {
+        Mlt::Playlist playlist(producer);
+        hashPlaylist(hash, playlist, in, out);
+        break;
+    }
+    case tractor_type: {
+        Mlt::Tractor tractor(producer);
+        hashTractor(hash, tractor, in, out);
+        break;
+    }
+    default:
+        hashInt(hash, in);
+        hashInt(hash, out);
+        hashProperties(hash, producer);
+        hashFilters(hash, producer, in, out);
+        break;
+    }
+}
+
+// Mark a stored chunk as recently used
+void touchChunk(const QString &path)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    QFile file(path);
+    if (file.open(QIODevice::Append)) {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+#else
+    // Without access to the file times, eviction follows the creation order
+    Q_UNUSED(path)
+#endif
+}
+} // namespace
 
 PreviewManager::PreviewManager(TimelineController *controller, Mlt::Tractor *tractor)
     : QObject()
@@ -44,6 +216,9 @@ PreviewManager::PreviewManager(TimelineController *controller, Mlt::Tractor *tra
 {
     m_previewGatherTimer.setSingleShot(true);
     m_previewGatherTimer.setInterval(200);
+    m_workerIdleTimer.setSingleShot(true);
+    m_workerIdleTimer.setInterval(120000);
+    connect(&m_workerIdleTimer, &QTimer::timeout, this, &PreviewManager::stopIdleWorkers);
 
     // Find path for Kdenlive renderer
 #ifdef Q_OS_WIN
@@ -57,17 +232,21 @@ PreviewManager::PreviewManager(TimelineController *controller, Mlt::Tractor *tra
             m_renderer = QStringLiteral("kdenlive_render");
         }
     }
-    connect(this, &PreviewManager::abortPreview, &m_previewProcess, &QProcess::kill, Qt::DirectConnection);
-    connect(&m_previewProcess, &QProcess::readyReadStandardError, this, &PreviewManager::receivedStderr);
 }
 
 PreviewManager::~PreviewManager()
 {
     if (m_initialized) {
         abortRendering();
-        if (m_undoDir.dirName() == QLatin1String("undo")) {
-            m_undoDir.removeRecursively();
+        for (auto &worker : m_workers) {
+            worker->process.disconnect(this);
+            worker->process.closeWriteChannel();
+            if (!worker->process.waitForFinished(3000)) {
+                worker->process.kill();
+                worker->process.waitForFinished();
+            }
         }
+        m_workers.clear();
         if ((pCore->currentDoc()->url().isEmpty() && m_cacheDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot).isEmpty()) ||
             m_cacheDir.entryList(QDir::AllEntries | QDir::NoDotAndDotDot).isEmpty()) {
             if (m_cacheDir.dirName() == QLatin1String("preview")) {
@@ -96,8 +275,7 @@ bool PreviewManager::initialize()
         pCore->displayMessage(i18n("Cannot create folder %1", m_cacheDir.absolutePath()), ErrorMessage);
         return false;
     }
-    if (m_cacheDir.dirName() != QLatin1String("preview") || m_cacheDir == QDir() ||
-        (!m_cacheDir.exists(QStringLiteral("undo")) && !m_cacheDir.mkdir(QStringLiteral("undo"))) || !m_cacheDir.absolutePath().contains(documentId)) {
+    if (m_cacheDir.dirName() != QLatin1String("preview") || m_cacheDir == QDir() || !m_cacheDir.absolutePath().contains(documentId)) {
         pCore->displayMessage(i18n("Something is wrong with cache folder %1", m_cacheDir.absolutePath()), ErrorMessage);
         return false;
     }
@@ -105,22 +283,30 @@ bool PreviewManager::initialize()
         pCore->displayMessage(i18n("Invalid timeline preview parameters"), ErrorMessage);
         return false;
     }
-    m_undoDir = QDir(m_cacheDir.absoluteFilePath(QStringLiteral("undo")));
+    // Rendered chunks are stored by content in a folder shared by all projects
+    m_storeDir = doc->getCacheDir(CacheRoot, &ok);
+    if (!ok || !m_storeDir.mkpath(QStringLiteral("previewchunks")) || !m_storeDir.cd(QStringLiteral("previewchunks"))) {
+        pCore->displayMessage(i18n("Cannot create folder %1", m_storeDir.absoluteFilePath(QStringLiteral("previewchunks"))), ErrorMessage);
+        return false;
+    }
 
     // Make sure our cache dirs are inside the temporary folder
-    if (!m_cacheDir.makeAbsolute() || !m_undoDir.makeAbsolute() || !m_undoDir.mkpath(QStringLiteral("."))) {
+    if (!m_cacheDir.makeAbsolute() || !m_storeDir.makeAbsolute()) {
         pCore->displayMessage(i18n("Something is wrong with cache folders"), ErrorMessage);
         return false;
     }
-
-    connect(this, &PreviewManager::cleanupOldPreviews, this, &PreviewManager::doCleanupOldPreviews);
-    connect(doc, &KdenliveDoc::removeInvalidUndo, this, &PreviewManager::slotRemoveInvalidUndo, Qt::DirectConnection);
+    // The undo history of previous versions is replaced by the chunk store, their chunks are moved to the store when the project chunks are loaded
+    QDir legacyUndo(m_cacheDir.absoluteFilePath(QStringLiteral("undo")));
+    if (legacyUndo.exists() && legacyUndo.dirName() == QLatin1String("undo")) {
+        legacyUndo.removeRecursively();
+    }
     m_previewTimer.setSingleShot(true);
     m_previewTimer.setInterval(3000);
     connect(&m_previewTimer, &QTimer::timeout, this, &PreviewManager::startPreviewRender);
     connect(this, &PreviewManager::previewRender, this, &PreviewManager::gotPreviewRender, Qt::DirectConnection);
     connect(&m_previewGatherTimer, &QTimer::timeout, this, &PreviewManager::slotProcessDirtyChunks);
     m_initialized = true;
+    evictStoredChunks();
     return true;
 }
 
@@ -138,7 +324,7 @@ bool PreviewManager::buildPreviewTrack()
     return true;
 }
 
-void PreviewManager::loadChunks(QVariantList previewChunks, QVariantList dirtyChunks, const QDateTime &documentDate)
+void PreviewManager::loadChunks(QVariantList previewChunks, QVariantList dirtyChunks)
 {
     if (previewChunks.isEmpty()) {
         previewChunks = m_renderedChunks;
@@ -146,17 +332,20 @@ void PreviewManager::loadChunks(QVariantList previewChunks, QVariantList dirtyCh
     if (dirtyChunks.isEmpty()) {
         dirtyChunks = m_dirtyChunks;
     }
+    // Chunks are looked up by content, so a file is only reused if the timeline did not change since it was rendered
+    updateChunkKeys(previewChunks);
+    if (!m_legacyChecked && !isRendering()) {
+        m_legacyChecked = true;
+        QHash<int, QString> renderedKeys;
+        for (const auto &frame : previewChunks) {
+            renderedKeys.insert(frame.toInt(), m_chunkKeys.value(frame.toInt()));
+        }
+        migrateLegacyChunks(m_cacheDir, m_storeDir, m_extension, renderedKeys);
+    }
     for (const auto &frame : previewChunks) {
-        const QString fileName = m_cacheDir.absoluteFilePath(QStringLiteral("%1.%2").arg(frame.toInt()).arg(m_extension));
-        QFile file(fileName);
-        if (file.exists()) {
-            if (!documentDate.isNull() && QFileInfo(file).lastModified() > documentDate) {
-                // Timeline preview file was created after document, invalidate
-                file.remove();
-                dirtyChunks << frame;
-            } else {
-                gotPreviewRender(frame.toInt(), fileName, 1000);
-            }
+        const QString fileName = storedChunk(frame.toInt());
+        if (!fileName.isEmpty()) {
+            gotPreviewRender(frame.toInt(), fileName, 1000);
         } else {
             dirtyChunks << frame;
         }
@@ -174,6 +363,109 @@ void PreviewManager::loadChunks(QVariantList previewChunks, QVariantList dirtyCh
     }
 }
 
+QString PreviewManager::chunkKey(int frame) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    Mlt::Profile &profile = pCore->getCurrentProfile()->profile();
+    hash.addData(QStringLiteral("%1x%2 %3/%4 %5/%6 %7 %8")
+                     .arg(profile.width())
+                     .arg(profile.height())
+                     .arg(profile.frame_rate_num())
+                     .arg(profile.frame_rate_den())
+                     .arg(profile.sample_aspect_num())
+                     .arg(profile.sample_aspect_den())
+                     .arg(profile.progressive())
+                     .arg(profile.colorspace())
+                     .toUtf8());
+    hash.addData(m_extension.toUtf8());
+    hash.addData(m_consumerParams.join(QLatin1Char(' ')).toUtf8());
+    const int chunkSize = KdenliveSettings::timelinechunks();
+    hashTractor(hash, *m_tractor, frame, frame + chunkSize - 1);
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+void PreviewManager::updateChunkKeys(const QVariantList &frames)
+{
+    if (frames.isEmpty()) {
+        return;
+    }
+    m_tractor->lock();
+    for (const auto &frame : frames) {
+        m_chunkKeys.insert(frame.toInt(), chunkKey(frame.toInt()));
+    }
+    m_tractor->unlock();
+}
+
+QString PreviewManager::storedChunk(int frame) const
+{
+    const QString key = m_chunkKeys.value(frame);
+    if (key.isEmpty()) {
+        return QString();
+    }
+    const QString fileName = m_storeDir.absoluteFilePath(QStringLiteral("%1.%2").arg(key).arg(m_extension));
+    if (!QFile::exists(fileName)) {
+        return QString();
+    }
+    touchChunk(fileName);
+    return fileName;
+}
+
+void PreviewManager::evictStoredChunks()
+{
+    if (m_evictionThread.isRunning()) {
+        return;
+    }
+    const qint64 limit = KdenliveSettings::previewcachesize() * 1024LL * 1024LL;
+    // Never delete the chunks matching the current content of the timeline: they are used by our preview track, being rendered or about to be plugged
+    QSet<QString> used;
+    for (const QString &key : m_chunkKeys) {
+        used.insert(QStringLiteral("%1.%2").arg(key).arg(m_extension));
+    }
+    m_evictionThread = QtConcurrent::run(&PreviewManager::evictChunks, m_storeDir, used, limit);
+}
+
+// static
+void PreviewManager::evictChunks(const QDir &store, const QSet<QString> &used, qint64 limit)
+{
+    // Oldest (least recently used) first
+    const QFileInfoList files = store.entryInfoList(QDir::Files, QDir::Time | QDir::Reversed);
+    qint64 total = 0;
+    for (const QFileInfo &file : files) {
+        total += file.size();
+    }
+    for (const QFileInfo &file : files) {
+        if (total <= limit) {
+            break;
+        }
+        if (!used.contains(file.fileName()) && QFile::remove(file.absoluteFilePath())) {
+            total -= file.size();
+        }
+    }
+}
+
+// static
+void PreviewManager::migrateLegacyChunks(const QDir &cacheDir, const QDir &storeDir, const QString &extension, const QHash<int, QString> &renderedKeys)
+{
+    // Previous versions stored the chunks in the project preview folder, named by their start frame
+    const QStringList legacyChunks = cacheDir.entryList({QStringLiteral("*.") + extension}, QDir::Files);
+    for (const QString &chunk : legacyChunks) {
+        bool ok = false;
+        const int frame = chunk.section(QLatin1Char('.'), 0, 0).toInt(&ok);
+        if (!ok) {
+            continue;
+        }
+        const QString key = renderedKeys.value(frame);
+        if (!key.isEmpty()) {
+            // The project lists this chunk as rendered, keep it for the current content
+            const QString stored = storeDir.absoluteFilePath(QStringLiteral("%1.%2").arg(key).arg(extension));
+            if (!QFile::exists(stored) && QFile::rename(cacheDir.absoluteFilePath(chunk), stored)) {
+                continue;
+            }
+        }
+        QFile::remove(cacheDir.absoluteFilePath(chunk));
+    }
+}
+
 void PreviewManager::deletePreviewTrack()
 {
     m_tractor->lock();
@@ -277,103 +569,28 @@ void PreviewManager::invalidatePreviews(const QVariantList chunks)
         m_previewTimer.stop();
         timer = true;
     }
-    KdenliveDoc *doc = pCore->currentDoc();
-    int stackIx = doc->commandStack()->index();
-    int stackMax = doc->commandStack()->count();
-    if (stackIx == stackMax && !m_undoDir.exists(QString::number(stackIx - 1))) {
-        // We just added a new command in stack, archive existing chunks
-        int ix = stackIx - 1;
-        m_undoDir.mkdir(QString::number(ix));
-        bool foundPreviews = false;
-        for (const auto &i : chunks) {
-            QString current = QStringLiteral("%1.%2").arg(i.toInt()).arg(m_extension);
-            if (m_cacheDir.rename(current, QStringLiteral("undo/%1/%2").arg(ix).arg(current))) {
-                foundPreviews = true;
-            }
-        }
-        if (!foundPreviews) {
-            // No preview files found, remove undo folder
-            m_undoDir.rmdir(QString::number(ix));
-        } else {
-            // new chunks archived, cleanup old ones
-            emit cleanupOldPreviews();
-        }
-    } else {
-        // Restore existing chunks, delete others
-        // Check if we just undo the last stack action, then backup, otherwise delete
-        bool lastUndo = false;
-        if (stackIx + 1 == stackMax) {
-            if (!m_undoDir.exists(QString::number(stackMax))) {
-                lastUndo = true;
-                bool foundPreviews = false;
-                m_undoDir.mkdir(QString::number(stackMax));
-                for (const auto &i : chunks) {
-                    QString current = QStringLiteral("%1.%2").arg(i.toInt()).arg(m_extension);
-                    if (m_cacheDir.rename(current, QStringLiteral("undo/%1/%2").arg(stackMax).arg(current))) {
-                        foundPreviews = true;
-                    }
-                }
-                if (!foundPreviews) {
-                    m_undoDir.rmdir(QString::number(stackMax));
-                }
-            }
-        }
-        bool moveFile = true;
-        QDir tmpDir = m_undoDir;
-        if (!tmpDir.cd(QString::number(stackIx))) {
-            moveFile = false;
-        }
-        QVariantList foundChunks;
-        for (const auto &i : chunks) {
-            QString cacheFileName = QStringLiteral("%1.%2").arg(i.toInt()).arg(m_extension);
-            if (!lastUndo) {
-                m_cacheDir.remove(cacheFileName);
-            }
-            if (moveFile) {
-                if (QFile::copy(tmpDir.absoluteFilePath(cacheFileName), m_cacheDir.absoluteFilePath(cacheFileName))) {
-                    foundChunks << i;
-                    m_dirtyChunks.removeAll(i);
-                    m_renderedChunks << i;
-                } else {
-                    qDebug() << "// ERROR PROCESSE CHUNK: " << i << ", " << cacheFileName;
-                }
-            }
-        }
-        if (!foundChunks.isEmpty()) {
-            qSort(foundChunks);
-            m_controller->dirtyChunksChanged();
-            m_controller->renderedChunksChanged();
-            reloadChunks(foundChunks);
+    // Chunks whose content was already rendered (after an undo, or moving an item back) are restored from the store
+    updateChunkKeys(chunks);
+    QVariantList foundChunks;
+    for (const auto &i : chunks) {
+        if (!storedChunk(i.toInt()).isEmpty()) {
+            foundChunks << i;
+            m_dirtyChunks.removeAll(i);
+            m_renderedChunks << i;
         }
     }
-    doc->setModified(true);
+    if (!foundChunks.isEmpty()) {
+        qSort(foundChunks);
+        m_controller->dirtyChunksChanged();
+        m_controller->renderedChunksChanged();
+        reloadChunks(foundChunks);
+    }
+    pCore->currentDoc()->setModified(true);
     if (timer) {
         m_previewTimer.start();
     }
 }
 
-void PreviewManager::doCleanupOldPreviews()
-{
-    if (m_undoDir.dirName() != QLatin1String("undo")) {
-        return;
-    }
-    QStringList dirs = m_undoDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-
-    // Use QCollator to do a natural sorting so that 10 is after 2
-    QCollator collator;
-    collator.setNumericMode(true);
-    std::sort(dirs.begin(), dirs.end(), [&collator](const QString &file1, const QString &file2) { return collator.compare(file1, file2) < 0; });
-    bool ok;
-    while (dirs.count() > 5) {
-        QDir tmp = m_undoDir;
-        QString dirName = dirs.takeFirst();
-        dirName.toInt(&ok);
-        if (ok && tmp.cd(dirName)) {
-            tmp.removeRecursively();
-        }
-    }
-}
-
 void PreviewManager::clearPreviewRange(bool resetZones)
 {
     m_previewGatherTimer.stop();
@@ -381,7 +598,6 @@ void PreviewManager::clearPreviewRange(bool resetZones)
     m_tractor->lock();
     bool hasPreview = m_previewTrack != nullptr;
     for (const auto &ix : m_renderedChunks) {
-        m_cacheDir.remove(QStringLiteral("%1.%2").arg(ix.toInt()).arg(m_extension));
         m_dirtyChunks << ix;
         if (!hasPreview) {
             continue;
@@ -431,18 +647,17 @@ void PreviewManager::addPreviewRange(const QPoint zone, bool add)
     if (add) {
         qDebug() << "CHUNKS CHANGED: " << m_dirtyChunks;
         m_controller->dirtyChunksChanged();
-        if (m_previewProcess.state() == QProcess::NotRunning && KdenliveSettings::autopreview()) {
+        if (!isRendering() && KdenliveSettings::autopreview()) {
             m_previewTimer.start();
         }
     } else {
         // Remove processed chunks
-        bool isRendering = m_previewProcess.state() != QProcess::NotRunning;
+        bool wasRendering = isRendering();
         m_previewGatherTimer.stop();
         abortRendering();
         m_tractor->lock();
         bool hasPreview = m_previewTrack != nullptr;
         for (int ix : toRemove) {
-            m_cacheDir.remove(QStringLiteral("%1.%2").arg(ix).arg(m_extension));
             if (!hasPreview) {
                 continue;
             }
@@ -458,7 +673,7 @@ void PreviewManager::addPreviewRange(const QPoint zone, bool add)
         m_controller->renderedChunksChanged();
         m_controller->dirtyChunksChanged();
         m_tractor->unlock();
-        if (isRendering || KdenliveSettings::autopreview()) {
+        if (wasRendering || KdenliveSettings::autopreview()) {
             m_previewTimer.start();
         }
     }
@@ -466,16 +681,42 @@ void PreviewManager::addPreviewRange(const QPoint zone, bool add)
 
 void PreviewManager::abortRendering()
 {
-    if (m_previewProcess.state() == QProcess::NotRunning) {
+    m_renderQueue.clear();
+    if (!isRendering()) {
         return;
     }
     qDebug() << "/// ABORTING RENDEIGN 1\nRRRRRRRRRR";
+    // Busy workers are killed, idle ones are kept for the next render
+    std::vector<RenderWorker *> busy;
+    for (auto &worker : m_workers) {
+        if (worker->chunk >= 0) {
+            busy.push_back(worker.get());
+        }
+    }
+    // The killed workers must not re-queue their chunk
+    m_aborting = true;
     emit abortPreview();
-    m_previewProcess.waitForFinished();
+    for (RenderWorker *worker : busy) {
+        worker->process.waitForFinished();
+    }
+    m_aborting = false;
     // Re-init time estimation
     emit previewRender(-1, QString(), 1000);
 }
 
+bool PreviewManager::isRendering() const
+{
+    if (!m_renderQueue.isEmpty()) {
+        return true;
+    }
+    for (const auto &worker : m_workers) {
+        if (worker->chunk >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void PreviewManager::startPreviewRender()
 {
     if (m_renderedChunks.isEmpty() && m_dirtyChunks.isEmpty()) {
@@ -495,78 +736,246 @@ void PreviewManager::startPreviewRender()
     }
 }
 
-void PreviewManager::receivedStderr()
+void PreviewManager::receivedStderr(RenderWorker *worker)
 {
-    QStringList resultList = QString::fromLocal8Bit(m_previewProcess.readAllStandardError()).split(QLatin1Char('\n'));
-    for (auto &result : resultList) {
+    // Only process complete lines, several workers may be writing at the same time
+    while (worker->process.canReadLine()) {
+        const QString result = QString::fromLocal8Bit(worker->process.readLine()).trimmed();
         qDebug() << "GOT PROCESS RESULT: " << result;
         if (result.startsWith(QLatin1String("START:"))) {
-            workingPreview = result.section(QLatin1String("START:"), 1).simplified().toInt();
-            qDebug() << "// GOT START INFO: " << workingPreview;
-            m_controller->workingPreviewChanged();
+            worker->chunk = result.section(QLatin1String("START:"), 1).simplified().toInt();
+            qDebug() << "// GOT START INFO: " << worker->chunk;
+            updateWorkingPreview();
         } else if (result.startsWith(QLatin1String("DONE:"))) {
             int chunk = result.section(QLatin1String("DONE:"), 1).simplified().toInt();
             m_processedChunks++;
-            QString fileName = QStringLiteral("%1.%2").arg(chunk).arg(m_extension);
+            // Move the rendered file to the store
+            const QString renderedFile = m_cacheDir.absoluteFilePath(QStringLiteral("%1.%2").arg(chunk).arg(m_extension));
+            QString fileName = renderedFile;
+            if (m_chunkKeys.contains(chunk)) {
+                const QString stored = m_storeDir.absoluteFilePath(QStringLiteral("%1.%2").arg(m_chunkKeys.value(chunk)).arg(m_extension));
+                if (QFile::exists(stored) || QFile::rename(renderedFile, stored) || QFile::copy(renderedFile, stored)) {
+                    QFile::remove(renderedFile);
+                    fileName = stored;
+                }
+            }
             qDebug() << "---------------\nJOB PROGRRESS: " << m_chunksToRender << ", " << m_processedChunks << " = "
                      << (100 * m_processedChunks / m_chunksToRender);
-            emit previewRender(chunk, m_cacheDir.absoluteFilePath(fileName), 1000 * m_processedChunks / m_chunksToRender);
-        } else {
+            emit previewRender(chunk, fileName, 1000 * m_processedChunks / m_chunksToRender);
+            worker->chunk = -1;
+            dispatchChunk(worker);
+            updateWorkingPreview();
+        } else if (result.startsWith(QLatin1String("FAILED:"))) {
+            // The worker could not load the playlist, give up on this render. It is reported once the other workers are done
+            qDebug() << "// RENDER SERVER FAILED: " << result;
+            worker->chunk = -1;
+            m_renderFailed = true;
+            m_renderQueue.clear();
+            updateWorkingPreview();
+            if (!isRendering()) {
+                renderFinished(false);
+            }
+        } else if (!result.isEmpty() && !result.startsWith(QLatin1String("READY:"))) {
             m_errorLog.append(result);
         }
     }
 }
 
+void PreviewManager::dispatchChunk(RenderWorker *worker)
+{
+    if (worker->process.state() != QProcess::Running) {
+        return;
+    }
+    if (m_renderQueue.isEmpty()) {
+        // Nothing left, the worker stays idle until the next render
+        if (!isRendering()) {
+            renderFinished(true);
+        }
+        return;
+    }
+    if (worker->job != m_renderJob) {
+        // Select the playlist, the worker only parses it again if it changed since its last job
+        const QStringList job{QStringLiteral("JOB"),
+                              m_renderScene,
+                              m_cacheDir.absolutePath(),
+                              QString::number(KdenliveSettings::timelinechunks() - 1),
+                              m_extension,
+                              m_consumerParams.join(QLatin1Char(' '))};
+        worker->process.write(job.join(QLatin1Char('\t')).toUtf8() + '\n');
+        worker->job = m_renderJob;
+    }
+    worker->chunk = m_renderQueue.takeFirst();
+    worker->process.write(QByteArray::number(worker->chunk) + '\n');
+}
+
+void PreviewManager::renderFinished(bool success)
+{
+    if (m_renderScene.isEmpty()) {
+        return;
+    }
+    QFile::remove(m_renderScene);
+    m_renderScene.clear();
+    if (m_renderFailed) {
+        emit previewRender(0, m_errorLog, -1);
+    } else if (success) {
+        pCore->currentDoc()->previewProgress(1000);
+    }
+    evictStoredChunks();
+    // Don't keep idle render servers forever
+    m_workerIdleTimer.start();
+}
+
+void PreviewManager::stopIdleWorkers()
+{
+    for (auto &worker : m_workers) {
+        if (worker->chunk < 0 && worker->process.state() == QProcess::Running) {
+            // The server exits when its input is closed
+            worker->process.closeWriteChannel();
+        }
+    }
+}
+
+void PreviewManager::updateWorkingPreview()
+{
+    // Show the first chunk being processed in the ruler
+    int working = -1;
+    for (const auto &worker : m_workers) {
+        if (worker->chunk >= 0 && (working < 0 || worker->chunk < working)) {
+            working = worker->chunk;
+        }
+    }
+    if (working != workingPreview) {
+        workingPreview = working;
+        m_controller->workingPreviewChanged();
+    }
+}
+
+void PreviewManager::workerFinished(RenderWorker *worker, QProcess::ExitStatus status)
+{
+    qDebug() << "// PROCESS IS FINISHED!!!";
+    const int chunk = worker->chunk;
+    worker->chunk = -1;
+    worker->job = -1;
+    if (chunk >= 0 && !m_aborting) {
+        qDebug() << "// PROCESS IS CRASHED!!!!!!";
+        const QString fileName = QStringLiteral("%1.%2").arg(chunk).arg(m_extension);
+        if (m_cacheDir.exists(fileName)) {
+            m_cacheDir.remove(fileName);
+        }
+        if (m_crashedChunks.contains(chunk)) {
+            // Crashed twice, give up
+            m_errorLog.append(i18n("Rendering of chunk %1 crashed", chunk));
+            m_renderFailed = true;
+            m_renderQueue.clear();
+        } else {
+            // Retry first, on a new worker
+            m_crashedChunks << chunk;
+            m_renderQueue.prepend(chunk);
+            worker->process.start(m_renderer, {QStringLiteral("-server")});
+            if (worker->process.waitForStarted()) {
+                dispatchChunk(worker);
+            }
+        }
+    }
+    updateWorkingPreview();
+    bool running = false;
+    for (const auto &w : m_workers) {
+        running = running || w->process.state() != QProcess::NotRunning;
+    }
+    if (!running && !m_renderQueue.isEmpty()) {
+        // No worker left to process the queue
+        m_renderQueue.clear();
+        m_renderFailed = true;
+    }
+    if (!isRendering()) {
+        renderFinished(status != QProcess::CrashExit || chunk < 0);
+    }
+}
+
 void PreviewManager::doPreviewRender(const QString &scene)
 {
     // initialize progress bar
-    qSort(m_dirtyChunks);
     if (m_dirtyChunks.isEmpty()) {
         return;
     }
-
-    if (m_previewProcess.state() != QProcess::NotRunning) {
-        m_previewProcess.kill();
-        m_previewProcess.waitForFinished();
+    abortRendering();
+    // Chunks that are already in the store don't need to be rendered
+    updateChunkKeys(m_dirtyChunks);
+    const QVariantList dirtyChunks = m_dirtyChunks;
+    for (const QVariant &frame : dirtyChunks) {
+        const QString fileName = storedChunk(frame.toInt());
+        if (!fileName.isEmpty()) {
+            gotPreviewRender(frame.toInt(), fileName, 0);
+        }
     }
-    QStringList chunks;
+    if (m_dirtyChunks.isEmpty()) {
+        QFile::remove(scene);
+        pCore->currentDoc()->previewProgress(1000);
+        return;
+    }
+    // Render the chunks nearest to the playhead first
+    const int position = pCore->getTimelinePosition();
+    m_renderQueue.clear();
     for (QVariant &frame : m_dirtyChunks) {
-        chunks << frame.toString();
+        m_renderQueue << frame.toInt();
+        // The renderer keeps existing files, remove leftovers from an interrupted render
+        m_cacheDir.remove(QStringLiteral("%1.%2").arg(frame.toInt()).arg(m_extension));
     }
-    m_chunksToRender = m_dirtyChunks.count();
+    std::sort(m_renderQueue.begin(), m_renderQueue.end(), [position](int a, int b) {
+        int distA = qAbs(a - position);
+        int distB = qAbs(b - position);
+        return distA == distB ? a < b : distA < distB;
+    });
+    m_chunksToRender = m_renderQueue.count();
     m_processedChunks = 0;
-    int chunkSize = KdenliveSettings::timelinechunks();
-    QStringList args{KdenliveSettings::rendererpath(),
-                     scene,
-                     m_cacheDir.absolutePath(),
-                     QStringLiteral("-split"),
-                     chunks.join(QLatin1Char(',')),
-                     QString::number(chunkSize - 1),
-                     m_extension,
-                     m_consumerParams.join(QLatin1Char(' '))};
-    qDebug() << " -  - -STARTING PREVIEW JOBS: " << args;
+    m_renderFailed = false;
+    m_crashedChunks.clear();
+    m_renderScene = scene;
+    m_renderJob++;
+    m_workerIdleTimer.stop();
+    int workerCount = KdenliveSettings::previewworkers();
+    if (workerCount <= 0) {
+        // Each worker already uses several encoding threads
+        workerCount = qBound(1, QThread::idealThreadCount() / 4, 8);
+    }
+    workerCount = qMin(workerCount, m_chunksToRender);
+    qDebug() << " -  - -STARTING PREVIEW JOBS: " << workerCount;
     pCore->currentDoc()->previewProgress(0);
-    m_previewProcess.start(m_renderer, args);
-    QObject::connect(&m_previewProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), [this, scene](int, QProcess::ExitStatus status) {
-        qDebug() << "// PROCESS IS FINISHED!!!";
-        QFile::remove(scene);
-        if (status == QProcess::QProcess::CrashExit) {
-            qDebug() << "// PROCESS IS CRASHED!!!!!!";
-            pCore->currentDoc()->previewProgress(-1);
-            if (workingPreview >= 0) {
-                const QString fileName = QStringLiteral("%1.%2").arg(workingPreview).arg(m_extension);
-                if (m_cacheDir.exists(fileName)) {
-                    m_cacheDir.remove(fileName);
-                }
+    while ((int)m_workers.size() < workerCount) {
+        std::unique_ptr<RenderWorker> worker(new RenderWorker);
+        RenderWorker *w = worker.get();
+        w->process.setReadChannel(QProcess::StandardError);
+        connect(this, &PreviewManager::abortPreview, &w->process,
+                [w]() {
+                    if (w->chunk >= 0) {
+                        w->process.kill();
+                    }
+                },
+                Qt::DirectConnection);
+        connect(&w->process, &QProcess::readyReadStandardError, this, [this, w]() { receivedStderr(w); });
+        connect(&w->process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this,
+                [this, w](int, QProcess::ExitStatus status) { workerFinished(w, status); });
+        m_workers.push_back(std::move(worker));
+    }
+    for (int i = 0; i < workerCount; ++i) {
+        RenderWorker *worker = m_workers[(size_t)i].get();
+        if (worker->process.state() == QProcess::NotRunning) {
+            // Start a render server, it keeps MLT initialized between jobs
+            worker->chunk = -1;
+            worker->job = -1;
+            worker->process.start(m_renderer, {QStringLiteral("-server")});
+            if (!worker->process.waitForStarted()) {
+                continue;
             }
-        } else {
-            pCore->currentDoc()->previewProgress(1000);
+            qDebug() << " -  - -STARTING PREVIEW JOBS . . . STARTED";
         }
-        workingPreview = -1;
-        m_controller->workingPreviewChanged();
-    });
-    if (m_previewProcess.waitForStarted()) {
-        qDebug() << " -  - -STARTING PREVIEW JOBS . . . STARTED";
+        dispatchChunk(worker);
+    }
+    if (!isRendering()) {
+        // No worker could be started
+        m_renderQueue.clear();
+        renderFinished(false);
+        pCore->currentDoc()->previewProgress(-1);
     }
 }
 
@@ -581,25 +990,6 @@ void PreviewManager::slotProcessDirtyChunks()
     }
 }
 
-void PreviewManager::slotRemoveInvalidUndo(int ix)
-{
-    QMutexLocker lock(&m_previewMutex);
-    if (m_undoDir.dirName() != QLatin1String("undo")) {
-        // Make sure we delete correct folder
-        return;
-    }
-    QStringList dirs = m_undoDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-    bool ok;
-    for (const QString &dir : dirs) {
-        if (dir.toInt(&ok) >= ix && ok) {
-            QDir tmp = m_undoDir;
-            if (tmp.cd(dir)) {
-                tmp.removeRecursively();
-            }
-        }
-    }
-}
-
 void PreviewManager::invalidatePreview(int startFrame, int endFrame)
 {
     int chunkSize = KdenliveSettings::timelinechunks();
@@ -641,9 +1031,9 @@ void PreviewManager::reloadChunks(const QVariantList chunks)
     }
     m_tractor->lock();
     for (const auto &ix : chunks) {
-        if (m_previewTrack->is_blank_at(ix.toInt())) {
-            QString fileName = m_cacheDir.absoluteFilePath(QStringLiteral("%1.%2").arg(ix.toInt()).arg(m_extension));
-            fileName.prepend(QStringLiteral("avformat:"));
+        const QString file = storedChunk(ix.toInt());
+        if (!file.isEmpty() && m_previewTrack->is_blank_at(ix.toInt())) {
+            const QString fileName = QStringLiteral("avformat:") + file;
             Mlt::Producer prod(pCore->getCurrentProfile()->profile(), fileName.toUtf8().constData());
             if (prod.is_valid()) {
                 // m_ruler->updatePreview(ix, true);
@@ -700,12 +1090,9 @@ void PreviewManager::gotPreviewRender(int frame, const QString &file, int progre
 
 void PreviewManager::corruptedChunk(int frame, const QString &fileName)
 {
-    emit abortPreview();
-    m_previewProcess.waitForFinished();
-    if (workingPreview >= 0) {
-        workingPreview = -1;
-        m_controller->workingPreviewChanged();
-    }
+    m_renderQueue.clear();
+    abortRendering();
+    updateWorkingPreview();
     emit previewRender(0, m_errorLog, -1);
     m_cacheDir.remove(fileName);
     m_dirtyChunks << frame;
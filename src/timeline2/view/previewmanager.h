@@ -24,9 +24,13 @@
 
 #include <QDir>
 #include <QFuture>
+#include <QHash>
 #include <QMutex>
 #include <QProcess>
+#include <QSet>
 #include <QTimer>
+#include <memory>
+#include <vector>
 
 class TimelineController;
 
@@ -66,8 +70,10 @@ public:
     void addPreviewRange(const QPoint zone, bool add);
     /** @brief: Remove all existing previews. */
     void clearPreviewRange(bool resetZones);
-    /** @brief: stops current rendering process. */
+    /** @brief: stops current rendering processes. */
     void abortRendering();
+    /** @brief: Returns true if a render worker is running. */
+    bool isRendering() const;
     /** @brief: rendering parameters have changed, reload them. */
     bool loadParams();
     /** @brief: Create the preview track if not existing. */
@@ -81,7 +87,7 @@ public:
     /** @brief: Returns directory currently used to store the preview files. */
     const QDir getCacheDir() const;
     /** @brief: Load existing ruler chunks. */
-    void loadChunks(QVariantList previewChunks, QVariantList dirtyChunks, const QDateTime &documentDate);
+    void loadChunks(QVariantList previewChunks, QVariantList dirtyChunks);
     int setOverlayTrack(Mlt::Playlist *overlay);
     /** @brief Remove the effect compare overlay track */
     void removeOverlayTrack();
@@ -101,12 +107,40 @@ private:
     int m_previewTrackIndex;
     /** @brief: The kdenlive renderer app. */
     QString m_renderer;
-    /** @brief: The kdenlive timeline preview process. */
-    QProcess m_previewProcess;
+    /** @brief: A kdenlive_render server process, rendering chunks sent on its stdin one at a time. It stays alive between renders. */
+    struct RenderWorker
+    {
+        QProcess process;
+        /** @brief: The chunk being rendered, -1 if idle */
+        int chunk{-1};
+        /** @brief: The render job whose playlist was last sent to this worker */
+        int job{-1};
+    };
+    /** @brief: The timeline preview render processes. */
+    std::vector<std::unique_ptr<RenderWorker>> m_workers;
+    /** @brief: Chunks waiting for a free worker, nearest to the playhead first. */
+    QList<int> m_renderQueue;
+    /** @brief: The playlist rendered by the workers, deleted when they are all finished. */
+    QString m_renderScene;
+    /** @brief: A chunk could not be rendered, the render is reported as failed when the last busy worker is done. */
+    bool m_renderFailed{false};
+    /** @brief: Chunks whose worker crashed during the current render. They are rendered again once. */
+    QList<int> m_crashedChunks;
+    /** @brief: True while the busy workers are killed. */
+    bool m_aborting{false};
+    /** @brief: Incremented for each render, to know which workers need the new playlist. */
+    int m_renderJob{0};
+    /** @brief: Stops the render servers after a while without rendering. */
+    QTimer m_workerIdleTimer;
     /** @brief: The directory used to store the preview files. */
     QDir m_cacheDir;
-    /** @brief: The directory used to store undo history of preview files (child of m_cacheDir). */
-    QDir m_undoDir;
+    /** @brief: The directory storing rendered chunks by content hash, shared between projects. */
+    QDir m_storeDir;
+    /** @brief: The content hash of the chunks, by frame. */
+    QHash<int, QString> m_chunkKeys;
+    QFuture<void> m_evictionThread;
+    /** @brief: True once the chunks of previous versions were moved to the store. */
+    bool m_legacyChecked{false};
     QMutex m_previewMutex;
     QStringList m_consumerParams;
     QString m_extension;
@@ -127,18 +161,37 @@ private:
     void reloadChunks(const QVariantList chunks);
     /** @brief: A chunk failed to render, abort. */
     void corruptedChunk(int workingPreview, const QString &fileName);
+    /** @brief: Returns a hash of everything that is rendered in the chunk starting at frame: producers and their range, filters, transitions and render
+     * parameters. Must be called with the tractor locked. */
+    QString chunkKey(int frame) const;
+    /** @brief: Compute the content hash of the given chunks. */
+    void updateChunkKeys(const QVariantList &frames);
+    /** @brief: Returns the stored file matching the current content of a chunk, or an empty string if it was never rendered. */
+    QString storedChunk(int frame) const;
+    /** @brief: Delete the least recently used chunks from the store when it exceeds the configured size. */
+    void evictStoredChunks();
+    /** @brief: Delete the oldest files of store, except the used ones, until its size is below limit. */
+    static void evictChunks(const QDir &store, const QSet<QString> &used, qint64 limit);
+    /** @brief: Move the chunks stored by previous versions in cacheDir to storeDir, under the key of their frame. Unlisted chunks are deleted. */
+    static void migrateLegacyChunks(const QDir &cacheDir, const QDir &storeDir, const QString &extension, const QHash<int, QString> &renderedKeys);
+    /** @brief: Send the next queued chunk to a worker, or close its input if there is nothing left. */
+    void dispatchChunk(RenderWorker *worker);
+    /** @brief: Process the render output of a worker. */
+    void receivedStderr(RenderWorker *worker);
+    /** @brief: A worker process exited. */
+    void workerFinished(RenderWorker *worker, QProcess::ExitStatus status);
+    /** @brief: Update the chunk displayed as being rendered in the ruler. */
+    void updateWorkingPreview();
+    /** @brief: All queued chunks were processed or the render was aborted. A render where a chunk failed is never reported as successful. */
+    void renderFinished(bool success);
+    /** @brief: Let the workers that are not rendering exit. */
+    void stopIdleWorkers();
 
 private slots:
-    /** @brief: To avoid filling the hard drive, remove preview undo history after 5 steps. */
-    void doCleanupOldPreviews();
     /** @brief: Start the real rendering process. */
     void doPreviewRender(const QString &scene); // std::shared_ptr<Mlt::Producer> sourceProd);
-    /** @brief: If user does an undo, then makes a new timeline operation, delete undo history of more recent stack . */
-    void slotRemoveInvalidUndo(int ix);
     /** @brief: When the timer collecting invalid zones is done, process. */
     void slotProcessDirtyChunks();
-    /** @brief: Process preview rendering output. */
-    void receivedStderr();
 
 public slots:
     /** @brief: Prepare and start rendering. */
@@ -152,7 +205,6 @@ protected:
 
 signals:
     void abortPreview();
-    void cleanupOldPreviews();
     void previewRender(int frame, const QString &file, int progress);
 };
 
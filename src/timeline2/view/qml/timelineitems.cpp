@@ -23,6 +23,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "kdenlivesettings.h"
 #include "core.h"
 #include "bin/projectitemmodel.h"
+#include "lib/audio/audioPeaks.h"
 #include <QPainter>
 #include <QPainterPath>
 #include <QPalette>
@@ -97,8 +98,9 @@ public:
         setMipmap(true);
         setTextureSize(QSize(width(), height()));
         connect(this, &TimelineWaveform::levelsChanged, [&]() {
-            if (!m_binId.isEmpty() && m_audioLevels.isEmpty()) {
+            if (!m_binId.isEmpty() && (m_audioLevels.isEmpty() || !m_peaks)) {
                 m_audioLevels = pCore->projectItemModel()->getAudioLevelsByBinID(m_binId);
+                m_peaks = pCore->projectItemModel()->getAudioPeaksByBinID(m_binId);
                 update();
             }
         });
@@ -109,7 +111,14 @@ public:
 
     void paint(QPainter *painter) override
     {
-        if (!m_showItem || m_audioLevels.isEmpty()) {
+        if (!m_showItem) {
+            return;
+        }
+        if (m_peaks && m_peaks->channels() == m_channels) {
+            paintPeaks(painter);
+            return;
+        }
+        if (m_audioLevels.isEmpty()) {
             return;
         }
         qreal indicesPrPixel = qreal(m_outPoint - m_inPoint) / width();
@@ -189,6 +198,101 @@ public:
         }
     }
 
+    /** @brief Draw the waveform from the audio peaks, using the decimation level matching the current zoom */
+    void paintPeaks(QPainter *painter)
+    {
+        // in and out points are expressed in frame * channels
+        double samplesPerFrame = m_peaks->sampleRate() / pCore->getCurrentFps();
+        double firstSample = double(m_inPoint) / m_channels * samplesPerFrame;
+        double samplesPerPixel = double(m_outPoint - m_inPoint) / m_channels * samplesPerFrame / width();
+        if (qFuzzyIsNull(samplesPerPixel)) {
+            return;
+        }
+        int peakLevel = m_peaks->levelForResolution(qAbs(samplesPerPixel));
+        // Returns the peak of a channel for the pixel starting at x, normalized in [-1, 1]
+        auto peakAt = [&](int x, int channel, double &min, double &max) {
+            double start = firstSample + x * samplesPerPixel;
+            double end = start + samplesPerPixel;
+            qint16 low, high;
+            if (!m_peaks->peak(peakLevel, channel, (qint64)floor(qMin(start, end)), (qint64)ceil(qMax(start, end)), low, high)) {
+                return false;
+            }
+            min = low / 32768.;
+            max = high / 32768.;
+            return true;
+        };
+        const int pixels = (int)ceil(width());
+        QPen pen = painter->pen();
+        pen.setColor(m_color);
+        pen.setWidthF(0);
+        painter->setBrush(m_color);
+        if (!KdenliveSettings::displayallchannels()) {
+            // Draw merged channels
+            QPainterPath path;
+            path.moveTo(-1, height());
+            int x = 0;
+            for (; x <= pixels; ++x) {
+                double level = 0;
+                bool valid = false;
+                for (int channel = 0; channel < m_channels; channel++) {
+                    double min, max;
+                    if (peakAt(x, channel, min, max)) {
+                        level = qMax(level, qMax(-min, max));
+                        valid = true;
+                    }
+                }
+                if (!valid) {
+                    break;
+                }
+                path.lineTo(x, height() - qMin(level, 1.) * height());
+            }
+            path.lineTo(x, height());
+            painter->drawPath(path);
+            return;
+        }
+        double channelHeight = height() / (2 * m_channels);
+        QFont font = painter->font();
+        font.setPixelSize(channelHeight - 1);
+        painter->setFont(font);
+        // Draw separate channels, with their minimum and maximum values around the median line
+        QRectF bgRect(0, 0, width(), 2 * channelHeight);
+        for (int channel = 0; channel < m_channels; channel++) {
+            double y = height() - (2 * channel * channelHeight) - channelHeight;
+            painter->setOpacity(0.2);
+            if (channel % 2 == 0) {
+                // Add dark background on odd channels
+                bgRect.moveTo(0, y - channelHeight);
+                painter->fillRect(bgRect, Qt::black);
+            }
+            // Draw channel median line
+            painter->setPen(pen);
+            painter->drawLine(QLineF(0., y, width(), y));
+            painter->setOpacity(1);
+            QPolygonF upper, lower;
+            upper.reserve(pixels + 1);
+            lower.reserve(pixels + 1);
+            for (int x = 0; x <= pixels; ++x) {
+                double min, max;
+                if (!peakAt(x, channel, min, max)) {
+                    break;
+                }
+                upper << QPointF(x, y - qMin(max, 1.) * channelHeight);
+                lower << QPointF(x, y - qMax(min, -1.) * channelHeight);
+            }
+            if (m_firstChunk && m_channels > 1 && m_channels < 7) {
+                painter->drawText(2, y + channelHeight, chanelNames[channel]);
+            }
+            if (upper.isEmpty()) {
+                continue;
+            }
+            for (int i = lower.size() - 1; i >= 0; --i) {
+                upper << lower.at(i);
+            }
+            painter->setPen(Qt::NoPen);
+            painter->drawPolygon(upper);
+        }
+    }
+
 signals:
     void levelsChanged();
     void propertyChanged();
@@ -199,6 +303,7 @@ signals:
 
 private:
     QList<double> m_audioLevels;
+    std::shared_ptr<AudioPeaks> m_peaks;
     int m_inPoint;
     int m_outPoint;
     QString m_binId;
@@ -22,101 +22,243 @@
 #include "core.h"
 #include "utils/thumbnailcache.hpp"
 
-#include <QCryptographicHash>
 #include <QDebug>
-#include <QQuickImageProvider>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <algorithm>
 #include <mlt++/MltFilter.h>
 #include <mlt++/MltProfile.h>
 
+namespace {
+// Maximum number of decoders working on the same clip
+const size_t maxDecodersPerClip = 2;
+// A second decoder is only started if that many requests are waiting for a clip
+const size_t secondDecoderQueue = 4;
+// Number of clips whose decoders are kept open when idle
+const size_t maxOpenClips = 12;
+} // namespace
+
+class ThumbnailDecodeTask : public QRunnable
+{
+public:
+    ThumbnailDecodeTask(ThumbnailProvider *provider, QString binId, std::shared_ptr<ThumbnailProvider::Decoder> decoder)
+        : m_provider(provider)
+        , m_binId(std::move(binId))
+        , m_decoder(std::move(decoder))
+    {
+    }
+    void run() override { m_provider->runDecoder(m_binId, m_decoder); }
+
+private:
+    ThumbnailProvider *m_provider;
+    QString m_binId;
+    std::shared_ptr<ThumbnailProvider::Decoder> m_decoder;
+};
+
 ThumbnailProvider::ThumbnailProvider()
-    : QQuickImageProvider(QQmlImageProviderBase::Image, QQmlImageProviderBase::ForceAsynchronousImageLoading)
-//, m_profile(pCore->getCurrentProfilePath().toUtf8().constData())
+    : QQuickAsyncImageProvider()
 {
+    m_pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount() / 2));
 }
 
-ThumbnailProvider::~ThumbnailProvider() = default;
+ThumbnailProvider::~ThumbnailProvider()
+{
+    std::vector<ThumbnailResponse *> pending;
+    {
+        QMutexLocker locker(&m_mutex);
+        // Stop the decoders, the queued requests will not be processed
+        for (auto &clip : m_clips) {
+            pending.insert(pending.end(), clip.second.queue.begin(), clip.second.queue.end());
+            clip.second.queue.clear();
+        }
+    }
+    // The engine only releases a response once it is finished
+    for (ThumbnailResponse *response : pending) {
+        emit response->finished();
+    }
+    m_pool.waitForDone();
+}
 
 void ThumbnailProvider::resetProject()
 {
-    // m_producers.clear();
+    QMutexLocker locker(&m_mutex);
+    for (auto it = m_clips.begin(); it != m_clips.end();) {
+        // Running decoders stop by themselves once their clip is removed
+        it = it->second.queue.empty() ? m_clips.erase(it) : std::next(it);
+    }
+    m_recentClips.clear();
+    for (const auto &clip : m_clips) {
+        m_recentClips.push_back(clip.first);
+    }
 }
 
-QImage ThumbnailProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+QQuickImageResponse *ThumbnailProvider::requestImageResponse(const QString &id, const QSize &requestedSize)
 {
-    QImage result;
     // id is binID/#frameNumber
     QString binId = id.section('/', 0, 0);
     bool ok;
     int frameNumber = id.section('#', -1).toInt(&ok);
-    if (ok) {
-        if (ThumbnailCache::get()->hasThumbnail(binId, frameNumber, false)) {
-            result = ThumbnailCache::get()->getThumbnail(binId, frameNumber);
-            *size = result.size();
-            return result;
+    auto *response = new ThumbnailResponse(this, binId, frameNumber, requestedSize);
+    if (!ok) {
+        response->finishLater();
+    } else if (ThumbnailCache::get()->hasThumbnail(binId, frameNumber, false)) {
+        response->m_image = ThumbnailCache::get()->getThumbnail(binId, frameNumber);
+        response->finishLater();
+    } else {
+        enqueue(response);
+    }
+    return response;
+}
+
+void ThumbnailProvider::enqueue(ThumbnailResponse *response)
+{
+    std::shared_ptr<ProjectClip> binClip = pCore->projectItemModel()->getClipByBinID(response->m_binId);
+    if (!binClip) {
+        response->finishLater();
+        return;
+    }
+    const int generation = binClip->thumbProducerGeneration();
+    QMutexLocker locker(&m_mutex);
+    ClipDecoders &clip = m_clips[response->m_binId];
+    m_recentClips.remove(response->m_binId);
+    m_recentClips.push_front(response->m_binId);
+    if (clip.generation != generation) {
+        // The clip was reloaded, busy decoders stop after their current frame
+        clip.decoders.clear();
+        clip.generation = generation;
+    }
+    clip.queue.push_back(response);
+    std::shared_ptr<Decoder> decoder;
+    for (const auto &d : clip.decoders) {
+        if (!d->busy) {
+            decoder = d;
+            break;
         }
-        std::shared_ptr<ProjectClip> binClip = pCore->projectItemModel()->getClipByBinID(binId);
-        if (binClip) {
-            std::shared_ptr<Mlt::Producer> prod = binClip->thumbProducer();
-            if (prod && prod->is_valid()) {
-                result = makeThumbnail(prod, frameNumber, requestedSize);
-                ThumbnailCache::get()->storeThumbnail(binId, frameNumber, result, false);
-            }
+    }
+    if (!decoder && (clip.decoders.empty() || (clip.decoders.size() < maxDecodersPerClip && clip.queue.size() >= secondDecoderQueue))) {
+        decoder = std::make_shared<Decoder>();
+        clip.decoders.push_back(decoder);
+    }
+    if (decoder) {
+        decoder->busy = true;
+        m_pool.start(new ThumbnailDecodeTask(this, response->m_binId, decoder));
+    }
+    releaseIdleClips();
+}
+
+bool ThumbnailProvider::dequeue(ThumbnailResponse *response)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_clips.find(response->m_binId);
+    if (it != m_clips.end()) {
+        auto &queue = it->second.queue;
+        auto pos = std::find(queue.begin(), queue.end(), response);
+        if (pos != queue.end()) {
+            queue.erase(pos);
+            return true;
         }
+    }
+    // A decoder already took the request, it will not decode it
+    response->m_canceled = true;
+    return false;
+}
 
-        /*if (m_producers.contains(binId.toInt())) {
-            producer = m_producers.object(binId.toInt());
-        } else {
-            m_binClip->thumbProducer();
-            if (!resource.isEmpty()) {
-                producer = new Mlt::Producer(m_profile, service.toUtf8().constData(), resource.toUtf8().constData());
-            } else {
-                producer = new Mlt::Producer(m_profile, service.toUtf8().constData());
+ThumbnailResponse *ThumbnailProvider::takeNext(ClipDecoders &clip, const Decoder &decoder)
+{
+    // Prefer the closest frame after the decoder position, so that we keep reading forward.
+    // Otherwise restart from the first requested frame
+    auto best = clip.queue.end();
+    auto first = clip.queue.end();
+    for (auto it = clip.queue.begin(); it != clip.queue.end(); ++it) {
+        const int frame = (*it)->m_frame;
+        if (first == clip.queue.end() || frame < (*first)->m_frame) {
+            first = it;
+        }
+        if (frame >= decoder.position && (best == clip.queue.end() || frame < (*best)->m_frame)) {
+            best = it;
+        }
+    }
+    if (best == clip.queue.end()) {
+        best = first;
+    }
+    if (best == clip.queue.end()) {
+        return nullptr;
+    }
+    ThumbnailResponse *response = *best;
+    clip.queue.erase(best);
+    return response;
+}
+
+void ThumbnailProvider::runDecoder(const QString &binId, const std::shared_ptr<Decoder> &decoder)
+{
+    while (true) {
+        ThumbnailResponse *response = nullptr;
+        {
+            QMutexLocker locker(&m_mutex);
+            auto it = m_clips.find(binId);
+            if (it == m_clips.end() || std::find(it->second.decoders.begin(), it->second.decoders.end(), decoder) == it->second.decoders.end()) {
+                // Clip reloaded or removed
+                decoder->busy = false;
+                return;
             }
-            std::shared_ptr<ProjectClip> binClip = pCore->projectItemModel()->getClipByBinID(binId);
-            if (binClip) {
-                std::shared_ptr<Mlt::Producer> projectProducer = binClip->originalProducer();
-                Mlt::Properties original(projectProducer->get_properties());
-                Mlt::Properties cloneProps(producer->get_properties());
-                cloneProps.pass_list(original, "video_index,force_aspect_num,force_aspect_den,force_aspect_ratio,force_fps,force_progressive,force_tff,"
-                "force_colorspace,set.force_full_luma,templatetext,autorotate,xmldata");
+            response = takeNext(it->second, *decoder);
+            if (response == nullptr) {
+                decoder->busy = false;
+                return;
             }
-            Mlt::Filter scaler(m_profile, "swscale");
-            Mlt::Filter padder(m_profile, "resize");
-            Mlt::Filter converter(m_profile, "avcolor_space");
-            producer->attach(scaler);
-            producer->attach(padder);
-            producer->attach(converter);
-            m_producers.insert(binId.toInt(), producer);
         }
-        if ((producer != nullptr) && producer->is_valid()) {
-            // result = KThumb::getFrame(producer, frameNumber, 0, 0);
-            result = makeThumbnail(producer, frameNumber, requestedSize);
-            ThumbnailCache::get()->storeThumbnail(binId, frameNumber, result, false);
-            //m_cache->insertImage(key, result);
-        } else {
-            qDebug() << "INVALID PRODUCER; " << service << " / " << resource;
-        }*/
+        const int frameNumber = response->m_frame;
+        if (ThumbnailCache::get()->hasThumbnail(binId, frameNumber, false)) {
+            response->m_image = ThumbnailCache::get()->getThumbnail(binId, frameNumber);
+        } else if (!isCanceled(response)) {
+            if (!decoder->producer) {
+                // Open the decoder outside of the lock, this can be slow
+                std::shared_ptr<ProjectClip> binClip = pCore->projectItemModel()->getClipByBinID(binId);
+                if (binClip) {
+                    decoder->producer = binClip->createThumbProducer();
+                }
+            }
+            if (decoder->producer && decoder->producer->is_valid()) {
+                response->m_image = makeThumbnail(decoder->producer, frameNumber, response->m_requestedSize);
+                decoder->position = frameNumber + 1;
+                ThumbnailCache::get()->storeThumbnail(binId, frameNumber, response->m_image, false);
+            }
+        }
+        emit response->finished();
     }
-    if (size) *size = result.size();
-    return result;
 }
 
-QString ThumbnailProvider::cacheKey(Mlt::Properties &properties, const QString &service, const QString &resource, const QString &hash, int frameNumber)
+bool ThumbnailProvider::isCanceled(ThumbnailResponse *response)
 {
-    QString time = properties.frames_to_time(frameNumber, mlt_time_clock);
-    // Reduce the precision to centiseconds to increase chance for cache hit
-    // without much loss of accuracy.
-    time = time.left(time.size() - 1);
-    QString key;
-    if (hash.isEmpty()) {
-        key = QString("%1 %2 %3").arg(service).arg(resource).arg(time);
-        QCryptographicHash hash2(QCryptographicHash::Sha1);
-        hash2.addData(key.toUtf8());
-        key = hash2.result().toHex();
-    } else {
-        key = QString("%1 %2").arg(hash).arg(time);
+    QMutexLocker locker(&m_mutex);
+    return response->m_canceled;
+}
+
+void ThumbnailProvider::releaseIdleClips()
+{
+    if (m_recentClips.size() <= maxOpenClips) {
+        return;
+    }
+    auto it = m_recentClips.begin();
+    std::advance(it, maxOpenClips);
+    while (it != m_recentClips.end()) {
+        auto clip = m_clips.find(*it);
+        bool idle = clip == m_clips.end() || clip->second.queue.empty();
+        if (idle && clip != m_clips.end()) {
+            for (const auto &decoder : clip->second.decoders) {
+                idle = idle && !decoder->busy;
+            }
+        }
+        if (idle) {
+            if (clip != m_clips.end()) {
+                m_clips.erase(clip);
+            }
+            it = m_recentClips.erase(it);
+        } else {
+            ++it;
+        }
     }
-    return key;
 }
 
 QImage ThumbnailProvider::makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frameNumber, const QSize &requestedSize)
@@ -19,25 +19,98 @@
 #ifndef THUMBNAILPROVIDER_H
 #define THUMBNAILPROVIDER_H
 
-#include <KImageCache>
-#include <QCache>
+#include "definitions.h"
+
+#include <QMutex>
 #include <QQuickImageProvider>
+#include <QThreadPool>
+#include <list>
 #include <memory>
 #include <mlt++/MltProducer.h>
-#include <mlt++/MltProfile.h>
+#include <unordered_map>
+#include <vector>
+
+class ThumbnailResponse;
 
-class ThumbnailProvider : public QQuickImageProvider
+/** @brief Provides the timeline clip thumbnails.
+    Each clip has a small pool of decoders (independent thumbnail producers). Pending requests are kept per clip and each decoder always takes the
+    closest request after its current position, so that a row of thumbnails is decoded with forward reads instead of seeking back and forth.
+    Requests canceled by QML (for example when the clip is scrolled out of view) are removed from the queue, or skipped by the decoder that took them.
+ */
+class ThumbnailProvider : public QQuickAsyncImageProvider
 {
 public:
     explicit ThumbnailProvider();
     ~ThumbnailProvider() override;
-    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+    QQuickImageResponse *requestImageResponse(const QString &id, const QSize &requestedSize) override;
     void resetProject();
 
 private:
-    QString cacheKey(Mlt::Properties &properties, const QString &service, const QString &resource, const QString &hash, int frameNumber);
-    QImage makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frameNumber, const QSize &requestedSize);
-    QCache<int, Mlt::Producer> m_producers;
+    struct Decoder
+    {
+        std::shared_ptr<Mlt::Producer> producer;
+        int position{-1};
+        bool busy{false};
+    };
+    struct ClipDecoders
+    {
+        std::vector<std::shared_ptr<Decoder>> decoders;
+        std::vector<ThumbnailResponse *> queue;
+        int generation{0};
+    };
+    friend class ThumbnailResponse;
+    friend class ThumbnailDecodeTask;
+
+    static QImage makeThumbnail(const std::shared_ptr<Mlt::Producer> &producer, int frameNumber, const QSize &requestedSize);
+    // Queue a request and start a decoder if possible
+    void enqueue(ThumbnailResponse *response);
+    // Remove a canceled request from the queue. Returns false if a decoder already took it, the request is then marked as canceled
+    bool dequeue(ThumbnailResponse *response);
+    // Returns true if a request taken by a decoder was canceled since
+    bool isCanceled(ThumbnailResponse *response);
+    // Process the requests of a clip with one of its decoders until the queue is empty
+    void runDecoder(const QString &binId, const std::shared_ptr<Decoder> &decoder);
+    // Pick the next request for a decoder. Must be called with m_mutex held
+    ThumbnailResponse *takeNext(ClipDecoders &clip, const Decoder &decoder);
+    // Release the decoders of clips that were not used recently. Must be called with m_mutex held
+    void releaseIdleClips();
+
+    QMutex m_mutex;
+    QThreadPool m_pool;
+    std::unordered_map<QString, ClipDecoders> m_clips;
+    // Most recently used clip first
+    std::list<QString> m_recentClips;
+};
+
+/** @brief A thumbnail requested by QML. It is finished once decoded, or when it was canceled before a decoder took it.
+    A request canceled after that is finished by its decoder, without being decoded */
+class ThumbnailResponse : public QQuickImageResponse
+{
+public:
+    ThumbnailResponse(ThumbnailProvider *provider, QString binId, int frame, const QSize &requestedSize)
+        : m_provider(provider)
+        , m_binId(std::move(binId))
+        , m_frame(frame)
+        , m_requestedSize(requestedSize)
+    {
+    }
+    QQuickTextureFactory *textureFactory() const override { return QQuickTextureFactory::textureFactoryForImage(m_image); }
+    void cancel() override
+    {
+        if (m_provider->dequeue(this)) {
+            emit finished();
+        }
+    }
+    // Emit finished from the event loop, the engine is not yet connected when the response is created
+    void finishLater() { QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection); }
+
+    ThumbnailProvider *m_provider;
+    QString m_binId;
+    int m_frame;
+    QSize m_requestedSize;
+    QImage m_image;
+    // Protected by the mutex of the provider
+    bool m_canceled{false};
 };
 
 #endif // THUMBNAILPROVIDER_H
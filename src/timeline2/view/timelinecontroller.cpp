@@ -1198,7 +1198,7 @@ void TimelineController::disablePreview(bool disable)
                 m_timelinePreview->reconnectTrack();
                 m_model->m_tractor->unlock();
             }
-            m_timelinePreview->loadChunks(QVariantList(), QVariantList(), QDateTime());
+            m_timelinePreview->loadChunks(QVariantList(), QVariantList());
             m_usePreview = true;
         }
     }
@@ -1233,7 +1233,7 @@ void TimelineController::resetPreview()
     }
 }
 
-void TimelineController::loadPreview(const QString &chunks, const QString &dirty, const QDateTime &documentDate, int enable)
+void TimelineController::loadPreview(const QString &chunks, const QString &dirty, int enable)
 {
     if (chunks.isEmpty() && dirty.isEmpty()) {
         return;
@@ -1259,7 +1259,7 @@ void TimelineController::loadPreview(const QString &chunks, const QString &dirty
         m_usePreview = true;
         m_model->m_overlayTrackCount = m_timelinePreview->addedTracks();
     }
-    m_timelinePreview->loadChunks(renderedChunks, dirtyChunks, documentDate);
+    m_timelinePreview->loadChunks(renderedChunks, dirtyChunks);
 }
 
 QMap<QString, QString> TimelineController::documentProperties()
@@ -22,7 +22,101 @@
 #include "undohelper.hpp"
 #include "logger.hpp"
 #include <QDebug>
+#include <QReadWriteLock>
+#include <algorithm>
+#include <limits>
 #include <utility>
+
+bool FunList::operator()() const
+{
+    // Push order of the first operation that failed
+    size_t firstFailure = std::numeric_limits<size_t>::max();
+    auto run = [&firstFailure](const Entry &entry) {
+        if (entry.mode == Mode::SkipAfterFailure && firstFailure < entry.sequence) {
+            return true;
+        }
+        bool v = entry.operation();
+        if (!v) {
+            firstFailure = std::min(firstFailure, entry.sequence);
+        }
+        return v || entry.mode != Mode::StopOnFailure;
+    };
+    for (auto it = m_front.rbegin(); it != m_front.rend(); ++it) {
+        if (!run(*it)) {
+            return false;
+        }
+    }
+    for (const Entry &entry : m_back) {
+        if (!run(entry)) {
+            return false;
+        }
+    }
+    return firstFailure == std::numeric_limits<size_t>::max();
+}
+
+void FunList::pushBack(const Fun &operation, Mode mode)
+{
+    m_back.push_back({operation, mode, m_nextSequence++});
+}
+
+void FunList::pushFront(const Fun &operation, Mode mode)
+{
+    m_front.push_back({operation, mode, m_nextSequence++});
+}
+
+size_t FunList::size() const
+{
+    size_t count = 0;
+    for (const auto *list : {&m_front, &m_back}) {
+        for (const Entry &entry : *list) {
+            count += UndoHelper::operationCount(entry.operation);
+        }
+    }
+    return count;
+}
+
+bool LockedFun::operator()() const
+{
+    lock->lockForWrite();
+    bool res_lambda = operation();
+    lock->unlock();
+    return res_lambda;
+}
+
+void UndoHelper::pushBack(Fun &lambda, const Fun &operation, FunList::Mode mode)
+{
+    // operation may be an alias of lambda, so copy it before modifying lambda
+    Fun op = operation;
+    if (lambda.target<FunList>() == nullptr) {
+        FunList list;
+        list.pushBack(lambda, FunList::Mode::Always);
+        lambda = std::move(list);
+    }
+    lambda.target<FunList>()->pushBack(op, mode);
+}
+
+void UndoHelper::pushFront(Fun &lambda, const Fun &operation, FunList::Mode mode)
+{
+    Fun op = operation;
+    if (lambda.target<FunList>() == nullptr) {
+        FunList list;
+        list.pushBack(lambda, FunList::Mode::Always);
+        lambda = std::move(list);
+    }
+    lambda.target<FunList>()->pushFront(op, mode);
+}
+
+size_t UndoHelper::operationCount(const Fun &lambda)
+{
+    if (const auto *list = lambda.target<FunList>()) {
+        return list->size();
+    }
+    if (const auto *locked = lambda.target<LockedFun>()) {
+        return operationCount(locked->operation);
+    }
+    return 1;
+}
+
 FunctionalUndoCommand::FunctionalUndoCommand(Fun undo, Fun redo, const QString &text, QUndoCommand *parent)
     : QUndoCommand(parent)
     , m_undo(std::move(undo))
@@ -30,6 +124,17 @@ FunctionalUndoCommand::FunctionalUndoCommand(Fun undo, Fun redo, const QString &
     , m_undone(false)
 {
     setText(text);
+    m_operationCount = UndoHelper::operationCount(m_undo) + UndoHelper::operationCount(m_redo);
+}
+
+size_t FunctionalUndoCommand::operationCount() const
+{
+    return m_operationCount;
+}
+
+FunctionalUndoCommand *FunctionalUndoCommand::clone() const
+{
+    return new FunctionalUndoCommand(m_undo, m_redo, text());
 }
 
 void FunctionalUndoCommand::undo()
@@ -21,25 +21,72 @@
 
 #ifndef UNDOHELPER_H
 #define UNDOHELPER_H
+#include <cstddef>
 #include <functional>
+#include <vector>
 
 using Fun = std::function<bool(void)>;
 
-/* @brief this macro executes an operation after a given lambda
+class QReadWriteLock;
+
+/* @brief A flat list of operations, that can be stored in a Fun.
+   Pushing an operation on a Fun holding such a list appends it to the list, instead of wrapping the previous function in a new closure. This way, big
+   operations (group moves, extracts, paste...) don't build deep chains of nested lambdas that are slow to run and can overflow the stack when executed. It
+   also lets the undo stack know how many operations a command holds.
+   Operations are executed iteratively: first the ones pushed in front (last pushed first), then the ones pushed at the back (in push order).
+   As with nested lambdas, the failure of an operation only affects the operations that were pushed after it, whatever their execution order.
  */
-#define PUSH_LAMBDA(operation, lambda)                                                                                                                         \
-    lambda = [lambda, operation]() {                                                                                                                           \
-        bool v = lambda();                                                                                                                                     \
-        return v && operation();                                                                                                                               \
+class FunList
+{
+public:
+    enum class Mode {
+        Always,           // the operation is always executed
+        SkipAfterFailure, // the operation is not executed if one pushed before it failed (PUSH_LAMBDA)
+        StopOnFailure     // if the operation fails, the following ones are not executed (PUSH_FRONT_LAMBDA)
     };
 
+    bool operator()() const;
+    void pushBack(const Fun &operation, Mode mode);
+    void pushFront(const Fun &operation, Mode mode);
+    /* @brief Number of operations stored, nested lists included */
+    size_t size() const;
+
+private:
+    struct Entry
+    {
+        Fun operation;
+        Mode mode;
+        size_t sequence; // push order of the operation
+    };
+    std::vector<Entry> m_front; // stored in reverse execution order
+    std::vector<Entry> m_back;
+    size_t m_nextSequence{0};
+};
+
+/* @brief The operation built by LOCK_IN_LAMBDA: locks the given mutex while the operation is executed */
+struct LockedFun
+{
+    QReadWriteLock *lock;
+    Fun operation;
+    bool operator()() const;
+};
+
+namespace UndoHelper {
+/* @brief Appends an operation to the list held by lambda (the previous content of lambda becomes the first element of a new list if needed) */
+void pushBack(Fun &lambda, const Fun &operation, FunList::Mode mode);
+/* @brief Same as pushBack, but the operation is executed before the content of lambda */
+void pushFront(Fun &lambda, const Fun &operation, FunList::Mode mode);
+/* @brief Returns the number of operations held by a function built from the undo helpers (1 for a plain function) */
+size_t operationCount(const Fun &lambda);
+} // namespace UndoHelper
+
+/* @brief this macro executes an operation after a given lambda
+ */
+#define PUSH_LAMBDA(operation, lambda) UndoHelper::pushBack(lambda, operation, FunList::Mode::SkipAfterFailure);
+
 /* @brief this macro executes an operation before a given lambda
  */
-#define PUSH_FRONT_LAMBDA(operation, lambda)                                                                                                                   \
-    lambda = [lambda, operation]() {                                                                                                                           \
-        bool v = operation();                                                                                                                                  \
-        return v && lambda();                                                                                                                                  \
-    };
+#define PUSH_FRONT_LAMBDA(operation, lambda) UndoHelper::pushFront(lambda, operation, FunList::Mode::StopOnFailure);
 
 #include <QUndoCommand>
 
@@ -54,10 +101,15 @@ public:
     FunctionalUndoCommand(Fun undo, Fun redo, const QString &text, QUndoCommand *parent = nullptr);
     void undo() override;
     void redo() override;
+    /* @brief Number of operations stored in the undo and redo functions of the command */
+    size_t operationCount() const;
+    /* @brief Returns a copy of the command that was not undone yet, so that pushing it on a stack doesn't execute it */
+    FunctionalUndoCommand *clone() const;
 
 private:
     Fun m_undo, m_redo;
     bool m_undone;
+    size_t m_operationCount;
 };
 
 #endif
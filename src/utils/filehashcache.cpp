@@ -0,0 +1,179 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "filehashcache.hpp"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QtConcurrent>
+
+std::unique_ptr<FileHashCache> FileHashCache::instance;
+std::once_flag FileHashCache::m_onceFlag;
+
+namespace {
+// Size of the hashed parts at the start and end of the file
+const qint64 hashedPart = 1000000;
+// Beyond that, the stored hashes are mostly of files that changed or disappeared, start again
+const size_t maxEntries = 200000;
+} // namespace
+
+FileHashCache::FileHashCache() = default;
+
+std::unique_ptr<FileHashCache> &FileHashCache::get()
+{
+    std::call_once(m_onceFlag, [] { instance.reset(new FileHashCache()); });
+    return instance;
+}
+
+// static
+QString FileHashCache::storagePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/filehashes");
+}
+
+// static
+MediaProbeCache::FileKey FileHashCache::cacheKey(const QString &path, const MediaProbeCache::FileKey &fileKey)
+{
+    MediaProbeCache::FileKey key = fileKey;
+    if (key.inode == 0) {
+        key.inode = QCryptographicHash::hash(QFileInfo(path).absoluteFilePath().toUtf8(), QCryptographicHash::Md5).left(8).toHex().toULongLong(nullptr, 16);
+    }
+    return key;
+}
+
+void FileHashCache::load()
+{
+    if (m_loaded) {
+        return;
+    }
+    m_loaded = true;
+    QFile file(storagePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    // Each line is: inode size modification hash
+    while (!file.atEnd()) {
+        const QList<QByteArray> fields = file.readLine().trimmed().split(' ');
+        if (fields.size() != 4) {
+            continue;
+        }
+        MediaProbeCache::FileKey key;
+        key.inode = fields.at(0).toULongLong();
+        key.size = fields.at(1).toLongLong();
+        key.modified = fields.at(2).toLongLong();
+        m_hashes[key] = QString::fromLatin1(fields.at(3));
+    }
+    file.close();
+    if (m_hashes.size() > maxEntries) {
+        m_hashes.clear();
+        file.remove();
+    }
+}
+
+QString FileHashCache::hash(const QString &path, qint64 *size)
+{
+    MediaProbeCache::FileKey fileKey;
+    if (!MediaProbeCache::fileKey(path, fileKey)) {
+        return QString();
+    }
+    if (size) {
+        *size = fileKey.size;
+    }
+    const MediaProbeCache::FileKey key = cacheKey(path, fileKey);
+    {
+        QMutexLocker lock(&m_mutex);
+        load();
+        auto it = m_hashes.find(key);
+        if (it != m_hashes.end()) {
+            return it->second;
+        }
+    }
+    const QString result = computeHash(path);
+    if (result.isEmpty()) {
+        return result;
+    }
+    QMutexLocker lock(&m_mutex);
+    if (m_hashes.count(key) == 0) {
+        m_hashes[key] = result;
+        QDir().mkpath(QFileInfo(storagePath()).absolutePath());
+        QFile file(storagePath());
+        if (file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            file.write(QStringLiteral("%1 %2 %3 %4\n").arg(key.inode).arg(key.size).arg(key.modified).arg(result).toLatin1());
+        }
+    }
+    return result;
+}
+
+QMap<QString, QString> FileHashCache::hashFiles(const QStringList &paths)
+{
+    QMap<QString, QString> result;
+    QMutex resultMutex;
+    QStringList files = paths;
+    QtConcurrent::blockingMap(files, [this, &result, &resultMutex](const QString &path) {
+        const QString fileHash = hash(path);
+        if (!fileHash.isEmpty()) {
+            QMutexLocker lock(&resultMutex);
+            result.insert(path, fileHash);
+        }
+    });
+    return result;
+}
+
+// static
+QString FileHashCache::computeHash(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QString();
+    }
+    const qint64 size = file.size();
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    auto addRange = [&file, &hash](qint64 offset, qint64 length) {
+        if (length == 0) {
+            return true;
+        }
+        uchar *data = file.map(offset, length);
+        if (data != nullptr) {
+            hash.addData(reinterpret_cast<const char *>(data), (int)length);
+            file.unmap(data);
+            return true;
+        }
+        // Some file systems cannot be mapped
+        if (!file.seek(offset)) {
+            return false;
+        }
+        const QByteArray buffer = file.read(length);
+        hash.addData(buffer);
+        return buffer.size() == length;
+    };
+    bool ok;
+    if (size > 2 * hashedPart) {
+        ok = addRange(0, hashedPart) && addRange(size - hashedPart, hashedPart);
+    } else {
+        ok = addRange(0, size);
+    }
+    if (!ok) {
+        return QString();
+    }
+    return QString::fromLatin1(hash.result().toHex());
+}
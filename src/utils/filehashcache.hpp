@@ -0,0 +1,84 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#pragma once
+
+#include "utils/mediaprobecache.hpp"
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+/** @brief This class computes and remembers the hashes identifying media files, as stored in the kdenlive:file_hash property.
+    The hash is the MD5 of the first and last megabyte of the file (of the whole file if it is smaller than 2 MB).
+    It is saved in project files and used to find moved files, so it must not change.
+    Files are mapped in memory instead of read in a buffer, and several files can be hashed in parallel.
+    Results are kept on disk, keyed by the inode, size and modification time of the file, so an unchanged
+    file is never read again: neither when a project is reopened, nor when searching for a missing clip.
+ * Note that this class is a Singleton
+ */
+
+class FileHashCache
+{
+
+public:
+    // Returns the instance of the Singleton
+    static std::unique_ptr<FileHashCache> &get();
+
+    /* @brief Hash of a file, in hexadecimal. Empty if the file cannot be read
+       @param size if not null, receives the size of the file */
+    QString hash(const QString &path, qint64 *size = nullptr);
+
+    /* @brief Hash several files in parallel
+       @return the hash of each readable file */
+    QMap<QString, QString> hashFiles(const QStringList &paths);
+
+    /* @brief Compute the hash of a file, without using the cache */
+    static QString computeHash(const QString &path);
+
+protected:
+    // Constructor is protected because class is a Singleton
+    FileHashCache();
+
+    // Path of the file storing the hashes
+    static QString storagePath();
+    // Read the stored hashes, the first time they are needed. m_mutex must be locked
+    void load();
+
+    struct KeyHash
+    {
+        std::size_t operator()(const MediaProbeCache::FileKey &k) const
+        {
+            return std::hash<quint64>()(k.inode ^ (quint64(k.size) * 0x9E3779B97F4A7C15ULL) ^ quint64(k.modified));
+        }
+    };
+    // Files without an inode (on Windows) are identified by their path
+    static MediaProbeCache::FileKey cacheKey(const QString &path, const MediaProbeCache::FileKey &fileKey);
+
+    static std::unique_ptr<FileHashCache> instance;
+    static std::once_flag m_onceFlag; // flag to create the cache only once;
+
+    QMutex m_mutex;
+    bool m_loaded{false};
+    std::unordered_map<MediaProbeCache::FileKey, QString, KeyHash> m_hashes;
+};
@@ -0,0 +1,224 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "mediaprobecache.hpp"
+#include "bin/bin.h"
+#include "core.h"
+#include "kdenlive_debug.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <mlt++/MltProducer.h>
+#include <mlt++/MltProfile.h>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+std::unique_ptr<MediaProbeCache> MediaProbeCache::instance;
+std::once_flag MediaProbeCache::m_onceFlag;
+
+MediaProbeCache::MediaProbeCache()
+{
+    m_validator.setMaxThreadCount(1);
+}
+
+MediaProbeCache::~MediaProbeCache()
+{
+    cancelValidation();
+}
+
+std::unique_ptr<MediaProbeCache> &MediaProbeCache::get()
+{
+    std::call_once(m_onceFlag, [] { instance.reset(new MediaProbeCache()); });
+    return instance;
+}
+
+// static
+bool MediaProbeCache::fileKey(const QString &path, FileKey &key)
+{
+    QFileInfo info(path);
+    if (!info.isFile()) {
+        return false;
+    }
+    key.size = info.size();
+    key.modified = info.lastModified().toMSecsSinceEpoch();
+    key.inode = 0;
+#ifdef Q_OS_UNIX
+    // A file replaced by another one with the same size and date gets a new inode
+    struct stat buffer;
+    if (stat(QFile::encodeName(path).constData(), &buffer) == 0) {
+        key.inode = (quint64)buffer.st_ino;
+    }
+#endif
+    return true;
+}
+
+// static
+QDir MediaProbeCache::getDir(bool *ok)
+{
+    QDir dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/probes"));
+    *ok = dir.mkpath(QStringLiteral("."));
+    return dir;
+}
+
+// static
+QString MediaProbeCache::entryName(const QString &path)
+{
+    return QString::fromLatin1(QCryptographicHash::hash(QFileInfo(path).absoluteFilePath().toUtf8(), QCryptographicHash::Md5).toHex()) +
+           QStringLiteral(".json");
+}
+
+bool MediaProbeCache::lookup(const QString &path, double fps, QMap<QString, QString> &properties) const
+{
+    FileKey key;
+    bool ok;
+    QDir dir = getDir(&ok);
+    if (!ok || !fileKey(path, key)) {
+        return false;
+    }
+    QFile file(dir.absoluteFilePath(entryName(path)));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QJsonObject entry = QJsonDocument::fromJson(file.readAll()).object();
+    // The path is checked too, in case of a hash collision
+    FileKey cached;
+    cached.size = (qint64)entry.value(QStringLiteral("size")).toDouble(-1);
+    cached.modified = (qint64)entry.value(QStringLiteral("modified")).toDouble();
+    cached.inode = entry.value(QStringLiteral("inode")).toString().toULongLong();
+    if (!(cached == key) || entry.value(QStringLiteral("path")).toString() != QFileInfo(path).absoluteFilePath()) {
+        return false;
+    }
+    // The length of the clip depends on the frame rate
+    if (!qFuzzyCompare(entry.value(QStringLiteral("fps")).toDouble(), fps)) {
+        return false;
+    }
+    const QJsonObject props = entry.value(QStringLiteral("properties")).toObject();
+    if (props.isEmpty()) {
+        return false;
+    }
+    properties.clear();
+    for (auto it = props.constBegin(); it != props.constEnd(); ++it) {
+        properties.insert(it.key(), it.value().toString());
+    }
+    return true;
+}
+
+void MediaProbeCache::store(const QString &path, double fps, const QMap<QString, QString> &properties)
+{
+    FileKey key;
+    bool ok;
+    QDir dir = getDir(&ok);
+    if (!ok || properties.isEmpty() || !fileKey(path, key)) {
+        return;
+    }
+    QJsonObject props;
+    QMapIterator<QString, QString> i(properties);
+    while (i.hasNext()) {
+        i.next();
+        props.insert(i.key(), i.value());
+    }
+    QJsonObject entry;
+    entry.insert(QStringLiteral("path"), QFileInfo(path).absoluteFilePath());
+    // Json numbers are doubles, exact up to 2^53
+    entry.insert(QStringLiteral("size"), (double)key.size);
+    entry.insert(QStringLiteral("modified"), (double)key.modified);
+    entry.insert(QStringLiteral("inode"), QString::number(key.inode));
+    entry.insert(QStringLiteral("fps"), fps);
+    entry.insert(QStringLiteral("properties"), props);
+    // Several load jobs may write at the same time, each entry is replaced atomically
+    QSaveFile file(dir.absoluteFilePath(entryName(path)));
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(entry).toJson(QJsonDocument::Compact));
+        file.commit();
+    }
+}
+
+// static
+QMap<QString, QString> MediaProbeCache::probedProperties(Mlt::Producer &producer)
+{
+    QMap<QString, QString> properties;
+    for (int i = 0; i < producer.count(); ++i) {
+        const char *name = producer.get_name(i);
+        const char *value = producer.get(i);
+        if (name == nullptr || value == nullptr || name[0] == '_') {
+            // Internal or binary data
+            continue;
+        }
+        const QString key = QString::fromUtf8(name);
+        if (key == QLatin1String("mlt_service") || key == QLatin1String("resource") || key.startsWith(QLatin1String("kdenlive"))) {
+            continue;
+        }
+        properties.insert(key, QString::fromUtf8(value));
+    }
+    return properties;
+}
+
+void MediaProbeCache::validate(const QString &binId, const QString &path)
+{
+    // The task must not use the profile of the document, it may be closed before the task runs
+    const QString profilePath = pCore->getCurrentProfilePath();
+    const int document = m_document;
+    QtConcurrent::run(&m_validator, [this, binId, path, profilePath, document]() {
+        if (document != m_document) {
+            return;
+        }
+        QThread::currentThread()->setPriority(QThread::LowestPriority);
+        Mlt::Profile profile(profilePath.toUtf8().constData());
+        const double fps = profile.fps();
+        QMap<QString, QString> cached;
+        if (!lookup(path, fps, cached)) {
+            // Changed since it was loaded, the file watcher takes care of it
+            return;
+        }
+        Mlt::Producer producer(profile, "avformat", path.toUtf8().constData());
+        QMap<QString, QString> probed;
+        if (producer.is_valid()) {
+            probed = probedProperties(producer);
+        }
+        if (probed == cached) {
+            return;
+        }
+        qCDebug(KDENLIVE_LOG) << "// Cached probe of" << path << "is outdated, reloading clip" << binId;
+        if (probed.isEmpty()) {
+            bool ok;
+            QDir dir = getDir(&ok);
+            QFile::remove(dir.absoluteFilePath(entryName(path)));
+        } else {
+            store(path, fps, probed);
+        }
+        if (document == m_document && pCore->bin()) {
+            QMetaObject::invokeMethod(pCore->bin(), "reloadClip", Qt::QueuedConnection, Q_ARG(const QString &, binId));
+        }
+    });
+}
+
+void MediaProbeCache::cancelValidation()
+{
+    m_document++;
+    m_validator.clear();
+    m_validator.waitForDone();
+}
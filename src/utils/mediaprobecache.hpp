@@ -0,0 +1,100 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QDir>
+#include <QMap>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace Mlt {
+class Producer;
+}
+
+/** @brief This class is a persistent cache of the properties found by MLT when it probes a media file.
+    Opening an avformat producer reads the file headers and decodes some packets, which is slow on network storage.
+    When a project is reopened, the clips whose file did not change are created without probing, from the cached properties.
+    A file is considered unchanged if its size, modification time and inode are the same as when it was probed.
+    The durations found by MLT are counted in frames, so an entry is only used with the frame rate it was probed with.
+    Each file has its own entry on disk, in the application cache folder, so the cache is shared by all projects.
+    Clips loaded from the cache are probed again later, in the background, and reloaded if the result differs.
+ * Note that this class is a Singleton
+ */
+
+class MediaProbeCache
+{
+
+public:
+    // Returns the instance of the Singleton
+    static std::unique_ptr<MediaProbeCache> &get();
+    ~MediaProbeCache();
+
+    /* @brief Identity of a version of a file */
+    struct FileKey
+    {
+        qint64 size{-1};
+        qint64 modified{0};
+        quint64 inode{0};
+        bool operator==(const FileKey &other) const { return size == other.size && modified == other.modified && inode == other.inode; }
+    };
+    /* @brief Read the identity of a file, returns false if it does not exist */
+    static bool fileKey(const QString &path, FileKey &key);
+
+    /* @brief Get the cached properties of a file
+       @param fps is the frame rate of the profile used to open the file
+       @return false if the file was not probed with this frame rate, or changed since it was */
+    bool lookup(const QString &path, double fps, QMap<QString, QString> &properties) const;
+
+    /* @brief Store the properties of a file that was just probed with a profile of @param fps frames per second */
+    void store(const QString &path, double fps, const QMap<QString, QString> &properties);
+
+    /* @brief Extract the properties set by the probe of a producer, to store them in the cache.
+       This must be called before properties coming from the project are set on the producer */
+    static QMap<QString, QString> probedProperties(Mlt::Producer &producer);
+
+    /* @brief Probe again a file loaded from the cache, in the background. If the result differs, the entry is updated and the clip reloaded
+       @param binId is the id of the clip of the current document using the file */
+    void validate(const QString &binId, const QString &path);
+
+    /* @brief Drop the validations of the current document, and wait for the running one.
+       Must be called before the document is closed */
+    void cancelValidation();
+
+protected:
+    // Constructor is protected because class is a Singleton
+    MediaProbeCache();
+
+    // Return the dir where the cache lives
+    static QDir getDir(bool *ok);
+    // Name of the entry of a file
+    static QString entryName(const QString &path);
+
+    static std::unique_ptr<MediaProbeCache> instance;
+    static std::once_flag m_onceFlag; // flag to create the cache only once;
+
+    // Validation probes run one at a time, so that they don't compete with the loading of the project
+    QThreadPool m_validator;
+    // Incremented when the document is closed, validations of a previous document are dropped
+    std::atomic<int> m_document{0};
+};
@@ -0,0 +1,282 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#include "thumbnailatlas.hpp"
+#include <QBuffer>
+#include <QDebug>
+#include <QDir>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+const char atlasMagic[4] = {'K', 'D', 'T', 'A'};
+const quint32 atlasVersion = 1;
+const qint64 headerSize = 8;       // magic + version
+const qint64 recordHeaderSize = 9; // frame (int32) + payload size (uint32) + codec (uint8)
+enum Codec : quint8 { CodecJpeg = 0, CodecPng = 1 };
+
+bool isOpaque(const QImage &img)
+{
+    if (!img.hasAlphaChannel()) {
+        return true;
+    }
+    const QImage argb = img.convertToFormat(QImage::Format_ARGB32);
+    for (int y = 0; y < argb.height(); ++y) {
+        const auto *line = reinterpret_cast<const QRgb *>(argb.constScanLine(y));
+        for (int x = 0; x < argb.width(); ++x) {
+            if (qAlpha(line[x]) != 255) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+} // namespace
+
+ThumbnailAtlas::ThumbnailAtlas(const QString &folder, const QString &clipHash)
+    : m_folder(folder)
+    , m_clipHash(clipHash)
+{
+}
+
+ThumbnailAtlas::~ThumbnailAtlas()
+{
+    release();
+}
+
+// static
+QString ThumbnailAtlas::fileName(const QString &clipHash)
+{
+    return clipHash + QStringLiteral(".thumbs");
+}
+
+bool ThumbnailAtlas::isOpen() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_file.isOpen();
+}
+
+bool ThumbnailAtlas::open(bool create)
+{
+    if (m_file.isOpen()) {
+        return true;
+    }
+    if (m_missing && !create) {
+        return false;
+    }
+    QDir folder(m_folder);
+    if (!m_indexed) {
+        // Look for thumbnails stored in the legacy format, they will be migrated when accessed
+        const QStringList legacyFiles = folder.entryList({m_clipHash + QStringLiteral("#*.png")}, QDir::Files);
+        for (const QString &file : legacyFiles) {
+            bool ok = false;
+            int frame = file.section(QLatin1Char('#'), 1).section(QLatin1Char('.'), 0, 0).toInt(&ok);
+            if (ok) {
+                m_legacy.insert(frame);
+            }
+        }
+    }
+    m_file.setFileName(folder.absoluteFilePath(fileName(m_clipHash)));
+    if (!create && !m_file.exists()) {
+        // Nothing stored yet, don't create an empty file for every queried clip
+        m_missing = true;
+        m_indexed = true;
+        return false;
+    }
+    m_missing = false;
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qDebug() << "// Cannot open thumbnail atlas" << m_file.fileName();
+        return false;
+    }
+    bool validHeader = false;
+    if (m_file.size() >= headerSize) {
+        char header[headerSize];
+        if (m_file.read(header, headerSize) == headerSize && memcmp(header, atlasMagic, 4) == 0 &&
+            qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(header + 4)) == atlasVersion) {
+            validHeader = true;
+        }
+    }
+    if (!validHeader) {
+        // New or unreadable file, start from scratch
+        m_index.clear();
+        m_file.resize(0);
+        uchar header[headerSize];
+        memcpy(header, atlasMagic, 4);
+        qToLittleEndian<quint32>(atlasVersion, header + 4);
+        m_file.seek(0);
+        m_file.write(reinterpret_cast<const char *>(header), headerSize);
+        m_file.flush();
+        m_indexed = false;
+    }
+    if (!remap()) {
+        m_file.close();
+        return false;
+    }
+    if (!m_indexed) {
+        // Walk the record headers to build the index
+        qint64 pos = headerSize;
+        while (pos + recordHeaderSize <= m_mappedSize) {
+            const int frame = qFromLittleEndian<qint32>(m_map + pos);
+            const quint32 size = qFromLittleEndian<quint32>(m_map + pos + 4);
+            const quint8 codec = m_map[pos + 8];
+            if (pos + recordHeaderSize + size > m_mappedSize) {
+                break;
+            }
+            m_index[frame] = {pos + recordHeaderSize, size, codec};
+            m_legacy.erase(frame);
+            pos += recordHeaderSize + size;
+        }
+        if (pos < m_mappedSize) {
+            // Incomplete record at the end (interrupted write), drop it
+            qDebug() << "// Truncating damaged thumbnail atlas" << m_file.fileName();
+            m_file.unmap(m_map);
+            m_map = nullptr;
+            m_file.resize(pos);
+            remap();
+        }
+        m_indexed = true;
+    }
+    return true;
+}
+
+bool ThumbnailAtlas::remap()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_mappedSize = m_file.size();
+    if (m_mappedSize == 0) {
+        return true;
+    }
+    m_map = m_file.map(0, m_mappedSize);
+    return m_map != nullptr;
+}
+
+void ThumbnailAtlas::release()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_mappedSize = 0;
+    m_file.close();
+}
+
+bool ThumbnailAtlas::contains(int frame)
+{
+    QMutexLocker locker(&m_mutex);
+    open(false);
+    return m_index.count(frame) > 0 || m_legacy.count(frame) > 0;
+}
+
+QImage ThumbnailAtlas::read(int frame)
+{
+    QMutexLocker locker(&m_mutex);
+    bool opened = open(false);
+    auto it = m_index.find(frame);
+    if (!opened || it == m_index.end()) {
+        if (m_legacy.count(frame) > 0) {
+            return migrateLegacy(frame);
+        }
+        return QImage();
+    }
+    const Record record = it->second;
+    if (record.offset + record.size > m_mappedSize) {
+        // The record was appended after we mapped the file
+        remap();
+    }
+    if (m_map == nullptr || record.offset + record.size > m_mappedSize) {
+        return QImage();
+    }
+    // Copy the compressed data so that decoding happens without holding the lock
+    const QByteArray data(reinterpret_cast<const char *>(m_map + record.offset), (int)record.size);
+    locker.unlock();
+    return QImage::fromData(data, record.codec == CodecJpeg ? "JPG" : "PNG");
+}
+
+bool ThumbnailAtlas::append(int frame, const QImage &img)
+{
+    QMutexLocker locker(&m_mutex);
+    return appendLocked(frame, img);
+}
+
+bool ThumbnailAtlas::appendLocked(int frame, const QImage &img)
+{
+    if (img.isNull() || !open(true)) {
+        return false;
+    }
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    const quint8 codec = isOpaque(img) ? CodecJpeg : CodecPng;
+    if (!img.save(&buffer, codec == CodecJpeg ? "JPG" : "PNG", codec == CodecJpeg ? 90 : -1)) {
+        return false;
+    }
+    uchar header[recordHeaderSize];
+    qToLittleEndian<qint32>(frame, header);
+    qToLittleEndian<quint32>((quint32)data.size(), header + 4);
+    header[8] = codec;
+    const qint64 pos = m_file.size();
+    if (!m_file.seek(pos) || m_file.write(reinterpret_cast<const char *>(header), recordHeaderSize) != recordHeaderSize ||
+        m_file.write(data) != data.size() || !m_file.flush()) {
+        qDebug() << "// Error writing thumbnail to " << m_file.fileName();
+        // Remove the partial record
+        m_file.resize(pos);
+        return false;
+    }
+    m_index[frame] = {pos + recordHeaderSize, (quint32)data.size(), codec};
+    m_legacy.erase(frame);
+    return true;
+}
+
+QImage ThumbnailAtlas::migrateLegacy(int frame)
+{
+    const QString path = QDir(m_folder).absoluteFilePath(m_clipHash + QLatin1Char('#') + QString::number(frame) + QStringLiteral(".png"));
+    m_legacy.erase(frame);
+    QImage img(path);
+    if (!img.isNull() && appendLocked(frame, img)) {
+        QFile::remove(path);
+    }
+    return img;
+}
+
+void ThumbnailAtlas::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_mappedSize = 0;
+    m_file.close();
+    QDir folder(m_folder);
+    QFile::remove(folder.absoluteFilePath(fileName(m_clipHash)));
+    const QStringList legacyFiles = folder.entryList({m_clipHash + QStringLiteral("#*.png")}, QDir::Files);
+    for (const QString &file : legacyFiles) {
+        QFile::remove(folder.absoluteFilePath(file));
+    }
+    m_index.clear();
+    m_legacy.clear();
+    m_indexed = false;
+    m_missing = false;
+}
@@ -0,0 +1,99 @@
+/***************************************************************************
+ *   This file is part of Kdenlive. See www.kdenlive.org.                  *
+ *                                                                         *
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) version 3 or any later version accepted by the       *
+ *   membership of KDE e.V. (or its successor approved  by the membership  *
+ *   of KDE e.V.), which shall act as a proxy defined in Section 14 of     *
+ *   version 3 of the license.                                             *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#pragma once
+
+#include <QFile>
+#include <QImage>
+#include <QMutex>
+#include <QString>
+#include <unordered_map>
+#include <unordered_set>
+
+/** @brief This class stores all the persistent thumbnails of a clip in a single file.
+    The file starts with a small header (magic, version) followed by appended records, each made of the frame number, the size and codec of the
+    payload and the compressed image (JPEG for opaque images, PNG otherwise). When several records exist for a frame, the last one wins.
+    The frame -> offset index is rebuilt in memory by walking the record headers when the file is first opened, and the file is memory mapped
+    for reads. New thumbnails are appended at the end of the file.
+    Thumbnails stored with the legacy format (one <hash>#<frame>.png file per frame) are moved into the atlas when first read.
+    All methods are thread safe.
+ */
+class ThumbnailAtlas
+{
+
+public:
+    /* @brief Construct the atlas of a clip
+       @param folder is the thumbnail cache folder
+       @param clipHash is the hash of the clip
+    */
+    ThumbnailAtlas(const QString &folder, const QString &clipHash);
+    ~ThumbnailAtlas();
+
+    /* @brief Returns true if a thumbnail is stored for the given frame */
+    bool contains(int frame);
+
+    /* @brief Returns the thumbnail for the given frame, or a null image */
+    QImage read(int frame);
+
+    /* @brief Store a thumbnail for the given frame */
+    bool append(int frame, const QImage &img);
+
+    /* @brief Delete all the thumbnails of the clip from disk */
+    void clear();
+
+    /* @brief Close the file and unmap it. It will be reopened on next access */
+    void release();
+
+    /* @brief Returns true if the file is currently opened */
+    bool isOpen() const;
+
+    /* @brief Returns the file name used for the atlas of a given clip */
+    static QString fileName(const QString &clipHash);
+
+protected:
+    struct Record
+    {
+        qint64 offset;
+        quint32 size;
+        quint8 codec;
+    };
+
+    // Open the file, build the index and map it. Must be called with m_mutex held
+    // If create is false and the file does not exist, nothing is created and false is returned
+    bool open(bool create);
+    // Map the whole file. Must be called with m_mutex held
+    bool remap();
+    // Append a record. Must be called with m_mutex held
+    bool appendLocked(int frame, const QImage &img);
+    // Move a legacy png thumbnail into the atlas. Must be called with m_mutex held
+    QImage migrateLegacy(int frame);
+
+    QString m_folder;
+    QString m_clipHash;
+    QFile m_file;
+    mutable QMutex m_mutex;
+    uchar *m_map{nullptr};
+    qint64 m_mappedSize{0};
+    bool m_indexed{false};
+    bool m_missing{false};
+    std::unordered_map<int, Record> m_index;
+    // frames that only exist as legacy png files
+    std::unordered_set<int> m_legacy;
+};
@@ -24,24 +24,35 @@
 #include "bin/projectitemmodel.h"
 #include "core.h"
 #include "doc/kdenlivedoc.h"
+#include "kdenlivesettings.h"
+#include "thumbnailatlas.hpp"
 #include <QDir>
 #include <QMutexLocker>
+#include <QtConcurrent>
+#include <algorithm>
 #include <list>
 
 std::unique_ptr<ThumbnailCache> ThumbnailCache::instance;
 std::once_flag ThumbnailCache::m_onceFlag;
 
+namespace {
+// Number of independently locked parts of the volatile cache
+const size_t shardCount = 16;
+// Number of clip atlases that we keep opened and mapped
+const size_t maxOpenAtlases = 32;
+} // namespace
+
 class ThumbnailCache::Cache_t
 {
 public:
-    Cache_t(int maxCost)
+    Cache_t(qint64 maxCost)
         : m_maxCost(maxCost)
     {
     }
 
-    bool contains(const QString &key) const { return m_cache.count(key) > 0; }
+    bool contains(const Key &key) const { return m_cache.count(key) > 0; }
 
-    void remove(const QString &key)
+    void remove(const Key &key)
     {
         if (!contains(key)) {
             return;
@@ -52,7 +63,7 @@ public:
         m_cache.erase(key);
     }
 
-    void insert(const QString &key, const QImage &img, int cost)
+    void insert(const Key &key, const QImage &img, qint64 cost)
     {
         if (cost > m_maxCost) {
             return;
@@ -61,37 +72,67 @@ public:
         auto it = m_data.begin();
         m_cache[key] = it;
         m_currentCost += cost;
-        while (m_currentCost > m_maxCost) {
-            remove(m_data.back().first);
-        }
+        shrink();
     }
 
-    QImage get(const QString &key)
+    QImage get(const Key &key)
     {
         if (!contains(key)) {
             return QImage();
         }
         // when a get operation occurs, we put the corresponding list item in front to remember last access
-        std::pair<QString, std::pair<QImage, int>> data;
         auto it = m_cache.at(key);
-        std::swap(data, (*it));                                         // take data out without copy
-        QImage result = data.second.first;                              // a copy occurs here
-        m_data.erase(it);                                               // delete old iterator
-        m_cache[key] = m_data.emplace(m_data.begin(), std::move(data)); // reinsert without copy and store iterator
-        return result;
+        m_data.splice(m_data.begin(), m_data, it); // move to front without copy, iterators stay valid
+        return it->second.first;                   // a copy occurs here
+    }
+
+    void setMaxCost(qint64 maxCost)
+    {
+        m_maxCost = maxCost;
+        shrink();
     }
 
 protected:
-    int m_maxCost;
-    int m_currentCost{0};
+    void shrink()
+    {
+        while (m_currentCost > m_maxCost && !m_data.empty()) {
+            remove(m_data.back().first);
+        }
+    }
 
-    std::list<std::pair<QString, std::pair<QImage, int>>> m_data; // the data is stored as (key,(image, cost))
-    std::unordered_map<QString, decltype(m_data.begin())> m_cache;
+    qint64 m_maxCost;
+    qint64 m_currentCost{0};
+
+    std::list<std::pair<Key, std::pair<QImage, qint64>>> m_data; // the data is stored as (key,(image, cost))
+    std::unordered_map<Key, decltype(m_data.begin()), KeyHash> m_cache;
+};
+
+class ThumbnailCache::Shard_t
+{
+public:
+    explicit Shard_t(qint64 maxCost)
+        : cache(maxCost)
+    {
+    }
+
+    QMutex mutex;
+    Cache_t cache;
+    // the following map keeps track of the positions that we store for each clip hash in this shard.
+    // Note that we don't track deletions due to items dropped from the cache. So the map can contain more items that are currently stored.
+    std::unordered_map<quint64, std::vector<int>> storedVolatile;
 };
 
 ThumbnailCache::ThumbnailCache()
-    : m_volatileCache(new Cache_t(10000000))
 {
+    qint64 maxCost = qMax(1, KdenliveSettings::thumbnailcachesize()) * 1048576LL;
+    for (size_t i = 0; i < shardCount; ++i) {
+        m_shards.emplace_back(new Shard_t(maxCost / (qint64)shardCount));
+    }
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    flushPendingWrites();
 }
 
 std::unique_ptr<ThumbnailCache> &ThumbnailCache::get()
@@ -100,65 +141,108 @@ std::unique_ptr<ThumbnailCache> &ThumbnailCache::get()
     return instance;
 }
 
+ThumbnailCache::Shard_t &ThumbnailCache::shard(const Key &key) const
+{
+    return *m_shards[KeyHash()(key) % m_shards.size()];
+}
+
+void ThumbnailCache::setMaxCost(qint64 bytes)
+{
+    for (const auto &s : m_shards) {
+        QMutexLocker locker(&s->mutex);
+        s->cache.setMaxCost(bytes / (qint64)m_shards.size());
+    }
+}
+
 bool ThumbnailCache::hasThumbnail(const QString &binId, int pos, bool volatileOnly) const
 {
-    QMutexLocker locker(&m_mutex);
-    bool ok = false;
-    auto key = getKey(binId, pos, &ok);
-    if (ok && m_volatileCache->contains(key)) {
-        return true;
+    ClipHash hash;
+    if (!getClipHash(binId, hash)) {
+        return false;
     }
-    if (!ok || volatileOnly) {
+    const Key key{hash.value, pos};
+    {
+        Shard_t &s = shard(key);
+        QMutexLocker locker(&s.mutex);
+        if (s.cache.contains(key)) {
+            return true;
+        }
+    }
+    if (volatileOnly) {
         return false;
     }
+    {
+        QMutexLocker locker(&m_writeMutex);
+        if (m_pendingWrites.count(key) > 0) {
+            return true;
+        }
+    }
+    bool ok = false;
     QDir thumbFolder = getDir(&ok);
-    return ok && thumbFolder.exists(key);
+    if (!ok) {
+        return false;
+    }
+    auto atlas = getAtlas(thumbFolder.absolutePath(), hash.name);
+    return atlas && atlas->contains(pos);
 }
 
 QImage ThumbnailCache::getThumbnail(const QString &binId, int pos, bool volatileOnly) const
 {
-    QMutexLocker locker(&m_mutex);
-    bool ok = false;
-    auto key = getKey(binId, pos, &ok);
-    if (ok && m_volatileCache->contains(key)) {
-        return m_volatileCache->get(key);
+    ClipHash hash;
+    if (!getClipHash(binId, hash)) {
+        return QImage();
     }
-    if (!ok || volatileOnly) {
+    const Key key{hash.value, pos};
+    {
+        Shard_t &s = shard(key);
+        QMutexLocker locker(&s.mutex);
+        if (s.cache.contains(key)) {
+            return s.cache.get(key);
+        }
+    }
+    if (volatileOnly) {
         return QImage();
     }
+    {
+        QMutexLocker locker(&m_writeMutex);
+        auto it = m_pendingWrites.find(key);
+        if (it != m_pendingWrites.end()) {
+            return it->second.image;
+        }
+    }
+    bool ok = false;
     QDir thumbFolder = getDir(&ok);
-    if (ok && thumbFolder.exists(key)) {
-        return QImage(thumbFolder.absoluteFilePath(key));
+    if (!ok) {
+        return QImage();
     }
-    return QImage();
+    auto atlas = getAtlas(thumbFolder.absolutePath(), hash.name);
+    return atlas ? atlas->read(pos) : QImage();
 }
 
 void ThumbnailCache::storeThumbnail(const QString &binId, int pos, const QImage &img, bool persistent)
 {
-    QMutexLocker locker(&m_mutex);
-    bool ok = false;
-    const QString key = getKey(binId, pos, &ok);
-    if (!ok) {
+    ClipHash hash;
+    if (!getClipHash(binId, hash)) {
         return;
     }
+    const Key key{hash.value, pos};
+    {
+        Shard_t &s = shard(key);
+        QMutexLocker locker(&s.mutex);
+        // if volatile cache already contains this entry, update it
+        if (s.cache.contains(key)) {
+            s.cache.remove(key);
+        } else {
+            s.storedVolatile[key.clip].push_back(pos);
+        }
+        s.cache.insert(key, img, img.byteCount());
+    }
     if (persistent) {
+        bool ok = false;
         QDir thumbFolder = getDir(&ok);
         if (ok) {
-            if (!img.save(thumbFolder.absoluteFilePath(key))) {
-                qDebug() << ".............\nAAAAAAAAAAAARGH ERROR SAVING THUMB";
-            }
-            m_storedOnDisk[binId].push_back(pos);
-            // if volatile cache also contains this entry, update it
-            if (m_volatileCache->contains(key)) {
-                m_volatileCache->remove(key);
-            } else {
-                m_storedVolatile[binId].push_back(pos);
-            }
-            m_volatileCache->insert(key, img, img.byteCount());
+            enqueueWrite(key, thumbFolder.absolutePath(), hash.name, img);
         }
-    } else {
-        m_volatileCache->insert(key, img, img.byteCount());
-        m_storedVolatile[binId].push_back(pos);
     }
 }
 
@@ -169,54 +253,217 @@ void ThumbnailCache::saveCachedThumbs(QStringList keys)
     if (!ok) {
         return;
     }
-    for (const QString &key : keys) {
-        if (!thumbFolder.exists(key) && m_volatileCache->contains(key)) {
-            QImage img = m_volatileCache->get(key);
-            if (!img.save(thumbFolder.absoluteFilePath(key))) {
-                qDebug() << "// Error writing thumbnails to " << thumbFolder.absolutePath();
-                break;
+    const QString folder = thumbFolder.absolutePath();
+    for (const QString &thumbKey : keys) {
+        // keys are of the form hash#pos.png
+        const QString clipHash = thumbKey.section(QLatin1Char('#'), 0, 0);
+        const Key key{hashValue(clipHash), thumbKey.section(QLatin1Char('#'), 1).section(QLatin1Char('.'), 0, 0).toInt()};
+        auto atlas = getAtlas(folder, clipHash);
+        if (!atlas || atlas->contains(key.frame)) {
+            continue;
+        }
+        QImage img;
+        {
+            Shard_t &s = shard(key);
+            QMutexLocker locker(&s.mutex);
+            if (!s.cache.contains(key)) {
+                continue;
             }
+            img = s.cache.get(key);
         }
+        enqueueWrite(key, folder, clipHash, img);
     }
 }
 
 void ThumbnailCache::invalidateThumbsForClip(const QString &binId)
 {
-    QMutexLocker locker(&m_mutex);
-    if (m_storedVolatile.find(binId) != m_storedVolatile.end()) {
-        bool ok = false;
-        for (int pos : m_storedVolatile.at(binId)) {
-            auto key = getKey(binId, pos, &ok);
-            if (ok) {
-                m_volatileCache->remove(key);
+    ClipHash hash;
+    {
+        QWriteLocker locker(&m_hashLock);
+        // Same key as in getClipHash: track producers share the thumbnails of their master clip
+        auto it = m_clipHashes.find(binId.section(QLatin1Char('_'), 0, 0));
+        if (it == m_clipHashes.end()) {
+            // Nothing was ever stored for this clip
+            return;
+        }
+        hash = it->second;
+        // The hash will be recomputed on next access, since the clip may have changed
+        m_clipHashes.erase(it);
+    }
+    for (const auto &s : m_shards) {
+        QMutexLocker locker(&s->mutex);
+        auto stored = s->storedVolatile.find(hash.value);
+        if (stored != s->storedVolatile.end()) {
+            for (int pos : stored->second) {
+                s->cache.remove({hash.value, pos});
+            }
+            s->storedVolatile.erase(stored);
+        }
+    }
+    {
+        // Drop the writes that did not happen yet
+        QMutexLocker locker(&m_writeMutex);
+        for (auto it = m_pendingWrites.begin(); it != m_pendingWrites.end();) {
+            if (it->first.clip == hash.value) {
+                it = m_pendingWrites.erase(it);
+            } else {
+                ++it;
             }
         }
-        m_storedVolatile.erase(binId);
     }
     bool ok = false;
     QDir thumbFolder = getDir(&ok);
-    if (ok && m_storedOnDisk.find(binId) != m_storedOnDisk.end()) {
+    if (ok) {
         // Remove persistent cache
-        for (int pos : m_storedOnDisk.at(binId)) {
-            auto key = getKey(binId, pos, &ok);
-            if (ok) {
-                QFile::remove(thumbFolder.absoluteFilePath(key));
+        auto atlas = getAtlas(thumbFolder.absolutePath(), hash.name);
+        if (atlas) {
+            atlas->clear();
+        }
+    }
+}
+
+void ThumbnailCache::enqueueWrite(const Key &key, const QString &folder, const QString &clipHash, const QImage &img)
+{
+    QMutexLocker locker(&m_writeMutex);
+    auto it = m_pendingWrites.find(key);
+    if (it != m_pendingWrites.end()) {
+        // A write is already scheduled, just update its content
+        it->second = {folder, clipHash, img};
+        return;
+    }
+    m_pendingWrites[key] = {folder, clipHash, img};
+    m_writeQueue.push_back(key);
+    if (!m_writerRunning) {
+        m_writerRunning = true;
+        m_writer = QtConcurrent::run(this, &ThumbnailCache::processPendingWrites);
+    }
+}
+
+void ThumbnailCache::processPendingWrites()
+{
+    QMutexLocker locker(&m_writeMutex);
+    while (!m_writeQueue.empty()) {
+        const Key key = m_writeQueue.front();
+        m_writeQueue.pop_front();
+        auto it = m_pendingWrites.find(key);
+        if (it == m_pendingWrites.end()) {
+            // thumbnails of the clip were invalidated
+            continue;
+        }
+        const PendingWrite job = it->second;
+        // The entry stays in the pending list while we write, so that it can still be read
+        locker.unlock();
+        auto atlas = getAtlas(job.folder, job.clipHash);
+        if (atlas) {
+            atlas->append(key.frame, job.image);
+        }
+        locker.relock();
+        it = m_pendingWrites.find(key);
+        if (it == m_pendingWrites.end()) {
+            // thumbnails of the clip were invalidated while we were writing
+            if (atlas) {
+                atlas->clear();
+            }
+        } else if (it->second.image.cacheKey() == job.image.cacheKey() && it->second.folder == job.folder) {
+            m_pendingWrites.erase(it);
+        } else {
+            // the thumbnail was replaced in the meantime, write it again
+            m_writeQueue.push_back(key);
+        }
+    }
+    m_writerRunning = false;
+}
+
+void ThumbnailCache::flushPendingWrites()
+{
+    while (true) {
+        QFuture<void> writer;
+        {
+            QMutexLocker locker(&m_writeMutex);
+            if (!m_writerRunning) {
+                return;
             }
+            writer = m_writer;
         }
-        m_storedOnDisk.erase(binId);
+        writer.waitForFinished();
+    }
+}
+
+bool ThumbnailCache::getClipHash(const QString &binId, ClipHash &hash) const
+{
+    const QString id = binId.section(QLatin1Char('_'), 0, 0);
+    {
+        QReadLocker locker(&m_hashLock);
+        auto it = m_clipHashes.find(id);
+        if (it != m_clipHashes.end()) {
+            hash = it->second;
+            return true;
+        }
+    }
+    auto binClip = pCore->projectItemModel()->getClipByBinID(id);
+    if (binClip == nullptr) {
+        return false;
     }
+    hash.name = binClip->hash();
+    hash.value = hashValue(hash.name);
+    QWriteLocker locker(&m_hashLock);
+    m_clipHashes[id] = hash;
+    return true;
 }
 
 // static
-QString ThumbnailCache::getKey(const QString &binId, int pos, bool *ok)
+quint64 ThumbnailCache::hashValue(const QString &clipHash)
+{
+    // Clip hashes are md5 hex digests, we keep their first 64 bits
+    bool ok = false;
+    quint64 value = clipHash.leftRef(16).toULongLong(&ok, 16);
+    if (!ok) {
+        value = (quint64(qHash(clipHash)) << 32) | qHash(clipHash, 0x9E3779B9);
+    }
+    return value;
+}
+
+std::shared_ptr<ThumbnailAtlas> ThumbnailCache::getAtlas(const QString &folder, const QString &clipHash) const
 {
-    auto binClip = pCore->projectItemModel()->getClipByBinID(binId);
-    *ok = binClip != nullptr;
-    return *ok ? binClip->hash() + QLatin1Char('#') + QString::number(pos) + QStringLiteral(".png") : QString();
+    if (clipHash.isEmpty()) {
+        return nullptr;
+    }
+    QMutexLocker locker(&m_atlasMutex);
+    const QString path = folder + QLatin1Char('/') + clipHash;
+    auto it = m_atlases.find(path);
+    if (it == m_atlases.end()) {
+        it = m_atlases.emplace(path, std::make_shared<ThumbnailAtlas>(folder, clipHash)).first;
+    }
+    std::shared_ptr<ThumbnailAtlas> atlas = it->second;
+    // Remember recently used atlases and close the other ones to avoid keeping too many files opened
+    auto recent = std::find(m_recentAtlases.begin(), m_recentAtlases.end(), atlas);
+    if (recent != m_recentAtlases.end()) {
+        m_recentAtlases.splice(m_recentAtlases.begin(), m_recentAtlases, recent);
+    } else {
+        m_recentAtlases.push_front(atlas);
+        if (m_recentAtlases.size() > maxOpenAtlases) {
+            m_recentAtlases.back()->release();
+            m_recentAtlases.pop_back();
+            // Forget the atlases that are neither recent nor in use, an atlas still used by another thread is dropped on a later eviction
+            for (auto it = m_atlases.begin(); it != m_atlases.end();) {
+                if (it->second.use_count() == 1) {
+                    it = m_atlases.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+    }
+    return atlas;
 }
 
 // static
 QDir ThumbnailCache::getDir(bool *ok)
 {
-    return pCore->currentDoc()->getCacheDir(CacheThumbs, ok);
+    KdenliveDoc *doc = pCore->currentDoc();
+    if (doc == nullptr) {
+        *ok = false;
+        return QDir();
+    }
+    return doc->getCacheDir(CacheThumbs, ok);
 }
@@ -23,8 +23,12 @@
 
 #include "definitions.h"
 #include <QDir>
+#include <QFuture>
 #include <QImage>
 #include <QMutex>
+#include <QReadWriteLock>
+#include <deque>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -36,15 +40,22 @@
     Note that for the volatile cache uses a custom implementation.
     QCache is not suitable since it operates on pointers and since the object is removed from the cache when accessed.
     KImageCache is not suitable since it lacks a way to remove objects from the cache.
+    The volatile cache is split in several shards, each with its own lock, so that concurrent accesses from the timeline image providers
+    and the thumbnail jobs rarely contend. Entries are keyed by a (clip hash, frame) integer pair.
+    Writes to the persistent cache are queued and performed by a background writer, so that lookups never wait on image encoding or disk access.
+    The persistent cache stores all the thumbnails of a clip in a single file (see ThumbnailAtlas).
  * Note that this class is a Singleton
  */
 
+class ThumbnailAtlas;
+
 class ThumbnailCache
 {
 
 public:
     // Returns the instance of the Singleton
     static std::unique_ptr<ThumbnailCache> &get();
+    ~ThumbnailCache();
 
     /* @brief Check whether a given thumbnail is in the cache
        @param binId is the id of the queried clip
@@ -63,7 +74,7 @@ public:
     /* @brief Get a given thumbnail from the cache
        @param binId is the id of the queried clip
        @param pos is the position where we query
-       @param persistent if true, we store the image in the persistent cache, which generates a disk access
+       @param persistent if true, we also store the image in the persistent cache. The disk write happens in the background
     */
     void storeThumbnail(const QString &binId, int pos, const QImage &img, bool persistent = false);
 
@@ -73,25 +84,79 @@ public:
     /* @brief Save all cached thumbs to disk */
     void saveCachedThumbs(QStringList keys);
 
+    /* @brief Change the memory budget (in bytes) of the volatile cache */
+    void setMaxCost(qint64 bytes);
+
+    /* @brief Block until all the queued persistent writes are done */
+    void flushPendingWrites();
+
+    /* @brief Binary key of a thumbnail: 64 bits of the clip hash and the frame number */
+    struct Key
+    {
+        quint64 clip;
+        int frame;
+        bool operator==(const Key &other) const { return clip == other.clip && frame == other.frame; }
+    };
+    struct KeyHash
+    {
+        std::size_t operator()(const Key &k) const { return std::hash<quint64>()(k.clip ^ (quint64(quint32(k.frame)) * 0x9E3779B97F4A7C15ULL)); }
+    };
+
 protected:
     // Constructor is protected because class is a Singleton
     ThumbnailCache();
 
-    // Return the key associated to a thumbnail
-    static QString getKey(const QString &binId, int pos, bool *ok);
+    // Clip hash of a bin clip: the string used to name persistent files and its binary counterpart
+    struct ClipHash
+    {
+        QString name;
+        quint64 value;
+    };
+
+    // Return the hash associated to a clip. The result is cached until the clip's thumbnails are invalidated
+    bool getClipHash(const QString &binId, ClipHash &hash) const;
+
+    // Return the binary counterpart of a clip hash
+    static quint64 hashValue(const QString &clipHash);
+
+    // Return the persistent storage of a clip's thumbnails in the given folder
+    std::shared_ptr<ThumbnailAtlas> getAtlas(const QString &folder, const QString &clipHash) const;
 
     // Return the dir where the persistent cache lives
     static QDir getDir(bool *ok);
 
+    // Queue a persistent write, and start the background writer if needed
+    void enqueueWrite(const Key &key, const QString &folder, const QString &clipHash, const QImage &img);
+    // Body of the background writer
+    void processPendingWrites();
+
     static std::unique_ptr<ThumbnailCache> instance;
     static std::once_flag m_onceFlag; // flag to create the repository only once;
 
     class Cache_t;
-    std::unique_ptr<Cache_t> m_volatileCache;
-    mutable QMutex m_mutex;
-
-    // the following maps keeps track of the positions that we store for each clip in volatile caches.
-    // Note that we don't track deletions due to items dropped from the cache. So the maps can contain more items that are currently stored.
-    std::unordered_map<QString, std::vector<int>> m_storedVolatile;
-    std::unordered_map<QString, std::vector<int>> m_storedOnDisk;
+    class Shard_t;
+    std::vector<std::unique_ptr<Shard_t>> m_shards;
+    Shard_t &shard(const Key &key) const;
+
+    // bin id -> hash of the clip. Computing it requires a lookup in the bin and a string conversion, so we remember it
+    mutable QReadWriteLock m_hashLock;
+    mutable std::unordered_map<QString, ClipHash> m_clipHashes;
+
+    // Persistent writes waiting for the background writer. The images stay readable until they are on disk
+    struct PendingWrite
+    {
+        QString folder;
+        QString clipHash;
+        QImage image;
+    };
+    mutable QMutex m_writeMutex;
+    std::unordered_map<Key, PendingWrite, KeyHash> m_pendingWrites;
+    std::deque<Key> m_writeQueue;
+    bool m_writerRunning{false};
+    QFuture<void> m_writer;
+
+    // Atlases are kept open (mapped) only for the most recently used clips, the other ones are forgotten unless still in use
+    mutable QMutex m_atlasMutex;
+    mutable std::unordered_map<QString, std::shared_ptr<ThumbnailAtlas>> m_atlases;
+    mutable std::list<std::shared_ptr<ThumbnailAtlas>> m_recentAtlases;
 };
@@ -0,0 +1,142 @@
+#include "catch.hpp"
+#include "lib/audio/audioMeter.h"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+// Interleaved sine, the same in all channels
+std::vector<qint16> makeSine(int channels, int frequency, int count, double sineFrequency, double amplitude, double phase = 0)
+{
+    std::vector<qint16> samples(size_t(count * channels));
+    for (int i = 0; i < count; ++i) {
+        const auto value = qint16(std::lround(32767 * amplitude * std::sin(2 * M_PI * sineFrequency * i / frequency + phase)));
+        for (int c = 0; c < channels; ++c) {
+            samples[size_t(i * channels + c)] = value;
+        }
+    }
+    return samples;
+}
+} // namespace
+
+TEST_CASE("Audio meter", "[AudioMeter]")
+{
+    const int frequency = 48000;
+    // One video frame at 25 fps
+    const int frameSamples = frequency / 25;
+
+    SECTION("Peak and RMS")
+    {
+        AudioMeter meter;
+        std::vector<qint16> samples = makeSine(2, frequency, frameSamples, 1000, 0.5);
+        // Silence in the second channel
+        for (int i = 0; i < frameSamples; ++i) {
+            samples[size_t(2 * i + 1)] = 0;
+        }
+        AudioMeter::Levels levels = meter.process(samples.data(), 2, frequency, frameSamples);
+        REQUIRE(levels.channels == 2);
+        REQUIRE(levels.peak[0] == Approx(-6.02).margin(0.05));
+        REQUIRE(levels.rms[0] == Approx(-9.03).margin(0.05));
+        REQUIRE(levels.peak[1] == AudioMeter::MinLevel);
+        REQUIRE(levels.truePeak[1] == AudioMeter::MinLevel);
+    }
+
+    SECTION("SIMD and scalar kernels are identical")
+    {
+        for (int channels : {1, 2, 3, 6, 8}) {
+            // Not a multiple of the vector size, with extreme values
+            const int count = 1001;
+            std::vector<qint16> samples = makeSine(channels, frequency, count, 440, 1.0);
+            samples[5] = -32768;
+            int simdPeaks[AudioMeter::MaxChannels] = {0};
+            int scalarPeaks[AudioMeter::MaxChannels] = {0};
+            double simdSquares[AudioMeter::MaxChannels] = {0};
+            double scalarSquares[AudioMeter::MaxChannels] = {0};
+            AudioMeter::peaksAndSquares(samples.data(), channels, count, simdPeaks, simdSquares, true);
+            AudioMeter::peaksAndSquares(samples.data(), channels, count, scalarPeaks, scalarSquares, false);
+            for (int c = 0; c < channels; ++c) {
+                REQUIRE(simdPeaks[c] == scalarPeaks[c]);
+                REQUIRE(simdSquares[c] == Approx(scalarSquares[c]));
+            }
+            REQUIRE(simdPeaks[5 % channels] == 32768);
+        }
+    }
+
+    SECTION("True peak is found between samples")
+    {
+        AudioMeter meter;
+        // A sine at a quarter of the sample rate, sampled 45 degrees away from its peaks
+        std::vector<qint16> samples = makeSine(1, frequency, frameSamples, frequency / 4., 0.5, M_PI / 4);
+        AudioMeter::Levels levels = meter.process(samples.data(), 1, frequency, frameSamples);
+        REQUIRE(levels.peak[0] == Approx(-9.03).margin(0.05));
+        REQUIRE(levels.truePeak[0] == Approx(-6.02).margin(0.5));
+    }
+
+    SECTION("Loudness")
+    {
+        // EBU Tech 3341: a 1kHz stereo sine at -23 dBFS reads -23 LUFS
+        AudioMeter meter;
+        const double amplitude = std::pow(10., -23. / 20.);
+        std::vector<qint16> samples = makeSine(2, frequency, 4 * frequency, 1000, amplitude);
+        AudioMeter::Levels levels;
+        for (int frame = 0; frame < 100; ++frame) {
+            levels = meter.process(samples.data() + frame * frameSamples * 2, 2, frequency, frameSamples);
+        }
+        REQUIRE(levels.momentary == Approx(-23).margin(0.1));
+        REQUIRE(levels.shortTerm == Approx(-23).margin(0.1));
+
+        // Silence brings the momentary loudness down first
+        std::vector<qint16> silence(size_t(frameSamples * 2), 0);
+        for (int frame = 0; frame < 10; ++frame) {
+            levels = meter.process(silence.data(), 2, frequency, frameSamples);
+        }
+        REQUIRE(levels.momentary < -60);
+        REQUIRE(levels.shortTerm > -30);
+
+        meter.reset();
+        levels = meter.process(silence.data(), 2, frequency, frameSamples);
+        REQUIRE(levels.shortTerm == AudioMeter::MinLevel);
+    }
+
+    SECTION("Ring")
+    {
+        AudioMeter::Ring ring;
+        AudioMeter::Levels levels;
+        REQUIRE_FALSE(ring.pop(levels));
+        int pushed = 0;
+        AudioMeter::Levels in;
+        while (ring.push(in)) {
+            in.channels = ++pushed;
+        }
+        // One slot is kept free to tell a full ring from an empty one
+        REQUIRE(pushed == AudioMeter::Ring::Size - 1);
+        for (int i = 0; i < pushed; ++i) {
+            REQUIRE(ring.pop(levels));
+            REQUIRE(levels.channels == i);
+        }
+        REQUIRE_FALSE(ring.pop(levels));
+    }
+
+    SECTION("Invalid input")
+    {
+        AudioMeter meter;
+        REQUIRE(meter.process(nullptr, 2, frequency, frameSamples).channels == 0);
+        std::vector<qint16> samples(size_t(AudioMeter::MaxChannels + 1), 0);
+        REQUIRE(meter.process(samples.data(), AudioMeter::MaxChannels + 1, frequency, 1).channels == 0);
+    }
+}
+
+TEST_CASE("Audio meter cost", "[.][Benchmark][AudioMeter]")
+{
+    const int frequency = 48000;
+    std::vector<qint16> samples = makeSine(6, frequency, frequency, 1000, 0.5);
+    AudioMeter meter;
+    float loudness = AudioMeter::MinLevel;
+    BENCHMARK("One second of 5.1 audio")
+    {
+        for (int frame = 0; frame < 25; ++frame) {
+            loudness = meter.process(samples.data() + frame * 6 * frequency / 25, 6, frequency, frequency / 25).momentary;
+        }
+    }
+    REQUIRE(loudness > AudioMeter::MinLevel);
+}
@@ -0,0 +1,116 @@
+#include "catch.hpp"
+#include "lib/audio/audioPeaks.h"
+
+#include <QTemporaryDir>
+#include <vector>
+
+TEST_CASE("Audio peaks pyramid", "[AudioPeaks]")
+{
+    const int channels = 2;
+    const int rate = 48000;
+    const int length = 10 * rate;
+    // channel 0 is a ramp, channel 1 has a single spike
+    std::vector<qint16> interleaved(size_t(length * channels));
+    for (int i = 0; i < length; ++i) {
+        interleaved[size_t(i * channels)] = qint16(i % 20000 - 10000);
+        interleaved[size_t(i * channels + 1)] = i == 100000 ? 30000 : 0;
+    }
+
+    SECTION("Interleaved and planar input give the same result")
+    {
+        AudioPeaks::Builder builder(channels, rate);
+        // feed in uneven chunks
+        int pos = 0;
+        for (int chunk : {1, 127, 1000, 4096}) {
+            while (pos + chunk <= length / 2) {
+                builder.addSamples(interleaved.data() + pos * channels, chunk);
+                pos += chunk;
+            }
+        }
+        builder.addSamples(interleaved.data() + pos * channels, length - pos);
+        auto peaks = builder.finish(QString());
+        REQUIRE(peaks != nullptr);
+
+        AudioPeaks::Builder planarBuilder(channels, rate);
+        for (int c = 0; c < channels; ++c) {
+            std::vector<qint16> planar;
+            for (int i = 0; i < length; ++i) {
+                planar.push_back(interleaved[size_t(i * channels + c)]);
+            }
+            planarBuilder.addChannelSamples(c, planar.data(), length);
+        }
+        auto planarPeaks = planarBuilder.finish(QString());
+        REQUIRE(planarPeaks != nullptr);
+        REQUIRE(planarPeaks->levelCount() == peaks->levelCount());
+        for (int l = 0; l < peaks->levelCount(); ++l) {
+            REQUIRE(peaks->level(l).count == planarPeaks->level(l).count);
+            for (qint64 i = 0; i < peaks->level(l).count * channels * 2; ++i) {
+                REQUIRE(peaks->level(l).data[i] == planarPeaks->level(l).data[i]);
+            }
+        }
+    }
+
+    SECTION("Levels match a brute force computation")
+    {
+        AudioPeaks::Builder builder(channels, rate);
+        builder.addSamples(interleaved.data(), length);
+        REQUIRE(builder.sampleCount() == length);
+        auto peaks = builder.finish(QString());
+        REQUIRE(peaks != nullptr);
+        REQUIRE(peaks->channels() == channels);
+        REQUIRE(peaks->sampleRate() == rate);
+        REQUIRE(peaks->sampleCount() == length);
+        REQUIRE(peaks->levelCount() > 1);
+        REQUIRE(peaks->level(0).samplesPerPeak == AudioPeaks::BaseSamplesPerPeak);
+        REQUIRE(peaks->level(1).samplesPerPeak == AudioPeaks::BaseSamplesPerPeak * AudioPeaks::LevelFactor);
+
+        for (int l = 0; l < peaks->levelCount(); ++l) {
+            for (qint64 first : {0, 12345, 99999, 250000}) {
+                qint64 last = first + 5000;
+                // align on the level resolution so that the result is exact
+                const qint64 spp = peaks->level(l).samplesPerPeak;
+                first = first / spp * spp;
+                last = qMin((qint64)length, (last + spp - 1) / spp * spp);
+                for (int c = 0; c < channels; ++c) {
+                    qint16 expectedMin = 32767, expectedMax = -32768;
+                    for (qint64 i = first; i < last; ++i) {
+                        expectedMin = qMin(expectedMin, interleaved[size_t(i * channels + c)]);
+                        expectedMax = qMax(expectedMax, interleaved[size_t(i * channels + c)]);
+                    }
+                    qint16 min, max;
+                    REQUIRE(peaks->peak(l, c, first, last, min, max));
+                    REQUIRE(min == expectedMin);
+                    REQUIRE(max == expectedMax);
+                }
+            }
+        }
+        // Resolution selection
+        REQUIRE(peaks->levelForResolution(1) == 0);
+        REQUIRE(peaks->levelForResolution(AudioPeaks::BaseSamplesPerPeak * AudioPeaks::LevelFactor) == 1);
+        REQUIRE(peaks->levelForResolution(1e12) == peaks->levelCount() - 1);
+        // Frame levels: one value per frame and channel
+        QList<double> levels = peaks->frameLevels(25);
+        REQUIRE(levels.size() == 250 * channels);
+        REQUIRE(levels.at(int(100000 / 1920) * channels + 1) > 200);
+        REQUIRE(levels.at(1) == 0);
+    }
+
+    SECTION("Save and load")
+    {
+        QTemporaryDir dir;
+        const QString path = dir.filePath(QStringLiteral("test.peaks"));
+        AudioPeaks::Builder builder(channels, rate);
+        builder.addSamples(interleaved.data(), length);
+        auto peaks = builder.finish(path);
+        REQUIRE(peaks != nullptr);
+        auto loaded = AudioPeaks::load(path);
+        REQUIRE(loaded != nullptr);
+        REQUIRE(loaded->sampleCount() == length);
+        REQUIRE(loaded->levelCount() == peaks->levelCount());
+        qint16 min, max;
+        REQUIRE(loaded->peak(0, 1, 0, length, min, max));
+        REQUIRE(max == 30000);
+        REQUIRE(min == 0);
+        REQUIRE(AudioPeaks::load(dir.filePath(QStringLiteral("missing.peaks"))) == nullptr);
+    }
+}
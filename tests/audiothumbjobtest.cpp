@@ -0,0 +1,47 @@
+#include "catch.hpp"
+#define protected public
+#include "jobs/audiothumbjob.hpp"
+#undef protected
+
+#include <QElapsedTimer>
+#include <QProcess>
+
+TEST_CASE("Audio thumbnail process output", "[AudioThumbs]")
+{
+    QProcess process;
+    QByteArray errors;
+    qint64 total = 0;
+    auto consume = [&total](const char *, qint64 size) { total += size; };
+
+    SECTION("Output is read until the process exits")
+    {
+        process.start(QStringLiteral("sh"), {QStringLiteral("-c"), QStringLiteral("head -c 200000 /dev/zero")});
+        REQUIRE(process.waitForStarted());
+        REQUIRE(AudioThumbJob::readProcessOutput(process, consume, []() { return false; }, errors));
+        REQUIRE(total == 200000);
+        REQUIRE(process.state() == QProcess::NotRunning);
+        REQUIRE(process.exitCode() == 0);
+    }
+
+    SECTION("Error output is collected")
+    {
+        process.start(QStringLiteral("sh"), {QStringLiteral("-c"), QStringLiteral("echo oops >&2; exit 3")});
+        REQUIRE(process.waitForStarted());
+        REQUIRE(AudioThumbJob::readProcessOutput(process, consume, []() { return false; }, errors));
+        errors.append(process.readAllStandardError());
+        REQUIRE(total == 0);
+        REQUIRE(errors.contains("oops"));
+        REQUIRE(process.exitCode() == 3);
+    }
+
+    SECTION("A stuck process is killed on cancelation")
+    {
+        process.start(QStringLiteral("sleep"), {QStringLiteral("30")});
+        REQUIRE(process.waitForStarted());
+        QElapsedTimer timer;
+        timer.start();
+        REQUIRE_FALSE(AudioThumbJob::readProcessOutput(process, consume, [&timer]() { return timer.elapsed() > 300; }, errors));
+        REQUIRE(timer.elapsed() < 5000);
+        REQUIRE(process.state() == QProcess::NotRunning);
+    }
+}
@@ -0,0 +1,49 @@
+#include "catch.hpp"
+#include "doc/autosavewriter.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+TEST_CASE("Autosave writer", "[AutoSave]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString autoSaveFile = dir.filePath(QStringLiteral("project.kdenlive"));
+    AutoSaveWriter writer;
+
+    SECTION("Write and clear")
+    {
+        QMap<QString, QString> replacements;
+        replacements.insert(QStringLiteral(">proxy/"), QStringLiteral(">/tmp/proxy/"));
+        writer.write(autoSaveFile, QStringLiteral("<mlt><property>proxy/a.mkv</property><property>proxy/b.mkv</property></mlt>"), replacements);
+        writer.waitForDone();
+        QFile file(autoSaveFile);
+        REQUIRE(file.open(QIODevice::ReadOnly));
+        REQUIRE(file.readAll() == QByteArray("<mlt><property>/tmp/proxy/a.mkv</property><property>/tmp/proxy/b.mkv</property></mlt>"));
+        file.close();
+
+        // A shorter scene replaces the whole content
+        writer.write(autoSaveFile, QStringLiteral("<mlt/>"), QMap<QString, QString>());
+        writer.clear(autoSaveFile);
+        writer.write(autoSaveFile, QStringLiteral("<mlt/>"), QMap<QString, QString>());
+        writer.waitForDone();
+        REQUIRE(file.open(QIODevice::ReadOnly));
+        REQUIRE(file.readAll() == QByteArray("<mlt/>"));
+        file.close();
+
+        writer.clear(autoSaveFile);
+        writer.waitForDone();
+        REQUIRE(QFileInfo(autoSaveFile).size() == 0);
+    }
+
+    SECTION("Write failures are reported")
+    {
+        const QString missing = dir.filePath(QStringLiteral("missing/project.kdenlive"));
+        QStringList failed;
+        QObject::connect(&writer, &AutoSaveWriter::writeFailed, [&failed](const QString &path) { failed << path; });
+        writer.write(missing, QStringLiteral("<mlt/>"), QMap<QString, QString>());
+        writer.waitForDone();
+        REQUIRE(failed == QStringList() << missing);
+    }
+}
@@ -0,0 +1,117 @@
+#include "test_utils.hpp"
+
+using namespace fakeit;
+Mlt::Profile profile_bin;
+
+TEST_CASE("Bin id, url and folder lookups", "[ProjectItemModel]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    REQUIRE(binModel->checkIndexConsistency());
+
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    QString binId = createProducer(profile_bin, "red", binModel);
+    QString binId2 = createProducer(profile_bin, "blue", binModel);
+    REQUIRE(binModel->checkIndexConsistency());
+
+    SECTION("Clip lookup")
+    {
+        REQUIRE(binModel->hasClip(binId));
+        REQUIRE(binModel->getClipByBinID(binId)->clipId() == binId);
+        REQUIRE(binModel->getClipByBinID(binId2)->clipId() == binId2);
+        // Track producers ids are resolved to their master clip
+        REQUIRE(binModel->getClipByBinID(binId + QStringLiteral("_video"))->clipId() == binId);
+        REQUIRE(binModel->getItemByBinId(binId) == binModel->getClipByBinID(binId));
+        REQUIRE_FALSE(binModel->isIdFree(binId));
+        REQUIRE(binModel->getClipByBinID(QStringLiteral("9999")) == nullptr);
+        REQUIRE(binModel->getFolderByBinId(binId) == nullptr);
+
+        auto clip = binModel->getClipByBinID(binId);
+        if (!clip->clipUrl().isEmpty()) {
+            REQUIRE(binModel->getClipByUrl(QFileInfo(clip->clipUrl())).contains(binId));
+        }
+    }
+
+    SECTION("Folder lookup and rename")
+    {
+        Fun undo = []() { return true; };
+        Fun redo = []() { return true; };
+        QString folderId;
+        REQUIRE(binModel->requestAddFolder(folderId, QStringLiteral("folder"), binModel->getRootFolder()->clipId(), undo, redo));
+        REQUIRE(binModel->checkIndexConsistency());
+        REQUIRE(binModel->getFolderIdByName(QStringLiteral("folder")) == folderId);
+        REQUIRE(binModel->getFolderByBinId(folderId)->clipId() == folderId);
+        REQUIRE(binModel->getClipByBinID(folderId) == nullptr);
+
+        REQUIRE(binModel->requestRenameFolder(binModel->getFolderByBinId(folderId), QStringLiteral("renamed"), undo, redo));
+        REQUIRE(binModel->checkIndexConsistency());
+        REQUIRE(binModel->getFolderIdByName(QStringLiteral("folder")).isEmpty());
+        REQUIRE(binModel->getFolderIdByName(QStringLiteral("renamed")) == folderId);
+
+        REQUIRE(undo());
+        REQUIRE(binModel->checkIndexConsistency());
+        REQUIRE(binModel->getFolderIdByName(QStringLiteral("renamed")).isEmpty());
+        REQUIRE(binModel->getFolderByBinId(folderId) == nullptr);
+        REQUIRE(binModel->isIdFree(folderId));
+    }
+
+    SECTION("Deletion")
+    {
+        Fun undo = []() { return true; };
+        Fun redo = []() { return true; };
+        REQUIRE(binModel->requestBinClipDeletion(binModel->getClipByBinID(binId), undo, redo));
+        REQUIRE(binModel->checkIndexConsistency());
+        REQUIRE(binModel->getClipByBinID(binId) == nullptr);
+        REQUIRE(binModel->isIdFree(binId));
+
+        REQUIRE(undo());
+        REQUIRE(binModel->checkIndexConsistency());
+        REQUIRE(binModel->getClipByBinID(binId)->clipId() == binId);
+    }
+    binModel->clean();
+    REQUIRE(binModel->checkIndexConsistency());
+}
+
+TEST_CASE("Bin lookup cost as the bin grows", "[.][Benchmark][ProjectItemModel]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    std::vector<QString> ids;
+    for (int size : {250, 1000, 4000}) {
+        while ((int)ids.size() < size) {
+            ids.push_back(createProducer(profile_bin, "red", binModel));
+        }
+        REQUIRE(binModel->checkIndexConsistency());
+        std::string name = std::to_string(size) + " clips: getClipByBinID x1000";
+        int found = 0;
+        BENCHMARK(name)
+        {
+            found = 0;
+            for (size_t i = 0; i < 1000; ++i) {
+                found += binModel->getClipByBinID(ids[(i * 7919) % ids.size()]) != nullptr ? 1 : 0;
+            }
+        }
+        REQUIRE(found == 1000);
+        name = std::to_string(size) + " clips: getClipByUrl x1000";
+        QFileInfo url(binModel->getClipByBinID(ids.front())->clipUrl());
+        BENCHMARK(name)
+        {
+            for (size_t i = 0; i < 1000; ++i) {
+                binModel->getClipByUrl(url);
+            }
+        }
+    }
+    binModel->clean();
+}
@@ -414,3 +414,82 @@ TEST_CASE("Composition manipulation", "[CompositionModel]")
     }
     Logger::print_trace();
 }
+
+TEST_CASE("Compositions stay sorted in the field", "[CompositionModel]")
+{
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel(new MarkerListModel(undoStack));
+    std::shared_ptr<TimelineItemModel> timeline = TimelineItemModel::construct(&profile_composition, guideModel, undoStack);
+
+    std::vector<int> tracks;
+    for (int i = 0; i < 6; ++i) {
+        tracks.push_back(TrackModel::construct(timeline));
+    }
+    // Insert compositions on tracks in a scrambled order
+    std::vector<int> compos;
+    const std::vector<int> order{3, 1, 5, 2, 4, 1, 5, 3};
+    for (size_t i = 0; i < order.size(); ++i) {
+        int cid = CompositionModel::construct(timeline, aCompo);
+        REQUIRE(timeline->requestCompositionMove(cid, tracks[size_t(order[i])], int(i) * 20));
+        REQUIRE(timeline->checkCompositionOrder());
+        compos.push_back(cid);
+    }
+    REQUIRE(timeline->checkConsistency());
+
+    // Moving across tracks only replants the moved composition
+    REQUIRE(timeline->requestCompositionMove(compos[2], tracks[1], 300));
+    REQUIRE(timeline->checkCompositionOrder());
+    REQUIRE(timeline->requestCompositionMove(compos[1], tracks[5], 400));
+    REQUIRE(timeline->checkCompositionOrder());
+    REQUIRE(timeline->checkConsistency());
+
+    // Undo restores a valid order
+    while (undoStack->canUndo()) {
+        undoStack->undo();
+        REQUIRE(timeline->checkCompositionOrder());
+    }
+    REQUIRE(timeline->checkConsistency());
+    while (undoStack->canRedo()) {
+        undoStack->redo();
+        REQUIRE(timeline->checkCompositionOrder());
+    }
+    REQUIRE(timeline->checkConsistency());
+
+    // The full replant gives the same result
+    REQUIRE(timeline->replantAllCompositions(-1, false));
+    REQUIRE(timeline->checkCompositionOrder());
+    REQUIRE(timeline->checkConsistency());
+}
+
+TEST_CASE("Composition replant cost", "[.][Benchmark][CompositionModel]")
+{
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel(new MarkerListModel(undoStack));
+    std::shared_ptr<TimelineItemModel> timeline = TimelineItemModel::construct(&profile_composition, guideModel, undoStack);
+
+    std::vector<int> tracks;
+    for (int i = 0; i < 8; ++i) {
+        tracks.push_back(TrackModel::construct(timeline));
+    }
+    std::vector<int> compos;
+    for (int i = 0; i < 320; ++i) {
+        int cid = CompositionModel::construct(timeline, aCompo);
+        REQUIRE(timeline->requestCompositionMove(cid, tracks[size_t(1 + i % 7)], i * 10, false, false));
+        compos.push_back(cid);
+    }
+    REQUIRE(timeline->checkCompositionOrder());
+    int moved = compos[160];
+    BENCHMARK("320 compositions: incremental replant")
+    {
+        timeline->unplantComposition(moved);
+        timeline->replantCompositions(moved, false);
+    }
+    REQUIRE(timeline->checkCompositionOrder());
+    BENCHMARK("320 compositions: full replant")
+    {
+        timeline->unplantComposition(moved);
+        timeline->replantAllCompositions(moved, false);
+    }
+    REQUIRE(timeline->checkCompositionOrder());
+    REQUIRE(timeline->checkConsistency());
+}
@@ -0,0 +1,84 @@
+#include "catch.hpp"
+#include "utils/filehashcache.hpp"
+
+#include <QCryptographicHash>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+namespace {
+QByteArray makeData(int size, char seed)
+{
+    QByteArray data(size, 0);
+    for (int i = 0; i < size; ++i) {
+        data[i] = char(seed + i * 7 + i / 1000);
+    }
+    return data;
+}
+
+QString writeFile(const QTemporaryDir &dir, const QString &name, const QByteArray &data)
+{
+    const QString path = dir.filePath(name);
+    QFile file(path);
+    REQUIRE(file.open(QIODevice::WriteOnly));
+    REQUIRE(file.write(data) == data.size());
+    return path;
+}
+} // namespace
+
+TEST_CASE("File hashes", "[FileHash]")
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+
+    SECTION("Hashes are the MD5 of the start and end of the file, as stored in projects")
+    {
+        const QByteArray small = makeData(5000, 1);
+        const QString smallPath = writeFile(dir, QStringLiteral("small.mp4"), small);
+        REQUIRE(FileHashCache::computeHash(smallPath) == QString::fromLatin1(QCryptographicHash::hash(small, QCryptographicHash::Md5).toHex()));
+
+        const QByteArray large = makeData(3000000, 2);
+        const QString largePath = writeFile(dir, QStringLiteral("large.mp4"), large);
+        const QByteArray hashed = large.left(1000000) + large.right(1000000);
+        const QString expected = QString::fromLatin1(QCryptographicHash::hash(hashed, QCryptographicHash::Md5).toHex());
+        REQUIRE(FileHashCache::computeHash(largePath) == expected);
+
+        qint64 size = 0;
+        REQUIRE(FileHashCache::get()->hash(largePath, &size) == expected);
+        REQUIRE(size == large.size());
+        // Second call is answered by the cache
+        REQUIRE(FileHashCache::get()->hash(largePath) == expected);
+
+        REQUIRE(FileHashCache::computeHash(writeFile(dir, QStringLiteral("empty.mp4"), QByteArray())) ==
+                QString::fromLatin1(QCryptographicHash::hash(QByteArray(), QCryptographicHash::Md5).toHex()));
+        REQUIRE(FileHashCache::get()->hash(dir.filePath(QStringLiteral("missing.mp4"))).isEmpty());
+    }
+
+    SECTION("Modified files are hashed again")
+    {
+        const QString path = writeFile(dir, QStringLiteral("clip.mp4"), makeData(1000, 3));
+        const QString before = FileHashCache::get()->hash(path);
+        QFile file(path);
+        REQUIRE(file.open(QIODevice::Append));
+        file.write("more");
+        file.close();
+        const QString after = FileHashCache::get()->hash(path);
+        REQUIRE(after != before);
+        REQUIRE(after == FileHashCache::computeHash(path));
+    }
+
+    SECTION("Files are hashed in parallel")
+    {
+        QStringList paths;
+        for (int i = 0; i < 8; ++i) {
+            paths << writeFile(dir, QStringLiteral("clip%1.mp4").arg(i), makeData(10000 + i, char(i)));
+        }
+        paths << dir.filePath(QStringLiteral("missing.mp4"));
+        const QMap<QString, QString> hashes = FileHashCache::get()->hashFiles(paths);
+        REQUIRE(hashes.size() == 8);
+        for (int i = 0; i < 8; ++i) {
+            REQUIRE(hashes.value(paths.at(i)) == FileHashCache::computeHash(paths.at(i)));
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#include "catch.hpp"
+#include "jobs/jobscheduler.hpp"
+
+#include <QMutex>
+#include <QSemaphore>
+#include <QStringList>
+
+TEST_CASE("Job scheduler ordering and limits", "[JobScheduler]")
+{
+    JobScheduler scheduler;
+    scheduler.setLimit(AbstractClipJob::CPURESOURCE, 1);
+    QSemaphore blocked;
+    QSemaphore started;
+    QSemaphore done;
+    QMutex mutex;
+    QStringList order;
+    auto record = [&](const QString &name) {
+        return [&, name](bool run) {
+            if (run) {
+                QMutexLocker locker(&mutex);
+                order << name;
+            }
+            done.release();
+        };
+    };
+    // Occupy the only cpu slot so that the following tasks are queued
+    scheduler.schedule(0, QStringLiteral("0"), AbstractClipJob::BACKGROUNDPRIORITY, AbstractClipJob::CPURESOURCE, [&](bool) {
+        started.release();
+        blocked.acquire();
+        done.release();
+    });
+    started.acquire();
+
+    SECTION("Priority classes, then boosted clips, then submission order")
+    {
+        scheduler.schedule(1, QStringLiteral("a"), AbstractClipJob::AUDIOTHUMBPRIORITY, AbstractClipJob::CPURESOURCE, record(QStringLiteral("audio")));
+        scheduler.schedule(2, QStringLiteral("b"), AbstractClipJob::INTERACTIVEPRIORITY, AbstractClipJob::CPURESOURCE, record(QStringLiteral("thumb b")));
+        scheduler.schedule(3, QStringLiteral("c"), AbstractClipJob::INTERACTIVEPRIORITY, AbstractClipJob::CPURESOURCE, record(QStringLiteral("thumb c")));
+        scheduler.schedule(4, QStringLiteral("d"), AbstractClipJob::INTERACTIVEPRIORITY, AbstractClipJob::CPURESOURCE, record(QStringLiteral("thumb d")));
+        scheduler.setBoostedClips({QStringLiteral("d")});
+        REQUIRE(scheduler.pendingCount() == 4);
+        blocked.release();
+        done.acquire(5);
+        REQUIRE(order == QStringList({QStringLiteral("thumb d"), QStringLiteral("thumb b"), QStringLiteral("thumb c"), QStringLiteral("audio")}));
+    }
+
+    SECTION("Resource classes have their own slots")
+    {
+        scheduler.schedule(1, QStringLiteral("a"), AbstractClipJob::LOADPRIORITY, AbstractClipJob::IORESOURCE, record(QStringLiteral("load")));
+        // The io task runs although the cpu slot is busy
+        done.acquire();
+        REQUIRE(order == QStringList({QStringLiteral("load")}));
+        blocked.release();
+        done.acquire();
+    }
+
+    SECTION("Dropped tasks are notified without running")
+    {
+        scheduler.schedule(1, QStringLiteral("a"), AbstractClipJob::INTERACTIVEPRIORITY, AbstractClipJob::CPURESOURCE, record(QStringLiteral("dropped")));
+        scheduler.schedule(2, QStringLiteral("b"), AbstractClipJob::INTERACTIVEPRIORITY, AbstractClipJob::CPURESOURCE, record(QStringLiteral("kept")));
+        scheduler.drop(1);
+        done.acquire();
+        REQUIRE(order.isEmpty());
+        blocked.release();
+        done.acquire(2);
+        REQUIRE(order == QStringList({QStringLiteral("kept")}));
+    }
+}
@@ -1,7 +1,10 @@
 #include <memory>
+#include <tuple>
 
 #include "test_utils.hpp"
 
+#include "assets/keyframes/model/keyframecurve.hpp"
+
 using namespace fakeit;
 
 bool test_model_equality(const std::shared_ptr<KeyframeModel> &m1, const std::shared_ptr<KeyframeModel> &m2)
@@ -250,3 +253,63 @@ TEST_CASE("Keyframe model", "[KeyframeModel]")
     pCore->m_projectManager = nullptr;
     Logger::print_trace();
 }
+
+TEST_CASE("Native keyframe interpolation", "[KeyframeModel]")
+{
+    // Keyframes given as (frame, type, value), the curves must match the MLT animation built from the same keyframes
+    auto mltSeparator = [](KeyframeType type) {
+        switch (type) {
+        case KeyframeType::Discrete:
+            return QStringLiteral("|=");
+        case KeyframeType::Curve:
+            return QStringLiteral("~=");
+        default:
+            return QStringLiteral("=");
+        }
+    };
+    std::vector<std::tuple<int, KeyframeType, double>> keys{{0, KeyframeType::Curve, 10},   {12, KeyframeType::Discrete, 40}, {20, KeyframeType::Curve, -5},
+                                                            {35, KeyframeType::Curve, 80},  {50, KeyframeType::Linear, 3},    {60, KeyframeType::Curve, 12},
+                                                            {61, KeyframeType::Linear, 50}, {75, KeyframeType::Linear, 0}};
+
+    SECTION("Double values")
+    {
+        KeyframeCurve curve(KeyframeCurve::ValueType::Double, 25);
+        QStringList anim;
+        for (const auto &key : keys) {
+            curve.append(std::get<0>(key), std::get<1>(key), QVariant(std::get<2>(key)));
+            anim << QString::number(std::get<0>(key)) + mltSeparator(std::get<1>(key)) + QString::number(std::get<2>(key));
+        }
+        Mlt::Properties prop;
+        prop.set("key", anim.join(QLatin1Char(';')).toUtf8().constData());
+        for (int frame = -10; frame < 90; ++frame) {
+            double expected = prop.anim_get_double("key", frame, 100);
+            REQUIRE(curve.doubleValue(frame) == Approx(expected).margin(1e-9));
+        }
+        // On keyframes, the stored value is returned unchanged
+        REQUIRE(curve.value(12) == QVariant(40.));
+    }
+
+    SECTION("Rect values")
+    {
+        KeyframeCurve curve(KeyframeCurve::ValueType::Rect, 25);
+        QStringList anim;
+        for (const auto &key : keys) {
+            int v = (int)std::get<2>(key);
+            QString value = QStringLiteral("%1 %2 %3 %4 %5").arg(v).arg(2 * v).arg(300 + v).arg(200 - v).arg(v > 10 ? 1 : 0);
+            curve.append(std::get<0>(key), std::get<1>(key), QVariant(value));
+            anim << QString::number(std::get<0>(key)) + mltSeparator(std::get<1>(key)) + value;
+        }
+        Mlt::Properties prop;
+        prop.set("key", anim.join(QLatin1Char(';')).toUtf8().constData());
+        for (int frame = -10; frame < 90; ++frame) {
+            mlt_rect expected = prop.anim_get_rect("key", frame, 100);
+            mlt_rect rect = curve.rectValue(frame);
+            REQUIRE(rect.x == Approx(expected.x).margin(1e-9));
+            REQUIRE(rect.y == Approx(expected.y).margin(1e-9));
+            REQUIRE(rect.w == Approx(expected.w).margin(1e-9));
+            REQUIRE(rect.h == Approx(expected.h).margin(1e-9));
+            REQUIRE(rect.o == Approx(expected.o).margin(1e-9));
+        }
+        REQUIRE(curve.value(30).toString() == KeyframeCurve::rectToString(curve.rectValue(30)));
+    }
+}
@@ -0,0 +1,70 @@
+#include "catch.hpp"
+#include "utils/mediaprobecache.hpp"
+
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+TEST_CASE("Media probe cache", "[ProbeCache]")
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("clip.mp4"));
+    QFile file(path);
+    REQUIRE(file.open(QIODevice::WriteOnly));
+    file.write("0123456789");
+    file.close();
+
+    QMap<QString, QString> properties;
+    properties.insert(QStringLiteral("length"), QStringLiteral("250"));
+    properties.insert(QStringLiteral("meta.media.nb_streams"), QStringLiteral("2"));
+    properties.insert(QStringLiteral("meta.media.0.stream.type"), QStringLiteral("video"));
+
+    QMap<QString, QString> cached;
+    REQUIRE_FALSE(MediaProbeCache::get()->lookup(path, 25., cached));
+    REQUIRE_FALSE(MediaProbeCache::get()->lookup(dir.filePath(QStringLiteral("missing.mp4")), 25., cached));
+
+    SECTION("Unchanged files are found")
+    {
+        MediaProbeCache::get()->store(path, 25., properties);
+        REQUIRE(MediaProbeCache::get()->lookup(path, 25., cached));
+        REQUIRE(cached == properties);
+    }
+
+    SECTION("Entries are only used with the same frame rate")
+    {
+        // The length is counted in frames
+        MediaProbeCache::get()->store(path, 25., properties);
+        REQUIRE_FALSE(MediaProbeCache::get()->lookup(path, 30000. / 1001., cached));
+        MediaProbeCache::get()->store(path, 30000. / 1001., properties);
+        REQUIRE(MediaProbeCache::get()->lookup(path, 30000. / 1001., cached));
+        REQUIRE_FALSE(MediaProbeCache::get()->lookup(path, 25., cached));
+    }
+
+    SECTION("Modified files are probed again")
+    {
+        MediaProbeCache::get()->store(path, 25., properties);
+        REQUIRE(file.open(QIODevice::Append));
+        file.write("more data");
+        file.close();
+        REQUIRE_FALSE(MediaProbeCache::get()->lookup(path, 25., cached));
+    }
+
+    SECTION("Replaced files are probed again")
+    {
+        MediaProbeCache::get()->store(path, 25., properties);
+        MediaProbeCache::FileKey before;
+        REQUIRE(MediaProbeCache::fileKey(path, before));
+        const QString other = dir.filePath(QStringLiteral("other.mp4"));
+        REQUIRE(QFile::copy(path, other));
+        REQUIRE(QFile::remove(path));
+        REQUIRE(QFile::rename(other, path));
+        MediaProbeCache::FileKey after;
+        REQUIRE(MediaProbeCache::fileKey(path, after));
+        if (!(after == before)) {
+            REQUIRE_FALSE(MediaProbeCache::get()->lookup(path, 25., cached));
+        }
+    }
+    QFile::remove(path);
+}
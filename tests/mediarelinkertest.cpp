@@ -0,0 +1,72 @@
+#include "catch.hpp"
+#include "doc/mediarelinker.h"
+#include "utils/filehashcache.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+
+namespace {
+QString createFile(const QString &path, const QByteArray &data)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    REQUIRE(file.open(QIODevice::WriteOnly));
+    REQUIRE(file.write(data) == data.size());
+    return QFileInfo(path).absoluteFilePath();
+}
+} // namespace
+
+TEST_CASE("Relink missing clips", "[Relink]")
+{
+    QStandardPaths::setTestModeEnabled(true);
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    // Two clips of the same size with different content, one clip with a unique size
+    const QString first = createFile(dir.filePath(QStringLiteral("a/b/first.mp4")), QByteArray(1000, 'a'));
+    const QString second = createFile(dir.filePath(QStringLiteral("a/c/second.mp4")), QByteArray(1000, 'b'));
+    const QString third = createFile(dir.filePath(QStringLiteral("third.mp4")), QByteArray(2000, 'c'));
+    // Same name as the first clip, closer to the root
+    const QString homonym = createFile(dir.filePath(QStringLiteral("a/first.mp4")), QByteArray(10, 'd'));
+
+    MediaRelinker relinker(dir.path());
+    QList<int> folderProgress;
+    relinker.crawl([&folderProgress](int folders, int) { folderProgress << folders; });
+    REQUIRE(relinker.fileCount() == 4);
+    REQUIRE(relinker.folderCount() == 4);
+    REQUIRE(!folderProgress.isEmpty());
+    REQUIRE(folderProgress.last() == 4);
+
+    QList<MediaRelinker::Clip> clips;
+    MediaRelinker::Clip clip;
+    clip.size = 1000;
+    clip.hash = FileHashCache::computeHash(second);
+    clips << clip;
+    clip.hash = FileHashCache::computeHash(first);
+    clips << clip;
+    clip.size = 2000;
+    clip.hash = FileHashCache::computeHash(third);
+    clips << clip;
+    // Right size, wrong content
+    clip.size = 1000;
+    clip.hash = FileHashCache::computeHash(third);
+    clips << clip;
+    // Unknown size
+    clip.size = -1;
+    clips << clip;
+
+    const QStringList found = relinker.resolve(clips);
+    REQUIRE(found.count() == 5);
+    REQUIRE(found.at(0) == second);
+    REQUIRE(found.at(1) == first);
+    REQUIRE(found.at(2) == third);
+    REQUIRE(found.at(3).isEmpty());
+    REQUIRE(found.at(4).isEmpty());
+
+    REQUIRE(relinker.findByName(QStringLiteral("first.mp4")) == homonym);
+    // File names are compared without case, like the previous search did
+    REQUIRE(relinker.findByName(QStringLiteral("FIRST.MP4")) == homonym);
+    REQUIRE(relinker.findByName(QStringLiteral("Third.mp4")) == third);
+    REQUIRE(relinker.findByName(QStringLiteral("missing.mp4")).isEmpty());
+}
@@ -815,6 +815,53 @@ TEST_CASE("Clip manipulation", "[ClipModel]")
         check_undo(8, tid2, tid1);
     }
 
+    SECTION("Group move around ungrouped clips")
+    {
+        // cid2 is not part of the group and sits between two grouped clips of the same track
+        REQUIRE(timeline->requestClipMove(cid1, tid1, 0));
+        REQUIRE(timeline->requestClipMove(cid2, tid1, length + 5));
+        REQUIRE(timeline->requestClipMove(cid3, tid1, 2 * length + 10));
+        REQUIRE(timeline->requestClipMove(cid4, tid2, 4));
+        REQUIRE(timeline->requestClipsGroup({cid1, cid3, cid4}));
+        auto state = [&](int delta) {
+            REQUIRE(timeline->checkConsistency());
+            REQUIRE(timeline->getTrackClipsCount(tid1) == 3);
+            REQUIRE(timeline->getTrackClipsCount(tid2) == 1);
+            REQUIRE(timeline->getClipTrackId(cid1) == tid1);
+            REQUIRE(timeline->getClipTrackId(cid3) == tid1);
+            REQUIRE(timeline->getClipTrackId(cid4) == tid2);
+            REQUIRE(timeline->getClipPosition(cid1) == delta);
+            REQUIRE(timeline->getClipPosition(cid2) == length + 5);
+            REQUIRE(timeline->getClipPosition(cid3) == 2 * length + 10 + delta);
+            REQUIRE(timeline->getClipPosition(cid4) == 4 + delta);
+        };
+        state(0);
+        int undo_index = undoStack->index();
+
+        REQUIRE(timeline->requestClipMove(cid1, tid1, 3));
+        state(3);
+        // the whole group move is a single undo entry
+        REQUIRE(undoStack->index() == undo_index + 1);
+        undoStack->undo();
+        state(0);
+        undoStack->redo();
+        state(3);
+
+        // cid1 would overlap cid2, nothing moves
+        REQUIRE_FALSE(timeline->requestClipMove(cid1, tid1, 6));
+        state(3);
+        REQUIRE_FALSE(timeline->requestClipMove(cid1, tid1, -1));
+        state(3);
+
+        // jump over cid2, up to the end of the track
+        REQUIRE(timeline->requestClipMove(cid1, tid1, 2 * length + 6));
+        state(2 * length + 6);
+        undoStack->undo();
+        state(3);
+        undoStack->undo();
+        state(0);
+    }
+
     SECTION("Group move to unavailable track")
     {
         REQUIRE(timeline->requestClipMove(cid1, tid1, 10));
@@ -1735,6 +1782,53 @@ TEST_CASE("Snapping", "[Snapping]")
         REQUIRE(timeline->getTrackById(tid1)->getBlankSizeNearClip(cid1, true) == 0);
         REQUIRE(timeline->getTrackById(tid1)->getBlankSizeNearClip(cid2, true) == INT_MAX);
     }
+    SECTION("Position queries")
+    {
+        auto track = timeline->getTrackById(tid1);
+        REQUIRE(track->getClipByPosition(0) == -1);
+        REQUIRE(track->isBlankAt(0));
+        REQUIRE(track->getBlankEnd(0) == INT_MAX);
+        REQUIRE(timeline->requestClipMove(cid1, tid1, 10));
+        REQUIRE(timeline->requestClipMove(cid2, tid1, 20 + length));
+        auto check = [&]() {
+            REQUIRE(timeline->checkConsistency());
+            REQUIRE(track->getClipByPosition(9) == -1);
+            REQUIRE(track->getClipByPosition(10) == cid1);
+            REQUIRE(track->getClipByPosition(9 + length) == cid1);
+            REQUIRE(track->getClipByPosition(10 + length) == -1);
+            REQUIRE(track->getClipByPosition(20 + length) == cid2);
+            REQUIRE(track->getClipByPosition(20 + length + length2) == -1);
+            REQUIRE(track->isBlankAt(5));
+            REQUIRE_FALSE(track->isBlankAt(10));
+            REQUIRE(track->getBlankStart(15 + length) == 10 + length);
+            REQUIRE(track->getBlankStart(15) == 15);
+            REQUIRE(track->getBlankEnd(15 + length) == 20 + length);
+            REQUIRE(track->getBlankEnd(30 + length + length2) == INT_MAX);
+            REQUIRE(track->getBlankSizeAtPos(5) == 10);
+            REQUIRE(track->getBlankSizeAtPos(15 + length) == 10);
+            REQUIRE(track->getClipsInRange(0, 10) == std::unordered_set<int>{});
+            REQUIRE(track->getClipsInRange(0, 11) == std::unordered_set<int>{cid1});
+            REQUIRE(track->getClipsInRange(9 + length, 21 + length) == std::unordered_set<int>{cid1, cid2});
+            REQUIRE(track->getClipsInRange(10 + length, -1) == std::unordered_set<int>{cid2});
+        };
+        check();
+
+        // resizing updates the index
+        REQUIRE(timeline->requestItemResize(cid1, length - 5, false, true) == length - 5);
+        REQUIRE(timeline->checkConsistency());
+        REQUIRE(track->getClipByPosition(10) == -1);
+        REQUIRE(track->getClipByPosition(15) == cid1);
+        REQUIRE(track->getBlankStart(12) == 0);
+        undoStack->undo();
+        check();
+
+        // as well as deletion
+        REQUIRE(timeline->requestItemDeletion(cid2));
+        REQUIRE(track->getClipByPosition(20 + length) == -1);
+        REQUIRE(track->getClipsInRange(0, -1) == std::unordered_set<int>{cid1});
+        undoStack->undo();
+        check();
+    }
     SECTION("Snap move to a single clip")
     {
         int beg = 30;
@@ -1788,3 +1882,93 @@ TEST_CASE("Snapping", "[Snapping]")
     pCore->m_projectManager = nullptr;
     Logger::print_trace();
 }
+
+TEST_CASE("Clip view state", "[ClipModel]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    std::shared_ptr<TimelineItemModel> timeline = TimelineItemModel::construct(&profile_model, guideModel, undoStack);
+
+    QString binId = createProducer(profile_model, "red", binModel);
+    int tid = TrackModel::construct(timeline);
+    int cid = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+    REQUIRE(timeline->requestClipMove(cid, tid, 0));
+    QModelIndex ix = timeline->makeClipIndexFromID(cid);
+
+    QString service = timeline->data(ix, TimelineModel::ServiceRole).toString();
+    REQUIRE(service == timeline->getClipPtr(cid)->getProperty(QStringLiteral("mlt_service")));
+    QString name = timeline->data(ix, TimelineModel::NameRole).toString();
+    REQUIRE_FALSE(name.isEmpty());
+
+    // The displayed name is cached until the model is notified
+    Mlt::Producer *producer = timeline->getClipPtr(cid)->service();
+    if (producer->parent().is_valid()) {
+        producer->parent().set("kdenlive:clipname", "renamed");
+    } else {
+        producer->set("kdenlive:clipname", "renamed");
+    }
+    REQUIRE(timeline->data(ix, TimelineModel::NameRole).toString() == name);
+    timeline->requestClipUpdate(cid, {TimelineModel::NameRole});
+    REQUIRE(timeline->data(ix, TimelineModel::NameRole).toString() == QLatin1String("renamed"));
+    REQUIRE(timeline->data(ix, Qt::DisplayRole).toString() == QLatin1String("renamed"));
+    REQUIRE(timeline->data(ix, TimelineModel::ServiceRole).toString() == service);
+
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Timeline data cost", "[.][Benchmark][ClipModel]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    std::shared_ptr<MarkerListModel> guideModel = std::make_shared<MarkerListModel>(undoStack);
+
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    std::shared_ptr<TimelineItemModel> timeline = TimelineItemModel::construct(&profile_model, guideModel, undoStack);
+
+    QString binId = createProducer(profile_model, "red", binModel, 10);
+    int tid = TrackModel::construct(timeline);
+    std::vector<QModelIndex> indexes;
+    for (int i = 0; i < 200; ++i) {
+        int cid = ClipModel::construct(timeline, binId, -1, PlaylistState::VideoOnly);
+        REQUIRE(timeline->requestClipMove(cid, tid, i * 10));
+        indexes.push_back(timeline->makeClipIndexFromID(cid));
+    }
+    const std::vector<int> roles{TimelineModel::NameRole, TimelineModel::ResourceRole, TimelineModel::ServiceRole, TimelineModel::EffectNamesRole,
+                                 TimelineModel::StartRole, TimelineModel::DurationRole};
+    int valid = 0;
+    BENCHMARK("200 clips: data() for 6 roles")
+    {
+        valid = 0;
+        for (const QModelIndex &ix : indexes) {
+            for (int role : roles) {
+                valid += timeline->data(ix, role).isValid() ? 1 : 0;
+            }
+        }
+    }
+    REQUIRE(valid == 200 * 6);
+    BENCHMARK("200 clips: data() for 6 roles after name change")
+    {
+        for (const QModelIndex &ix : indexes) {
+            timeline->notifyChange(ix, ix, TimelineModel::NameRole);
+            for (int role : roles) {
+                timeline->data(ix, role);
+            }
+        }
+    }
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
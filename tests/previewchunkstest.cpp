@@ -0,0 +1,78 @@
+#include "catch.hpp"
+#define private public
+#include "timeline2/view/previewmanager.h"
+#undef private
+
+#include <QDateTime>
+#include <QFile>
+#include <QTemporaryDir>
+
+namespace {
+void writeChunk(const QDir &dir, const QString &name, int size, int age)
+{
+    QFile file(dir.absoluteFilePath(name));
+    REQUIRE(file.open(QIODevice::WriteOnly));
+    REQUIRE(file.write(QByteArray(size, 'x')) == size);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+    REQUIRE(file.setFileTime(QDateTime::currentDateTime().addSecs(-age), QFileDevice::FileModificationTime));
+#else
+    Q_UNUSED(age)
+#endif
+}
+} // namespace
+
+TEST_CASE("Timeline preview chunk store", "[Preview]")
+{
+    QTemporaryDir temp;
+    REQUIRE(temp.isValid());
+    QDir root(temp.path());
+    REQUIRE(root.mkpath(QStringLiteral("preview")));
+    REQUIRE(root.mkpath(QStringLiteral("previewchunks")));
+    const QDir cacheDir(root.absoluteFilePath(QStringLiteral("preview")));
+    const QDir storeDir(root.absoluteFilePath(QStringLiteral("previewchunks")));
+
+    SECTION("Eviction deletes the oldest unused chunks until the store fits")
+    {
+        writeChunk(storeDir, QStringLiteral("a.mp4"), 1000, 50);
+        writeChunk(storeDir, QStringLiteral("b.mp4"), 1000, 40);
+        writeChunk(storeDir, QStringLiteral("c.mp4"), 1000, 30);
+        writeChunk(storeDir, QStringLiteral("d.mp4"), 1000, 20);
+        // a is the oldest but is used by the timeline
+        PreviewManager::evictChunks(storeDir, {QStringLiteral("a.mp4")}, 2500);
+        REQUIRE(storeDir.exists(QStringLiteral("a.mp4")));
+        REQUIRE(storeDir.entryList(QDir::Files).count() == 2);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+        REQUIRE_FALSE(storeDir.exists(QStringLiteral("b.mp4")));
+        REQUIRE_FALSE(storeDir.exists(QStringLiteral("c.mp4")));
+        REQUIRE(storeDir.exists(QStringLiteral("d.mp4")));
+#endif
+    }
+
+    SECTION("Used chunks are kept even if the store stays too large")
+    {
+        writeChunk(storeDir, QStringLiteral("a.mp4"), 1000, 50);
+        writeChunk(storeDir, QStringLiteral("b.mp4"), 1000, 40);
+        PreviewManager::evictChunks(storeDir, {QStringLiteral("a.mp4"), QStringLiteral("b.mp4")}, 0);
+        REQUIRE(storeDir.entryList(QDir::Files).count() == 2);
+    }
+
+    SECTION("Chunks of previous versions are moved to the store")
+    {
+        writeChunk(cacheDir, QStringLiteral("0.mp4"), 100, 0);
+        writeChunk(cacheDir, QStringLiteral("25.mp4"), 200, 0);
+        writeChunk(cacheDir, QStringLiteral("50.mp4"), 300, 0);
+        writeChunk(cacheDir, QStringLiteral("preview.mlt"), 10, 0);
+        // The content of frame 25 was already rendered by another project
+        writeChunk(storeDir, QStringLiteral("bbb.mp4"), 250, 0);
+        QHash<int, QString> keys;
+        keys.insert(0, QStringLiteral("aaa"));
+        keys.insert(25, QStringLiteral("bbb"));
+        PreviewManager::migrateLegacyChunks(cacheDir, storeDir, QStringLiteral("mp4"), keys);
+        // Listed chunks are kept under their key, the other ones are removed
+        REQUIRE(cacheDir.entryList({QStringLiteral("*.mp4")}, QDir::Files).isEmpty());
+        REQUIRE(cacheDir.exists(QStringLiteral("preview.mlt")));
+        REQUIRE(QFileInfo(storeDir.absoluteFilePath(QStringLiteral("aaa.mp4"))).size() == 100);
+        REQUIRE(QFileInfo(storeDir.absoluteFilePath(QStringLiteral("bbb.mp4"))).size() == 250);
+        REQUIRE(storeDir.entryList(QDir::Files).count() == 2);
+    }
+}
@@ -0,0 +1,120 @@
+#include "catch.hpp"
+#include "doc/scenelistwriter.h"
+
+#include <QDir>
+#include <QDomDocument>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+
+TEST_CASE("Streaming project save", "[Save]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString path = dir.filePath(QStringLiteral("project.kdenlive"));
+    const QString scene = QStringLiteral("<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+                                         "<mlt LC_NUMERIC=\"C\" root=\"/tmp\">\n"
+                                         "  <producer id=\"p1\" in=\"0\" out=\"10\">\n"
+                                         "    <property name=\"resource\">proxy/a.mkv</property>\n"
+                                         "    <property name=\"kdenlive:originalurl\">/cache/proxy/b.mkv</property>\n"
+                                         "    <property name=\"kdenlive:clipname\">A &amp; B &lt;1&gt;</property>\n"
+                                         "  </producer>\n"
+                                         "  <tractor id=\"maintractor\">\n"
+                                         "    <property name=\"meta.volume\">0.5</property>\n"
+                                         "    <track producer=\"p1\"/>\n"
+                                         "  </tractor>\n"
+                                         "</mlt>\n");
+
+    SECTION("The scene is rewritten with the same content")
+    {
+        QMap<QString, QString> replacements;
+        replacements.insert(QStringLiteral(">proxy/"), QStringLiteral(">/new/proxy/"));
+        replacements.insert(QStringLiteral("/cache/proxy/"), QStringLiteral("/new/proxy/"));
+        QList<int> progress;
+        QString error;
+        REQUIRE(SceneListWriter::write(scene, path, replacements, [&progress](int value) { progress << value; }, &error));
+        REQUIRE(error.isEmpty());
+        REQUIRE(!progress.isEmpty());
+        REQUIRE(progress.last() == 100);
+        for (int i = 1; i < progress.count(); ++i) {
+            REQUIRE(progress.at(i) > progress.at(i - 1));
+        }
+
+        QFile file(path);
+        REQUIRE(file.open(QIODevice::ReadOnly));
+        QDomDocument doc;
+        REQUIRE(doc.setContent(&file));
+        QDomElement mlt = doc.documentElement();
+        REQUIRE(mlt.tagName() == QStringLiteral("mlt"));
+        REQUIRE(mlt.attribute(QStringLiteral("root")) == QStringLiteral("/tmp"));
+        QDomNodeList properties = mlt.firstChildElement(QStringLiteral("producer")).elementsByTagName(QStringLiteral("property"));
+        REQUIRE(properties.count() == 3);
+        REQUIRE(properties.at(0).toElement().text() == QStringLiteral("/new/proxy/a.mkv"));
+        REQUIRE(properties.at(1).toElement().text() == QStringLiteral("/new/proxy/b.mkv"));
+        REQUIRE(properties.at(2).toElement().text() == QStringLiteral("A & B <1>"));
+        // The playlist volume is reset
+        QDomElement tractor = mlt.firstChildElement(QStringLiteral("tractor"));
+        REQUIRE(tractor.firstChildElement(QStringLiteral("property")).text() == QStringLiteral("1"));
+        REQUIRE(tractor.firstChildElement(QStringLiteral("track")).attribute(QStringLiteral("producer")) == QStringLiteral("p1"));
+    }
+
+    SECTION("A corrupted scene does not replace the file")
+    {
+        QFile file(path);
+        REQUIRE(file.open(QIODevice::WriteOnly));
+        file.write("previous");
+        file.close();
+
+        QString error;
+        REQUIRE_FALSE(SceneListWriter::write(scene.left(scene.size() / 2), path, {}, nullptr, &error));
+        REQUIRE_FALSE(error.isEmpty());
+        REQUIRE_FALSE(SceneListWriter::write(QStringLiteral("<mlt/>"), path, {}, nullptr));
+        REQUIRE_FALSE(SceneListWriter::write(QStringLiteral("<kdenlive><producer/></kdenlive>"), path, {}, nullptr));
+
+        REQUIRE(file.open(QIODevice::ReadOnly));
+        REQUIRE(file.readAll() == QByteArray("previous"));
+    }
+
+    SECTION("A file that cannot be committed does not replace the previous version")
+    {
+        QDir root(dir.path());
+        REQUIRE(root.mkdir(QStringLiteral("project")));
+        REQUIRE(root.mkdir(QStringLiteral("moved")));
+        const QString projectPath = root.absoluteFilePath(QStringLiteral("project/project.kdenlive"));
+        QFile file(projectPath);
+        REQUIRE(file.open(QIODevice::WriteOnly));
+        file.write("previous");
+        file.close();
+
+        // The folder disappears while the file is written, so the temporary file cannot be renamed
+        bool moved = false;
+        auto moveFolder = [&root, &moved](int) {
+            if (!moved) {
+                moved = root.rename(QStringLiteral("project"), QStringLiteral("moved/project"));
+            }
+        };
+        QString error;
+        REQUIRE_FALSE(SceneListWriter::write(scene, projectPath, {}, moveFolder, &error));
+        REQUIRE(moved);
+        REQUIRE_FALSE(error.isEmpty());
+        QFile previous(root.absoluteFilePath(QStringLiteral("moved/project/project.kdenlive")));
+        REQUIRE(previous.open(QIODevice::ReadOnly));
+        REQUIRE(previous.readAll() == QByteArray("previous"));
+    }
+
+    SECTION("Saving in a read-only folder fails")
+    {
+        QDir root(dir.path());
+        REQUIRE(root.mkdir(QStringLiteral("readonly")));
+        const QString folder = root.absoluteFilePath(QStringLiteral("readonly"));
+        REQUIRE(QFile::setPermissions(folder, QFile::ReadOwner | QFile::ExeOwner));
+        // Permissions are not enforced for the super user
+        if (!QFileInfo(folder).isWritable()) {
+            QString error;
+            REQUIRE_FALSE(SceneListWriter::write(scene, folder + QStringLiteral("/project.kdenlive"), {}, nullptr, &error));
+            REQUIRE_FALSE(error.isEmpty());
+            REQUIRE_FALSE(QFile::exists(folder + QStringLiteral("/project.kdenlive")));
+        }
+        QFile::setPermissions(folder, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner);
+    }
+}
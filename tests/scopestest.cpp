@@ -0,0 +1,237 @@
+#include "catch.hpp"
+#include "scopes/colorscopes/framestatistics.h"
+
+#include <QImage>
+#include <vector>
+
+namespace {
+// Build a yuv420p frame where the left half and the right half have different colors
+std::vector<uint8_t> makeFrame(int width, int height, uint8_t yLeft, uint8_t uLeft, uint8_t vLeft, uint8_t yRight, uint8_t uRight, uint8_t vRight)
+{
+    std::vector<uint8_t> frame(size_t(width * height + 2 * (width / 2) * (height / 2)));
+    uint8_t *u = frame.data() + width * height;
+    uint8_t *v = u + (width / 2) * (height / 2);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            frame[size_t(y * width + x)] = x < width / 2 ? yLeft : yRight;
+        }
+    }
+    for (int y = 0; y < height / 2; ++y) {
+        for (int x = 0; x < width / 2; ++x) {
+            u[y * (width / 2) + x] = x < width / 4 ? uLeft : uRight;
+            v[y * (width / 2) + x] = x < width / 4 ? vLeft : vRight;
+        }
+    }
+    return frame;
+}
+
+// Compare everything the scopes can read
+void requireSameStatistics(const FrameStatistics &a, const FrameStatistics &b)
+{
+    REQUIRE(a.pixelCount() == b.pixelCount());
+    REQUIRE(a.columns() == b.columns());
+    for (int i = 0; i < 256; ++i) {
+        REQUIRE(a.redHistogram()[i] == b.redHistogram()[i]);
+        REQUIRE(a.greenHistogram()[i] == b.greenHistogram()[i]);
+        REQUIRE(a.blueHistogram()[i] == b.blueHistogram()[i]);
+        REQUIRE(a.lumaHistogram()[i] == b.lumaHistogram()[i]);
+        for (int column = 0; column < a.columns(); ++column) {
+            REQUIRE(a.waveformColumn(column)[i] == b.waveformColumn(column)[i]);
+            REQUIRE(a.redColumn(column)[i] == b.redColumn(column)[i]);
+            REQUIRE(a.greenColumn(column)[i] == b.greenColumn(column)[i]);
+            REQUIRE(a.blueColumn(column)[i] == b.blueColumn(column)[i]);
+        }
+        for (int cr = 0; cr < 256; ++cr) {
+            REQUIRE(a.chromaCount(i, cr) == b.chromaCount(i, cr));
+            REQUIRE(a.chromaColor(i, cr) == b.chromaColor(i, cr));
+        }
+    }
+}
+
+FrameStatistics::Request allScopes()
+{
+    FrameStatistics::Request request;
+    request.scopes = FrameStatistics::Histogram | FrameStatistics::Waveform | FrameStatistics::Parade | FrameStatistics::Vectorscope;
+    return request;
+}
+} // namespace
+
+TEST_CASE("Frame statistics", "[Scopes]")
+{
+    const int width = 64;
+    const int height = 16;
+    const int pixels = width * height;
+
+    SECTION("Black and white")
+    {
+        std::vector<uint8_t> frame = makeFrame(width, height, 16, 128, 128, 235, 128, 128);
+        auto stats = FrameStatistics::fromYuv420p(frame.data(), width, height, FrameStatistics::Rec_601, allScopes());
+        REQUIRE(stats->pixelCount() == pixels);
+        REQUIRE(stats->columns() == width);
+        REQUIRE(stats->redHistogram()[0] == pixels / 2);
+        REQUIRE(stats->redHistogram()[255] == pixels / 2);
+        REQUIRE(stats->blueHistogram()[255] == pixels / 2);
+        REQUIRE(stats->lumaHistogram()[0] == pixels / 2);
+        REQUIRE(stats->lumaHistogram()[255] == pixels / 2);
+        REQUIRE(stats->waveformColumn(0)[0] == height);
+        REQUIRE(stats->waveformColumn(width - 1)[255] == height);
+        REQUIRE(stats->greenColumn(width - 1)[255] == height);
+        REQUIRE(stats->chromaCount(128, 128) == pixels);
+    }
+
+    SECTION("Colors")
+    {
+        // Rec. 601 red on the left, neutral grey on the right
+        std::vector<uint8_t> frame = makeFrame(width, height, 81, 90, 240, 126, 128, 128);
+        auto stats = FrameStatistics::fromYuv420p(frame.data(), width, height, FrameStatistics::Rec_601, allScopes());
+        QRgb red = stats->chromaColor(90, 240);
+        REQUIRE(qRed(red) > 250);
+        REQUIRE(qGreen(red) < 5);
+        REQUIRE(qBlue(red) < 5);
+        REQUIRE(stats->chromaCount(90, 240) == pixels / 2);
+        REQUIRE(stats->chromaColor(128, 128) == qRgb(128, 128, 128));
+        REQUIRE(stats->redColumn(width - 1)[128] == height);
+    }
+
+    SECTION("Images give the same statistics")
+    {
+        std::vector<uint8_t> frame = makeFrame(width, height, 16, 128, 128, 126, 128, 128);
+        QImage image(width, height, QImage::Format_RGB32);
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                image.setPixel(x, y, x < width / 2 ? qRgb(0, 0, 0) : qRgb(128, 128, 128));
+            }
+        }
+        auto fromYuv = FrameStatistics::fromYuv420p(frame.data(), width, height, FrameStatistics::Rec_709, allScopes());
+        auto fromImage = FrameStatistics::fromImage(image, allScopes());
+        for (int i = 0; i < 256; ++i) {
+            REQUIRE(fromYuv->redHistogram()[i] == fromImage->redHistogram()[i]);
+            REQUIRE(fromYuv->lumaHistogram()[i] == fromImage->lumaHistogram()[i]);
+            for (int x = 0; x < width; ++x) {
+                REQUIRE(fromYuv->waveformColumn(x)[i] == fromImage->waveformColumn(x)[i]);
+                REQUIRE(fromYuv->blueColumn(x)[i] == fromImage->blueColumn(x)[i]);
+            }
+        }
+        REQUIRE(fromImage->chromaCount(128, 128) == pixels);
+    }
+
+    SECTION("Only requested data is collected")
+    {
+        const int wide = FrameStatistics::MaxColumns * 2;
+        std::vector<uint8_t> frame = makeFrame(wide, 2, 16, 128, 128, 235, 128, 128);
+        FrameStatistics::Request request;
+        request.scopes = FrameStatistics::Waveform;
+        auto stats = FrameStatistics::fromYuv420p(frame.data(), wide, 2, FrameStatistics::Rec_601, request);
+        REQUIRE(stats->columns() == FrameStatistics::MaxColumns);
+        // Columns are grouped
+        REQUIRE(stats->waveformColumn(0)[0] == 4);
+        REQUIRE(stats->waveformColumn(FrameStatistics::MaxColumns - 1)[255] == 4);
+        REQUIRE(stats->lumaHistogram()[0] == 0);
+        REQUIRE(stats->chromaCount(128, 128) == 0);
+        // RGB histograms are always available
+        REQUIRE(stats->redHistogram()[255] == uint32_t(wide));
+    }
+
+    SECTION("Merging requests")
+    {
+        FrameStatistics::Request histogram;
+        histogram.scopes = FrameStatistics::Histogram;
+        histogram.histogramRec = FrameStatistics::Rec_709;
+        FrameStatistics::Request waveform;
+        waveform.scopes = FrameStatistics::Waveform;
+        waveform.histogramRec = FrameStatistics::Rec_601;
+        waveform.waveformRec = FrameStatistics::Rec_709;
+        FrameStatistics::Request request;
+        request.merge(histogram);
+        request.merge(waveform);
+        REQUIRE(request.scopes == (FrameStatistics::Histogram | FrameStatistics::Waveform));
+        REQUIRE(request.histogramRec == FrameStatistics::Rec_709);
+        REQUIRE(request.waveformRec == FrameStatistics::Rec_709);
+    }
+
+    SECTION("SIMD and scalar conversions are identical")
+    {
+        // Odd width, so that the scalar tail and the reused last chroma sample are covered
+        const int rowWidth = 8 * 256 + 7;
+        const int chromaWidth = rowWidth / 2;
+        std::vector<uint8_t> y(rowWidth), u(chromaWidth), v(chromaWidth);
+        for (int x = 0; x < rowWidth; ++x) {
+            y[x] = uint8_t(x);
+        }
+        for (int x = 0; x < chromaWidth; ++x) {
+            u[x] = uint8_t(x * 7);
+            v[x] = uint8_t(x / 4);
+        }
+        std::vector<uint8_t> simd(3 * rowWidth), scalar(3 * rowWidth), simdLuma(rowWidth), scalarLuma(rowWidth);
+        for (auto matrix : {FrameStatistics::Rec_601, FrameStatistics::Rec_709}) {
+            FrameStatistics::yuvToRgbRow(y.data(), u.data(), v.data(), rowWidth, chromaWidth, matrix, simd.data(), simd.data() + rowWidth,
+                                         simd.data() + 2 * rowWidth, true);
+            FrameStatistics::yuvToRgbRow(y.data(), u.data(), v.data(), rowWidth, chromaWidth, matrix, scalar.data(), scalar.data() + rowWidth,
+                                         scalar.data() + 2 * rowWidth, false);
+            REQUIRE(simd == scalar);
+            FrameStatistics::rgbToLumaRow(simd.data(), simd.data() + rowWidth, simd.data() + 2 * rowWidth, rowWidth, matrix, simdLuma.data(), true);
+            FrameStatistics::rgbToLumaRow(simd.data(), simd.data() + rowWidth, simd.data() + 2 * rowWidth, rowWidth, matrix, scalarLuma.data(), false);
+            REQUIRE(simdLuma == scalarLuma);
+        }
+    }
+
+    SECTION("Frames analysed in bands give the same statistics")
+    {
+        // Tall enough to be split between threads, with a different color on each row
+        const int tall = 1024;
+        std::vector<uint8_t> frame = makeFrame(width, tall, 16, 128, 128, 235, 128, 128);
+        for (int y = 0; y < tall; ++y) {
+            std::fill(frame.begin() + y * width, frame.begin() + y * width + width / 2, uint8_t(16 + y % 220));
+        }
+        auto stats = FrameStatistics::fromYuv420p(frame.data(), width, tall, FrameStatistics::Rec_601, allScopes(), FrameStatistics::MaxThreads);
+        REQUIRE(stats->pixelCount() == width * tall);
+        REQUIRE(stats->redHistogram()[255] >= uint32_t(width * tall / 2));
+        uint32_t total = 0;
+        for (int i = 0; i < 256; ++i) {
+            total += stats->lumaHistogram()[i];
+            REQUIRE(stats->waveformColumn(width - 1)[i] == (i == 255 ? uint32_t(tall) : 0u));
+        }
+        REQUIRE(total == uint32_t(width * tall));
+        REQUIRE(stats->chromaCount(128, 128) == uint32_t(width * tall));
+
+        // Same result as a single band
+        auto single = FrameStatistics::fromYuv420p(frame.data(), width, tall, FrameStatistics::Rec_601, allScopes(), 1);
+        requireSameStatistics(*stats, *single);
+        QImage image(width, tall, QImage::Format_RGB32);
+        for (int y = 0; y < tall; ++y) {
+            for (int x = 0; x < width; ++x) {
+                image.setPixel(x, y, qRgb(x * 4, y % 256, (x + y) % 256));
+            }
+        }
+        requireSameStatistics(*FrameStatistics::fromImage(image, allScopes(), FrameStatistics::MaxThreads), *FrameStatistics::fromImage(image, allScopes(), 1));
+    }
+
+    SECTION("Invalid frames")
+    {
+        auto stats = FrameStatistics::fromYuv420p(nullptr, width, height, FrameStatistics::Rec_601, allScopes());
+        REQUIRE(stats->isEmpty());
+        REQUIRE(FrameStatistics::fromImage(QImage(), allScopes())->isEmpty());
+    }
+}
+
+TEST_CASE("Frame statistics cost", "[.][Benchmark][Scopes]")
+{
+    const int width = 1920;
+    const int height = 1080;
+    std::vector<uint8_t> frame = makeFrame(width, height, 60, 100, 150, 200, 140, 120);
+    int pixels = 0;
+    BENCHMARK("1080p frame, all scopes")
+    {
+        pixels = FrameStatistics::fromYuv420p(frame.data(), width, height, FrameStatistics::Rec_709, allScopes())->pixelCount();
+    }
+    REQUIRE(pixels == width * height);
+
+    const int width4k = 3840;
+    const int height4k = 2160;
+    std::vector<uint8_t> frame4k = makeFrame(width4k, height4k, 60, 100, 150, 200, 140, 120);
+    BENCHMARK("4K frame, all scopes")
+    {
+        pixels = FrameStatistics::fromYuv420p(frame4k.data(), width4k, height4k, FrameStatistics::Rec_709, allScopes())->pixelCount();
+    }
+    REQUIRE(pixels == width4k * height4k);
+}
@@ -0,0 +1,194 @@
+#include "test_utils.hpp"
+#include "utils/thumbnailatlas.hpp"
+#include "utils/thumbnailcache.hpp"
+
+#include <QTemporaryDir>
+#include <QtEndian>
+
+using namespace fakeit;
+Mlt::Profile profile_thumbs;
+
+TEST_CASE("Volatile thumbnail cache", "[ThumbnailCache]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    // No opened document: the persistent cache is not available
+    When(Method(pmMock, current)).AlwaysReturn(nullptr);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    QString binId = createProducer(profile_thumbs, "red", binModel);
+    QString binId2 = createProducer(profile_thumbs, "blue", binModel);
+    QImage img(16, 9, QImage::Format_ARGB32);
+    img.fill(Qt::red);
+
+    auto &cache = ThumbnailCache::get();
+    cache->setMaxCost(64 * 1048576LL);
+    cache->storeThumbnail(binId, 10, img);
+    cache->storeThumbnail(binId, 20, img);
+    cache->storeThumbnail(binId2, 10, img);
+    REQUIRE(cache->hasThumbnail(binId, 10, true));
+    REQUIRE(cache->hasThumbnail(binId, 20, true));
+    REQUIRE(cache->getThumbnail(binId, 10, true) == img);
+    REQUIRE_FALSE(cache->hasThumbnail(binId, 30, true));
+
+    SECTION("Track producers share the thumbnails of their master clip")
+    {
+        REQUIRE(cache->hasThumbnail(binId + QStringLiteral("_video"), 10, true));
+    }
+
+    SECTION("Invalidation only removes the thumbnails of the clip")
+    {
+        cache->invalidateThumbsForClip(binId);
+        REQUIRE_FALSE(cache->hasThumbnail(binId, 10, true));
+        REQUIRE_FALSE(cache->hasThumbnail(binId, 20, true));
+        REQUIRE(cache->hasThumbnail(binId2, 10, true));
+    }
+
+    SECTION("Invalidation through a track producer id")
+    {
+        cache->invalidateThumbsForClip(binId + QStringLiteral("_audio"));
+        REQUIRE_FALSE(cache->hasThumbnail(binId, 10, true));
+        REQUIRE_FALSE(cache->hasThumbnail(binId, 20, true));
+        REQUIRE(cache->hasThumbnail(binId2, 10, true));
+    }
+
+    SECTION("Lowering the memory budget evicts thumbnails")
+    {
+        // Each shard now has room for less than one image
+        cache->setMaxCost(img.byteCount());
+        REQUIRE_FALSE(cache->hasThumbnail(binId, 10, true));
+        REQUIRE_FALSE(cache->hasThumbnail(binId2, 10, true));
+        cache->setMaxCost(64 * 1048576LL);
+        cache->storeThumbnail(binId, 10, img);
+        REQUIRE(cache->hasThumbnail(binId, 10, true));
+    }
+
+    cache->invalidateThumbsForClip(binId);
+    cache->invalidateThumbsForClip(binId2);
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
+
+TEST_CASE("Thumbnail atlas", "[ThumbnailCache]")
+{
+    QTemporaryDir dir;
+    REQUIRE(dir.isValid());
+    const QString clipHash = QStringLiteral("0123456789abcdef0123456789abcdef");
+    const QString atlasPath = dir.filePath(ThumbnailAtlas::fileName(clipHash));
+    QImage opaque(32, 18, QImage::Format_RGB32);
+    opaque.fill(Qt::blue);
+    QImage transparent(32, 18, QImage::Format_ARGB32);
+    transparent.fill(QColor(255, 0, 0, 128));
+
+    SECTION("Nothing is created until a thumbnail is stored")
+    {
+        ThumbnailAtlas atlas(dir.path(), clipHash);
+        REQUIRE_FALSE(atlas.contains(0));
+        REQUIRE(atlas.read(0).isNull());
+        REQUIRE_FALSE(QFile::exists(atlasPath));
+    }
+
+    SECTION("Records are appended after the header and indexed again on reopen")
+    {
+        {
+            ThumbnailAtlas atlas(dir.path(), clipHash);
+            REQUIRE(atlas.append(10, opaque));
+            REQUIRE(atlas.append(20, transparent));
+            REQUIRE(atlas.contains(10));
+            REQUIRE(atlas.contains(20));
+            REQUIRE_FALSE(atlas.contains(30));
+        }
+        QFile file(atlasPath);
+        REQUIRE(file.open(QIODevice::ReadOnly));
+        const QByteArray data = file.readAll();
+        REQUIRE(data.startsWith(QByteArray("KDTA\x01\x00\x00\x00", 8)));
+        // First record: frame 10, opaque images are stored as JPEG
+        REQUIRE(qFromLittleEndian<qint32>(reinterpret_cast<const uchar *>(data.constData() + 8)) == 10);
+        REQUIRE(data.at(16) == 0);
+
+        ThumbnailAtlas atlas(dir.path(), clipHash);
+        REQUIRE(atlas.contains(10));
+        REQUIRE(atlas.contains(20));
+        const QImage img = atlas.read(10);
+        REQUIRE(img.size() == opaque.size());
+        REQUIRE(qAbs(qBlue(img.pixel(5, 5)) - 255) < 8);
+        // Transparent images are stored losslessly
+        REQUIRE(atlas.read(20).convertToFormat(QImage::Format_ARGB32) == transparent);
+    }
+
+    SECTION("The last record of a frame wins")
+    {
+        ThumbnailAtlas atlas(dir.path(), clipHash);
+        REQUIRE(atlas.append(10, opaque));
+        REQUIRE(atlas.append(10, transparent));
+        atlas.release();
+        REQUIRE_FALSE(atlas.isOpen());
+        ThumbnailAtlas reopened(dir.path(), clipHash);
+        REQUIRE(reopened.read(10).convertToFormat(QImage::Format_ARGB32) == transparent);
+    }
+
+    SECTION("An interrupted write is dropped")
+    {
+        qint64 size;
+        {
+            ThumbnailAtlas atlas(dir.path(), clipHash);
+            REQUIRE(atlas.append(10, opaque));
+            size = QFileInfo(atlasPath).size();
+        }
+        QFile file(atlasPath);
+        REQUIRE(file.open(QIODevice::Append));
+        file.write("\x14\x00\x00\x00\xff\x00", 6);
+        file.close();
+        ThumbnailAtlas atlas(dir.path(), clipHash);
+        REQUIRE(atlas.contains(10));
+        REQUIRE_FALSE(atlas.contains(20));
+        REQUIRE(QFileInfo(atlasPath).size() == size);
+        REQUIRE(atlas.append(20, opaque));
+        REQUIRE_FALSE(atlas.read(20).isNull());
+    }
+
+    SECTION("Legacy thumbnails are moved into the atlas when read")
+    {
+        const QString legacyPath = dir.filePath(clipHash + QStringLiteral("#5.png"));
+        REQUIRE(transparent.save(legacyPath));
+        {
+            ThumbnailAtlas atlas(dir.path(), clipHash);
+            REQUIRE(atlas.contains(5));
+            REQUIRE_FALSE(atlas.contains(6));
+            REQUIRE(QFile::exists(legacyPath));
+            REQUIRE(atlas.read(5).convertToFormat(QImage::Format_ARGB32) == transparent);
+            REQUIRE_FALSE(QFile::exists(legacyPath));
+        }
+        ThumbnailAtlas atlas(dir.path(), clipHash);
+        REQUIRE(atlas.contains(5));
+        REQUIRE(atlas.read(5).convertToFormat(QImage::Format_ARGB32) == transparent);
+    }
+
+    SECTION("Clearing removes the atlas and the legacy files")
+    {
+        const QString legacyPath = dir.filePath(clipHash + QStringLiteral("#5.png"));
+        REQUIRE(opaque.save(legacyPath));
+        ThumbnailAtlas atlas(dir.path(), clipHash);
+        REQUIRE(atlas.append(10, opaque));
+        atlas.clear();
+        REQUIRE_FALSE(QFile::exists(atlasPath));
+        REQUIRE_FALSE(QFile::exists(legacyPath));
+        REQUIRE_FALSE(atlas.contains(5));
+        REQUIRE_FALSE(atlas.contains(10));
+    }
+
+    SECTION("Only the recently used atlases are kept")
+    {
+        auto &cache = ThumbnailCache::get();
+        for (int i = 0; i < 100; ++i) {
+            cache->getAtlas(dir.path(), QString::number(i, 16).rightJustified(32, QLatin1Char('0')));
+        }
+        REQUIRE(cache->m_recentAtlases.size() <= 32);
+        REQUIRE(cache->m_atlases.size() == cache->m_recentAtlases.size());
+    }
+}
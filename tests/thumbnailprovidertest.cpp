@@ -0,0 +1,132 @@
+#include "test_utils.hpp"
+#include "timeline2/view/qmltypes/thumbnailprovider.h"
+#include "utils/thumbnailcache.hpp"
+
+using namespace fakeit;
+Mlt::Profile profile_provider;
+
+namespace {
+ThumbnailResponse *addRequest(ThumbnailProvider &provider, const QString &binId, int frame, int &finished)
+{
+    auto *response = new ThumbnailResponse(&provider, binId, frame, QSize());
+    QObject::connect(response, &QQuickImageResponse::finished, [&finished]() { finished++; });
+    provider.m_clips[binId].queue.push_back(response);
+    return response;
+}
+} // namespace
+
+TEST_CASE("Timeline thumbnail requests", "[ThumbnailProvider]")
+{
+    auto binModel = pCore->projectItemModel();
+    binModel->clean();
+
+    std::shared_ptr<DocUndoStack> undoStack = std::make_shared<DocUndoStack>(nullptr);
+    Mock<ProjectManager> pmMock;
+    When(Method(pmMock, undoStack)).AlwaysReturn(undoStack);
+    // No opened document: thumbnails are only kept in memory
+    When(Method(pmMock, current)).AlwaysReturn(nullptr);
+    ProjectManager &mocked = pmMock.get();
+    pCore->m_projectManager = &mocked;
+
+    QString binId = createProducer(profile_provider, "red", binModel);
+    int finished = 0;
+    std::vector<ThumbnailResponse *> responses;
+
+    SECTION("Decoders read forward")
+    {
+        ThumbnailProvider provider;
+        for (int frame : {50, 10, 30, 70}) {
+            responses.push_back(addRequest(provider, binId, frame, finished));
+        }
+        auto &clip = provider.m_clips[binId];
+        ThumbnailProvider::Decoder decoder;
+        decoder.position = 25;
+        std::vector<int> order;
+        while (ThumbnailResponse *response = provider.takeNext(clip, decoder)) {
+            order.push_back(response->m_frame);
+            decoder.position = response->m_frame + 1;
+        }
+        // Back to the first frame once the end is reached
+        REQUIRE(order == std::vector<int>{30, 50, 70, 10});
+        REQUIRE(clip.queue.empty());
+    }
+
+    SECTION("Canceled requests are not decoded")
+    {
+        QImage img(16, 9, QImage::Format_ARGB32);
+        img.fill(Qt::blue);
+        ThumbnailCache::get()->storeThumbnail(binId, 10, img, false);
+        {
+            ThumbnailProvider provider;
+            responses.push_back(addRequest(provider, binId, 10, finished));
+            responses.push_back(addRequest(provider, binId, 20, finished));
+            responses.push_back(addRequest(provider, binId, 30, finished));
+            // Still queued: removed and finished right away
+            responses[2]->cancel();
+            REQUIRE(finished == 1);
+            REQUIRE(provider.m_clips[binId].queue.size() == 2);
+            // Taken by a decoder: only marked, the decoder finishes it
+            provider.m_clips[binId].queue.pop_back();
+            responses[1]->cancel();
+            REQUIRE(finished == 1);
+            REQUIRE(provider.isCanceled(responses[1]));
+            provider.m_clips[binId].queue.push_back(responses[1]);
+
+            auto decoder = std::make_shared<ThumbnailProvider::Decoder>();
+            decoder->busy = true;
+            provider.m_clips[binId].decoders.push_back(decoder);
+            provider.runDecoder(binId, decoder);
+            REQUIRE(finished == 3);
+            REQUIRE_FALSE(decoder->busy);
+            REQUIRE(responses[0]->m_image == img);
+            REQUIRE(responses[1]->m_image.isNull());
+            // Nothing was opened for the canceled request
+            REQUIRE(decoder->producer == nullptr);
+        }
+        REQUIRE(finished == 3);
+        ThumbnailCache::get()->invalidateThumbsForClip(binId);
+    }
+
+    SECTION("Decoders of a reloaded clip stop")
+    {
+        ThumbnailProvider provider;
+        auto decoder = std::make_shared<ThumbnailProvider::Decoder>();
+        decoder->busy = true;
+        auto &clip = provider.m_clips[binId];
+        clip.decoders.push_back(decoder);
+        const int generation = binModel->getClipByBinID(binId)->thumbProducerGeneration();
+        clip.generation = generation - 1;
+        // A request drops the decoders of the previous generation and starts a new one
+        auto *response = new ThumbnailResponse(&provider, binId, 10, QSize());
+        QObject::connect(response, &QQuickImageResponse::finished, [&finished]() { finished++; });
+        responses.push_back(response);
+        provider.enqueue(response);
+        provider.m_pool.waitForDone();
+        REQUIRE(finished == 1);
+        REQUIRE(clip.generation == generation);
+        REQUIRE(clip.decoders.size() == 1);
+        REQUIRE(clip.decoders.front() != decoder);
+        REQUIRE_FALSE(clip.decoders.front()->busy);
+        // The old decoder stops without taking requests
+        responses.push_back(addRequest(provider, binId, 20, finished));
+        provider.runDecoder(binId, decoder);
+        REQUIRE_FALSE(decoder->busy);
+        REQUIRE(clip.queue.size() == 1);
+        REQUIRE(finished == 1);
+        ThumbnailCache::get()->invalidateThumbsForClip(binId);
+    }
+
+    SECTION("Pending requests are finished when the provider is deleted")
+    {
+        {
+            ThumbnailProvider provider;
+            responses.push_back(addRequest(provider, binId, 10, finished));
+            responses.push_back(addRequest(provider, binId, 20, finished));
+        }
+        REQUIRE(finished == 2);
+    }
+
+    qDeleteAll(responses);
+    binModel->clean();
+    pCore->m_projectManager = nullptr;
+}
@@ -186,4 +186,32 @@ TEST_CASE("Basic tree testing", "[TreeModel]")
         REQUIRE(item5->changeParent(item2));
         state();
     }
+
+    SECTION("Rows after removal and moves")
+    {
+        auto root = model->getRoot();
+        std::vector<std::shared_ptr<TreeItem>> items;
+        for (int i = 0; i < 6; ++i) {
+            items.push_back(root->appendChild(QList<QVariant>{QString::number(i)}));
+        }
+        auto check_rows = [&](const std::vector<int> &order) {
+            REQUIRE(model->checkConsistency());
+            REQUIRE(root->childCount() == (int)order.size());
+            for (size_t row = 0; row < order.size(); ++row) {
+                REQUIRE(items[(size_t)order[row]]->row() == (int)row);
+                REQUIRE(root->child((int)row) == items[(size_t)order[row]]);
+            }
+        };
+        check_rows({0, 1, 2, 3, 4, 5});
+
+        // removing a child shifts the following rows
+        root->removeChild(items[2]);
+        check_rows({0, 1, 3, 4, 5});
+
+        // moving a child inside its parent
+        root->moveChild(0, items[4]);
+        check_rows({4, 0, 1, 3, 5});
+        root->moveChild(4, items[4]);
+        check_rows({0, 1, 3, 5, 4});
+    }
 }
@@ -0,0 +1,205 @@
+#include "catch.hpp"
+#include "doc/docundostack.hpp"
+#include "macros.hpp"
+#include "undohelper.hpp"
+
+#include <vector>
+
+namespace {
+// Push a command made of @param size increments of @param state, that were already executed
+void pushCommand(DocUndoStack &stack, int &state, int size)
+{
+    Fun undo = []() { return true; };
+    Fun redo = []() { return true; };
+    for (int i = 0; i < size; ++i) {
+        Fun operation = [&state]() {
+            state++;
+            return true;
+        };
+        Fun reverse = [&state]() {
+            state--;
+            return true;
+        };
+        REQUIRE(operation());
+        UPDATE_UNDO_REDO_NOLOCK(operation, reverse, undo, redo);
+    }
+    stack.push(new FunctionalUndoCommand(undo, redo, QStringLiteral("command")));
+}
+} // namespace
+
+TEST_CASE("Flat undo operation lists", "[Undo]")
+{
+    std::vector<int> order;
+    auto op = [&order](int i) {
+        return [&order, i]() {
+            order.push_back(i);
+            return true;
+        };
+    };
+
+    SECTION("Execution order")
+    {
+        Fun undo = []() { return true; };
+        Fun redo = []() { return true; };
+        for (int i = 0; i < 4; ++i) {
+            Fun operation = op(i);
+            Fun reverse = op(-i);
+            UPDATE_UNDO_REDO_NOLOCK(operation, reverse, undo, redo);
+        }
+        REQUIRE(redo());
+        REQUIRE(order == std::vector<int>{0, 1, 2, 3});
+        order.clear();
+        REQUIRE(undo());
+        REQUIRE(order == std::vector<int>{-3, -2, -1, 0});
+        REQUIRE(redo.target<FunList>()->size() == 5);
+
+        // Copies are independent
+        Fun copy = redo;
+        PUSH_LAMBDA(op(4), copy);
+        REQUIRE(redo.target<FunList>()->size() == 5);
+        REQUIRE(copy.target<FunList>()->size() == 6);
+    }
+
+    SECTION("Failures")
+    {
+        Fun fail = []() { return false; };
+        Fun lambda = op(0);
+        PUSH_LAMBDA(fail, lambda);
+        PUSH_LAMBDA(op(1), lambda);
+        PUSH_FRONT_LAMBDA(op(2), lambda);
+        REQUIRE_FALSE(lambda());
+        // operations pushed with PUSH_LAMBDA are skipped after a failure
+        REQUIRE(order == std::vector<int>{2, 0});
+        order.clear();
+
+        Fun undo = []() { return true; };
+        Fun redo = []() { return true; };
+        Fun operation = op(0);
+        UPDATE_UNDO_REDO_NOLOCK(operation, fail, undo, redo);
+        operation = op(1);
+        Fun reverse = op(1);
+        UPDATE_UNDO_REDO_NOLOCK(operation, reverse, undo, redo);
+        // undo operations are all executed even if one fails
+        REQUIRE_FALSE(undo());
+        REQUIRE(order == std::vector<int>{1});
+        order.clear();
+
+        // a failure only skips the operations that were pushed after it, even if it is executed before them
+        undo = []() { return true; };
+        PUSH_LAMBDA(op(2), undo);
+        operation = op(3);
+        UPDATE_UNDO_REDO_NOLOCK(operation, fail, undo, redo);
+        REQUIRE_FALSE(undo());
+        REQUIRE(order == std::vector<int>{2});
+    }
+
+    SECTION("Long chains")
+    {
+        int count = 0;
+        Fun lambda = []() { return true; };
+        Fun increment = [&count]() {
+            count++;
+            return true;
+        };
+        for (int i = 0; i < 500000; ++i) {
+            PUSH_LAMBDA(increment, lambda);
+        }
+        REQUIRE(lambda());
+        REQUIRE(count == 500000);
+        REQUIRE(UndoHelper::operationCount(lambda) == 500001);
+    }
+}
+
+TEST_CASE("Undo stack operation limit", "[Undo]")
+{
+    DocUndoStack stack(nullptr);
+    int state = 0;
+    for (int i = 0; i < 10; ++i) {
+        pushCommand(stack, state, 100);
+    }
+    REQUIRE(stack.count() == 10);
+    REQUIRE(state == 1000);
+    size_t commandOperations = DocUndoStack::commandOperations(stack.command(0));
+    REQUIRE(commandOperations == 202);
+    REQUIRE(stack.operationCount() == 10 * commandOperations);
+
+    // Only 4 commands fit in the limit, they are discarded on the next push
+    stack.setOperationLimit(4 * commandOperations + commandOperations / 2);
+    REQUIRE(stack.count() == 10);
+    pushCommand(stack, state, 100);
+    REQUIRE(stack.count() == 4);
+    REQUIRE(stack.index() == 4);
+    REQUIRE(state == 1100);
+
+    // The remaining commands still work
+    stack.undo();
+    stack.undo();
+    REQUIRE(state == 900);
+    stack.redo();
+    REQUIRE(state == 1000);
+
+    // Pushing discards the redo branch, then the oldest commands
+    pushCommand(stack, state, 100);
+    REQUIRE(state == 1100);
+    REQUIRE(stack.count() == 4);
+    while (stack.canUndo()) {
+        stack.undo();
+    }
+    REQUIRE(state == 700);
+}
+
+TEST_CASE("Trimming a modified undo stack", "[Undo]")
+{
+    DocUndoStack stack(nullptr);
+    int state = 0;
+    for (int i = 0; i < 9; ++i) {
+        pushCommand(stack, state, 100);
+    }
+    size_t commandOperations = DocUndoStack::commandOperations(stack.command(0));
+
+    SECTION("The saved state was discarded")
+    {
+        // The document was saved before the first command
+        pushCommand(stack, state, 100);
+        REQUIRE_FALSE(stack.isClean());
+        stack.setOperationLimit(4 * commandOperations + commandOperations / 2);
+        std::vector<int> indexes;
+        bool canUndo = false;
+        QObject::connect(&stack, &QUndoStack::indexChanged, [&indexes](int index) { indexes.push_back(index); });
+        QObject::connect(&stack, &QUndoStack::canUndoChanged, [&canUndo](bool enabled) { canUndo = enabled; });
+        pushCommand(stack, state, 100);
+        // Only the final state is reported
+        REQUIRE(indexes == std::vector<int>{4});
+        REQUIRE(canUndo);
+        REQUIRE_FALSE(stack.isClean());
+        while (stack.canUndo()) {
+            stack.undo();
+        }
+        REQUIRE(stack.index() == 0);
+        REQUIRE(state == 700);
+        // Index 0 is not the saved state anymore
+        REQUIRE_FALSE(stack.isClean());
+        REQUIRE(stack.cleanIndex() == -1);
+    }
+
+    SECTION("The saved state is kept")
+    {
+        stack.setClean();
+        pushCommand(stack, state, 100);
+        REQUIRE_FALSE(stack.isClean());
+        stack.setOperationLimit(4 * commandOperations + commandOperations / 2);
+        pushCommand(stack, state, 100);
+        REQUIRE(stack.count() == 4);
+        REQUIRE(stack.cleanIndex() == 2);
+        stack.undo();
+        REQUIRE_FALSE(stack.isClean());
+        stack.undo();
+        REQUIRE(stack.isClean());
+        REQUIRE(state == 900);
+        stack.undo();
+        stack.undo();
+        REQUIRE(stack.index() == 0);
+        REQUIRE_FALSE(stack.isClean());
+        REQUIRE(state == 700);
+    }
+}